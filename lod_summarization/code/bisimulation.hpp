@@ -0,0 +1,3507 @@
+// The k-bisimulation of a binary encoded graph, along with the outcome, mapping and condensed summary files it writes.
+// The bisimulator program and lod_pipeline run it through run_k_bisimulation_store_partition_condensed_timed, the bisimulator also through
+// run_k_bisimulation_incremental_timed.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <map>
+#include <stack>
+// #include <span>
+#include <fstream>
+#include <string>
+// #define BOOST_USE_VALGRIND  // TODO disable this command in the final running version
+#include <boost/algorithm/string.hpp>
+#include <boost/dynamic_bitset.hpp>
+#include <boost/unordered/unordered_flat_map.hpp>
+#include <boost/unordered/unordered_flat_set.hpp>
+#include <boost/format.hpp>
+#include <iostream>
+#include <sstream>
+#define BOOST_CHRONO_HEADER_ONLY
+#include <boost/chrono.hpp>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+#include <boost/algorithm/string/find.hpp>
+#include "partition_file.hpp"
+#include "experiment_manifest.hpp"
+#include "stage_cache.hpp"
+#include "my_exception.hpp"
+
+using edge_type = uint32_t;
+// The graph, partition and signature code below is templated on the type of the node indices (node_index).
+// Blocks use the same type (block_index), singletons get negative indices of the signed counterpart (block_or_singleton_index).
+// Graphs with fewer than 2^31 vertices use 32-bit indices, see run_with_node_index_width.
+using set_of_types = boost::unordered_flat_set<edge_type>;
+
+const int BYTES_PER_ENTITY = 5;
+const int BYTES_PER_PREDICATE = 4;
+const int BYTES_PER_BLOCK = 4;
+const int BYTES_PER_BLOCK_OR_SINGLETON = 5;
+const int BYTES_PER_K_TYPE = 2;
+const int BYTES_PER_OFFSET = 8;
+
+// The local to global block map starts with this magic and version, see create_condensed_summary_graph_from_partitions
+const std::string LOCAL_GLOBAL_MAP_MAGIC = "LGMP";
+const uint8_t LOCAL_GLOBAL_MAP_VERSION = 2;
+
+const int64_t MAX_SIGNED_BLOCK_SIZE = INT64_MAX;
+
+
+#define CREATE_REVERSE_INDEX
+
+template <typename node_index>
+struct Edge
+{
+public:
+    const edge_type label;
+    const node_index target;
+};
+
+template <typename node_index>
+class Node
+{
+    std::vector<Edge<node_index>> edges;
+
+public:
+    Node()
+    {
+        edges.reserve(1);
+    }
+    std::vector<Edge<node_index>>& get_outgoing_edges()
+    {
+        std::vector<Edge<node_index>> & edges_ref = edges;
+        return edges_ref;
+    }
+
+    void add_edge(edge_type label, node_index target)
+    {
+        edges.emplace_back(label, target);
+    }
+};
+
+template <typename node_index>
+class Graph
+{
+private:
+    std::vector<Node<node_index>> nodes;
+
+    Graph(Graph &)
+    {
+    }
+
+public:
+    Graph()
+    {
+    }
+    node_index add_vertex()
+    {
+        nodes.emplace_back();
+        return nodes.size() - 1;
+    }
+    void resize(node_index vertex_count)
+    {
+        nodes.resize(vertex_count);
+    }
+
+    std::vector<Node<node_index>>& get_nodes()
+    {
+        std::vector<Node<node_index>> & nodes_ref = nodes;
+        return nodes_ref;
+    }
+    inline node_index size()
+    {
+        return nodes.size();
+    }
+#ifdef CREATE_REVERSE_INDEX
+    std::vector<std::vector<node_index>> reverse;
+
+    void compute_reverse_index()
+    {
+        if (!this->reverse.empty())
+        {
+            throw MyException("computing the reverse while this has been computed before. Probably a programming error");
+        }
+        size_t number_of_nodes = this->nodes.size();
+        // we create it first with sets to remove duplicates
+        std::vector<boost::unordered_flat_set<node_index>> unique_index(number_of_nodes);
+        for (node_index sourceID = 0; sourceID < number_of_nodes; sourceID++)
+        {
+            Node<node_index> &node = this->nodes[sourceID];
+            for (const Edge<node_index> edge : node.get_outgoing_edges())
+            {
+                node_index targetID = edge.target;
+                unique_index[targetID].insert(sourceID);
+            }
+        }
+        // now convert to the final index
+        this->reverse.resize(number_of_nodes);
+        for (node_index targetID = 0; targetID < number_of_nodes; targetID++)
+        {
+            for (const node_index &sourceID : unique_index[targetID])
+            {
+                this->reverse[targetID].push_back(sourceID);
+            }
+            // minimize memory usage
+            this->reverse[targetID].shrink_to_fit();
+        }
+    }
+#endif
+
+    /**
+     * Renumbers the nodes such that the new node i is the old node new_to_old[i].
+     * The edges (and the reverse index) are translated to the new node indices.
+     */
+    void renumber(const std::vector<node_index> &new_to_old)
+    {
+        size_t number_of_nodes = this->nodes.size();
+        if (new_to_old.size() != number_of_nodes)
+        {
+            throw MyException("The renumbering does not have the same size as the graph. Probably a programming error");
+        }
+        std::vector<node_index> old_to_new(number_of_nodes);
+        for (node_index new_id = 0; new_id < number_of_nodes; new_id++)
+        {
+            old_to_new[new_to_old[new_id]] = new_id;
+        }
+
+        std::vector<Node<node_index>> renumbered_nodes(number_of_nodes);
+        for (node_index new_id = 0; new_id < number_of_nodes; new_id++)
+        {
+            std::vector<Edge<node_index>> &old_edges = this->nodes[new_to_old[new_id]].get_outgoing_edges();
+            Node<node_index> &renumbered_node = renumbered_nodes[new_id];
+            renumbered_node.get_outgoing_edges().reserve(old_edges.size());
+            for (const Edge<node_index> edge : old_edges)
+            {
+                renumbered_node.add_edge(edge.label, old_to_new[edge.target]);
+            }
+            // Free the old edges right away, to limit the peak memory usage
+            std::vector<Edge<node_index>>().swap(old_edges);
+        }
+        this->nodes.swap(renumbered_nodes);
+
+#ifdef CREATE_REVERSE_INDEX
+        if (!this->reverse.empty())
+        {
+            std::vector<std::vector<node_index>> renumbered_reverse(number_of_nodes);
+            for (node_index new_id = 0; new_id < number_of_nodes; new_id++)
+            {
+                std::vector<node_index> &old_sources = this->reverse[new_to_old[new_id]];
+                std::vector<node_index> &renumbered_sources = renumbered_reverse[new_id];
+                renumbered_sources.reserve(old_sources.size());
+                for (node_index old_source : old_sources)
+                {
+                    renumbered_sources.push_back(old_to_new[old_source]);
+                }
+                std::vector<node_index>().swap(old_sources);
+            }
+            this->reverse.swap(renumbered_reverse);
+        }
+#endif
+    }
+};
+
+template <typename T>
+class IDMapper
+{
+    boost::unordered_flat_map<std::string, T> mapping;
+
+public:
+    IDMapper() : mapping(10000000)
+    {
+    }
+
+    T getID(std::string &stringID)
+    {
+        T potentially_new = mapping.size();
+        // std::pair<boost::unordered_flat_map<std::string, T>::const_iterator, bool>
+        auto result = mapping.try_emplace(stringID, potentially_new);
+        T the_id = (*result.first).second;
+        return the_id;
+    }
+
+    // template <class Stream>
+    void dump(std::ostream &out)
+    {
+        for (auto a = this->mapping.cbegin(); a != this->mapping.cend(); a++)
+        {
+            std::string str(a->first);
+            T id = a->second;
+            out << str << " " << id << '\n';
+        }
+        out.flush();
+    }
+
+    void dump_to_file(const std::string &filename)
+    {
+        std::ofstream mapping_out(filename, std::ios::trunc);
+        if (!mapping_out.is_open())
+        {
+            throw MyException("Opening the file to dump to failed");
+        }
+        this->dump(mapping_out);
+        mapping_out.close();
+    }
+};
+
+/**
+ * Decides, based on their predicate, which triples are used for the bisimulation.
+ * The predicates are listed as IRIs (one per line) and resolved through the rel2ID.txt file written by the preprocessor.
+ * Either only the listed predicates are kept (an allow-list), or the listed predicates are ignored (a deny-list).
+ * The default filter keeps every triple.
+ */
+class PredicateFilter
+{
+private:
+    boost::dynamic_bitset<> listed;
+    bool allow_list;
+    bool active;
+
+    void read_predicates(std::istream &rel2ID_stream, const std::string &predicates_file)
+    {
+        boost::unordered_flat_map<std::string, edge_type> predicate_to_id;
+        std::string line;
+        while (std::getline(rel2ID_stream, line))
+        {
+            // The ID follows the last space, the IRI itself should not contain spaces
+            std::size_t separator = line.rfind(' ');
+            if (separator == std::string::npos)
+            {
+                continue;
+            }
+            predicate_to_id[line.substr(0, separator)] = std::stoul(line.substr(separator + 1));
+        }
+
+        std::ifstream predicates_stream(predicates_file);
+        if (!predicates_stream.is_open())
+        {
+            throw MyException("Could not open the file with predicates to filter on: " + predicates_file);
+        }
+        while (std::getline(predicates_stream, line))
+        {
+            boost::trim(line);
+            // The IRIs may be written with or without angle brackets, rel2ID.txt stores them without
+            if (line.size() >= 2 && line.front() == '<' && line.back() == '>')
+            {
+                line = line.substr(1, line.size() - 2);
+            }
+            if (line.empty())
+            {
+                continue;
+            }
+            auto predicate_iter = predicate_to_id.find(line);
+            if (predicate_iter == predicate_to_id.end())
+            {
+                std::cout << "Warning: the predicate " << line << " does not occur in the graph" << std::endl;
+                continue;
+            }
+            edge_type predicate = predicate_iter->second;
+            if (predicate >= this->listed.size())
+            {
+                this->listed.resize(predicate + 1);
+            }
+            this->listed.set(predicate);
+        }
+    }
+
+public:
+    PredicateFilter() : allow_list(false), active(false)
+    {
+    }
+
+    PredicateFilter(const std::string &rel2ID_file, const std::string &predicates_file, bool allow_list) : allow_list(allow_list), active(true)
+    {
+        std::ifstream rel2ID_stream(rel2ID_file);
+        if (!rel2ID_stream.is_open())
+        {
+            throw MyException("Could not open the predicate IDs (" + rel2ID_file + ") needed to resolve the predicates to filter on");
+        }
+        this->read_predicates(rel2ID_stream, predicates_file);
+    }
+
+    // The predicate IDs are read in the rel2ID.txt format, lod_pipeline passes them from memory
+    PredicateFilter(std::istream &rel2ID_stream, const std::string &predicates_file, bool allow_list) : allow_list(allow_list), active(true)
+    {
+        this->read_predicates(rel2ID_stream, predicates_file);
+    }
+
+    bool is_active() const
+    {
+        return this->active;
+    }
+
+    bool is_allow_list() const
+    {
+        return this->allow_list;
+    }
+
+    inline bool keeps(edge_type predicate) const
+    {
+        bool is_listed = predicate < this->listed.size() && this->listed[predicate];
+        return is_listed == this->allow_list;
+    }
+};
+
+inline void write_uint_BLOCK_little_endian(std::ostream &outputstream, int64_t value)
+{
+    char data[BYTES_PER_BLOCK];
+    for (unsigned int i = 0; i < BYTES_PER_BLOCK; i++)
+    {
+        data[i] = char(value & 0x00000000000000FFull);
+        value = value >> 8;
+    }
+    outputstream.write(data, BYTES_PER_BLOCK);
+    if (outputstream.fail())
+    {
+        std::cout << "Write block failed with code: " << outputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << outputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << outputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (outputstream.fail() && !outputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << outputstream.bad() << std::endl;
+        exit(outputstream.rdstate());
+    }
+}
+
+inline void write_uint_ENTITY_little_endian(std::ostream &outputstream, int64_t value)
+{
+    char data[BYTES_PER_ENTITY];
+    for (unsigned int i = 0; i < BYTES_PER_ENTITY; i++)
+    {
+        data[i] = char(value & 0x00000000000000FFull);
+        value = value >> 8;
+    }
+    outputstream.write(data, BYTES_PER_ENTITY);
+    if (outputstream.fail())
+    {
+        std::cout << "Write entity failed with code: " << outputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << outputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << outputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (outputstream.fail() && !outputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << outputstream.bad() << std::endl;
+        exit(outputstream.rdstate());
+    }
+}
+
+inline void write_uint_PREDICATE_little_endian(std::ostream &outputstream, u_int32_t value)
+{
+    char data[BYTES_PER_PREDICATE];
+    for (unsigned int i = 0; i < BYTES_PER_PREDICATE; i++)
+    {
+        data[i] = char(value & 0x00000000000000FFull);
+        value = value >> 8;
+    }
+    outputstream.write(data, BYTES_PER_PREDICATE);
+    if (outputstream.fail())
+    {
+        std::cout << "Write predicate failed with code: " << outputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << outputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << outputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (outputstream.fail() && !outputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << outputstream.bad() << std::endl;
+        exit(outputstream.rdstate());
+    }
+}
+
+inline void write_int_BLOCK_OR_SINGLETON_little_endian(std::ostream &outputstream, int64_t value)
+{
+    char data[BYTES_PER_BLOCK_OR_SINGLETON];
+    for (unsigned int i = 0; i < BYTES_PER_BLOCK_OR_SINGLETON; i++)
+    {
+        data[i] = char(value & 0x00000000000000FFull);
+        value = value >> 8;
+    }
+    outputstream.write(data, BYTES_PER_BLOCK_OR_SINGLETON);
+    if (outputstream.fail())
+    {
+        std::cout << "Write block or singleton failed with code: " << outputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << outputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << outputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (outputstream.fail() && !outputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << outputstream.bad() << std::endl;
+        exit(outputstream.rdstate());
+    }
+}
+
+inline void write_uint_K_TYPE_little_endian(std::ostream &outputstream, u_int16_t value)
+{
+    char data[BYTES_PER_K_TYPE];
+    for (unsigned int i = 0; i < BYTES_PER_K_TYPE; i++)
+    {
+        data[i] = char(value & 0x00000000000000FFull);
+        value = value >> 8;
+    }
+    outputstream.write(data, BYTES_PER_K_TYPE);
+    if (outputstream.fail())
+    {
+        std::cout << "Write k failed with code: " << outputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << outputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << outputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (outputstream.fail() && !outputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << outputstream.bad() << std::endl;
+        exit(outputstream.rdstate());
+    }
+}
+
+inline void write_uint_OFFSET_little_endian(std::ostream &outputstream, u_int64_t value)
+{
+    char data[BYTES_PER_OFFSET];
+    for (unsigned int i = 0; i < BYTES_PER_OFFSET; i++)
+    {
+        data[i] = char(value & 0x00000000000000FFull);
+        value = value >> 8;
+    }
+    outputstream.write(data, BYTES_PER_OFFSET);
+    if (outputstream.fail())
+    {
+        std::cout << "Write offset failed with code: " << outputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << outputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << outputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (outputstream.fail() && !outputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << outputstream.bad() << std::endl;
+        exit(outputstream.rdstate());
+    }
+}
+
+inline u_int64_t read_uint_ENTITY_little_endian(std::istream &inputstream)
+{
+    char data[8];
+    inputstream.read(data, BYTES_PER_ENTITY);
+    if (inputstream.eof())
+    {
+        return UINT64_MAX;
+    }
+    if (inputstream.fail())
+    {
+        std::cout << "Read entity failed with code: " << inputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << inputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << inputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (inputstream.fail() && !inputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << inputstream.bad() << std::endl;
+        exit(inputstream.rdstate());
+    }
+    u_int64_t result = uint64_t(0);
+
+    for (unsigned int i = 0; i < BYTES_PER_ENTITY; i++)
+    {
+        result |= (uint64_t(data[i]) & 255) << (i * 8); // `& 255` makes sure that we only write one byte of data
+    }
+    return result;
+}
+
+inline u_int32_t read_PREDICATE_little_endian(std::istream &inputstream)
+{
+    char data[4];
+    inputstream.read(data, BYTES_PER_PREDICATE);
+    if (inputstream.eof())
+    {
+        return UINT32_MAX;
+    }
+    if (inputstream.fail())
+    {
+        std::cout << "Read predicate failed with code: " << inputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << inputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << inputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (inputstream.fail() && !inputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << inputstream.bad() << std::endl;
+        exit(inputstream.rdstate());
+    }
+    u_int32_t result = uint32_t(0);
+
+    for (unsigned int i = 0; i < BYTES_PER_PREDICATE; i++)
+    {
+        result |= (uint32_t(data[i]) & 255) << (i * 8); // `& 255` makes sure that we only write one byte of data
+    }
+    return result;
+}
+
+inline u_int64_t read_uint_BLOCK_little_endian(std::istream &inputstream)
+{
+    char data[8];
+    inputstream.read(data, BYTES_PER_BLOCK);
+    if (inputstream.eof())
+    {
+        return UINT64_MAX;
+    }
+    if (inputstream.fail())
+    {
+        std::cout << "Read block failed with code: " << inputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << inputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << inputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (inputstream.fail() && !inputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << inputstream.bad() << std::endl;
+        exit(inputstream.rdstate());
+    }
+    u_int64_t result = u_int64_t(0);
+
+    for (unsigned int i = 0; i < BYTES_PER_BLOCK; i++)
+    {
+        result |= (u_int64_t(data[i]) & 0x00000000000000FFull) << (i * 8); // `& 0x00000000000000FFull` makes sure that we only write one byte of data
+    }
+    return result;
+}
+
+template <typename clock>
+class StopWatch
+{
+    struct Step
+    {
+        const std::string name;
+        const clock::duration duration;
+        const int memory_in_kb;
+        const bool newline;
+        Step(const std::string &name, const clock::duration &duration, const int &memory_in_kb, const bool &newline)
+            : name(name), duration(duration), memory_in_kb(memory_in_kb), newline(newline)
+        {
+        }
+        Step(const Step &step)
+            : name(step.name), duration(step.duration), memory_in_kb(step.memory_in_kb), newline(step.newline)
+        {
+        }
+    };
+
+private:
+    std::vector<StopWatch::Step> steps;
+    bool started;
+    bool paused;
+    clock::time_point last_starting_time;
+    std::string current_step_name;
+    clock::duration stored_at_last_pause;
+    bool newline;
+
+    StopWatch()
+    {
+    }
+
+    static int current_memory_use_in_kb()
+    {
+        std::ifstream procfile("/proc/self/status");
+        std::string line;
+        while (std::getline(procfile, line))
+        {
+            if (line.rfind("VmRSS:", 0) == 0)
+            {
+                // split in 3 pieces
+                std::vector<std::string> parts;
+                boost::split(parts, line, boost::is_any_of("\t "), boost::token_compress_on);
+                // check that we have exactly thee parts
+                if (parts.size() != 3)
+                {
+                    throw MyException("The line with VmRSS: did not split in 3 parts on whitespace");
+                }
+                if (parts[2] != "kB")
+                {
+                    throw MyException("The line with VmRSS: did not end in kB");
+                }
+                int size = std::stoi(parts[1]);
+                procfile.close();
+                return size;
+            }
+        }
+        throw MyException("fail. could not find VmRSS");
+    }
+
+public:
+    static StopWatch create_started()
+    {
+        StopWatch c = create_not_started();
+        c.start_step("start");
+        return c;
+    }
+
+    static StopWatch create_not_started()
+    {
+        StopWatch c;
+        c.started = false;
+        c.paused = false;
+        c.newline = false;
+        return c;
+    }
+
+    void pause()
+    {
+        if (!this->started)
+        {
+            throw MyException("Cannot pause not running StopWatch, start it first");
+        }
+        if (this->paused)
+        {
+            throw MyException("Cannot pause paused StopWatch, resume it first");
+        }
+        this->stored_at_last_pause += clock::now() - last_starting_time;
+        this->paused = true;
+    }
+
+    void resume()
+    {
+        if (!this->started)
+        {
+            throw MyException("Cannot resume not running StopWatch, start it first");
+        }
+        if (!this->paused)
+        {
+            throw MyException("Cannot resume not paused StopWatch, pause it first");
+        }
+        this->last_starting_time = clock::now();
+        this->paused = false;
+    }
+
+    void start_step(std::string name, bool newline = false)
+    {
+        if (this->started)
+        {
+            throw MyException("Cannot start on running StopWatch, stop it first");
+        }
+        if (this->paused)
+        {
+            throw MyException("This must never happen. Invariant is wrong. If stopped, there can be no pause active.");
+        }
+        this->last_starting_time = clock::now();
+        this->current_step_name = name;
+        this->started = true;
+        this->newline = newline;
+    }
+
+    void stop_step()
+    {
+        if (!this->started)
+        {
+            throw MyException("Cannot stop not running StopWatch, start it first");
+        }
+        if (this->paused)
+        {
+            throw MyException("Cannot stop not paused StopWatch, unpause it first");
+        }
+        auto stop_time = clock::now();
+        auto total_duration = (stop_time - this->last_starting_time) + this->stored_at_last_pause;
+        // For measuring memory, we sleep 100ms to give the os time to reclaim memory
+        // std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        int memory_use = current_memory_use_in_kb();
+
+        this->steps.emplace_back(this->current_step_name, total_duration, memory_use, this->newline);
+        this->started = false;
+        this->newline = false;
+    }
+
+    std::string to_string()
+    {
+        if (this->started)
+        {
+            throw MyException("Cannot convert a running StopWatch to a string, stop it first");
+        }
+        std::stringstream out;
+        for (auto step : this->get_times())
+        {
+            out << "Step: " << step.name << ", time = " << boost::chrono::ceil<boost::chrono::milliseconds>(step.duration).count() << " ms"
+                << ", memory = " << step.memory_in_kb << " kB"
+                << "\n";
+            if (step.newline)
+            {
+                out << "\n";
+            }
+        }
+        // Create the output string and remove the final superfluous '\n' characters
+        std::string out_str = out.str();
+        boost::trim(out_str);
+        return out_str;
+    }
+
+    std::vector<StopWatch::Step>& get_times()
+    {
+        std::vector<StopWatch::Step> & steps_ref = this->steps;
+        return steps_ref;
+    }
+};
+
+/**
+ * Samples the resident set size of this process in a background thread and remembers whether it ever exceeded the budget.
+ * Exceeding the budget does not interrupt anything, the refinement checks is_exceeded() between levels.
+ * A budget of 0 means that there is no budget, in which case no thread is started.
+ */
+class MemoryBudgetWatcher
+{
+private:
+    const int64_t budget_in_kb;
+    std::atomic<bool> exceeded;
+    bool stopping;
+    std::mutex stopping_mutex;
+    std::condition_variable stopping_condition;
+    std::thread watcher;
+
+    MemoryBudgetWatcher(MemoryBudgetWatcher &) = delete; // no copies
+
+    static int64_t current_rss_in_kb()
+    {
+        // The second value in statm is the resident set size in pages, this is cheaper to read than /proc/self/status
+        std::ifstream statm("/proc/self/statm");
+        int64_t size_in_pages;
+        int64_t resident_in_pages;
+        statm >> size_in_pages >> resident_in_pages;
+        return resident_in_pages * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    void watch(std::chrono::milliseconds interval)
+    {
+        std::unique_lock<std::mutex> lock(this->stopping_mutex);
+        while (!this->stopping)
+        {
+            if (current_rss_in_kb() > this->budget_in_kb)
+            {
+                this->exceeded = true;
+            }
+            this->stopping_condition.wait_for(lock, interval, [this] { return this->stopping; });
+        }
+    }
+
+public:
+    MemoryBudgetWatcher(int64_t budget_in_kb, std::chrono::milliseconds interval = std::chrono::milliseconds(100))
+        : budget_in_kb(budget_in_kb), exceeded(false), stopping(false)
+    {
+        if (budget_in_kb > 0)
+        {
+            this->watcher = std::thread(&MemoryBudgetWatcher::watch, this, interval);
+        }
+    }
+
+    ~MemoryBudgetWatcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->stopping_mutex);
+            this->stopping = true;
+        }
+        this->stopping_condition.notify_all();
+        if (this->watcher.joinable())
+        {
+            this->watcher.join();
+        }
+    }
+
+    bool is_exceeded() const
+    {
+        return this->exceeded;
+    }
+};
+
+/**
+ * Reads the binary encoded graph and returns the number of edges that were kept.
+ * Triples whose predicate is not kept by the filter are left out (their subject and object still become vertices), these are counted in ignored_edge_count.
+ */
+template <typename node_index>
+u_int64_t read_graph_from_stream_timed(std::istream &inputstream, Graph<node_index> &g, const PredicateFilter &filter, u_int64_t &ignored_edge_count)
+{
+    StopWatch<boost::chrono::process_cpu_clock> w = StopWatch<boost::chrono::process_cpu_clock>::create_not_started();
+
+    const int BufferSize = 8 * 16184;
+
+    char _buffer[BufferSize];
+
+    inputstream.rdbuf()->pubsetbuf(_buffer, BufferSize);
+
+    w.start_step("Reading graph");
+    u_int64_t edge_count = 0;
+
+    auto t_start{boost::chrono::system_clock::now()};
+    auto time_t_start{boost::chrono::system_clock::to_time_t(t_start)};
+    std::tm *ptm_start{std::localtime(&time_t_start)};
+
+    std::cout << std::put_time(ptm_start, "%Y/%m/%d %H:%M:%S") << " Reading started" << std::endl;
+    while (true)
+    {
+        // subject
+        // node_index subject_index = node_ID_Mapper.getID(parts[0]);
+        node_index subject_index = read_uint_ENTITY_little_endian(inputstream);
+
+        // edge
+        // edge_type edge_label = edge_ID_Mapper.getID(parts[1]);
+        edge_type edge_label = read_PREDICATE_little_endian(inputstream);
+
+        // object
+        // node_index object_index = node_ID_Mapper.getID(parts[2]);
+        node_index object_index = read_uint_ENTITY_little_endian(inputstream);
+
+        // Break when the last valid values have been read
+        if (inputstream.eof())
+        {
+            break;
+        }
+        // std::cout << subject_index << " " << edge_label <<  " " << object_index << std::endl;
+
+        // Add Nodes
+        // while (subject_index >= g.get_nodes().size())
+        // {
+        //     g.add_vertex();
+        // }
+        // while (object_index >= g.get_nodes().size())
+        // {
+        //     g.add_vertex();
+        // }
+        node_index largest = std::max(subject_index, object_index);
+        if (largest >= g.size())
+        {
+            g.resize(largest + 1);
+        }
+
+        if (!filter.keeps(edge_label))
+        {
+            ignored_edge_count++;
+            continue;
+        }
+
+        g.get_nodes()[subject_index].add_edge(edge_label, object_index);
+        // also add reverse
+        // g.get_nodes()[object_index].add_edge(edge_label, subject_index);
+
+        if (edge_count % 1000000 == 0)
+        {
+            auto now{boost::chrono::system_clock::to_time_t(boost::chrono::system_clock::now())};
+            std::tm *ptm{std::localtime(&now)};
+            std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S") << " done with " << edge_count << " triples" << std::endl;
+        }
+        edge_count++;
+    }
+    w.stop_step();
+
+    auto t_reading_done{boost::chrono::system_clock::now()};
+    auto time_t_reading_done{boost::chrono::system_clock::to_time_t(t_reading_done)};
+    std::tm *ptm_reading_done{std::localtime(&time_t_reading_done)};
+
+    std::cout << std::put_time(ptm_reading_done, "%Y/%m/%d %H:%M:%S")
+              << " Time taken for reading = " << boost::chrono::ceil<boost::chrono::milliseconds>(t_reading_done - t_start).count()
+              << " ms, memory = " << w.get_times()[0].memory_in_kb << " kB" << std::endl;
+    if (filter.is_active())
+    {
+        std::cout << std::put_time(ptm_reading_done, "%Y/%m/%d %H:%M:%S")
+                  << " Kept " << edge_count << " triples, ignored " << ignored_edge_count << " triples based on their predicate" << std::endl;
+    }
+#ifdef CREATE_REVERSE_INDEX
+    w.start_step("Creating reverse index");
+    g.compute_reverse_index();
+    w.stop_step();
+
+    auto t_reverse_index_done{boost::chrono::system_clock::now()};
+    auto time_t_reverse_index_done{boost::chrono::system_clock::to_time_t(t_reverse_index_done)};
+    std::tm *ptm_reverse_index_done{std::localtime(&time_t_reverse_index_done)};
+
+    std::cout << std::put_time(ptm_reverse_index_done, "%Y/%m/%d %H:%M:%S")
+              << " Time taken for creating reverse index = " << boost::chrono::ceil<boost::chrono::milliseconds>(t_reverse_index_done - t_reading_done).count()
+              << " ms, memory = " << w.get_times()[1].memory_in_kb << " kB" << std::endl;
+#endif
+    return edge_count;
+}
+
+template <typename node_index>
+u_int64_t read_graph_timed(const std::string &filename, Graph<node_index> &g, const PredicateFilter &filter, u_int64_t &ignored_edge_count)
+{
+
+    std::ifstream infile(filename, std::ifstream::in);
+    u_int64_t edge_count = read_graph_from_stream_timed(infile, g, filter, ignored_edge_count);
+    return edge_count;
+}
+
+/**
+ * Reads the graph of a previous experiment and applies a delta to it. The removed triples are left out and the added triples are appended.
+ * The resulting graph is also written to `updated_graph_file`, such that later stages can use it like any other binary encoding.
+ * The subjects of all added and (actually) removed triples are collected in `touched_nodes`, as these are the only nodes whose outgoing edges changed.
+ */
+template <typename node_index>
+u_int64_t read_graph_with_delta_timed(const std::string &graph_file,
+                                      const std::string &added_file,
+                                      const std::string &removed_file,
+                                      const std::string &updated_graph_file,
+                                      Graph<node_index> &g,
+                                      node_index &previous_graph_size,
+                                      boost::unordered_flat_set<node_index> &touched_nodes)
+{
+    StopWatch<boost::chrono::process_cpu_clock> w = StopWatch<boost::chrono::process_cpu_clock>::create_not_started();
+
+    auto t_start{boost::chrono::system_clock::now()};
+    auto time_t_start{boost::chrono::system_clock::to_time_t(t_start)};
+    std::tm *ptm_start{std::localtime(&time_t_start)};
+
+    std::cout << std::put_time(ptm_start, "%Y/%m/%d %H:%M:%S") << " Reading started" << std::endl;
+
+    w.start_step("Reading removed triples");
+    using triple_t = std::pair<node_index, std::pair<edge_type, node_index>>;
+    boost::unordered_flat_set<triple_t> removed_triples;
+    if (removed_file != "")
+    {
+        std::ifstream removed_stream(removed_file, std::ifstream::in);
+        if (!removed_stream.is_open())
+        {
+            throw MyException("Could not open the file with removed triples: " + removed_file);
+        }
+        while (true)
+        {
+            node_index subject_index = read_uint_ENTITY_little_endian(removed_stream);
+            edge_type edge_label = read_PREDICATE_little_endian(removed_stream);
+            node_index object_index = read_uint_ENTITY_little_endian(removed_stream);
+            if (removed_stream.eof())
+            {
+                break;
+            }
+            removed_triples.emplace(subject_index, std::make_pair(edge_label, object_index));
+        }
+    }
+    w.stop_step();
+
+    // The graph is written next to its final location and only renamed once it is complete, a truncated graph would otherwise be read as a valid one by the next incremental run
+    std::string partial_graph_file = updated_graph_file + ".partial";
+    std::ofstream updated_graph_stream(partial_graph_file, std::ios::trunc);
+    if (!updated_graph_stream.is_open())
+    {
+        throw MyException("Could not open the updated graph for writing: " + partial_graph_file);
+    }
+    u_int64_t edge_count = 0;
+    u_int64_t removed_count = 0;
+    u_int64_t added_count = 0;
+
+    w.start_step("Reading graph");
+    std::ifstream graph_stream(graph_file, std::ifstream::in);
+    if (!graph_stream.is_open())
+    {
+        throw MyException("Could not open the graph of the previous experiment: " + graph_file);
+    }
+    while (true)
+    {
+        node_index subject_index = read_uint_ENTITY_little_endian(graph_stream);
+        edge_type edge_label = read_PREDICATE_little_endian(graph_stream);
+        node_index object_index = read_uint_ENTITY_little_endian(graph_stream);
+        if (graph_stream.eof())
+        {
+            break;
+        }
+
+        // The graph keeps the size of the previous experiment, even if a node loses all its edges
+        node_index largest = std::max(subject_index, object_index);
+        if (largest >= g.size())
+        {
+            g.resize(largest + 1);
+        }
+
+        if (removed_triples.contains(std::make_pair(subject_index, std::make_pair(edge_label, object_index))))
+        {
+            touched_nodes.emplace(subject_index);
+            removed_count++;
+            continue;
+        }
+        g.get_nodes()[subject_index].add_edge(edge_label, object_index);
+        write_uint_ENTITY_little_endian(updated_graph_stream, subject_index);
+        write_uint_PREDICATE_little_endian(updated_graph_stream, edge_label);
+        write_uint_ENTITY_little_endian(updated_graph_stream, object_index);
+        edge_count++;
+    }
+    previous_graph_size = g.size();
+    w.stop_step();
+
+    w.start_step("Reading added triples");
+    if (added_file != "")
+    {
+        std::ifstream added_stream(added_file, std::ifstream::in);
+        if (!added_stream.is_open())
+        {
+            throw MyException("Could not open the file with added triples: " + added_file);
+        }
+        while (true)
+        {
+            node_index subject_index = read_uint_ENTITY_little_endian(added_stream);
+            edge_type edge_label = read_PREDICATE_little_endian(added_stream);
+            node_index object_index = read_uint_ENTITY_little_endian(added_stream);
+            if (added_stream.eof())
+            {
+                break;
+            }
+            node_index largest = std::max(subject_index, object_index);
+            if (largest >= g.size())
+            {
+                g.resize(largest + 1);
+            }
+            g.get_nodes()[subject_index].add_edge(edge_label, object_index);
+            write_uint_ENTITY_little_endian(updated_graph_stream, subject_index);
+            write_uint_PREDICATE_little_endian(updated_graph_stream, edge_label);
+            write_uint_ENTITY_little_endian(updated_graph_stream, object_index);
+            touched_nodes.emplace(subject_index);
+            edge_count++;
+            added_count++;
+        }
+    }
+    updated_graph_stream.close();
+    if (!updated_graph_stream)
+    {
+        std::filesystem::remove(partial_graph_file);
+        throw MyException("Could not write the updated graph: " + partial_graph_file);
+    }
+    std::filesystem::rename(partial_graph_file, updated_graph_file);
+    w.stop_step();
+
+    auto t_reading_done{boost::chrono::system_clock::now()};
+    auto time_t_reading_done{boost::chrono::system_clock::to_time_t(t_reading_done)};
+    std::tm *ptm_reading_done{std::localtime(&time_t_reading_done)};
+
+    std::cout << std::put_time(ptm_reading_done, "%Y/%m/%d %H:%M:%S")
+              << " Time taken for reading = " << boost::chrono::ceil<boost::chrono::milliseconds>(t_reading_done - t_start).count()
+              << " ms, memory = " << w.get_times().back().memory_in_kb << " kB" << std::endl;
+    std::cout << std::put_time(ptm_reading_done, "%Y/%m/%d %H:%M:%S")
+              << " Removed " << removed_count << " triples (" << removed_triples.size() << " requested), added " << added_count
+              << " triples, " << touched_nodes.size() << " nodes have changed outgoing edges" << std::endl;
+#ifdef CREATE_REVERSE_INDEX
+    w.start_step("Creating reverse index");
+    g.compute_reverse_index();
+    w.stop_step();
+
+    auto t_reverse_index_done{boost::chrono::system_clock::now()};
+    auto time_t_reverse_index_done{boost::chrono::system_clock::to_time_t(t_reverse_index_done)};
+    std::tm *ptm_reverse_index_done{std::localtime(&time_t_reverse_index_done)};
+
+    std::cout << std::put_time(ptm_reverse_index_done, "%Y/%m/%d %H:%M:%S")
+              << " Time taken for creating reverse index = " << boost::chrono::ceil<boost::chrono::milliseconds>(t_reverse_index_done - t_reading_done).count()
+              << " ms, memory = " << w.get_times().back().memory_in_kb << " kB" << std::endl;
+#else
+    throw MyException("The incremental bisimulation requires the reverse index (CREATE_REVERSE_INDEX)");
+#endif
+    return edge_count;
+}
+
+const std::vector<std::string> RENUMBERING_STRATEGIES = {"none", "bfs", "rcm", "type_set"};
+
+/**
+ * Computes an order of the nodes (new_to_old[i] is the old index of the new node i) that is meant to improve the memory locality of the refinement.
+ * - bfs: breadth-first over the undirected graph, starting a new search from the lowest unvisited index
+ * - rcm: reverse Cuthill-McKee, i.e. breadth-first over the undirected graph from low degree nodes, visiting neighbours by increasing degree, with the final order reversed
+ * - type_set: nodes with the same rdf:type set (i.e. the same block for the typed start) are placed next to each other
+ */
+template <typename node_index>
+std::vector<node_index> compute_renumbering(Graph<node_index> &g, const std::string &strategy)
+{
+    node_index number_of_nodes = g.size();
+    std::vector<Node<node_index>> &nodes = g.get_nodes();
+    std::vector<node_index> new_to_old;
+    new_to_old.reserve(number_of_nodes);
+
+    if (strategy == "type_set")
+    {
+        // Give each type set an index in the order in which it is first encountered, then do a counting sort on these indices
+        boost::unordered_flat_map<set_of_types, node_index> type_set_indices;
+        std::vector<node_index> node_type_set(number_of_nodes);
+        std::vector<node_index> type_set_counts;
+        for (node_index node = 0; node < number_of_nodes; node++)
+        {
+            set_of_types set_of_types_of_node;
+            for (const Edge<node_index> edge : nodes[node].get_outgoing_edges())
+            {
+                if (edge.label == 0) // assumes rdf:type is mapped on 0!!!
+                {
+                    set_of_types_of_node.emplace(edge.target);
+                }
+            }
+            auto result = type_set_indices.try_emplace(set_of_types_of_node, type_set_indices.size());
+            node_index type_set_index = result.first->second;
+            if (result.second)
+            {
+                type_set_counts.push_back(0);
+            }
+            node_type_set[node] = type_set_index;
+            type_set_counts[type_set_index]++;
+        }
+        // Turn the counts into the offset of each type set
+        node_index offset = 0;
+        for (node_index &count : type_set_counts)
+        {
+            node_index type_set_size = count;
+            count = offset;
+            offset += type_set_size;
+        }
+        new_to_old.resize(number_of_nodes);
+        for (node_index node = 0; node < number_of_nodes; node++)
+        {
+            new_to_old[type_set_counts[node_type_set[node]]++] = node;
+        }
+        return new_to_old;
+    }
+
+#ifdef CREATE_REVERSE_INDEX
+    if (strategy == "bfs" || strategy == "rcm")
+    {
+        bool cuthill_mckee = strategy == "rcm";
+        std::vector<node_index> degrees;
+        std::vector<node_index> start_candidates;
+        if (cuthill_mckee)
+        {
+            degrees.resize(number_of_nodes);
+            start_candidates.resize(number_of_nodes);
+            for (node_index node = 0; node < number_of_nodes; node++)
+            {
+                degrees[node] = nodes[node].get_outgoing_edges().size() + g.reverse[node].size();
+                start_candidates[node] = node;
+            }
+            std::stable_sort(start_candidates.begin(), start_candidates.end(),
+                             [&degrees](node_index a, node_index b) { return degrees[a] < degrees[b]; });
+        }
+
+        boost::dynamic_bitset<> visited(number_of_nodes);
+        std::vector<node_index> neighbours;
+        for (node_index candidate = 0; candidate < number_of_nodes; candidate++)
+        {
+            node_index start = cuthill_mckee ? start_candidates[candidate] : candidate;
+            if (visited[start])
+            {
+                continue;
+            }
+            visited.set(start);
+            // new_to_old doubles as the queue of the breadth-first search
+            node_index queue_head = new_to_old.size();
+            new_to_old.push_back(start);
+            while (queue_head < new_to_old.size())
+            {
+                node_index current = new_to_old[queue_head++];
+                neighbours.clear();
+                for (const Edge<node_index> edge : nodes[current].get_outgoing_edges())
+                {
+                    if (!visited[edge.target])
+                    {
+                        visited.set(edge.target);
+                        neighbours.push_back(edge.target);
+                    }
+                }
+                for (node_index source : g.reverse[current])
+                {
+                    if (!visited[source])
+                    {
+                        visited.set(source);
+                        neighbours.push_back(source);
+                    }
+                }
+                if (cuthill_mckee)
+                {
+                    std::stable_sort(neighbours.begin(), neighbours.end(),
+                                     [&degrees](node_index a, node_index b) { return degrees[a] < degrees[b]; });
+                }
+                new_to_old.insert(new_to_old.end(), neighbours.begin(), neighbours.end());
+            }
+        }
+        if (cuthill_mckee)
+        {
+            std::reverse(new_to_old.begin(), new_to_old.end());
+        }
+        return new_to_old;
+    }
+#else
+    if (strategy == "bfs" || strategy == "rcm")
+    {
+        throw MyException("The " + strategy + " renumbering requires the reverse index (CREATE_REVERSE_INDEX)");
+    }
+#endif
+    throw MyException("Unknown renumbering strategy: " + strategy);
+}
+
+/**
+ * Gives the index of a node in the binary encoding, given its index during the refinement.
+ * An empty new_to_old means that the nodes have not been renumbered.
+ */
+template <typename node_index>
+inline node_index original_node_index(const std::vector<node_index> &new_to_old, node_index node)
+{
+    return new_to_old.empty() ? node : new_to_old[node];
+}
+
+template <typename node_index>
+using Block = std::vector<node_index>;
+
+template <typename node_index>
+using BlockPtr = std::shared_ptr<Block<node_index>>;
+
+// this is isolated because it might be faster to use a boost::dynamic_bitset<>
+template <typename node_index>
+class DirtyBlockContainer
+{
+private:
+    using block_index = node_index;
+    boost::unordered_flat_set<block_index> blocks;
+
+public:
+    DirtyBlockContainer() {}
+    void clear()
+    {
+        this->blocks.clear();
+        // deallocate the underlying memory as well
+        this->blocks.rehash(0);
+    }
+    void set_dirty(block_index index)
+    {
+        blocks.emplace(index);
+    }
+
+    typename boost::unordered_flat_set<block_index>::const_iterator cbegin() const
+    {
+        return this->blocks.cbegin();
+    }
+
+    typename boost::unordered_flat_set<block_index>::const_iterator cend() const
+    {
+        return this->blocks.cend();
+    }
+};
+
+template <typename node_index>
+class MappingNode2BlockMapper; // forward declaration
+
+template <typename node_index>
+class Node2BlockMapper
+{ // interface
+public:
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+
+    virtual ~Node2BlockMapper()
+    { /* releases Base's resources */
+    }
+    /**
+     * get_block returns a positive numebr only in case the block really exists.
+     * If it is a singleton, a (singleton specific) negative number will be returned.
+     */
+    virtual block_or_singleton_index get_block(node_index) = 0;
+    virtual void clear() = 0;
+    virtual node_index singleton_count() = 0;
+    virtual std::shared_ptr<MappingNode2BlockMapper<node_index>> modifyable_copy() = 0;
+    virtual size_t freeblock_count() = 0;
+};
+
+template <typename node_index>
+class AllToZeroNode2BlockMapper : public Node2BlockMapper<node_index>
+{
+private:
+    using block_index = node_index;
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+
+    // The highest node index (exclusive)
+    node_index max_node_index;
+
+    AllToZeroNode2BlockMapper(AllToZeroNode2BlockMapper &) {} // no copies
+public:
+    /**
+     * max_node_index is exclusive
+     */
+    AllToZeroNode2BlockMapper(node_index max_node_index) : max_node_index(max_node_index)
+    {
+        if (max_node_index < 2)
+        {
+            throw MyException("The graph has only one, or zero nodes, breaking the precondition for using the AllToZeroNode2BlockMapper. It assumes there will not be any singletons.");
+        }
+    }
+    block_or_singleton_index get_block(node_index n_index) override
+    {
+        if (n_index >= this->max_node_index)
+        {
+            throw MyException("requested an index higher than the max_node_index");
+        }
+        return 0;
+    }
+    void clear() override
+    {
+        // do nothing
+    }
+    std::shared_ptr<MappingNode2BlockMapper<node_index>> modifyable_copy() override
+    {
+        std::vector<block_or_singleton_index> node_to_block(this->max_node_index, 0);
+        node_to_block.shrink_to_fit();
+        std::stack<block_index> emptystack;
+        return std::make_shared<MappingNode2BlockMapper<node_index>>(node_to_block, emptystack, 0);
+    }
+    node_index singleton_count()
+    {
+        return 0;
+    }
+    size_t freeblock_count() override
+    {
+        return 0;
+    }
+};
+
+template <typename node_index>
+class MappingNode2BlockMapper : public Node2BlockMapper<node_index>
+{
+private:
+    using block_index = node_index;
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+
+    std::vector<block_or_singleton_index> node_to_block;
+    uint64_t singleton_counter;
+    MappingNode2BlockMapper(MappingNode2BlockMapper &) {} // No copies
+
+public:
+    MappingNode2BlockMapper(std::vector<block_or_singleton_index> &node_to_block, std::stack<block_index> &freeblock_indices, uint64_t singleton_count) : node_to_block(node_to_block), singleton_counter(singleton_count), freeblock_indices(freeblock_indices) {}
+
+    std::stack<block_index> freeblock_indices;
+
+    size_t freeblock_count() override
+    {
+        return this->freeblock_indices.size();
+    }
+    node_index singleton_count()
+    {
+        return this->singleton_counter;
+    }
+
+    void overwrite_mapping(node_index n_index, block_index b_index)
+    {
+        this->node_to_block.at(n_index) = b_index;
+    }
+
+    block_or_singleton_index get_block(node_index n_index) override
+    {
+        return this->node_to_block.at(n_index);
+    }
+
+    void clear() override
+    {
+        this->node_to_block.clear();
+        this->node_to_block.reserve(0);
+    }
+
+    std::shared_ptr<MappingNode2BlockMapper<node_index>> modifyable_copy() override
+    {
+        std::vector<block_or_singleton_index> new_node_to_block(this->node_to_block);
+        std::stack<block_index> new_freeblock_indices(this->freeblock_indices);
+        return std::make_shared<MappingNode2BlockMapper<node_index>>(new_node_to_block, new_freeblock_indices, this->singleton_counter);
+    }
+
+    /**
+     * Modifies this mapping. Changes the specified node into a singleton. Future calls to get_block for this node will return a negative number
+     */
+    void put_into_singleton(node_index node)
+    {
+        if (node_to_block[node] < 0)
+        {
+            throw MyException("Tried to create a singleton from a node which already was a singleton. This is nearly certainly a mistake in the code.");
+        }
+        this->singleton_counter++;
+        assert(node <= node_index(std::numeric_limits<block_or_singleton_index>::max()));
+        this->node_to_block[node] = -((block_or_singleton_index) node)-1;
+    }
+};
+
+template <typename node_index>
+class Refines_Edge
+{
+public:
+    using block_index = node_index;
+
+    block_index original_block;
+    std::vector<block_index> split_blocks;
+
+    Refines_Edge(block_index original_block, std::vector<block_index> split_blocks)
+    {
+        this->original_block = original_block;
+        this->split_blocks = split_blocks;
+    }
+};
+
+template <typename node_index>
+class Refines_Mapping
+{
+public:
+    using block_index = node_index;
+
+    std::map<block_index, std::vector<block_index>> refines_edges;
+
+    Refines_Mapping()
+    {
+    }
+
+    void add_edge(Refines_Edge<node_index> edge)
+    {
+        this->refines_edges[edge.original_block] = edge.split_blocks;
+    }
+};
+
+template <typename node_index>
+class KBisumulationOutcome
+{
+public:
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+
+    const std::vector<BlockPtr<node_index>> blocks;
+    DirtyBlockContainer<node_index> dirty_blocks;
+    // If the block for the node is not a singleton, this contains the block index.
+    // Otherwise, this will contain a negative number unique for that singleton
+    std::shared_ptr<Node2BlockMapper<node_index>> node_to_block; // can most probably also be an auto_ptr, I don't think these will be shared, but overhead is minimal
+    Refines_Mapping<node_index> k_minus_one_to_k_mapping;
+
+public:
+    KBisumulationOutcome(const std::vector<BlockPtr<node_index>> &blocks,
+                         const DirtyBlockContainer<node_index> &dirty_blocks,
+                         const std::shared_ptr<Node2BlockMapper<node_index>> &node_to_block) : blocks(blocks),
+                                                                                   dirty_blocks(dirty_blocks),
+                                                                                   node_to_block(node_to_block)
+    {
+    }
+
+    void clear_indices()
+    {
+        this->node_to_block->clear();
+        this->dirty_blocks.clear();
+    }
+
+    block_or_singleton_index get_block_ID_for_node(const node_index &node) const
+    {
+        return this->node_to_block->get_block(node);
+    }
+
+    int64_t singleton_block_count()
+    {
+        return this->node_to_block->singleton_count();
+    }
+
+    std::size_t non_singleton_block_count()
+    {
+        std::size_t blocks_allocated = this->blocks.size();
+        std::size_t unused_blocks = this->node_to_block->freeblock_count();
+        return blocks_allocated - unused_blocks;
+    }
+
+    std::size_t total_blocks()
+    {
+        return this->singleton_block_count() + this->non_singleton_block_count();
+    }
+
+    void add_mapping(Refines_Mapping<node_index> mapping)
+    {
+        this->k_minus_one_to_k_mapping = mapping;
+    }
+};
+
+template <typename node_index>
+KBisumulationOutcome<node_index> get_0_bisimulation(Graph<node_index> &g)
+{
+
+    std::vector<BlockPtr<node_index>> new_blocks;
+
+    BlockPtr<node_index> block = std::make_shared<Block<node_index>>();
+
+    std::size_t amount = g.get_nodes().size();
+    block->reserve(amount);
+    for (unsigned int i = 0; i < amount; i++)
+    {
+        block->emplace_back(i);
+    }
+    new_blocks.emplace_back(block);
+
+    std::shared_ptr<AllToZeroNode2BlockMapper<node_index>> node_to_block = std::make_shared<AllToZeroNode2BlockMapper<node_index>>(g.size());
+
+    DirtyBlockContainer<node_index> dirty;
+    dirty.set_dirty(0);
+
+    KBisumulationOutcome<node_index> result(new_blocks, dirty, node_to_block);
+    return result;
+}
+template <typename node_index>
+static BlockPtr<node_index> global_empty_block = std::make_shared<Block<node_index>>();
+
+template <typename node_index>
+KBisumulationOutcome<node_index> get_typed_0_bisimulation(Graph<node_index> &g)
+{
+    using block_index = node_index;
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+
+    // collect the signatures for nodes in the block
+    boost::unordered_flat_map<set_of_types, BlockPtr<node_index>> partition_map;
+    auto nodes = g.get_nodes();
+
+    for (uint64_t i = 0; i < nodes.size(); i++ ){
+        set_of_types set_of_types_of_node;
+        Node<node_index> & node = nodes[i];
+        for (auto edge : node.get_outgoing_edges()){
+            if (edge.label == 0){ // assumes rdf:type is mapped on 0!!!
+                set_of_types_of_node.emplace(edge.target);
+            }
+        }
+
+        node_index i_as_node_index = i;
+        auto partition_map_iterator = partition_map.find(set_of_types_of_node);
+        if (partition_map_iterator == partition_map.cend())
+        {
+            BlockPtr<node_index> block = std::make_shared<Block<node_index>>();
+            partition_map[set_of_types_of_node] = block;
+            partition_map_iterator = partition_map.find(set_of_types_of_node);
+        }
+        auto the_set = partition_map_iterator->first;
+        auto the_block = partition_map_iterator->second;
+        the_block->emplace_back(i_as_node_index);
+    }
+
+    std::vector<block_or_singleton_index> new_node_to_block;
+    new_node_to_block.resize(g.size());
+    std::vector<BlockPtr<node_index>> new_blocks;
+    new_blocks.reserve(partition_map.size());
+
+    int64_t singleton_counter = 0;
+
+    DirtyBlockContainer<node_index> dirty;
+
+    for (auto part : partition_map){
+        auto & block = part.second;
+        if ((*block).size() == 1){
+            // no block, add singleton
+            singleton_counter++;
+            int singleton_index = -singleton_counter;
+            new_node_to_block[(*block)[0]] = singleton_index;
+        } else {
+            //add the block
+            new_blocks.emplace_back(block);
+            int new_block_index = new_blocks.size() - 1;
+            for(auto node: *block){
+                new_node_to_block[node] = new_block_index;
+            }
+            dirty.set_dirty(new_block_index);
+        }
+    }
+    new_node_to_block.shrink_to_fit();
+
+    std::stack<block_index> new_freeblock_indices; // empty
+    auto mapper = std::make_shared<MappingNode2BlockMapper<node_index>>(new_node_to_block, new_freeblock_indices, singleton_counter);
+
+    KBisumulationOutcome<node_index> result(new_blocks, dirty, mapper);
+
+    return result;
+}
+
+template <typename node_index>
+KBisumulationOutcome<node_index> get_k_bisimulation(Graph<node_index> &g, const KBisumulationOutcome<node_index> &k_minus_one_outcome, std::size_t min_support = 1)
+{
+    using block_index = node_index;
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+
+    // we make copies which we will modify
+    std::vector<BlockPtr<node_index>> k_blocks(k_minus_one_outcome.blocks);
+    std::shared_ptr<MappingNode2BlockMapper<node_index>> k_node_to_block = k_minus_one_outcome.node_to_block->modifyable_copy();
+
+    // We collect all nodes from split blocks. In the end we mark all blocks which target these as dirty.
+    boost::unordered_flat_set<node_index> nodes_from_split_blocks;
+
+    // Define a mapping in which we can store the refines edges
+    Refines_Mapping<node_index> refines_edges;
+
+    // we first do dirty blocks of size 2 because if they split, they cause two singletons and a gap (freeblock) in the list of blocks
+    // These freeblocks can be filled if larger blocks are split.
+
+    if (min_support < 2)
+    {
+        for (auto iter = k_minus_one_outcome.dirty_blocks.cbegin(); iter != k_minus_one_outcome.dirty_blocks.cend(); iter++)
+        {
+            block_index dirty_block_index = *iter;
+            BlockPtr<node_index> dirty_block = k_minus_one_outcome.blocks[dirty_block_index];
+            size_t dirty_block_size = dirty_block->size();
+
+            // define the vector to store the new block indices in
+            std::vector<block_index> new_block_indices;
+
+            if (dirty_block_size != 2)
+            {
+                // we deal with this below
+                continue;
+            }
+            // else
+            // we checked above that min_support < 2, so no need to check that here.
+
+            // pair of edge type and target *block*, the block ID can be negative if it is a singleton
+            using signature_t = boost::unordered_flat_set<std::pair<edge_type, block_or_singleton_index>>; //[tuple[HashableEdgeLabel, int]]
+            // collect the signatures for nodes in the block
+            boost::unordered_flat_map<signature_t, Block<node_index>> M;
+            for (auto v_iter = dirty_block->begin(); v_iter != dirty_block->end(); v_iter++)
+            {
+                node_index v = *v_iter;
+                signature_t signature;
+                for (Edge<node_index> edge_info : g.get_nodes()[v].get_outgoing_edges())
+                {
+                    block_or_singleton_index to_block = k_minus_one_outcome.get_block_ID_for_node(edge_info.target);
+                    signature.emplace(edge_info.label, to_block);
+                }
+                // try_emplace returns an iterator to a new element if there was nothing yet, otherwise to the existing one
+                auto empl_res = M.try_emplace(signature);
+                (*(empl_res.first)).second.emplace_back(v);
+            }
+            // if the block is not refined
+            if (M.size() == 1)
+            {
+                // no need to update anything in the blocks, nor in the index
+                continue;
+            }
+            // else form two singletons and mark the block as free
+            for (auto &signature_blocks : M)
+            {
+                if (signature_blocks.second.size() != 1)
+                {
+                    throw MyException("invariant violation");
+                }
+                node_index the_node = *(signature_blocks.second.cbegin());
+                k_node_to_block->put_into_singleton(the_node);
+                nodes_from_split_blocks.emplace(the_node);
+            }
+            k_blocks[dirty_block_index] = global_empty_block<node_index>;
+            k_node_to_block->freeblock_indices.push(dirty_block_index);
+            // Add the split to the refines edges. Here 0 is used to indicates some (in this case all) nodes became singletons
+            new_block_indices.push_back(0);
+            // Add 1 to the dirty block index to be consistent with the new_block_indeces
+            refines_edges.add_edge(Refines_Edge<node_index>(dirty_block_index+1, new_block_indices));
+        }
+    }
+
+    // now we deal with larger blocks. When they split, we first attempt to fill the gaps created in the previous loop.
+    // if there is no free space, we append the blocks.
+    // in the meantime, we also maintain the k_node_to_block index.
+    for (auto iter = k_minus_one_outcome.dirty_blocks.cbegin(); iter != k_minus_one_outcome.dirty_blocks.cend(); iter++)
+    {
+        block_index dirty_block_index = *iter;
+        BlockPtr<node_index> dirty_block = k_minus_one_outcome.blocks[dirty_block_index];
+        size_t dirty_block_size = dirty_block->size();
+
+        // define the vector to store the new block indices in
+        std::vector<block_index> new_block_indices;
+
+        if (dirty_block_size == 2 || dirty_block_size <= min_support)
+        {
+            // if it is 2, we dealt with it above.
+            // if it is less than min_support, no need to update anything in the blocks, nor in the index
+            continue;
+        }
+        // else
+
+        // pair of edge type and target *block*, the block ID can be negative if it is a singleton
+        using signature_t = boost::unordered_flat_set<std::pair<edge_type, block_or_singleton_index>>; //[tuple[HashableEdgeLabel, int]]
+        // collect the signatures for nodes in the block
+        boost::unordered_flat_map<signature_t, Block<node_index>> M;
+        for (auto v_iter = dirty_block->begin(); v_iter != dirty_block->end(); v_iter++)
+        {
+            node_index v = *v_iter;
+            signature_t signature;
+            for (Edge<node_index> edge_info : g.get_nodes()[v].get_outgoing_edges())
+            {
+                block_or_singleton_index to_block = k_minus_one_outcome.get_block_ID_for_node(edge_info.target);
+                signature.emplace(edge_info.label, to_block);
+            }
+            // try_emplace returns an iterator to a new element if there was nothing yet, otherwise to the existing one
+            auto empl_res = M.try_emplace(signature);
+            (*(empl_res.first)).second.emplace_back(v);
+        }
+        // if the block is not refined
+        if (M.size() == 1)
+        {
+            // no need to update anythign in the blocks, nor in the index
+            continue;
+        }
+        // else
+
+        // we first make sure all nodes are added to the nodes_from_split_blocks
+        for (auto v_iter = dirty_block->begin(); v_iter != dirty_block->end(); v_iter++)
+        {
+            node_index v = *v_iter;
+            nodes_from_split_blocks.emplace(v);
+        }
+
+        // We mark the current block_index as a free one, and set it to the empty one
+        k_node_to_block->freeblock_indices.push(dirty_block_index);
+        k_blocks[dirty_block_index] = global_empty_block<node_index>;
+
+        // all indices for this block will be overwritten, so no need to do this now
+
+        // This bool is used to make sure we only add 0 at most once to the refines edges
+        bool found_singleton = false;
+
+        // categorize the blocks
+        for (auto &signature_blocks : M)
+        {
+            // if singleton, make it a singleton in the mapping
+            if (signature_blocks.second.size() == 1)
+            {
+                k_node_to_block->put_into_singleton(*(signature_blocks.second.cbegin()));
+                if (!found_singleton)
+                {
+                    found_singleton = true;
+                    // Add the split to the refines edges. Here 0 is used to indicates some nodes became singletons
+                    new_block_indices.push_back(0);
+                }
+                continue;
+            }
+            // else
+
+            BlockPtr<node_index> block = std::make_shared<Block<node_index>>(signature_blocks.second);
+            block->shrink_to_fit();
+            // if there are still known empty blocks, write on them
+            block_index new_block_index;  // changed from std::size_t to block_index
+            if (k_node_to_block->freeblock_indices.size() > 0)
+            {
+                new_block_index = k_node_to_block->freeblock_indices.top();
+                k_node_to_block->freeblock_indices.pop();
+                k_blocks[new_block_index] = block;
+            }
+            else
+            {
+                new_block_index = k_blocks.size();
+                k_blocks.push_back(block);
+            }
+            // We add 1 since the index 0 is reserved for singletons
+            new_block_indices.push_back(new_block_index+1);
+            // we still need to update the k_node_to_block index
+            if (new_block_index != dirty_block_index)
+            { // if new_block_index == dirty_block_index, then it is already set
+                for (auto node_iter = block->cbegin(); node_iter != block->cend(); node_iter++)
+                {
+                    node_index node_iter_index = *node_iter;
+                    k_node_to_block->overwrite_mapping(node_iter_index, new_block_index);
+                }
+            }
+        }
+        // Add 1 to the dirty block index to be consistent with the new_block_indeces
+        refines_edges.add_edge(Refines_Edge<node_index>(dirty_block_index+1, new_block_indices));
+    }
+
+    // for (node_index i = 0; i < g.size(); i++)
+    // {
+    //     std::cout << "from " << k_minus_one_outcome.node_to_block->get_block(i) << " to " << k_node_to_block->get_block(i) << std::endl;
+    // }
+
+    // we are now done with splitting all blocks. Also the indices are up to date. Time to mark the dirty blocks
+    DirtyBlockContainer<node_index> dirty;
+#ifdef CREATE_REVERSE_INDEX
+    // start marking
+    for (node_index target : nodes_from_split_blocks)
+    {
+        if (target > g.size() || target < 0)
+        {
+            throw MyException("impossible: target index goes beyond graph size");
+        }
+        for (node_index source : g.reverse.at(target))
+        {
+            if (source > g.size() || target < 0)
+            {
+                throw MyException("impossible: source index goes beyond graph size");
+            }
+            const block_or_singleton_index dirty_block_ID = k_node_to_block->get_block(source);
+            if (dirty_block_ID < 0)
+            {
+                // it is a singleton, which can never split, so no need to mark
+                continue;
+            }
+            // else
+            if (k_blocks.at(dirty_block_ID)->size() < min_support)
+            {
+                // that block will never split anyway, no need to mark it
+                continue;
+            }
+            // else
+            // mark as dirty block
+            dirty.set_dirty(dirty_block_ID);
+        }
+    }
+#else
+    std::vector<Node<node_index>> nodes = g.get_nodes();
+    for (node_index the_node_index = 0; the_node_index < nodes.size(); the_node_index++)
+    {
+        Node<node_index> &node = nodes[the_node_index];
+        block_or_singleton_index source_block = k_node_to_block->get_block(the_node_index);
+        if (source_block < 0)
+        {
+            // it is a singleton, which can never split, so no need to mark
+            continue;
+        }
+        // else
+        if (k_blocks[source_block]->size() < min_support)
+        {
+            // that block will never split anyway, no need to mark it
+            continue;
+        }
+        // else
+
+        for (auto edge : node.get_outgoing_edges())
+        {
+            if (nodes_from_split_blocks.contains(edge.target))
+            {
+                // mark as dirty block
+                dirty.set_dirty(source_block);
+                // now this block has been set dirty, no need to investigate the other edges.
+                break;
+            }
+        }
+    }
+
+#endif
+    KBisumulationOutcome<node_index> outcome(k_blocks, dirty, k_node_to_block);
+    outcome.add_mapping(refines_edges);
+    return outcome;
+}
+
+/**
+ * A block of a previous experiment that was split, with the nodes it contained and the (non-singleton) blocks it was split into
+ */
+template <typename node_index>
+struct PreviousSplit
+{
+    using block_index = node_index;
+    Block<node_index> members;
+    std::vector<block_index> new_blocks;
+};
+
+/**
+ * The partition of a previous experiment at a single level, reconstructed from its condensed outcome and mapping files.
+ * Block indices are kept as they are stored on disk (i.e. shifted by 1). Singletons get the usual -(node)-1 index.
+ */
+template <typename node_index>
+class PreviousPartition
+{
+private:
+    using block_index = node_index;
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+
+    std::vector<block_or_singleton_index> node_to_block;
+    boost::unordered_flat_map<block_index, Block<node_index>> blocks;
+
+    PreviousPartition(PreviousPartition &) {} // no copies
+
+    std::vector<block_index> read_condensed_outcome(const std::string &filename)
+    {
+        std::vector<block_index> read_blocks;
+        PartitionFileStream outcome_stream(filename, PARTITION_FILE_OUTCOME);
+        while (true)
+        {
+            block_index block = read_uint_BLOCK_little_endian(outcome_stream);
+            if (outcome_stream.eof())
+            {
+                break;
+            }
+            read_blocks.push_back(block);
+            node_index block_size = read_uint_ENTITY_little_endian(outcome_stream);
+            Block<node_index> &members = this->blocks[block];
+            members.reserve(block_size);
+            for (node_index j = 0; j < block_size; j++)
+            {
+                node_index node = read_uint_ENTITY_little_endian(outcome_stream);
+                members.push_back(node);
+                this->node_to_block.at(node) = block;
+            }
+        }
+        return read_blocks;
+    }
+
+public:
+    /**
+     * Creates the k=0 partition of the previous experiment.
+     * For a typed start it is read from the zero outcome, otherwise all nodes are in block 1 (i.e. block 0 before shifting)
+     */
+    PreviousPartition(node_index graph_size, bool typed_start, const std::string &zero_outcome_file) : node_to_block(graph_size)
+    {
+        if (typed_start)
+        {
+            for (node_index node = 0; node < graph_size; node++)
+            {
+                this->node_to_block[node] = -((block_or_singleton_index) node)-1;
+            }
+            this->read_condensed_outcome(zero_outcome_file);
+        }
+        else
+        {
+            Block<node_index> &universal_block = this->blocks[1];
+            universal_block.reserve(graph_size);
+            for (node_index node = 0; node < graph_size; node++)
+            {
+                universal_block.push_back(node);
+                this->node_to_block[node] = 1;
+            }
+        }
+    }
+
+    node_index size() const
+    {
+        return this->node_to_block.size();
+    }
+
+    block_or_singleton_index get_block(node_index node) const
+    {
+        return this->node_to_block[node];
+    }
+
+    const Block<node_index> &get_block_members(block_index block) const
+    {
+        return this->blocks.at(block);
+    }
+
+    /**
+     * Moves this partition to the next level, using the mapping and outcome files of the previous experiment.
+     * If there is no mapping file (this happens for the trivial mapping from k=0 to k=1), `split_universal_block` tells whether block 1 was split.
+     * Levels beyond the fixed point of the previous experiment have no files, in which case nothing changes.
+     * Returns the blocks that were split, with the nodes they contained before the split.
+     */
+    boost::unordered_flat_map<block_index, PreviousSplit<node_index>> advance(const std::string &mapping_file, const std::string &outcome_file, bool split_universal_block)
+    {
+        boost::unordered_flat_map<block_index, PreviousSplit<node_index>> splits;
+        if (std::filesystem::exists(mapping_file))
+        {
+            PartitionFileStream mapping_stream(mapping_file, PARTITION_FILE_MAPPING);
+            while (true)
+            {
+                block_index old_block = read_uint_BLOCK_little_endian(mapping_stream);
+                if (mapping_stream.eof())
+                {
+                    break;
+                }
+                block_index split_block_count = read_uint_BLOCK_little_endian(mapping_stream);
+                PreviousSplit<node_index> &split = splits[old_block];
+                for (block_index j = 0; j < split_block_count; j++)
+                {
+                    block_index new_block = read_uint_BLOCK_little_endian(mapping_stream);
+                    // 0 indicates that some nodes became singletons
+                    if (new_block != 0)
+                    {
+                        split.new_blocks.push_back(new_block);
+                    }
+                }
+            }
+        }
+        else if (split_universal_block)
+        {
+            splits[1];
+        }
+
+        for (auto &split : splits)
+        {
+            split.second.members = std::move(this->blocks.at(split.first));
+            this->blocks.erase(split.first);
+            // Nodes that do not end up in a new block (from the outcome file) are singletons
+            for (node_index node : split.second.members)
+            {
+                this->node_to_block[node] = -((block_or_singleton_index) node)-1;
+            }
+        }
+        if (std::filesystem::exists(outcome_file))
+        {
+            std::vector<block_index> new_blocks = this->read_condensed_outcome(outcome_file);
+            if (!std::filesystem::exists(mapping_file) && split_universal_block)
+            {
+                splits[1].new_blocks = new_blocks;
+            }
+        }
+        return splits;
+    }
+};
+
+/**
+ * Determines which dirty nodes moved, i.e. ended up in a different block than the one their previous block maps to.
+ * We map every previous block to at most one new block (and no two previous blocks to the same new block):
+ * if a previous block contains a node that is not dirty, it maps to the new block of that node (these all agree, see get_k_bisimulation_incremental).
+ * Otherwise, the first new block that one of its nodes ended up in is taken, if no other previous block maps to it yet.
+ * Nodes that did not exist in the previous graph are always considered to have moved.
+ * As long as the targets of a node did not move, the nodes it is equivalent to are the same as in the previous experiment.
+ */
+template <typename node_index>
+void collect_moved_nodes(const KBisumulationOutcome<node_index> &outcome,
+                         const PreviousPartition<node_index> &previous_outcome,
+                         const boost::unordered_flat_set<node_index> &dirty_nodes,
+                         boost::unordered_flat_set<node_index> &moved_nodes)
+{
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+    const block_or_singleton_index NO_BLOCK_YET = std::numeric_limits<block_or_singleton_index>::min();
+    node_index previous_size = previous_outcome.size();
+
+    // The new block each previous block maps to, or NO_BLOCK_YET if all its nodes are dirty and none of them claimed a new block
+    boost::unordered_flat_map<block_or_singleton_index, block_or_singleton_index> previous_to_new_block;
+    // Whether a new block is already mapped to by some previous block
+    boost::unordered_flat_map<block_or_singleton_index, bool> new_block_taken;
+
+    for (node_index v : dirty_nodes)
+    {
+        if (v >= previous_size)
+        {
+            moved_nodes.emplace(v);
+            continue;
+        }
+        block_or_singleton_index previous_block = previous_outcome.get_block(v);
+        block_or_singleton_index new_block = outcome.get_block_ID_for_node(v);
+
+        auto previous_iter = previous_to_new_block.find(previous_block);
+        if (previous_iter == previous_to_new_block.end())
+        {
+            block_or_singleton_index image = NO_BLOCK_YET;
+            if (previous_block >= 0)
+            {
+                for (node_index member : previous_outcome.get_block_members(previous_block))
+                {
+                    if (!dirty_nodes.contains(member))
+                    {
+                        image = outcome.get_block_ID_for_node(member);
+                        break;
+                    }
+                }
+            }
+            previous_iter = previous_to_new_block.emplace(previous_block, image).first;
+        }
+
+        if (previous_iter->second == NO_BLOCK_YET)
+        {
+            auto taken_iter = new_block_taken.find(new_block);
+            if (taken_iter == new_block_taken.end())
+            {
+                // A new block containing a node that is not dirty is the image of the previous block of that node
+                bool taken = false;
+                if (new_block >= 0)
+                {
+                    for (node_index member : *(outcome.blocks[new_block]))
+                    {
+                        if (!dirty_nodes.contains(member))
+                        {
+                            taken = true;
+                            break;
+                        }
+                    }
+                }
+                taken_iter = new_block_taken.emplace(new_block, taken).first;
+            }
+            if (!taken_iter->second)
+            {
+                // Claim the new block for this previous block
+                previous_iter->second = new_block;
+                taken_iter->second = true;
+                continue;
+            }
+        }
+        if (previous_iter->second != new_block)
+        {
+            moved_nodes.emplace(v);
+        }
+    }
+}
+
+/**
+ * Computes the k-bisimulation of the updated graph, using the (k-1)-bisimulation of the updated graph and the k-bisimulation of the previous experiment.
+ * A node is dirty if its outgoing edges changed, if it moved at k-1, or if one of its targets moved at k-1 (see collect_moved_nodes).
+ * Nodes that are not dirty end up together exactly when they were together in the previous experiment, so we only compute signatures for
+ * the dirty nodes and for one representative of each previous block they might join.
+ * Blocks without dirty nodes split exactly like their previous block did in the previous experiment.
+ * The dirty nodes that moved at k are collected in `moved_nodes`.
+ */
+template <typename node_index>
+KBisumulationOutcome<node_index> get_k_bisimulation_incremental(Graph<node_index> &g,
+                                                                const KBisumulationOutcome<node_index> &k_minus_one_outcome,
+                                                                const PreviousPartition<node_index> &previous_k_outcome,
+                                                                const boost::unordered_flat_map<node_index, PreviousSplit<node_index>> &previous_splits,
+                                                                const boost::unordered_flat_set<node_index> &dirty_nodes,
+                                                                boost::unordered_flat_set<node_index> &moved_nodes)
+{
+    using block_index = node_index;
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+
+    // we make copies which we will modify
+    std::vector<BlockPtr<node_index>> k_blocks(k_minus_one_outcome.blocks);
+    std::shared_ptr<MappingNode2BlockMapper<node_index>> k_node_to_block = k_minus_one_outcome.node_to_block->modifyable_copy();
+
+    // Define a mapping in which we can store the refines edges
+    Refines_Mapping<node_index> refines_edges;
+
+    // pair of edge type and target *block*, the block ID can be negative if it is a singleton
+    using signature_t = boost::unordered_flat_set<std::pair<edge_type, block_or_singleton_index>>;
+    auto get_signature = [&g, &k_minus_one_outcome](node_index v)
+    {
+        signature_t signature;
+        for (Edge<node_index> edge_info : g.get_nodes()[v].get_outgoing_edges())
+        {
+            block_or_singleton_index to_block = k_minus_one_outcome.get_block_ID_for_node(edge_info.target);
+            signature.emplace(edge_info.label, to_block);
+        }
+        return signature;
+    };
+
+    // The blocks containing a dirty node have to be recomputed (singletons can not split)
+    boost::unordered_flat_set<block_index> recompute_blocks;
+    for (node_index v : dirty_nodes)
+    {
+        block_or_singleton_index v_block = k_minus_one_outcome.get_block_ID_for_node(v);
+        if (v_block >= 0)
+        {
+            recompute_blocks.emplace(v_block);
+        }
+    }
+
+    // For every block that splits, the nodes it splits into
+    std::vector<std::pair<block_index, std::vector<Block<node_index>>>> splits;
+
+    // A block without dirty nodes consists of the nodes of a previous block that did not move, so it splits like that previous block did
+    for (auto &previous_split : previous_splits)
+    {
+        const Block<node_index> &previous_members = previous_split.second.members;
+        auto member_iter = std::find_if(previous_members.cbegin(), previous_members.cend(),
+                                        [&dirty_nodes](node_index member) { return !dirty_nodes.contains(member); });
+        if (member_iter == previous_members.cend())
+        {
+            continue;
+        }
+        block_or_singleton_index k_minus_one_block = k_minus_one_outcome.get_block_ID_for_node(*member_iter);
+        if (k_minus_one_block < 0 || recompute_blocks.contains(k_minus_one_block))
+        {
+            continue;
+        }
+        const Block<node_index> &members = *(k_minus_one_outcome.blocks[k_minus_one_block]);
+        std::vector<Block<node_index>> groups;
+        if (members.size() == previous_members.size())
+        {
+            // No node moved away, so this is exactly the previous split
+            for (block_index previous_new_block : previous_split.second.new_blocks)
+            {
+                groups.push_back(previous_k_outcome.get_block_members(previous_new_block));
+            }
+            for (node_index v : members)
+            {
+                if (previous_k_outcome.get_block(v) < 0)
+                {
+                    groups.push_back(Block<node_index>{v});
+                }
+            }
+        }
+        else
+        {
+            boost::unordered_flat_map<block_or_singleton_index, Block<node_index>> previous_groups;
+            for (node_index v : members)
+            {
+                previous_groups[previous_k_outcome.get_block(v)].push_back(v);
+            }
+            if (previous_groups.size() == 1)
+            {
+                // The nodes that caused the split in the previous experiment moved away
+                continue;
+            }
+            groups.reserve(previous_groups.size());
+            for (auto &previous_group : previous_groups)
+            {
+                groups.emplace_back(std::move(previous_group.second));
+            }
+        }
+        splits.emplace_back(k_minus_one_block, std::move(groups));
+    }
+
+    for (block_index recompute_block : recompute_blocks)
+    {
+        const Block<node_index> &members = *(k_minus_one_outcome.blocks[recompute_block]);
+        std::vector<Block<node_index>> groups;
+        boost::unordered_flat_map<signature_t, std::size_t> signature_to_group;
+
+        // Nodes that are not dirty are grouped according to their previous block, the signature of the first one represents the group
+        boost::unordered_flat_map<block_or_singleton_index, std::size_t> previous_block_to_group;
+        for (node_index v : members)
+        {
+            if (dirty_nodes.contains(v))
+            {
+                continue;
+            }
+            auto empl_res = previous_block_to_group.try_emplace(previous_k_outcome.get_block(v), groups.size());
+            if (empl_res.second)
+            {
+                groups.emplace_back();
+                if (!signature_to_group.try_emplace(get_signature(v), empl_res.first->second).second)
+                {
+                    throw MyException("invariant violation: two previous blocks without dirty nodes got the same signature");
+                }
+            }
+            groups[empl_res.first->second].push_back(v);
+        }
+        // Dirty nodes either join one of these groups, or form new ones
+        for (node_index v : members)
+        {
+            if (!dirty_nodes.contains(v))
+            {
+                continue;
+            }
+            auto empl_res = signature_to_group.try_emplace(get_signature(v), groups.size());
+            if (empl_res.second)
+            {
+                groups.emplace_back();
+            }
+            groups[empl_res.first->second].push_back(v);
+        }
+
+        if (groups.size() > 1)
+        {
+            splits.emplace_back(recompute_block, std::move(groups));
+        }
+    }
+
+    // Like in get_k_bisimulation, we first split blocks of size 2, such that the freed block indices can be reused by the larger blocks
+    for (bool split_size_two : {true, false})
+    {
+        for (auto &split : splits)
+        {
+            block_index dirty_block_index = split.first;
+            if ((k_minus_one_outcome.blocks[dirty_block_index]->size() == 2) != split_size_two)
+            {
+                continue;
+            }
+            std::vector<block_index> new_block_indices;
+
+            // We mark the current block_index as a free one, and set it to the empty one
+            k_node_to_block->freeblock_indices.push(dirty_block_index);
+            k_blocks[dirty_block_index] = global_empty_block<node_index>;
+
+            // This bool is used to make sure we only add 0 at most once to the refines edges
+            bool found_singleton = false;
+            for (Block<node_index> &group : split.second)
+            {
+                if (group.size() == 1)
+                {
+                    k_node_to_block->put_into_singleton(group[0]);
+                    if (!found_singleton)
+                    {
+                        found_singleton = true;
+                        // Add the split to the refines edges. Here 0 is used to indicates some nodes became singletons
+                        new_block_indices.push_back(0);
+                    }
+                    continue;
+                }
+                // else
+
+                BlockPtr<node_index> block = std::make_shared<Block<node_index>>(std::move(group));
+                block->shrink_to_fit();
+                // if there are still known empty blocks, write on them
+                block_index new_block_index;
+                if (k_node_to_block->freeblock_indices.size() > 0)
+                {
+                    new_block_index = k_node_to_block->freeblock_indices.top();
+                    k_node_to_block->freeblock_indices.pop();
+                    k_blocks[new_block_index] = block;
+                }
+                else
+                {
+                    new_block_index = k_blocks.size();
+                    k_blocks.push_back(block);
+                }
+                // We add 1 since the index 0 is reserved for singletons
+                new_block_indices.push_back(new_block_index+1);
+                if (new_block_index != dirty_block_index)
+                { // if new_block_index == dirty_block_index, then it is already set
+                    for (node_index node : *block)
+                    {
+                        k_node_to_block->overwrite_mapping(node, new_block_index);
+                    }
+                }
+            }
+            // Add 1 to the dirty block index to be consistent with the new_block_indeces
+            refines_edges.add_edge(Refines_Edge<node_index>(dirty_block_index+1, new_block_indices));
+        }
+    }
+
+    // The incremental approach does not use dirty blocks, the dirty nodes are derived from `moved_nodes` instead
+    DirtyBlockContainer<node_index> dirty;
+    KBisumulationOutcome<node_index> outcome(k_blocks, dirty, k_node_to_block);
+    outcome.add_mapping(refines_edges);
+    collect_moved_nodes(outcome, previous_k_outcome, dirty_nodes, moved_nodes);
+    return outcome;
+}
+
+/**
+ * Checks whether two outcomes describe the same partition of the nodes, regardless of the block indices used
+ */
+template <typename node_index>
+bool partitions_are_equal(const KBisumulationOutcome<node_index> &outcome, const KBisumulationOutcome<node_index> &other_outcome, node_index graph_size)
+{
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+    boost::unordered_flat_map<block_or_singleton_index, block_or_singleton_index> outcome_to_other;
+    boost::unordered_flat_map<block_or_singleton_index, block_or_singleton_index> other_to_outcome;
+    for (node_index node = 0; node < graph_size; node++)
+    {
+        block_or_singleton_index block = outcome.get_block_ID_for_node(node);
+        block_or_singleton_index other_block = other_outcome.get_block_ID_for_node(node);
+        if (outcome_to_other.try_emplace(block, other_block).first->second != other_block)
+        {
+            return false;
+        }
+        if (other_to_outcome.try_emplace(other_block, block).first->second != block)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename node_index>
+void write_all_blocks_condensed(const KBisumulationOutcome<node_index> &outcome, const std::string &filename, uint16_t level, uint8_t partition_file_version, ExperimentManifest &manifest, const std::vector<node_index> &new_to_old = {})
+{
+    using block_index = node_index;
+    PartitionFileWriter condensed_output(filename, PARTITION_FILE_OUTCOME, partition_file_version);
+    std::vector<uint64_t> members;
+    for (block_index i = 0; i<outcome.blocks.size(); i++)
+    {
+        BlockPtr<node_index> new_block_ptr = outcome.blocks[i];
+        members.clear();
+        for (auto v_iter = new_block_ptr->begin(); v_iter != new_block_ptr->end(); v_iter++)
+        {
+            members.push_back(original_node_index(new_to_old, *v_iter));  // We store each entity contained in the new block
+        }
+        condensed_output.write_block(i+1, members);  // We add 1, because we want to reserve 0 for the singleton blocks
+    }
+    condensed_output.close();
+    manifest.add(filename, "bisimulator", level, condensed_output.get_record_count(), condensed_output.get_value_count());
+}
+
+/**
+ * Returns the number of (non-singleton) blocks that were created by the splits of the outcome, without writing them
+ */
+template <typename node_index>
+node_index count_new_blocks(const KBisumulationOutcome<node_index> &outcome)
+{
+    node_index new_block_count = 0;
+    for (auto orig_new: outcome.k_minus_one_to_k_mapping.refines_edges)
+    {
+        for (auto new_block: orig_new.second)
+        {
+            // 0 corresponds to a special block for singletons
+            if (new_block != 0)
+            {
+                new_block_count++;
+            }
+        }
+    }
+    return new_block_count;
+}
+
+/**
+ * Writes the refines edges of the outcome to the mapping file and returns the number of (non-singleton) blocks that were created by the splits
+ */
+template <typename node_index>
+node_index write_refines_edges_condensed(const KBisumulationOutcome<node_index> &outcome, const std::string &filename, uint16_t level, uint8_t partition_file_version, ExperimentManifest &manifest)
+{
+    using block_index = node_index;
+    block_index new_block_count = 0;
+    PartitionFileWriter mapping_output(filename, PARTITION_FILE_MAPPING, partition_file_version);
+    std::vector<uint64_t> new_blocks;
+    for (auto orig_new: outcome.k_minus_one_to_k_mapping.refines_edges)
+    {
+        block_index split_block_count = u_int64_t(orig_new.second.size());
+        new_block_count += split_block_count;
+        new_blocks.clear();
+        for (auto new_block: orig_new.second)
+        {
+            new_blocks.push_back(u_int64_t(new_block));  // Write all the new blocks the old one got split into
+
+            // 0 corresponds to a special block for singletons and as such requires special care
+            if (new_block == 0)
+            {
+                new_block_count--;
+            }
+        }
+        mapping_output.write_split(u_int64_t(orig_new.first), new_blocks);
+    }
+    mapping_output.close();
+    manifest.add(filename, "bisimulator", level, mapping_output.get_record_count(), mapping_output.get_value_count());
+    return new_block_count;
+}
+
+template <typename node_index>
+void write_split_blocks_condensed(const KBisumulationOutcome<node_index> &outcome, const std::string &filename, uint16_t level, uint8_t partition_file_version, ExperimentManifest &manifest, const std::vector<node_index> &new_to_old = {})
+{
+    PartitionFileWriter condensed_output(filename, PARTITION_FILE_OUTCOME, partition_file_version);
+    std::vector<uint64_t> members;
+    // bool found_singletons = false;
+    for (auto orig_new: outcome.k_minus_one_to_k_mapping.refines_edges)
+    {
+        for (auto new_block: orig_new.second)
+        {
+            // Skip the singleton block
+            if (new_block == 0)
+            {
+                // found_singletons = true;
+                continue;
+            }
+            // We have to subtract 1 because we added 1 earlier
+            BlockPtr<node_index> new_block_ptr = outcome.blocks[new_block-1];
+            members.clear();
+            for (auto v_iter = new_block_ptr->begin(); v_iter != new_block_ptr->end(); v_iter++)
+            {
+                members.push_back(original_node_index(new_to_old, *v_iter));  // We store each entity contained in the new block
+            }
+            condensed_output.write_block(u_int64_t(new_block), members);
+        }
+    }
+    condensed_output.close();
+    manifest.add(filename, "bisimulator", level, condensed_output.get_record_count(), condensed_output.get_value_count());
+}
+
+template <typename node_index>
+void write_level_statistics(KBisumulationOutcome<node_index> &outcome, int64_t accumulated_block_count, int64_t duration_in_ms, int memory_in_kb, const std::string &filename)
+{
+    std::ofstream ad_hoc_output(filename, std::ios::trunc);
+    ad_hoc_output << "{\n    \"Block count\": " << outcome.total_blocks()
+                  << ",\n    \"Singleton count\": " << outcome.singleton_block_count()
+                  << ",\n    \"Accumulated block count\": " << accumulated_block_count
+                  << ",\n    \"Time taken (ms)\": " << duration_in_ms
+                  << ",\n    \"Memory footprint (kB)\": " << memory_in_kb << "\n}";
+    ad_hoc_output.flush();
+}
+
+/**
+ * Builds the condensed multi summary graph while the bisimulation runs, so create_condensed_summary_graph_from_partitions does not have to read the
+ * outcomes, mappings and data graph again afterwards.
+ * Every block gets a lifetime, from the level at which it was created up to the level before it got split. A level c adds the data edges from the
+ * lifetimes of the subjects at c to the lifetimes of the objects at c-1, where only the subjects that changed at c, or whose objects changed at c-1,
+ * can add an edge that was not added at an earlier level.
+ * The lifetimes only get their global block ids at the end, in the same order as create_condensed_summary_graph_from_partitions gives them out,
+ * so the written files are the same as the ones written by that tool.
+ */
+template <typename node_index>
+class CondensedSummaryBuilder
+{
+private:
+    using block_index = node_index;
+    using k_type = uint16_t;
+    // The lifetimes are referred to by their position in lifetimes, singletons by their (negative) global id
+    using lifetime_or_singleton = int64_t;
+
+    static const k_type ALIVE = UINT16_MAX;
+
+    struct BlockLifetime
+    {
+        block_index local_block;
+        k_type start;
+        k_type end;
+    };
+    struct LifetimeEdge
+    {
+        lifetime_or_singleton subject;
+        edge_type predicate;
+        lifetime_or_singleton object;
+
+        bool operator<(const LifetimeEdge &other) const
+        {
+            return std::tie(subject, predicate, object) < std::tie(other.subject, other.predicate, other.object);
+        }
+        bool operator==(const LifetimeEdge &other) const
+        {
+            return subject == other.subject && predicate == other.predicate && object == other.object;
+        }
+    };
+    struct LevelStatistics
+    {
+        k_type level;
+        bool repeated;  // The level is the repetition of the fixed point
+        int64_t duration_in_ms;
+        int memory_in_kb;
+    };
+
+    Graph<node_index> &g;
+    const std::vector<node_index> &new_to_old;
+    bool typed_start;
+    std::vector<BlockLifetime> lifetimes;
+    std::vector<lifetime_or_singleton> block_lifetimes;  // The lifetime of every block at the current level, -1 for unused blocks
+    std::vector<lifetime_or_singleton> node_lifetimes;  // The lifetime (or singleton) of every node at the current level
+    std::vector<lifetime_or_singleton> previous_node_lifetimes;  // The same, at the level before
+    std::vector<node_index> previous_changed_nodes;  // The nodes that got a new lifetime at the level before
+    std::vector<std::pair<lifetime_or_singleton, k_type>> singleton_starts;
+    std::vector<std::vector<lifetime_or_singleton>> ended_lifetimes;  // Per level c, the lifetimes that ended at c-1 because their block got split, by ascending local block
+    std::map<k_type, std::map<block_index, std::vector<lifetime_or_singleton>>> singleton_mappings;  // Per level, the singletons created from every merged block
+    std::vector<LifetimeEdge> edges;
+    uint64_t deduplicated_edge_count = 0;
+    std::vector<LevelStatistics> level_statistics;
+    lifetime_or_singleton universal_lifetime = -1;
+    k_type last_level = 0;
+
+    CondensedSummaryBuilder(CondensedSummaryBuilder &)
+    {
+    }
+
+    lifetime_or_singleton add_lifetime(block_index local_block, k_type start)
+    {
+        this->lifetimes.push_back({local_block, start, ALIVE});
+        if (this->block_lifetimes.size() < local_block)
+        {
+            this->block_lifetimes.resize(local_block, -1);
+        }
+        this->block_lifetimes[local_block - 1] = this->lifetimes.size() - 1;
+        return this->lifetimes.size() - 1;
+    }
+
+    lifetime_or_singleton make_singleton(node_index node, k_type start)
+    {
+        lifetime_or_singleton singleton = -lifetime_or_singleton(original_node_index(this->new_to_old, node)) - 1;
+        this->node_lifetimes[node] = singleton;
+        this->singleton_starts.emplace_back(singleton, start);
+        return singleton;
+    }
+
+    void write_local_global_map(std::ostream &outputstream, std::vector<std::tuple<k_type, int64_t, int64_t>> &level_local_global_triples)
+    {
+        std::sort(level_local_global_triples.begin(), level_local_global_triples.end());
+
+        outputstream.write(LOCAL_GLOBAL_MAP_MAGIC.data(), LOCAL_GLOBAL_MAP_MAGIC.size());
+        outputstream.put(char(LOCAL_GLOBAL_MAP_VERSION));
+        uint64_t offset = LOCAL_GLOBAL_MAP_MAGIC.size() + 1;
+
+        std::vector<std::pair<k_type, uint64_t>> level_offsets;
+        auto group_begin = level_local_global_triples.cbegin();
+        while (group_begin != level_local_global_triples.cend())
+        {
+            k_type level = std::get<0>(*group_begin);
+            auto group_end = std::find_if(group_begin, level_local_global_triples.cend(), [level](const auto &triple){return std::get<0>(triple) != level;});
+            uint64_t count = group_end - group_begin;
+            level_offsets.emplace_back(level, offset);
+
+            write_uint_K_TYPE_little_endian(outputstream, level);
+            write_uint_OFFSET_little_endian(outputstream, count);
+            for (auto it = group_begin; it != group_end; it++)
+            {
+                write_int_BLOCK_OR_SINGLETON_little_endian(outputstream, std::get<1>(*it));
+                write_int_BLOCK_OR_SINGLETON_little_endian(outputstream, std::get<2>(*it));
+            }
+            offset += BYTES_PER_K_TYPE + BYTES_PER_OFFSET + count * 2 * BYTES_PER_BLOCK_OR_SINGLETON;
+            group_begin = group_end;
+        }
+
+        write_uint_OFFSET_little_endian(outputstream, level_offsets.size());
+        for (auto [level, level_offset]: level_offsets)
+        {
+            write_uint_K_TYPE_little_endian(outputstream, level);
+            write_uint_OFFSET_little_endian(outputstream, level_offset);
+        }
+        write_uint_OFFSET_little_endian(outputstream, offset);
+        outputstream.flush();
+    }
+
+public:
+    // Without a typed start, all nodes start in the universal block (local block 0), which only lives at level 0
+    CondensedSummaryBuilder(Graph<node_index> &g, const std::vector<node_index> &new_to_old, bool typed_start) : g(g), new_to_old(new_to_old), typed_start(typed_start)
+    {
+        this->node_lifetimes.resize(g.size(), -1);
+        if (!typed_start)
+        {
+            this->lifetimes.push_back({0, 0, 0});
+            this->universal_lifetime = 0;
+            this->block_lifetimes.push_back(this->universal_lifetime);  // The universal block has block index 0 in the bisimulation
+            std::fill(this->node_lifetimes.begin(), this->node_lifetimes.end(), this->universal_lifetime);
+        }
+        this->previous_node_lifetimes = this->node_lifetimes;
+    }
+
+    // With a typed start, every block of the typed 0-bisimulation starts a lifetime at level 0
+    void add_typed_start(const KBisumulationOutcome<node_index> &outcome)
+    {
+        for (block_index block = 0; block < outcome.blocks.size(); block++)
+        {
+            if (outcome.blocks[block]->empty())
+            {
+                continue;
+            }
+            lifetime_or_singleton lifetime = this->add_lifetime(block + 1, 0);
+            for (node_index node: *outcome.blocks[block])
+            {
+                this->node_lifetimes[node] = lifetime;
+            }
+        }
+        for (node_index node = 0; node < this->g.size(); node++)
+        {
+            if (this->node_lifetimes[node] == -1)
+            {
+                this->make_singleton(node, 0);
+            }
+        }
+        this->previous_node_lifetimes = this->node_lifetimes;
+    }
+
+    // Adds level c, given the outcomes for c-1 and c, and returns whether this level is the repetition of the fixed point
+    bool add_level(k_type level, const KBisumulationOutcome<node_index> &previous_outcome, const KBisumulationOutcome<node_index> &outcome)
+    {
+        this->last_level = level;
+        this->ended_lifetimes.resize(level + 1);
+        const auto &refines_edges = outcome.k_minus_one_to_k_mapping.refines_edges;
+        std::vector<node_index> changed_nodes;
+
+        // The split blocks can reuse the index of any merged block, so all merged blocks are looked up before the split blocks are added
+        // The split from the universal block (at level 1 without a typed start) is not a real split, since the universal block gets no global block id
+        std::vector<lifetime_or_singleton> merged_lifetimes;
+        for (auto &[merged_block, split_blocks]: refines_edges)
+        {
+            lifetime_or_singleton merged_lifetime = this->block_lifetimes[merged_block - 1];
+            this->lifetimes[merged_lifetime].end = level - 1;
+            this->block_lifetimes[merged_block - 1] = -1;
+            if (merged_lifetime != this->universal_lifetime)
+            {
+                this->ended_lifetimes[level].push_back(merged_lifetime);
+            }
+            merged_lifetimes.push_back(merged_lifetime);
+        }
+        for (auto &[merged_block, split_blocks]: refines_edges)
+        {
+            for (block_index split_block: split_blocks)
+            {
+                if (split_block == 0)  // The singletons
+                {
+                    continue;
+                }
+                lifetime_or_singleton lifetime = this->add_lifetime(split_block, level);
+                for (node_index node: *outcome.blocks[split_block - 1])
+                {
+                    this->node_lifetimes[node] = lifetime;
+                }
+            }
+        }
+        auto merged_lifetime_iterator = merged_lifetimes.cbegin();
+        for (auto &[merged_block, split_blocks]: refines_edges)
+        {
+            lifetime_or_singleton merged_lifetime = *(merged_lifetime_iterator++);
+            for (node_index node: *previous_outcome.blocks[merged_block - 1])
+            {
+                changed_nodes.push_back(node);
+                if (this->node_lifetimes[node] == merged_lifetime)  // The node did not end up in any of the split blocks
+                {
+                    lifetime_or_singleton singleton = this->make_singleton(node, level);
+                    if (merged_lifetime != this->universal_lifetime)
+                    {
+                        this->singleton_mappings[level][merged_block].push_back(singleton);
+                    }
+                }
+            }
+        }
+
+        // If the universal block did not split, all its nodes still become singletons at level 1
+        if (!this->typed_start && level == 1 && refines_edges.empty())
+        {
+            this->block_lifetimes[0] = -1;
+            for (node_index node = 0; node < this->g.size(); node++)
+            {
+                this->make_singleton(node, level);
+                changed_nodes.push_back(node);
+            }
+        }
+
+        // Collect the subjects that can add new data edges, and add their edges
+        std::vector<node_index> subjects;
+        if (level == 1)
+        {
+            subjects.resize(this->g.size());
+            std::iota(subjects.begin(), subjects.end(), 0);
+        }
+        else
+        {
+            boost::dynamic_bitset<> is_subject(this->g.size());
+            for (node_index node: changed_nodes)
+            {
+                is_subject[node] = true;
+            }
+            for (node_index node: this->previous_changed_nodes)
+            {
+                for (node_index source: this->g.reverse[node])
+                {
+                    is_subject[source] = true;
+                }
+            }
+            for (auto node = is_subject.find_first(); node != is_subject.npos; node = is_subject.find_next(node))
+            {
+                subjects.push_back(node);
+            }
+        }
+        for (node_index subject: subjects)
+        {
+            lifetime_or_singleton subject_lifetime = this->node_lifetimes[subject];
+            for (const Edge<node_index> &edge: this->g.get_nodes()[subject].get_outgoing_edges())
+            {
+                this->edges.push_back({subject_lifetime, edge.label, this->previous_node_lifetimes[edge.target]});
+            }
+        }
+        // Whenever the edges have doubled since the last deduplication, they get deduplicated again, so the memory stays proportional to the number of summary edges
+        if (this->edges.size() >= 2 * this->deduplicated_edge_count + (1 << 20))
+        {
+            std::sort(this->edges.begin(), this->edges.end());
+            this->edges.erase(std::unique(this->edges.begin(), this->edges.end()), this->edges.end());
+            this->deduplicated_edge_count = this->edges.size();
+        }
+
+        for (node_index node: changed_nodes)
+        {
+            this->previous_node_lifetimes[node] = this->node_lifetimes[node];
+        }
+        this->previous_changed_nodes = std::move(changed_nodes);
+        return refines_edges.empty() && (this->typed_start || level > 1);
+    }
+
+    void add_level_statistics(k_type level, bool repeated, int64_t duration_in_ms, int memory_in_kb)
+    {
+        this->level_statistics.push_back({level, repeated, duration_in_ms, memory_in_kb});
+    }
+
+    // Gives out the global block ids and writes the summary graph, intervals, local to global map, singleton mappings and statistics
+    // depth is the final depth of the bisimulation (k), the written files are added to the manifest
+    void write(const std::string &output_path, k_type depth, ExperimentManifest &manifest)
+    {
+        StopWatch<boost::chrono::process_cpu_clock> w = StopWatch<boost::chrono::process_cpu_clock>::create_not_started();
+        w.start_step("Writing condensed summary graph");
+        std::string output_directory = output_path + "bisimulation/";
+        // Stopping right after the first level means that there is only the level after the start (typed or universal) to write
+        bool immediate_stop = this->typed_start ? depth == 0 : depth == 1;
+        k_type final_level = depth;
+        if (this->typed_start && depth == 0)
+        {
+            final_level = 1;  // There are always data edges between two levels, so we pretend we computed k=1 (which is the same as k=0)
+        }
+
+        // The final blocks get the first global block ids, followed by the blocks that got split, from the last level to the first
+        std::vector<int64_t> global_blocks(this->lifetimes.size(), 0);
+        int64_t next_global_block = 1;
+        uint64_t final_lifetime_count = this->singleton_starts.size();
+        for (lifetime_or_singleton lifetime: this->block_lifetimes)
+        {
+            if (lifetime >= 0)
+            {
+                global_blocks[lifetime] = next_global_block++;
+                final_lifetime_count++;
+            }
+        }
+        boost::unordered_flat_set<int64_t> summary_nodes;
+        k_type smallest_split_level = this->typed_start ? 1 : 2;
+        for (k_type level = this->last_level; level >= smallest_split_level && level < this->ended_lifetimes.size(); level--)
+        {
+            for (lifetime_or_singleton lifetime: this->ended_lifetimes[level])
+            {
+                global_blocks[lifetime] = next_global_block;
+                summary_nodes.emplace(next_global_block++);
+            }
+        }
+        // The universal block is only left out if it would be the same as the one block at level 1
+        bool universal_written = false;
+        if (!this->typed_start)
+        {
+            if (immediate_stop && final_lifetime_count == 1)
+            {
+                global_blocks[this->universal_lifetime] = this->singleton_starts.empty() ? global_blocks[this->block_lifetimes[0]] : this->singleton_starts[0].first;
+            }
+            else
+            {
+                global_blocks[this->universal_lifetime] = next_global_block;
+                summary_nodes.emplace(next_global_block++);
+                universal_written = true;
+            }
+        }
+        auto global_block = [&global_blocks](lifetime_or_singleton lifetime)
+        {
+            return lifetime < 0 ? lifetime : global_blocks[lifetime];
+        };
+
+        for (LifetimeEdge &edge: this->edges)
+        {
+            edge = {global_block(edge.subject), edge.predicate, global_block(edge.object)};
+        }
+        std::sort(this->edges.begin(), this->edges.end());
+        this->edges.erase(std::unique(this->edges.begin(), this->edges.end()), this->edges.end());
+        for (const LifetimeEdge &edge: this->edges)
+        {
+            summary_nodes.emplace(edge.subject);
+            summary_nodes.emplace(edge.object);
+        }
+
+        auto now{boost::chrono::system_clock::to_time_t(boost::chrono::system_clock::now())};
+        std::tm *ptm{std::localtime(&now)};
+        std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S") << " Writing condensed summary graph to disk" << std::endl;
+
+        std::ofstream output_graph_file_binary(output_directory + "condensed_multi_summary_graph.bin", std::ios::trunc | std::ofstream::out);
+        for (const LifetimeEdge &edge: this->edges)
+        {
+            write_int_BLOCK_OR_SINGLETON_little_endian(output_graph_file_binary, edge.subject);
+            write_uint_PREDICATE_little_endian(output_graph_file_binary, edge.predicate);
+            write_int_BLOCK_OR_SINGLETON_little_endian(output_graph_file_binary, edge.object);
+        }
+        output_graph_file_binary.close();
+        manifest.add(output_directory + "condensed_multi_summary_graph.bin", "bisimulator", MANIFEST_NO_LEVEL, this->edges.size());
+
+        for (auto &[level, merged_to_singletons]: this->singleton_mappings)
+        {
+            std::ostringstream current_level_stringstream;
+            current_level_stringstream << std::setw(4) << std::setfill('0') << level;
+            std::ostringstream previous_level_stringstream;
+            previous_level_stringstream << std::setw(4) << std::setfill('0') << level - 1;
+            std::string singleton_mapping_file = output_directory + "singleton_mapping-" + previous_level_stringstream.str() + "to" + current_level_stringstream.str() + ".bin";
+            std::ofstream output_file_binary(singleton_mapping_file, std::ios::trunc | std::ofstream::out);
+            uint64_t singleton_count = 0;
+            for (auto &[merged_block, singletons]: merged_to_singletons)
+            {
+                write_uint_BLOCK_little_endian(output_file_binary, merged_block);
+                write_int_BLOCK_OR_SINGLETON_little_endian(output_file_binary, singletons.size());
+                for (lifetime_or_singleton singleton: singletons)
+                {
+                    write_int_BLOCK_OR_SINGLETON_little_endian(output_file_binary, singleton);
+                }
+                singleton_count += singletons.size();
+            }
+            output_file_binary.close();
+            manifest.add(singleton_mapping_file, "bisimulator", level, merged_to_singletons.size(), singleton_count);
+        }
+
+        // We write the following to disk: {block,start_time,end_time}, sorted by block like create_condensed_summary_graph_from_partitions does
+        std::vector<std::tuple<int64_t, k_type, k_type>> block_intervals;
+        std::vector<std::tuple<k_type, int64_t, int64_t>> level_local_global_triples;
+        for (lifetime_or_singleton lifetime = 0; lifetime < int64_t(this->lifetimes.size()); lifetime++)
+        {
+            const BlockLifetime &block_lifetime = this->lifetimes[lifetime];
+            if (lifetime == this->universal_lifetime && !universal_written)
+            {
+                continue;
+            }
+            block_intervals.emplace_back(global_blocks[lifetime], block_lifetime.start, block_lifetime.end == ALIVE ? final_level : block_lifetime.end);
+            level_local_global_triples.emplace_back(block_lifetime.start, block_lifetime.local_block, global_blocks[lifetime]);
+        }
+        for (auto [singleton, start]: this->singleton_starts)
+        {
+            block_intervals.emplace_back(singleton, start, final_level);
+        }
+        std::sort(block_intervals.begin(), block_intervals.end());
+        std::ofstream output_interval_file_binary(output_directory + "condensed_multi_summary_intervals.bin", std::ios::trunc | std::ofstream::out);
+        for (auto [block, start, end]: block_intervals)
+        {
+            write_int_BLOCK_OR_SINGLETON_little_endian(output_interval_file_binary, block);
+            write_uint_K_TYPE_little_endian(output_interval_file_binary, start);
+            write_uint_K_TYPE_little_endian(output_interval_file_binary, end);
+        }
+        output_interval_file_binary.close();
+        manifest.add(output_directory + "condensed_multi_summary_intervals.bin", "bisimulator", MANIFEST_NO_LEVEL, level_local_global_triples.size() + this->singleton_starts.size());
+
+        std::ofstream output_map_file_binary(output_directory + "condensed_multi_summary_local_global_map.bin", std::ios::trunc | std::ofstream::out);
+        this->write_local_global_map(output_map_file_binary, level_local_global_triples);
+        output_map_file_binary.close();
+        manifest.add(output_directory + "condensed_multi_summary_local_global_map.bin", "bisimulator", MANIFEST_NO_LEVEL, level_local_global_triples.size());
+
+        w.stop_step();
+
+        // The total time and memory are the ones for adding the data edges at every level, and for writing the files
+        auto write_step = w.get_times().back();
+        int64_t total_duration_in_ms = boost::chrono::ceil<boost::chrono::milliseconds>(write_step.duration).count();
+        int maximum_memory_in_kb = write_step.memory_in_kb;
+        for (const LevelStatistics &statistics: this->level_statistics)
+        {
+            total_duration_in_ms += statistics.duration_in_ms;
+            maximum_memory_in_kb = std::max(maximum_memory_in_kb, statistics.memory_in_kb);
+        }
+
+        // After an immediate stop, the summary only has the data edges from level 1 to level 0
+        if (immediate_stop)
+        {
+            int64_t edges_duration_in_ms = 0;
+            int edges_memory_in_kb = 0;
+            for (const LevelStatistics &statistics: this->level_statistics)
+            {
+                edges_duration_in_ms += statistics.duration_in_ms;
+                edges_memory_in_kb = std::max(edges_memory_in_kb, statistics.memory_in_kb);
+            }
+            this->level_statistics = {{1, false, edges_duration_in_ms, edges_memory_in_kb}};
+        }
+        for (const LevelStatistics &statistics: this->level_statistics)
+        {
+            k_type subject_level = statistics.repeated ? statistics.level - 1 : statistics.level;
+            std::ostringstream subject_level_stringstream;
+            subject_level_stringstream << std::setw(4) << std::setfill('0') << subject_level;
+            std::ostringstream object_level_stringstream;
+            object_level_stringstream << std::setw(4) << std::setfill('0') << statistics.level - 1;
+            std::ofstream ad_hoc_output(output_path + "ad_hoc_results/data_edges_statistics_condensed-" + subject_level_stringstream.str() + "to" + object_level_stringstream.str() + ".json", std::ios::trunc);
+            ad_hoc_output << "{\n    \"Time taken (ms)\": " << statistics.duration_in_ms
+                          << ",\n    \"Memory footprint (kB)\": " << statistics.memory_in_kb << "\n}";
+            ad_hoc_output.flush();
+        }
+
+        std::ofstream summary_graph_stats_output(output_path + "ad_hoc_results/summary_graph_stats.json", std::ios::trunc);
+        summary_graph_stats_output << "{\n    \"Vertex count\": " << summary_nodes.size()
+                                   << ",\n    \"Edge count\": " << this->edges.size()
+                                   << ",\n    \"Total time taken (ms)\": " << total_duration_in_ms
+                                   << ",\n    \"Maximum memory footprint (kB)\": " << maximum_memory_in_kb << "\n}";
+        summary_graph_stats_output.close();
+        manifest.add(output_path + "ad_hoc_results/summary_graph_stats.json", "bisimulator");
+
+        std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S") << " vertex count: " << summary_nodes.size() << std::endl;
+        std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S") << " edge count: " << this->edges.size() << std::endl;
+    }
+};
+
+/**
+ * Reads the binary encoded graph from graph_stream and refines the partition up to the fixed point (or until a budget runs out), returning the timed steps.
+ * The input_path is the file the stream reads, lod_pipeline passes an empty path for a graph that only exists in memory.
+ * Without write_partitions the outcome and mapping files are not written, the statistics, graph_stats.json and the manifest always are.
+ */
+template <typename node_index>
+StopWatch<boost::chrono::process_cpu_clock> run_k_bisimulation_store_partition_condensed_timed(std::istream &graph_stream, const std::string &input_path, uint support, const std::string &output_path, bool typed_start,
+                                                                                               const std::string &renumbering, const PredicateFilter &filter, int64_t time_budget_in_s, int64_t memory_budget_in_kb,
+                                                                                               bool condensed_summary, uint8_t partition_file_version, bool write_partitions = true)
+{
+    using block_index = node_index;
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+
+    // The summary graph is built from the data edges that take part in the bisimulation, while create_condensed_summary_graph_from_partitions uses all of them
+    if (condensed_summary && filter.is_active())
+    {
+        throw MyException("The condensed summary can not be built during the bisimulation when predicates are filtered, use create_condensed_summary_graph_from_partitions instead");
+    }
+
+    // A manifest left by an earlier run in this directory would describe files that are about to be overwritten
+    ExperimentManifest::remove(output_path);
+    ExperimentManifest manifest(output_path);
+
+    // The budgets are checked after every level, so the last level is always completely written
+    auto t_start_run{boost::chrono::system_clock::now()};
+    MemoryBudgetWatcher memory_watcher(memory_budget_in_kb);
+    bool fixed_point = true;
+
+    StopWatch<boost::chrono::process_cpu_clock> w = StopWatch<boost::chrono::process_cpu_clock>::create_not_started();
+    Graph<node_index> g;
+    w.start_step("Read graph", true);  // Set newline to true
+    u_int64_t ignored_edge_count = 0;
+    uint64_t edge_count = read_graph_from_stream_timed(graph_stream, g, filter, ignored_edge_count);
+    w.stop_step();
+
+    // The refinement works on the renumbered nodes, the original indices are only restored when writing the outcomes
+    std::vector<node_index> new_to_old;
+    if (renumbering != "none")
+    {
+        auto t_start_renumbering{boost::chrono::system_clock::now()};
+        w.start_step("Renumbering nodes (" + renumbering + ")", true);  // Set newline to true
+        new_to_old = compute_renumbering(g, renumbering);
+        g.renumber(new_to_old);
+        w.stop_step();
+
+        auto t_renumbering_done{boost::chrono::system_clock::now()};
+        auto time_t_renumbering_done{boost::chrono::system_clock::to_time_t(t_renumbering_done)};
+        std::tm *ptm_renumbering_done{std::localtime(&time_t_renumbering_done)};
+        std::cout << std::put_time(ptm_renumbering_done, "%Y/%m/%d %H:%M:%S")
+                  << " Time taken for renumbering (" << renumbering << ") = " << boost::chrono::ceil<boost::chrono::milliseconds>(t_renumbering_done - t_start_renumbering).count()
+                  << " ms, memory = " << w.get_times().back().memory_in_kb << " kB" << std::endl;
+    }
+
+    auto t_start_bisim{boost::chrono::system_clock::now()};
+    auto time_t_start_bisim{boost::chrono::system_clock::to_time_t(t_start_bisim)};
+    std::tm *ptm_start_bisim{std::localtime(&time_t_start_bisim)};
+
+    std::ofstream graph_stats_output(output_path + "ad_hoc_results/graph_stats.json", std::ios::trunc);
+    graph_stats_output << "{\n    \"Vertex count\": " << g.size();
+    graph_stats_output << ",\n    \"Edge count\": " << edge_count;
+    graph_stats_output << ",\n    \"Support\": " << support;
+    if (filter.is_active())
+    {
+        graph_stats_output << ",\n    \"Ignored edge count\": " << ignored_edge_count;
+    }
+
+    std::cout << std::put_time(ptm_start_bisim, "%Y/%m/%d %H:%M:%S") << " Graph read with " << g.size() << " nodes" << std::endl;
+    std::vector<std::string> lines;
+    w.start_step("0000-bisimulation", true);  // Set newline to true
+
+    // We do some pointer trickery here to make sure res will accessible outside of the if-statement
+    // Using a regular pointer here would lead to some issues after calling w.get_times() later
+    std::unique_ptr<KBisumulationOutcome<node_index>> res_ptr;
+    if (!typed_start)
+    {
+        res_ptr = std::make_unique<KBisumulationOutcome<node_index>>(get_0_bisimulation(g));
+        // res_ptr = &trivial_res;
+    }
+    else
+    {
+        res_ptr = std::make_unique<KBisumulationOutcome<node_index>>(get_typed_0_bisimulation(g));
+    }
+    KBisumulationOutcome<node_index> res = *res_ptr;
+
+    // w.pause();
+    // std::cout << "initially one block with " << res.blocks.begin().operator*()->size() << " nodes" << std::endl;
+    // w.resume();
+    std::deque<KBisumulationOutcome<node_index>> outcomes;
+    outcomes.push_back(res);
+    w.stop_step();
+
+    std::unique_ptr<CondensedSummaryBuilder<node_index>> summary_builder;
+    if (condensed_summary)
+    {
+        summary_builder = std::make_unique<CondensedSummaryBuilder<node_index>>(g, new_to_old, typed_start);
+        if (typed_start)
+        {
+            summary_builder->add_typed_start(outcomes[0]);
+        }
+    }
+
+    int previous_total = 0;  // We overwrite this in case we do not start with the trivial/universal outcome for k=0
+
+    // These are the default if we have no typed start (i.e. k=0 contains the global block)
+    block_or_singleton_index pre_accumulated_block_count = 1;
+    block_or_singleton_index accumulated_block_count;
+    if (typed_start)
+    {
+        auto times = w.get_times();
+        auto bisim_step_duration = boost::chrono::ceil<boost::chrono::milliseconds>(times.back().duration).count();
+        auto bisim_step_memory = times.back().memory_in_kb;
+        pre_accumulated_block_count = outcomes[0].total_blocks() - outcomes[0].singleton_block_count();
+        accumulated_block_count = pre_accumulated_block_count + outcomes[0].singleton_block_count();
+
+        write_level_statistics(outcomes[0], accumulated_block_count, bisim_step_duration, bisim_step_memory,
+                               output_path + "ad_hoc_results/statistics_condensed-0000.json");
+
+        if (write_partitions)
+        {
+            w.start_step("0000-bisimulation (condensed) writing outcome to disk", true);  // Set newline to true
+            write_all_blocks_condensed(outcomes[0], output_path + "bisimulation/outcome_condensed-0000.bin", 0, partition_file_version, manifest, new_to_old);
+            w.stop_step();
+        }
+        previous_total = outcomes[0].total_blocks();
+    }
+
+    int i = 0;
+    for (i = 0;; i++)
+    {
+        std::ostringstream k_stringstream;
+        k_stringstream << std::setw(4) << std::setfill('0') << i;
+        std::string k_string(k_stringstream.str());
+
+        std::ostringstream k_next_stringstream;
+        k_next_stringstream << std::setw(4) << std::setfill('0') << i+1;
+        std::string k_next_string(k_next_stringstream.str());
+
+        w.start_step(k_next_string + "-bisimulation");
+        auto res = get_k_bisimulation(g, outcomes[0], support);
+        w.stop_step();
+        auto times = w.get_times();
+        auto bisim_step_duration = boost::chrono::ceil<boost::chrono::milliseconds>(times.back().duration).count();
+        auto bisim_step_memory = times.back().memory_in_kb;
+
+        if (condensed_summary)
+        {
+            w.start_step(k_next_string + "-bisimulation adding condensed data edges");
+            bool repeated_level = summary_builder->add_level(i + 1, outcomes[0], res);
+            w.stop_step();
+            auto summary_step = w.get_times().back();
+            summary_builder->add_level_statistics(i + 1, repeated_level, boost::chrono::ceil<boost::chrono::milliseconds>(summary_step.duration).count(), summary_step.memory_in_kb);
+        }
+        outcomes.pop_front();
+        outcomes.push_back(res);
+
+        block_index new_block_count = 0;
+
+        // We do not care for the first mapping from k=0 to k=1 if it is the trivial mapping.
+        if ((typed_start || i > 0) && write_partitions)
+        {
+            w.start_step(k_next_string + "-bisimulation writing " + k_string + " to " + k_next_string + " refines edges to disk");
+            new_block_count = write_refines_edges_condensed(outcomes[0], output_path + "bisimulation/mapping-" + k_string + "to" + k_next_string + ".bin", i+1, partition_file_version, manifest);
+            w.stop_step();
+        }
+        else if (typed_start || i > 0)
+        {
+            new_block_count = count_new_blocks(outcomes[0]);
+        }
+
+        pre_accumulated_block_count = pre_accumulated_block_count + new_block_count;
+        accumulated_block_count = pre_accumulated_block_count + outcomes[0].singleton_block_count();
+
+        write_level_statistics(outcomes[0], accumulated_block_count, bisim_step_duration, bisim_step_memory,
+                               output_path + "ad_hoc_results/statistics_condensed-" + k_next_string + ".json");
+
+        if (write_partitions)
+        {
+            w.start_step(k_next_string + "-bisimulation (condensed) writing outcome to disk", true);  // Set newline to true
+            write_split_blocks_condensed(outcomes[0], output_path + "bisimulation/outcome_condensed-" + k_next_string + ".bin", i+1, partition_file_version, manifest, new_to_old);
+            // // For the first outcome write the singltons into block 0
+            // if (i == 0 && found_singletons)
+            // {
+            //     block_index singletons_block = 0;
+            //     write_uint_BLOCK_little_endian(condensed_output, u_int64_t(singletons_block));
+            //     write_uint_ENTITY_little_endian(condensed_output, u_int64_t(outcomes[0].singleton_block_count()));  // The reader needs this size to decode the data
+            //     for (node_index node = 0; node<outcomes[0].total_blocks(); node++)
+            //     {
+            //         block_or_singleton_index node_block = outcomes[0].get_block_ID_for_node(node);
+            //         // If the node is in a singleton block, then write to the outcome
+            //         if (node_block < 0)
+            //         {
+            //             write_uint_ENTITY_little_endian(condensed_output, u_int64_t(node));
+            //         }
+            //     }
+            // }
+            w.stop_step();
+        }
+        
+        int new_total = outcomes[0].total_blocks();
+
+        auto now{boost::chrono::system_clock::to_time_t(boost::chrono::system_clock::now())};
+        std::tm *ptm{std::localtime(&now)};
+        std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S")
+                  << " level " << i + 1
+                  << ", blocks = " << outcomes[0].total_blocks()
+                  << ", accumulated blocks = " << accumulated_block_count
+                  << ", singletons = " << outcomes[0].singleton_block_count()
+                  << ", total = " << new_total
+                  << ", time = " << bisim_step_duration << " ms"
+                  << ", memory = " << bisim_step_memory << " kB" << std::endl;
+        if (new_total == previous_total)
+        {
+            break;
+        }
+        previous_total = new_total;
+
+        auto elapsed_in_s = boost::chrono::duration_cast<boost::chrono::seconds>(boost::chrono::system_clock::now() - t_start_run).count();
+        bool time_budget_exhausted = time_budget_in_s > 0 && elapsed_in_s >= time_budget_in_s;
+        bool memory_budget_exhausted = memory_watcher.is_exceeded();
+        if (time_budget_exhausted || memory_budget_exhausted)
+        {
+            std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S")
+                      << " Stopping after level " << i + 1 << " without reaching the fixed point, the "
+                      << (time_budget_exhausted ? "time budget of " + std::to_string(time_budget_in_s) + " s" : "memory budget of " + std::to_string(memory_budget_in_kb) + " kB")
+                      << " has been exhausted" << std::endl;
+            // The last level is not a repetition of the level before it, so it counts towards the depth
+            fixed_point = false;
+            i++;
+            break;
+        }
+    }
+
+    if (condensed_summary)
+    {
+        w.start_step("Writing condensed summary graph", true);  // Set newline to true
+        summary_builder->write(output_path, i, manifest);
+        w.stop_step();
+    }
+
+    // Print the clock
+    std::cout << "\n" << w.to_string() << "\n" << std::endl;
+
+    // Print and store the total time and memory
+    auto t_bisim_done{boost::chrono::system_clock::now()};
+    auto time_t_bisim_done{boost::chrono::system_clock::to_time_t(t_bisim_done)};
+    std::tm *ptm_bisim_done{std::localtime(&time_t_bisim_done)};
+    auto max_memory = w.get_times()[0].memory_in_kb;
+    for (auto step : w.get_times())
+    {
+        max_memory = std::max(max_memory, step.memory_in_kb);
+    }
+    std::cout << std::put_time(ptm_bisim_done, "%Y/%m/%d %H:%M:%S")
+              << " Time taken for the bisimulation = " << boost::chrono::ceil<boost::chrono::milliseconds>(t_bisim_done - t_start_bisim).count() << " ms" << std::endl;
+    std::cout << std::put_time(ptm_bisim_done, "%Y/%m/%d %H:%M:%S")
+              << " Maximum memory footprint = " << max_memory << " kB" << std::endl;
+    graph_stats_output << ",\n    \"Total time taken (ms)\": " << boost::chrono::ceil<boost::chrono::milliseconds>(t_bisim_done - t_start_bisim).count()
+                       << ",\n    \"Maximum memory footprint (kB)\": " << max_memory
+                       << ",\n    \"Final depth\": " << i //TODO make an implementation for a fixed k (instead of always doing the full bisimulation)
+                       << ",\n    \"Fixed point\": " << (fixed_point ? "true" : "false") << "\n}";
+    graph_stats_output.close();
+
+    // The manifest is written last, such that it only exists for a completed run
+    manifest.set_graph_facts(g.size(), i, fixed_point);
+    manifest.add(output_path + "ad_hoc_results/graph_stats.json", "bisimulator");
+    if (input_path != "" && input_path.compare(0, output_path.size(), output_path) == 0)
+    {
+        manifest.add(input_path, "bisimulator", MANIFEST_NO_LEVEL, edge_count);  // The graph is listed when it is part of the experiment directory
+    }
+    manifest.write();
+    return w;
+}
+
+/**
+ * Reads a single (integer) value from one of the json files in ad_hoc_results.
+ */
+inline int64_t read_statistic_from_json_file(const std::string &filename, const std::string &key)
+{
+    std::ifstream statistics_stream(filename);
+    std::string statistics_line;
+    std::string key_string = "\"" + key + "\"";
+    while (std::getline(statistics_stream, statistics_line))
+    {
+        boost::trim(statistics_line);
+        boost::erase_all(statistics_line, ",");
+        std::vector<std::string> result;
+        boost::split(result, statistics_line, boost::is_any_of(":"));
+        if (result[0] == key_string)
+        {
+            std::stringstream sstream(result[1]);
+            int64_t value;
+            sstream >> value;
+            return value;
+        }
+    }
+    throw MyException("Could not find " + key_string + " in " + filename);
+}
+
+template <typename node_index>
+void run_k_bisimulation_incremental_timed(const std::string &previous_path, const std::string &added_file, const std::string &removed_file, const std::string &output_path, bool verify,
+                                          uint8_t partition_file_version)
+{
+    using block_index = node_index;
+    using block_or_singleton_index = std::make_signed_t<node_index>;
+    StopWatch<boost::chrono::process_cpu_clock> w = StopWatch<boost::chrono::process_cpu_clock>::create_not_started();
+    // The full recomputation for the verification is timed separately, such that it does not influence the reported times
+    boost::chrono::system_clock::duration verification_duration = boost::chrono::system_clock::duration::zero();
+
+    ExperimentManifest::remove(output_path);
+    ExperimentManifest manifest(output_path);
+
+    // The previous experiment determines whether we start from the typed partition
+    bool typed_start = std::filesystem::exists(previous_path + "bisimulation/outcome_condensed-0000.bin");
+
+    Graph<node_index> g;
+    node_index previous_graph_size;
+    boost::unordered_flat_set<node_index> touched_nodes;
+    w.start_step("Read graph", true);  // Set newline to true
+    uint64_t edge_count = read_graph_with_delta_timed(previous_path + "binary_encoding.bin", added_file, removed_file, output_path + "binary_encoding.bin", g, previous_graph_size, touched_nodes);
+    w.stop_step();
+
+    // Nodes that were not in the previous graph have no previous block, so they are always recomputed
+    for (node_index node = previous_graph_size; node < g.size(); node++)
+    {
+        touched_nodes.emplace(node);
+    }
+
+    auto t_start_bisim{boost::chrono::system_clock::now()};
+    auto time_t_start_bisim{boost::chrono::system_clock::to_time_t(t_start_bisim)};
+    std::tm *ptm_start_bisim{std::localtime(&time_t_start_bisim)};
+
+    std::ofstream graph_stats_output(output_path + "ad_hoc_results/graph_stats.json", std::ios::trunc);
+    graph_stats_output << "{\n    \"Vertex count\": " << g.size();
+    graph_stats_output << ",\n    \"Edge count\": " << edge_count;
+    graph_stats_output << ",\n    \"Support\": 1";  // The incremental refinement always uses the default support
+
+    std::cout << std::put_time(ptm_start_bisim, "%Y/%m/%d %H:%M:%S") << " Graph read with " << g.size() << " nodes ("
+              << g.size() - previous_graph_size << " new)" << std::endl;
+    w.start_step("0000-bisimulation", true);  // Set newline to true
+
+    PreviousPartition<node_index> previous_outcome(previous_graph_size, typed_start, previous_path + "bisimulation/outcome_condensed-0000.bin");
+
+    std::unique_ptr<KBisumulationOutcome<node_index>> res_ptr;
+    boost::unordered_flat_set<node_index> moved_nodes;
+    if (!typed_start)
+    {
+        // Only the new nodes move, the universal block of the previous experiment maps to the new one
+        res_ptr = std::make_unique<KBisumulationOutcome<node_index>>(get_0_bisimulation(g));
+        boost::unordered_flat_set<node_index> new_nodes;
+        for (node_index node = previous_graph_size; node < g.size(); node++)
+        {
+            new_nodes.emplace(node);
+        }
+        collect_moved_nodes(*res_ptr, previous_outcome, new_nodes, moved_nodes);
+    }
+    else
+    {
+        // The typed partition is cheap to compute, so we fully recompute it. Only the touched nodes can have a different type set.
+        res_ptr = std::make_unique<KBisumulationOutcome<node_index>>(get_typed_0_bisimulation(g));
+        collect_moved_nodes(*res_ptr, previous_outcome, touched_nodes, moved_nodes);
+    }
+    KBisumulationOutcome<node_index> res = *res_ptr;
+
+    std::deque<KBisumulationOutcome<node_index>> outcomes;
+    outcomes.push_back(res);
+    w.stop_step();
+
+    std::deque<KBisumulationOutcome<node_index>> verification_outcomes;
+    if (verify)
+    {
+        verification_outcomes.push_back(res);
+    }
+
+    int previous_total = 0;  // We overwrite this in case we do not start with the trivial/universal outcome for k=0
+
+    // These are the default if we have no typed start (i.e. k=0 contains the global block)
+    block_or_singleton_index pre_accumulated_block_count = 1;
+    block_or_singleton_index accumulated_block_count;
+    if (typed_start)
+    {
+        auto times = w.get_times();
+        auto bisim_step_duration = boost::chrono::ceil<boost::chrono::milliseconds>(times.back().duration).count();
+        auto bisim_step_memory = times.back().memory_in_kb;
+
+        pre_accumulated_block_count = outcomes[0].total_blocks() - outcomes[0].singleton_block_count();
+        accumulated_block_count = pre_accumulated_block_count + outcomes[0].singleton_block_count();
+
+        write_level_statistics(outcomes[0], accumulated_block_count, bisim_step_duration, bisim_step_memory,
+                               output_path + "ad_hoc_results/statistics_condensed-0000.json");
+
+        w.start_step("0000-bisimulation (condensed) writing outcome to disk", true);  // Set newline to true
+        write_all_blocks_condensed(outcomes[0], output_path + "bisimulation/outcome_condensed-0000.bin", 0, partition_file_version, manifest);
+        w.stop_step();
+        previous_total = outcomes[0].total_blocks();
+    }
+
+    node_index recomputed_node_total = 0;
+    int i = 0;
+    for (i = 0;; i++)
+    {
+        std::ostringstream k_stringstream;
+        k_stringstream << std::setw(4) << std::setfill('0') << i;
+        std::string k_string(k_stringstream.str());
+
+        std::ostringstream k_next_stringstream;
+        k_next_stringstream << std::setw(4) << std::setfill('0') << i+1;
+        std::string k_next_string(k_next_stringstream.str());
+
+        w.start_step(k_next_string + "-bisimulation");
+        // Without a typed start, the trivial mapping from k=0 to k=1 was not written, so we derive whether the universal block split
+        bool split_universal_block = false;
+        if (!typed_start && i == 0)
+        {
+            split_universal_block = std::filesystem::file_size(previous_path + "bisimulation/outcome_condensed-0001.bin") > 0 ||
+                                    read_statistic_from_json_file(previous_path + "ad_hoc_results/statistics_condensed-0001.json", "Singleton count") > 0;
+        }
+        boost::unordered_flat_map<block_index, PreviousSplit<node_index>> previous_splits = previous_outcome.advance(
+            previous_path + "bisimulation/mapping-" + k_string + "to" + k_next_string + ".bin",
+            previous_path + "bisimulation/outcome_condensed-" + k_next_string + ".bin",
+            split_universal_block);
+
+        // The dirty nodes are the touched nodes, the moved nodes and everything that points to a moved node
+        boost::unordered_flat_set<node_index> dirty_nodes(touched_nodes);
+        for (node_index moved_node : moved_nodes)
+        {
+            dirty_nodes.emplace(moved_node);
+            for (node_index source : g.reverse.at(moved_node))
+            {
+                dirty_nodes.emplace(source);
+            }
+        }
+        recomputed_node_total += dirty_nodes.size();
+        moved_nodes.clear();
+
+        auto res = get_k_bisimulation_incremental(g, outcomes[0], previous_outcome, previous_splits, dirty_nodes, moved_nodes);
+        outcomes.pop_front();
+        outcomes.push_back(res);
+        w.stop_step();
+        auto times = w.get_times();
+        auto bisim_step_duration = boost::chrono::ceil<boost::chrono::milliseconds>(times.back().duration).count();
+        auto bisim_step_memory = times.back().memory_in_kb;
+
+        block_index new_block_count = 0;
+
+        // We do not care for the first mapping from k=0 to k=1 if it is the trivial mapping.
+        if (typed_start || i > 0)
+        {
+            w.start_step(k_next_string + "-bisimulation writing " + k_string + " to " + k_next_string + " refines edges to disk");
+            new_block_count = write_refines_edges_condensed(outcomes[0], output_path + "bisimulation/mapping-" + k_string + "to" + k_next_string + ".bin", i+1, partition_file_version, manifest);
+            w.stop_step();
+        }
+
+        pre_accumulated_block_count = pre_accumulated_block_count + new_block_count;
+        accumulated_block_count = pre_accumulated_block_count + outcomes[0].singleton_block_count();
+
+        write_level_statistics(outcomes[0], accumulated_block_count, bisim_step_duration, bisim_step_memory,
+                               output_path + "ad_hoc_results/statistics_condensed-" + k_next_string + ".json");
+
+        w.start_step(k_next_string + "-bisimulation (condensed) writing outcome to disk", true);  // Set newline to true
+        write_split_blocks_condensed(outcomes[0], output_path + "bisimulation/outcome_condensed-" + k_next_string + ".bin", i+1, partition_file_version, manifest);
+        w.stop_step();
+
+        int new_total = outcomes[0].total_blocks();
+
+        auto now{boost::chrono::system_clock::to_time_t(boost::chrono::system_clock::now())};
+        std::tm *ptm{std::localtime(&now)};
+        std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S")
+                  << " level " << i + 1
+                  << ", blocks = " << outcomes[0].total_blocks()
+                  << ", accumulated blocks = " << accumulated_block_count
+                  << ", singletons = " << outcomes[0].singleton_block_count()
+                  << ", total = " << new_total
+                  << ", recomputed nodes = " << dirty_nodes.size()
+                  << ", moved nodes = " << moved_nodes.size()
+                  << ", time = " << bisim_step_duration << " ms"
+                  << ", memory = " << bisim_step_memory << " kB" << std::endl;
+
+        if (verify)
+        {
+            auto t_start_verification{boost::chrono::system_clock::now()};
+            auto full_res = get_k_bisimulation(g, verification_outcomes[0]);
+            verification_outcomes.pop_front();
+            verification_outcomes.push_back(full_res);
+            verification_duration += boost::chrono::system_clock::now() - t_start_verification;
+            if (!partitions_are_equal(outcomes[0], verification_outcomes[0], g.size()))
+            {
+                throw MyException("Verification failed: the incremental partition at level " + std::to_string(i + 1) + " differs from the full recomputation");
+            }
+        }
+
+        if (new_total == previous_total)
+        {
+            break;
+        }
+        previous_total = new_total;
+    }
+
+    // Print the clock
+    std::cout << "\n" << w.to_string() << "\n" << std::endl;
+
+    // Print and store the total time and memory
+    auto t_bisim_done{boost::chrono::system_clock::now()};
+    auto time_t_bisim_done{boost::chrono::system_clock::to_time_t(t_bisim_done)};
+    std::tm *ptm_bisim_done{std::localtime(&time_t_bisim_done)};
+    auto max_memory = w.get_times()[0].memory_in_kb;
+    for (auto step : w.get_times())
+    {
+        max_memory = std::max(max_memory, step.memory_in_kb);
+    }
+    // The verification is not part of the incremental computation, so it is not included in the total time
+    auto bisim_duration = boost::chrono::ceil<boost::chrono::milliseconds>(t_bisim_done - t_start_bisim - verification_duration);
+    std::cout << std::put_time(ptm_bisim_done, "%Y/%m/%d %H:%M:%S")
+              << " Time taken for the incremental bisimulation = " << bisim_duration.count() << " ms"
+              << ", recomputed " << recomputed_node_total << " node signatures over " << i + 1 << " levels" << std::endl;
+    std::cout << std::put_time(ptm_bisim_done, "%Y/%m/%d %H:%M:%S")
+              << " Maximum memory footprint = " << max_memory << " kB" << std::endl;
+    if (verify)
+    {
+        std::cout << std::put_time(ptm_bisim_done, "%Y/%m/%d %H:%M:%S")
+                  << " Verification succeeded, all " << i + 1 << " levels match the full recomputation (time taken for the full recomputation = "
+                  << boost::chrono::ceil<boost::chrono::milliseconds>(verification_duration).count() << " ms)" << std::endl;
+    }
+    graph_stats_output << ",\n    \"Total time taken (ms)\": " << bisim_duration.count()
+                       << ",\n    \"Maximum memory footprint (kB)\": " << max_memory
+                       << ",\n    \"Final depth\": " << i
+                       << ",\n    \"Fixed point\": true" << "\n}";
+    graph_stats_output.close();
+
+    manifest.set_graph_facts(g.size(), i, true);
+    manifest.add(output_path + "ad_hoc_results/graph_stats.json", "bisimulator");
+    manifest.add(output_path + "binary_encoding.bin", "bisimulator", MANIFEST_NO_LEVEL, edge_count);
+    manifest.write();
+}
+
+/**
+ * Returns the number of vertices the graph reader creates for the binary encoded triples in the file, i.e. the highest entity ID plus one.
+ */
+inline u_int64_t read_vertex_count(const std::string &filename)
+{
+    const int BYTES_PER_TRIPLE = 2 * BYTES_PER_ENTITY + BYTES_PER_PREDICATE;
+    std::ifstream inputstream(filename, std::ifstream::in | std::ifstream::binary);
+    if (!inputstream.is_open())
+    {
+        throw MyException("Could not open the binary encoded graph: " + filename);
+    }
+    auto read_entity = [](const unsigned char *data)
+    {
+        u_int64_t result = 0;
+        for (int i = BYTES_PER_ENTITY - 1; i >= 0; i--)
+        {
+            result = (result << 8) | data[i];
+        }
+        return result;
+    };
+    // Read many triples at once, this is only a fraction of the time needed to actually read the graph
+    std::vector<unsigned char> buffer(BYTES_PER_TRIPLE * 65536);
+    u_int64_t vertex_count = 0;
+    while (true)
+    {
+        inputstream.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+        std::size_t triple_count = inputstream.gcount() / BYTES_PER_TRIPLE;
+        for (std::size_t triple = 0; triple < triple_count; triple++)
+        {
+            const unsigned char *triple_data = buffer.data() + triple * BYTES_PER_TRIPLE;
+            u_int64_t subject_index = read_entity(triple_data);
+            u_int64_t object_index = read_entity(triple_data + BYTES_PER_ENTITY + BYTES_PER_PREDICATE);
+            vertex_count = std::max(vertex_count, std::max(subject_index, object_index) + 1);
+        }
+        if (!inputstream)
+        {
+            break;
+        }
+    }
+    return vertex_count;
+}
+
+/**
+ * Whether the refinement can use 32-bit node indices, which halves the memory used for the graph, its reverse index, the blocks and the node to block mapping.
+ * Singletons get negative block indices, so the vertex count has to fit in a signed 32-bit integer.
+ */
+inline bool fits_32_bit_node_index(u_int64_t vertex_count)
+{
+    return vertex_count <= u_int64_t(std::numeric_limits<int32_t>::max());
+}
+
+inline void log_node_index_width(u_int64_t vertex_count, bool use_32_bit_node_index)
+{
+    auto now{boost::chrono::system_clock::to_time_t(boost::chrono::system_clock::now())};
+    std::tm *ptm{std::localtime(&now)};
+    std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S") << " Using " << (use_32_bit_node_index ? 32 : 64)
+              << "-bit node indices for " << vertex_count << " vertices" << std::endl;
+}
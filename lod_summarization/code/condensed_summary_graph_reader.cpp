@@ -7,6 +7,7 @@
 #include <boost/unordered/unordered_flat_map.hpp>
 #include <iostream>
 #include <boost/program_options.hpp>
+#include "partition_file.hpp"
 // #include <vector>
 
 const int BYTES_PER_ENTITY = 5;
@@ -62,7 +63,7 @@ int main(int ac, char *av[])
     std::map<uint32_t,std::map<u_int64_t,std::vector<u_int64_t>>> block_to_entity_maps;
     while (!final_file)
     {
-        std::ifstream outcome_file(input_path + "_outcome_condensed-" + std::to_string(k) + ".bin", std::ifstream::in);
+        PartitionFileStream outcome_file(input_path + "_outcome_condensed-" + std::to_string(k) + ".bin", PARTITION_FILE_OUTCOME);
         u_int64_t block_count = 0;
         // block_to_entity_maps[k] = std::map<u_int64_t,std::vector<u_int64_t>>>;
         while (true)
@@ -92,7 +93,7 @@ int main(int ac, char *av[])
     k = 1;
     while (!final_file)
     {
-        std::ifstream edge_file(input_path + "_mapping-" + std::to_string(k) + "to" + std::to_string(k+1) + ".bin", std::ifstream::in);
+        PartitionFileStream edge_file(input_path + "_mapping-" + std::to_string(k) + "to" + std::to_string(k+1) + ".bin", PARTITION_FILE_MAPPING);
         u_int64_t split_count = 0;
         // std::cout << "K: " << std::to_string(k) << "-->" << std::to_string(k+1) << std::endl;
         std::string mapping_msg_lhs = "K" + std::to_string(k) + "-" + std::to_string(k+1) + ": ";
@@ -1,9 +1,18 @@
 #include <cstdint>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <iterator>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <tuple>
+#include <thread>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 // #define BOOST_USE_VALGRIND  // TODO disable this command in the final running version
 #define BOOST_CHRONO_HEADER_ONLY
 #include <boost/chrono.hpp>
@@ -15,15 +24,17 @@
 #include <filesystem>
 #include <boost/algorithm/algorithm.hpp>
 #include <boost/algorithm/string.hpp>
+#include "partition_file.hpp"
+#include "experiment_manifest.hpp"
+#include "stage_cache.hpp"
 
 using edge_type = uint32_t;
 using node_index = uint64_t;
 using block_index = node_index;
 using block_or_singleton_index = int64_t;
 using k_type = uint16_t;
-using node_to_block_map_type = boost::unordered_flat_map<node_index, block_or_singleton_index>;
+using node_to_block_map_type = std::vector<block_or_singleton_index>;  // Indexed by node, since every node from 0 up to the vertex count has a block
 using local_to_global_map = boost::unordered_flat_map<std::pair<k_type,block_or_singleton_index>,block_or_singleton_index>;
-using predicate_object_pair_set = boost::unordered_flat_set<std::pair<edge_type,block_or_singleton_index>>;
 using time_interval = std::pair<k_type, k_type>;
 using interval_map = boost::unordered_flat_map<block_or_singleton_index, time_interval>;
 
@@ -32,7 +43,9 @@ const int BYTES_PER_PREDICATE = 4;
 const int BYTES_PER_BLOCK = 4;
 const int BYTES_PER_BLOCK_OR_SINGLETON = 5;
 const int BYTES_PER_K_TYPE = 2;
+const int BYTES_PER_OFFSET = 8;
 const int64_t MAX_SIGNED_BLOCK_SIZE = INT64_MAX;
+const std::string MANIFEST_PRODUCER = "create_condensed_summary_graph_from_partitions";
 // const k_type DEFAULT_TIME_VALUE = 1;
 
 const std::string outcome_file_regex_string = R"(^outcome_condensed-\d{4}\.bin$)";
@@ -40,6 +53,9 @@ const std::string mapping_file_regex_string = R"(^mapping-\d{4}to\d{4}\.bin$)";
 std::regex outcome_file_regex_pattern(outcome_file_regex_string);
 std::regex mapping_file_regex_pattern(mapping_file_regex_string);
 
+const std::string LOCAL_GLOBAL_MAP_MAGIC = "LGMP";
+const uint8_t LOCAL_GLOBAL_MAP_VERSION = 2;
+
 #define CREATE_REVERSE_INDEX
 
 class MyException : public std::exception
@@ -230,6 +246,26 @@ void write_uint_PREDICATE_little_endian(std::ostream &outputstream, edge_type va
     }
 }
 
+void write_uint_OFFSET_little_endian(std::ostream &outputstream, uint64_t value)
+{
+    char data[BYTES_PER_OFFSET];
+    for (unsigned int i = 0; i < BYTES_PER_OFFSET; i++)
+    {
+        data[i] = char(value & 0x00000000000000FFull);
+        value = value >> 8;
+    }
+    outputstream.write(data, BYTES_PER_OFFSET);
+    if (outputstream.fail())
+    {
+        std::cout << "Write offset failed with code: " << outputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << outputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << outputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (outputstream.fail() && !outputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << outputstream.bad() << std::endl;
+        exit(outputstream.rdstate());
+    }
+}
+
 u_int64_t read_uint_ENTITY_little_endian(std::istream &inputstream)
 {
     char data[8];
@@ -511,116 +547,249 @@ public:
     }
 };
 
-class NodeSet
+// Keeps the members of every block as a sorted range in one flat vector (similar to a CSR layout)
+// Blocks that are rewritten by an outcome get a new range appended, so the ranges of the other blocks (and the old ranges of rewritten blocks) stay valid
+class BlockMembership
 {
 private:
-    boost::unordered_flat_set<node_index> nodes;
+    std::vector<node_index> members;
+    std::vector<std::pair<uint64_t,uint64_t>> ranges;  // Indexed by block: {offset into members, size}
+    uint64_t live_member_count = 0;
+
+    void compact()
+    {
+        std::vector<node_index> compacted_members;
+        compacted_members.reserve(this->live_member_count);
+        for (auto &range: this->ranges)
+        {
+            uint64_t new_offset = compacted_members.size();
+            compacted_members.insert(compacted_members.end(), this->members.begin() + range.first, this->members.begin() + range.first + range.second);
+            range.first = new_offset;
+        }
+        this->members = std::move(compacted_members);
+    }
 
 public:
-    NodeSet()
+    BlockMembership()
     {
     }
-    void add_node(node_index node)
+    // Appends the members of all blocks in an outcome file, and updates node_to_block_map accordingly
+    void read_outcome(std::istream &outcome_file, node_to_block_map_type &node_to_block_map)
     {
-        nodes.emplace(node);  // Should the be emplace or insert?
+        while (true)
+        {
+            block_index block = read_uint_BLOCK_little_endian(outcome_file);
+            if (outcome_file.eof())
+            {
+                break;
+            }
+            assert(block <= MAX_SIGNED_BLOCK_SIZE);  // Later, we are storing a block_index as a block_or_singleton_index, so we need to check if the cast is possible
+            u_int64_t block_size = read_uint_ENTITY_little_endian(outcome_file);
+            uint64_t offset = this->members.size();
+            for (uint64_t i = 0; i < block_size; i++)
+            {
+                node_index node = read_uint_ENTITY_little_endian(outcome_file);
+                node_to_block_map[node] = (block_or_singleton_index) block;
+                this->members.push_back(node);
+            }
+            std::sort(this->members.begin() + offset, this->members.end());
+            this->set_range(block, {offset, block_size});
+        }
     }
-    boost::unordered_flat_set<node_index>& get_nodes()
+    // Makes room for the members of an outcome file with the given number of members (as listed in the manifest), such that reading it does not reallocate
+    void reserve_members(uint64_t member_count)
     {
-        return nodes;
+        uint64_t required_capacity = this->members.size() + member_count;
+        if (required_capacity > this->members.capacity())
+        {
+            this->members.reserve(std::max(required_capacity, 2 * this->members.capacity()));  // Grow geometrically, since every level appends its members
+        }
     }
-    void remove_node(node_index node)
+    void set_range(block_index block, std::pair<uint64_t,uint64_t> range)
     {
-        nodes.erase(node);
+        if (block >= this->ranges.size())
+        {
+            this->ranges.resize(block + 1, {0, 0});
+        }
+        this->live_member_count -= this->ranges[block].second;
+        this->live_member_count += range.second;
+        this->ranges[block] = range;
     }
-};
-
-class BlockMap
-{
-private:
-    boost::unordered_flat_map<block_or_singleton_index,NodeSet> block_map;
-
-public:
-    BlockMap()
+    void clear_block(block_index block)
     {
+        if (block < this->ranges.size())
+        {
+            this->set_range(block, {0, 0});
+        }
     }
-    boost::unordered_flat_map<block_or_singleton_index,NodeSet>& get_map()
+    // Appends the (sorted) members of a block to a vector
+    void append_members(block_index block, std::vector<node_index> &output) const
     {
-        return block_map;
+        if (block < this->ranges.size())
+        {
+            auto range = this->ranges[block];
+            output.insert(output.end(), this->members.begin() + range.first, this->members.begin() + range.first + range.second);
+        }
     }
-    NodeSet& get_node_set(block_or_singleton_index local_block)
+    uint64_t get_size(block_index block) const
     {
-        auto key_val_iterator = this->get_map().find(local_block);
-        assert(key_val_iterator != this->get_map().end());  // The queried block must exist as a key
-        return (*key_val_iterator).second;
+        return block < this->ranges.size() ? this->ranges[block].second : 0;
     }
-    void add_node(block_or_singleton_index merged_block, node_index node)
+    block_index get_block_count() const
     {
-        if (this->get_map().find(merged_block) == this->get_map().end())
+        return this->ranges.size();
+    }
+    // Drops the ranges that are not used anymore, once they take up more space than the live ones
+    void compact_if_needed()
+    {
+        if (this->members.size() > 2 * this->live_member_count + 1024)
         {
-            NodeSet empty_node_set = NodeSet();
-            block_map[merged_block] = empty_node_set;
+            this->compact();
         }
-        block_map[merged_block].add_node(node);
     }
 };
 
+// Keeps track of which singletons were created from which merged block at every level
+// The singletons of a level are written to singleton_mapping-XXXXtoYYYY.bin as soon as they are known, and the file is only mapped back into
+// memory when the backward pass reaches that level, so at most one level is held in memory at a time
 class SingletonMapper
 {
 private:
-    boost::unordered_flat_map<k_type,BlockMap> block_to_singletons;
+    std::string output_directory;
+    k_type mapped_level = 0;
+    const unsigned char *mapped_data = nullptr;
+    uint64_t mapped_size = 0;
+    boost::unordered_flat_map<block_index, std::pair<uint64_t,uint64_t>> merged_block_ranges;  // For the mapped level: {offset of the first singleton, singleton count}
+    std::vector<std::tuple<k_type,uint64_t,uint64_t>> written_levels;  // {level, merged block count, singleton count} for every written file
 
-public:
-    SingletonMapper()
+    SingletonMapper(SingletonMapper &)
+    {
+    }
+
+    std::string get_file_path(k_type k) const
     {
+        std::ostringstream current_level_stringstream;
+        current_level_stringstream << std::setw(4) << std::setfill('0') << k;
+        std::ostringstream previous_level_stringstream;
+        previous_level_stringstream << std::setw(4) << std::setfill('0') << k-1;
+        return this->output_directory + "singleton_mapping-" + previous_level_stringstream.str() + "to" + current_level_stringstream.str() + ".bin";
     }
-    boost::unordered_flat_map<k_type,BlockMap>& get_maps()
+    void unmap_level()
     {
-        return block_to_singletons;
+        if (this->mapped_data != nullptr)
+        {
+            munmap((void *) this->mapped_data, this->mapped_size);
+        }
+        this->mapped_data = nullptr;
+        this->mapped_size = 0;
+        this->merged_block_ranges.clear();
     }
-    BlockMap& get_map(k_type k)
+    void map_level(k_type k)
     {
-        return block_to_singletons[k];
+        this->unmap_level();
+        this->mapped_level = k;
+        std::string file_path = this->get_file_path(k);
+        int file_descriptor = open(file_path.c_str(), O_RDONLY);
+        if (file_descriptor == -1)
+        {
+            throw MyException("Could not open " + file_path);
+        }
+        struct stat file_status;
+        fstat(file_descriptor, &file_status);
+        this->mapped_size = file_status.st_size;
+        if (this->mapped_size > 0)  // An empty file can not be mapped
+        {
+            void *data = mmap(nullptr, this->mapped_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+            if (data == MAP_FAILED)
+            {
+                close(file_descriptor);
+                throw MyException("Could not map " + file_path + " into memory");
+            }
+            this->mapped_data = (const unsigned char *) data;
+        }
+        close(file_descriptor);
+
+        // Every entry is {merged block, singleton count, singletons}
+        uint64_t offset = 0;
+        while (offset < this->mapped_size)
+        {
+            block_index merged_block = this->read_little_endian(offset, BYTES_PER_BLOCK);
+            uint64_t singleton_count = this->read_little_endian(offset + BYTES_PER_BLOCK, BYTES_PER_BLOCK_OR_SINGLETON);
+            offset += BYTES_PER_BLOCK + BYTES_PER_BLOCK_OR_SINGLETON;
+            this->merged_block_ranges[merged_block] = {offset, singleton_count};
+            offset += singleton_count * BYTES_PER_BLOCK_OR_SINGLETON;
+        }
     }
-    void add_level(k_type k)
+    uint64_t read_little_endian(uint64_t offset, unsigned int byte_count) const
     {
-        assert(this->get_maps().count(k) == 0);  // The block map should not exist
-        BlockMap empty_block_map = BlockMap();
-        block_to_singletons[k] = empty_block_map;
+        uint64_t value = 0;
+        for (unsigned int i = 0; i < byte_count; i++)
+        {
+            value |= uint64_t(this->mapped_data[offset + i]) << (i * 8);
+        }
+        return value;
     }
-    void add_mapping(k_type k, block_or_singleton_index merged_block, node_index singleton)
+
+public:
+    SingletonMapper(const std::string &output_directory) : output_directory(output_directory)
     {
-        block_to_singletons[k].add_node(merged_block, singleton);
     }
-    void write_map_to_file_binary(std::string output_directory)
+    ~SingletonMapper()
     {
-        for (auto block_to_singleton_map: this->get_maps())
+        this->unmap_level();
+    }
+    // Writes the singletons that were created at level k, given as {merged block, singleton} pairs
+    void write_level(k_type k, std::vector<std::pair<block_index,node_index>> &merged_singleton_pairs)
+    {
+        std::sort(merged_singleton_pairs.begin(), merged_singleton_pairs.end());
+        std::ofstream output_file_binary(this->get_file_path(k), std::ios::trunc | std::ofstream::out);
+        uint64_t merged_block_count = 0;
+        auto group_begin = merged_singleton_pairs.cbegin();
+        while (group_begin != merged_singleton_pairs.cend())
         {
-            k_type current_level = block_to_singleton_map.first;
-
-            std::ostringstream current_level_stringstream;
-            current_level_stringstream << std::setw(4) << std::setfill('0') << current_level;
-            std::string current_level_string(current_level_stringstream.str());
-
-            std::ostringstream previous_level_stringstream;
-            previous_level_stringstream << std::setw(4) << std::setfill('0') << current_level-1;
-            std::string previous_level_string(previous_level_stringstream.str());
-
-            std::string output_file_path = output_directory + "singleton_mapping-" + previous_level_string + "to" + current_level_string + ".bin";
-            std::ofstream output_file_binary(output_file_path, std::ios::trunc | std::ofstream::out);
-
-            for (auto merged_singletons_pair: block_to_singleton_map.second.get_map())
+            block_index merged_block = group_begin->first;
+            auto group_end = std::find_if(group_begin, merged_singleton_pairs.cend(), [merged_block](const auto &pair){return pair.first != merged_block;});
+            merged_block_count++;
+            write_uint_BLOCK_little_endian(output_file_binary, merged_block);
+            write_int_BLOCK_OR_SINGLETON_little_endian(output_file_binary, group_end - group_begin);
+            for (auto it = group_begin; it != group_end; it++)
             {
-                block_index merged_block = (block_index) merged_singletons_pair.first;
-                block_or_singleton_index singleton_count = (block_or_singleton_index) merged_singletons_pair.second.get_nodes().size();
-                write_uint_BLOCK_little_endian(output_file_binary,merged_block);
-                write_int_BLOCK_OR_SINGLETON_little_endian(output_file_binary,singleton_count);
-                for (auto singleton: merged_singletons_pair.second.get_nodes())
-                {
-                    block_or_singleton_index singleton_block = (block_or_singleton_index) -(singleton+1);
-                    write_int_BLOCK_OR_SINGLETON_little_endian(output_file_binary,singleton_block);
-                }
+                block_or_singleton_index singleton_block = (block_or_singleton_index) -(it->second+1);
+                write_int_BLOCK_OR_SINGLETON_little_endian(output_file_binary, singleton_block);
             }
-            output_file_binary.flush();
+            group_begin = group_end;
+        }
+        output_file_binary.flush();
+        this->written_levels.emplace_back(k, merged_block_count, merged_singleton_pairs.size());
+    }
+    void add_to_manifest(ExperimentManifest &manifest) const
+    {
+        for (auto [k, merged_block_count, singleton_count]: this->written_levels)
+        {
+            manifest.add(this->get_file_path(k), MANIFEST_PRODUCER, k, merged_block_count, singleton_count);
+        }
+    }
+    // Calls function(singleton) for every singleton that was created from merged_block at level k
+    template <typename Function>
+    void for_each_singleton(k_type k, block_index merged_block, Function function)
+    {
+        if (this->mapped_data == nullptr || this->mapped_level != k)
+        {
+            this->map_level(k);
+        }
+        auto range_iterator = this->merged_block_ranges.find(merged_block);
+        assert(range_iterator != this->merged_block_ranges.end());  // The queried block must have created singletons
+        auto [offset, singleton_count] = range_iterator->second;
+        for (uint64_t i = 0; i < singleton_count; i++)
+        {
+            uint64_t singleton_offset = offset + i * BYTES_PER_BLOCK_OR_SINGLETON;
+            int64_t singleton_block = this->read_little_endian(singleton_offset, BYTES_PER_BLOCK_OR_SINGLETON);
+            // If this is true, then we are reading a negative number, meaning the high bit needs to be set to 1
+            if (int8_t(this->mapped_data[singleton_offset + BYTES_PER_BLOCK_OR_SINGLETON - 1]) < 0)
+            {
+                singleton_block |= 0xFFFFFF0000000000l;  // We need this conversion due to two's complement
+            }
+            function((node_index) (-singleton_block - 1));
         }
     }
 };
@@ -683,19 +852,54 @@ public:
         }
         return global_block;
     }
-    void write_map_to_file_binary(std::ostream &outputstream, interval_map &block_to_interval_map)  // TODO this format is very inefficient (as the level is written for every block), instead store like: LEVEL,SIZE,{{LOCAL,GLOBAL}...}
+    // Writes the map grouped by the level at which the global block starts:
+    // MAGIC, VERSION, then per level (ascending) LEVEL, COUNT, {LOCAL,GLOBAL}... (sorted by local block),
+    // followed by an index LEVEL_COUNT, {LEVEL,OFFSET}... and finally the OFFSET of that index
+    void write_map_to_file_binary(std::ostream &outputstream, interval_map &block_to_interval_map)
     {
+        std::vector<std::tuple<k_type,block_or_singleton_index,block_or_singleton_index>> level_local_global_triples;
+        level_local_global_triples.reserve(this->get_map().size());
         for (auto local_global_pair: this->get_map())
         {
-            // k_type level = local_global_pair.first.first;
             block_or_singleton_index local_block = local_global_pair.first.second;
             block_or_singleton_index global_block = local_global_pair.second;
             k_type level = block_to_interval_map[global_block].first;
+            level_local_global_triples.emplace_back(level, local_block, global_block);
+        }
+        std::sort(level_local_global_triples.begin(), level_local_global_triples.end());
+        level_local_global_triples.erase(std::unique(level_local_global_triples.begin(), level_local_global_triples.end()), level_local_global_triples.end());
+
+        outputstream.write(LOCAL_GLOBAL_MAP_MAGIC.data(), LOCAL_GLOBAL_MAP_MAGIC.size());
+        outputstream.put(char(LOCAL_GLOBAL_MAP_VERSION));
+        uint64_t offset = LOCAL_GLOBAL_MAP_MAGIC.size() + 1;
+
+        std::vector<std::pair<k_type,uint64_t>> level_offsets;
+        auto group_begin = level_local_global_triples.cbegin();
+        while (group_begin != level_local_global_triples.cend())
+        {
+            k_type level = std::get<0>(*group_begin);
+            auto group_end = std::find_if(group_begin, level_local_global_triples.cend(), [level](const auto &triple){return std::get<0>(triple) != level;});
+            uint64_t count = group_end - group_begin;
+            level_offsets.emplace_back(level, offset);
 
-            write_uint_K_TYPE_little_endian(outputstream,level);
-            write_int_BLOCK_OR_SINGLETON_little_endian(outputstream,local_block);
-            write_int_BLOCK_OR_SINGLETON_little_endian(outputstream,global_block);
+            write_uint_K_TYPE_little_endian(outputstream, level);
+            write_uint_OFFSET_little_endian(outputstream, count);
+            for (auto it = group_begin; it != group_end; it++)
+            {
+                write_int_BLOCK_OR_SINGLETON_little_endian(outputstream, std::get<1>(*it));
+                write_int_BLOCK_OR_SINGLETON_little_endian(outputstream, std::get<2>(*it));
+            }
+            offset += BYTES_PER_K_TYPE + BYTES_PER_OFFSET + count * 2 * BYTES_PER_BLOCK_OR_SINGLETON;
+            group_begin = group_end;
+        }
+
+        write_uint_OFFSET_little_endian(outputstream, level_offsets.size());
+        for (auto [level, level_offset]: level_offsets)
+        {
+            write_uint_K_TYPE_little_endian(outputstream, level);
+            write_uint_OFFSET_little_endian(outputstream, level_offset);
         }
+        write_uint_OFFSET_little_endian(outputstream, offset);
         outputstream.flush();
     }
 };
@@ -713,7 +917,7 @@ public:
     {
         mapping[split_block] = merged_block;
     }
-    block_or_singleton_index map_block(block_or_singleton_index possibly_split_block)
+    block_or_singleton_index map_block(block_or_singleton_index possibly_split_block) const
     {
         auto key_val_iterator = mapping.find(possibly_split_block);
         if (key_val_iterator == mapping.end())
@@ -756,29 +960,6 @@ public:
 // };
 // using sp_to_o_map = boost::unordered_flat_map<std::pair<block_or_singleton_index,edge_type>,SummaryObjectSet>;
 
-class SummaryPredicateObjectSet
-{
-    private:
-    predicate_object_pair_set po_pairs;
-
-    public:
-    SummaryPredicateObjectSet()
-    {
-    }
-    void add_pair(edge_type predicate, block_or_singleton_index object)
-    {
-        po_pairs.emplace(std::make_pair(predicate,object));  // Should the be emplace or insert?
-    }
-    predicate_object_pair_set& get_pairs()
-    {
-        return po_pairs;
-    }
-    void remove_pair(edge_type predicate, block_or_singleton_index object)
-    {
-        po_pairs.erase(std::make_pair(predicate,object));
-    }
-};
-using s_to_po_map = boost::unordered_flat_map<block_or_singleton_index,SummaryPredicateObjectSet>;
 
 
 // class SummaryNode
@@ -834,183 +1015,292 @@ using s_to_po_map = boost::unordered_flat_map<block_or_singleton_index,SummaryPr
 //     }
 // };
 
-class SummaryGraph
+// A data edge projected onto the summary: {subject block, predicate, object block}
+struct SummaryEdge
 {
-private:
-    s_to_po_map nodes;
+    block_or_singleton_index subject;
+    edge_type predicate;
+    block_or_singleton_index object;
 
-    #ifdef CREATE_REVERSE_INDEX
-    s_to_po_map reverse_nodes;
-    #endif
+    bool operator<(const SummaryEdge &other) const
+    {
+        return std::tie(subject, predicate, object) < std::tie(other.subject, other.predicate, other.object);
+    }
+    bool operator==(const SummaryEdge &other) const
+    {
+        return subject == other.subject && predicate == other.predicate && object == other.object;
+    }
+};
 
-    SummaryGraph(SummaryGraph &)
+// Runs function(thread, begin, end) on thread_count threads, each getting an (almost) equal share of [0, size)
+template <typename Function>
+void parallel_for_ranges(uint64_t size, unsigned int thread_count, Function function)
+{
+    if (thread_count <= 1 || size < thread_count)
+    {
+        function(0, 0, size);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back(function, t, (size * t) / thread_count, (size * (t + 1)) / thread_count);
+    }
+    for (std::thread &thread: threads)
+    {
+        thread.join();
+    }
+}
+
+// Sorts the edges and removes the duplicates, by sorting one range per thread and then merging the ranges pairwise in parallel
+template <typename Compare = std::less<SummaryEdge>>
+void parallel_sort_unique(std::vector<SummaryEdge> &edges, unsigned int thread_count, Compare compare = Compare())
+{
+    std::vector<std::pair<uint64_t, uint64_t>> runs(std::max(thread_count, 1u));
+    parallel_for_ranges(edges.size(), runs.size(), [&edges, &runs, &compare](unsigned int t, uint64_t begin, uint64_t end)
+    {
+        std::sort(edges.begin() + begin, edges.begin() + end, compare);
+        runs[t] = {begin, std::unique(edges.begin() + begin, edges.begin() + end) - edges.begin()};
+    });
+    if (edges.size() < runs.size())  // All edges were sorted as one range
+    {
+        runs.resize(1);
+    }
+
+    // Every merged run is written at the start of its left run, which leaves enough room since the union is never larger than both runs together
+    std::vector<SummaryEdge> buffer(edges.size());
+    while (runs.size() > 1)
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> merged_runs((runs.size() + 1) / 2);
+        parallel_for_ranges(merged_runs.size(), merged_runs.size(), [&edges, &buffer, &runs, &merged_runs, &compare](unsigned int, uint64_t begin, uint64_t end)
+        {
+            for (uint64_t pair = begin; pair < end; pair++)
+            {
+                auto left = runs[2 * pair];
+                if (2 * pair + 1 == runs.size())
+                {
+                    std::copy(edges.begin() + left.first, edges.begin() + left.second, buffer.begin() + left.first);
+                    merged_runs[pair] = left;
+                    continue;
+                }
+                auto right = runs[2 * pair + 1];
+                auto merged_end = std::set_union(edges.begin() + left.first, edges.begin() + left.second,
+                                                 edges.begin() + right.first, edges.begin() + right.second,
+                                                 buffer.begin() + left.first, compare);
+                merged_runs[pair] = {left.first, merged_end - buffer.begin()};
+            }
+        });
+        edges.swap(buffer);
+        runs = std::move(merged_runs);
+    }
+    edges.erase(edges.begin() + runs[0].second, edges.end());
+    edges.erase(edges.begin(), edges.begin() + runs[0].first);
+}
+
+// Orders edges by object first, as needed for looking up the incoming edges of a block
+struct ObjectFirstOrder
+{
+    bool operator()(const SummaryEdge &a, const SummaryEdge &b) const
     {
+        return std::tie(a.object, a.predicate, a.subject) < std::tie(b.object, b.predicate, b.subject);
     }
+};
+
+// Keeps edges as a few sorted runs (without duplicates within a run), where every run is more than twice as large as the run after it
+// Adding a run therefore merges at most a logarithmic number of runs, and finding the edges with some key takes a binary search per run
+template <typename Compare>
+class SortedEdgeRuns
+{
+private:
+    std::vector<std::vector<SummaryEdge>> runs;
+    Compare compare;
 
 public:
-    SummaryGraph()
+    SortedEdgeRuns()
     {
     }
-    s_to_po_map& get_nodes()
+    void add_run(std::vector<SummaryEdge> &&run)
     {
-        return nodes;
+        if (run.empty())
+        {
+            return;
+        }
+        this->runs.push_back(std::move(run));
+        while (this->runs.size() > 1 && this->runs[this->runs.size() - 2].size() <= 2 * this->runs.back().size())
+        {
+            std::vector<SummaryEdge> &left = this->runs[this->runs.size() - 2];
+            std::vector<SummaryEdge> &right = this->runs.back();
+            std::vector<SummaryEdge> merged;
+            merged.reserve(left.size() + right.size());
+            std::set_union(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(merged), this->compare);
+            this->runs.pop_back();
+            this->runs.back() = std::move(merged);
+        }
     }
-    s_to_po_map& get_reverse_nodes()
+    // Calls function(edge) for every edge between lower and upper (inclusive), an edge that occurs in several runs is visited once per run
+    template <typename Function>
+    void for_each_between(const SummaryEdge &lower, const SummaryEdge &upper, Function function) const
     {
-        return reverse_nodes;
+        for (const std::vector<SummaryEdge> &run: this->runs)
+        {
+            auto end = std::upper_bound(run.begin(), run.end(), upper, this->compare);
+            for (auto it = std::lower_bound(run.begin(), run.end(), lower, this->compare); it < end; it++)
+            {
+                function(*it);
+            }
+        }
     }
-    // boost::unordered_flat_map<block_or_singleton_index, SummaryNode>& get_nodes()
-    // {
-    //     return block_nodes;
-    // }
-    // boost::unordered_flat_map<block_or_singleton_index, SummaryNode>& get_reverse_index()
-    // {
-    //     return reverse_block_nodes;
-    // }
-    void add_block_node(block_or_singleton_index block_node)
+    template <typename Function>
+    void for_each(Function function) const
     {
-        assert(this->get_nodes().count(block_node) == 0);  // The node should not already exist
-        SummaryPredicateObjectSet empty_predicate_object_set = SummaryPredicateObjectSet();
-        nodes[block_node] = empty_predicate_object_set;
-
-        #ifdef CREATE_REVERSE_INDEX
-        if (this->get_reverse_nodes().count(block_node) == 0)  // The node should not already exist
+        for (const std::vector<SummaryEdge> &run: this->runs)
         {
-            SummaryPredicateObjectSet empty_predicate_object_set_reverse = SummaryPredicateObjectSet();
-            reverse_nodes[block_node] = empty_predicate_object_set_reverse;
+            for (const SummaryEdge &edge: run)
+            {
+                function(edge);
+            }
         }
-        #endif
     }
-    void try_add_block_node(block_or_singleton_index block_node)
+    // Merges all runs into one, and returns it
+    const std::vector<SummaryEdge>& merge_all()
     {
-        if (this->get_nodes().count(block_node) == 0)  // The node should not already exist
+        while (this->runs.size() > 1)
         {
-            SummaryPredicateObjectSet empty_predicate_object_set = SummaryPredicateObjectSet();
-            nodes[block_node] = empty_predicate_object_set;
+            std::vector<SummaryEdge> &left = this->runs[this->runs.size() - 2];
+            std::vector<SummaryEdge> &right = this->runs.back();
+            std::vector<SummaryEdge> merged;
+            merged.reserve(left.size() + right.size());
+            std::set_union(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(merged), this->compare);
+            this->runs.pop_back();
+            this->runs.back() = std::move(merged);
         }
-
-        #ifdef CREATE_REVERSE_INDEX
-        if (this->get_reverse_nodes().count(block_node) == 0)  // The node should not already exist
+        if (this->runs.empty())
         {
-            SummaryPredicateObjectSet empty_predicate_object_set_reverse = SummaryPredicateObjectSet();
-            reverse_nodes[block_node] = empty_predicate_object_set_reverse;
+            this->runs.emplace_back();
         }
-        #endif
+        return this->runs[0];
     }
-    // void remove_block_node(block_or_singleton_index block_node)
-    // {
-    //     this->get_nodes().erase(block_node);
-    // }
-    // void add_reverse_block_node(block_or_singleton_index block_node)
-    // {
-    //     assert(reverse_block_nodes.count(block_node) == 0);  // The node should not already exist
-    //     SummaryNode empty_node = SummaryNode();
-    //     reverse_block_nodes[block_node] = empty_node;
-    // }
-    // void remove_reverse_block_node(block_or_singleton_index block_node)
-    // {
-    //     this->get_reverse_index().erase(block_node);
-    // }
-    void add_edge_to_node(block_or_singleton_index subject, edge_type predicate, block_or_singleton_index object)//, bool add_reverse=true)
+};
+
+// The edges are appended to a buffer, which is sorted and deduplicated into the forward runs when flushed (once per level)
+// Lookups only see the edges up to the last flush
+// The runs sorted by object (for looking up incoming edges) are only created once they are first needed, by sorting a copy of the forward runs
+class SummaryGraph
+{
+private:
+    boost::unordered_flat_set<block_or_singleton_index> nodes;  // Also contains the nodes without outgoing edges
+    std::vector<SummaryEdge> unsorted_edges;
+    SortedEdgeRuns<std::less<SummaryEdge>> forward_edges;
+    SortedEdgeRuns<ObjectFirstOrder> reverse_edges;
+    bool reverse_edges_created = false;
+    unsigned int thread_count;
+
+    SummaryGraph(SummaryGraph &)
     {
-        assert(this->get_nodes().count(subject) > 0);  // The node should exist
-        this->get_nodes()[subject].add_pair(predicate, object);
+    }
 
-        #ifdef CREATE_REVERSE_INDEX
-        auto reverse_node_it = this->get_reverse_nodes().find(object);
-        if (reverse_node_it != this->get_reverse_nodes().cend())
+    void create_reverse_edges()
+    {
+        this->forward_edges.for_each([this](const SummaryEdge &edge)
+        {
+            this->unsorted_edges.push_back(edge);  // The forward runs are all flushed, so we can temporarily use the buffer
+        });
+        parallel_sort_unique(this->unsorted_edges, this->thread_count, ObjectFirstOrder());
+        this->reverse_edges.add_run(std::move(this->unsorted_edges));
+        this->unsorted_edges = std::vector<SummaryEdge>();
+        this->reverse_edges_created = true;
+    }
+
+public:
+    SummaryGraph(unsigned int thread_count) : thread_count(thread_count)
+    {
+    }
+    boost::unordered_flat_set<block_or_singleton_index>& get_nodes()
+    {
+        return nodes;
+    }
+    bool contains_node(block_or_singleton_index block_node)
+    {
+        return this->get_nodes().contains(block_node);
+    }
+    void add_block_node(block_or_singleton_index block_node)
+    {
+        assert(!this->contains_node(block_node));  // The node should not already exist
+        nodes.emplace(block_node);
+    }
+    void try_add_block_node(block_or_singleton_index block_node)
+    {
+        nodes.emplace(block_node);
+    }
+    void add_edge_to_node(block_or_singleton_index subject, edge_type predicate, block_or_singleton_index object)
+    {
+        assert(this->contains_node(subject));  // The node should exist
+        unsorted_edges.push_back({subject, predicate, object});
+    }
+    // Adds edges that are already sorted and deduplicated
+    void add_sorted_edges(std::vector<SummaryEdge> &&edges)
+    {
+        if (this->reverse_edges_created)
         {
-            reverse_node_it->second.add_pair(predicate,subject);
+            std::vector<SummaryEdge> reverse_run = edges;
+            parallel_sort_unique(reverse_run, this->thread_count, ObjectFirstOrder());
+            this->reverse_edges.add_run(std::move(reverse_run));
         }
-        else
+        this->forward_edges.add_run(std::move(edges));
+    }
+    // Makes the edges that were added since the last flush visible to the lookups
+    void flush()
+    {
+        if (this->unsorted_edges.empty())
         {
-            SummaryPredicateObjectSet empty_predicate_object_set_reverse = SummaryPredicateObjectSet();
-            reverse_nodes[object] = empty_predicate_object_set_reverse;
-            reverse_nodes[object].add_pair(predicate,subject);
+            return;
         }
-        #endif
-        // if (add_reverse)
-        // {
-        //     if (reverse_block_nodes.count(object) == 0)
-        //     {
-        //         add_reverse_block_node(object);
-        //     }
-        //     this->get_reverse_index()[object].add_edge(predicate, subject);
-        // }
+        std::vector<SummaryEdge> run = std::move(this->unsorted_edges);
+        this->unsorted_edges = std::vector<SummaryEdge>();
+        parallel_sort_unique(run, this->thread_count);
+        this->add_sorted_edges(std::move(run));
+    }
+    template <typename Function>
+    void for_each_outgoing_edge(block_or_singleton_index subject, Function function) const
+    {
+        this->forward_edges.for_each_between({subject, 0, INT64_MIN}, {subject, UINT32_MAX, INT64_MAX}, function);
+    }
+    // Creates the runs sorted by object, this has to be done before looking up incoming edges
+    void create_incoming_edge_index()
+    {
+        if (!this->reverse_edges_created)
+        {
+            std::vector<SummaryEdge> pending_edges = std::move(this->unsorted_edges);  // These should stay invisible until the next flush
+            this->unsorted_edges = std::vector<SummaryEdge>();
+            this->create_reverse_edges();
+            this->unsorted_edges = std::move(pending_edges);
+        }
+    }
+    template <typename Function>
+    void for_each_incoming_edge(block_or_singleton_index object, Function function) const
+    {
+        assert(this->reverse_edges_created);
+        this->reverse_edges.for_each_between({INT64_MIN, 0, object}, {INT64_MAX, UINT32_MAX, object}, function);
+    }
+    template <typename Function>
+    void for_each_edge(Function function) const
+    {
+        this->forward_edges.for_each(function);
+    }
+    // Flushes and returns all edges, sorted by subject and without duplicates
+    const std::vector<SummaryEdge>& get_sorted_edges()
+    {
+        this->flush();
+        return this->forward_edges.merge_all();
     }
-    // void ammend_object(block_or_singleton_index subject, edge_type predicate, block_or_singleton_index old_object, block_or_singleton_index new_object)//, bool ammend_reverse=true)
-    // {
-    //     assert(this->get_nodes().count(subject) > 0);  // The subject should exist
-    //     assert(this->get_nodes()[subject].count_edge_key(predicate) > 0);  // The predicate should exist
-    //     assert(this->get_nodes()[subject].get_edges()[predicate].get_objects().count(old_object) > 0);  // The predicate should exist
-
-    //     this->get_nodes()[subject].add_edge(predicate, new_object);
-    //     this->get_nodes()[subject].remove_edge_recursive(predicate, old_object);
-
-    //     // if (ammend_reverse)
-    //     // {
-    //     //     if (reverse_block_nodes.count(new_object) == 0)
-    //     //     {
-    //     //         add_reverse_block_node(new_object);
-    //     //     }
-    //     //     this->get_reverse_index()[new_object].add_edge(predicate, subject);
-    //     //     this->get_reverse_index()[old_object].remove_edge_recursive(predicate, subject);
-
-    //     //     // Remove the node in the reverse 
-    //     //     if (this->get_reverse_index()[old_object].get_edges().size() == 0)
-    //     //     {
-    //     //         this->remove_reverse_block_node(old_object);
-    //     //     }
-    //     // }
-    // }
-    // std::vector<Triple> remove_split_blocks_edges(boost::unordered_flat_set<block_index> split_blocks)
-    // {
-    //     std::vector<Triple> removed_edges;
-    //     // Remove the forward edges from the index and reverse index
-    //     for (block_or_singleton_index subject: split_blocks)
-    //     {
-    //         for (auto& block_node_key_val: this->get_nodes()[subject].get_edges())
-    //         {
-    //             edge_type predicate = block_node_key_val.first;
-    //             for (block_or_singleton_index object: block_node_key_val.second.get_objects())
-    //             {
-    //                 reverse_block_nodes[object].remove_edge_recursive(predicate, subject);
-    //                 removed_edges.emplace_back(Triple(subject, predicate, object));  // Keep track of the edges we have removed
-    //             }
-    //         }
-    //         this->get_nodes()[subject] = SummaryNode();  // After having removed the forward edges from the reverse index, clear the edges for the index
-    //     }
-
-    //     // Remove the backward edges from the index and reverse index
-    //     for (block_or_singleton_index subject: split_blocks)
-    //     {
-    //         for (auto& reverse_block_node_key_val: reverse_block_nodes[subject].get_edges())
-    //         {
-    //             edge_type predicate = reverse_block_node_key_val.first;
-    //             for (block_or_singleton_index object: reverse_block_node_key_val.second.get_objects())
-    //             {
-    //                 this->get_nodes()[object].remove_edge_recursive(predicate, subject);
-    //                 removed_edges.emplace_back(Triple(subject, predicate, object));  // Keep track of the edges we have removed
-    //             }
-    //         }
-    //         reverse_block_nodes[subject] = SummaryNode();  // After having removed the backward edges from the index, clear the edges for the reverse index
-    //     }
-    //     return removed_edges;
-    // }
     void write_graph_to_file_binary(std::ostream &graphoutputstream)
     {
-        for (auto s_po_pair: this->get_nodes())
+        for (const SummaryEdge &edge: this->get_sorted_edges())
         {
-            block_or_singleton_index subject = s_po_pair.first;
-            for (auto po_pair: s_po_pair.second.get_pairs())
-            {
-                edge_type predicate = po_pair.first;
-                block_or_singleton_index object = po_pair.second;
-                write_int_BLOCK_OR_SINGLETON_little_endian(graphoutputstream, subject);
-                write_uint_PREDICATE_little_endian(graphoutputstream, predicate);
-                write_int_BLOCK_OR_SINGLETON_little_endian(graphoutputstream, object);
-                // std::cout << "DEBUG wrote SPO: " << subject << " " << predicate << " " << object << std::endl;
-            }
+            write_int_BLOCK_OR_SINGLETON_little_endian(graphoutputstream, edge.subject);
+            write_uint_PREDICATE_little_endian(graphoutputstream, edge.predicate);
+            write_int_BLOCK_OR_SINGLETON_little_endian(graphoutputstream, edge.object);
+            // std::cout << "DEBUG wrote SPO: " << edge.subject << " " << edge.predicate << " " << edge.object << std::endl;
         }
         graphoutputstream.flush();
     }
@@ -1020,101 +1310,105 @@ public:
     }
     uint64_t get_edge_count()
     {
-        uint64_t edge_cout = 0;
-        for (auto id_node_pair: nodes)
-        {
-            edge_cout += id_node_pair.second.get_pairs().size();
-        }
-        return edge_cout;
+        return this->get_sorted_edges().size();
     }
-    // void write_graph_to_file_json(std::ostream &outputstream)
-    // {
-    //     outputstream << "[";
-    //     bool first_line = true;
-    //     for (auto node_key_val: this->get_nodes())
-    //     {
-    //         block_or_singleton_index subject = node_key_val.first;
-    //         for (auto edge_key_val: node_key_val.second.get_edges())
-    //         {
-    //             edge_type predicate = edge_key_val.first;
-    //             for (block_or_singleton_index object: edge_key_val.second.get_objects())
-    //             {
-    //                 if (first_line)
-    //                 {
-    //                     first_line = false;
-    //                 }
-    //                 else
-    //                 {
-    //                     outputstream << ",";
-    //                 }
-    //                 outputstream << "\n    [" << subject << ", " << object << ", " << predicate << "]";
-    //             }
-    //         }
-    //     }
-    //     outputstream << "\n]";
-    // }
 };
 
-void read_graph_into_summary_from_stream_timed(std::istream &inputstream, node_to_block_map_type &node_to_block_map, LocalBlockToGlobalBlockMap& block_map, SplitToMergedMap &split_to_merged_map, boost::unordered_flat_map<block_or_singleton_index, time_interval> &block_to_interval_map, k_type current_level, bool include_zero, bool fixed_point_reached, SummaryGraph &gs)
+void read_graph_into_summary_from_stream_timed(std::istream &inputstream, const node_to_block_map_type &node_to_block_map, LocalBlockToGlobalBlockMap& block_map, SplitToMergedMap &split_to_merged_map, boost::unordered_flat_map<block_or_singleton_index, time_interval> &block_to_interval_map, k_type current_level, bool include_zero, bool fixed_point_reached, SummaryGraph &gs, unsigned int thread_count)
 {
     StopWatch<boost::chrono::process_cpu_clock> w = StopWatch<boost::chrono::process_cpu_clock>::create_not_started();
 
-    const int BufferSize = 8 * 16184;
-
-    char _buffer[BufferSize];
-
-    inputstream.rdbuf()->pubsetbuf(_buffer, BufferSize);
+    const uint64_t BYTES_PER_TRIPLE = 2 * BYTES_PER_ENTITY + BYTES_PER_PREDICATE;
+    const uint64_t TRIPLES_PER_CHUNK = 1 << 20;
 
     w.start_step("Reading graph");
-    u_int64_t line_counter = 0;
 
     auto t_start{boost::chrono::system_clock::now()};
     auto time_t_start{boost::chrono::system_clock::to_time_t(t_start)};
     std::tm *ptm_start{std::localtime(&time_t_start)};
 
     std::cout << std::put_time(ptm_start, "%Y/%m/%d %H:%M:%S") << " Reading started" << std::endl;
-    while (true)
-    {
-        // subject
-        node_index subject_index = read_uint_ENTITY_little_endian(inputstream);
-
-        // edge
-        edge_type edge_label = read_PREDICATE_little_endian(inputstream);
 
-        // object
-        node_index object_index = read_uint_ENTITY_little_endian(inputstream);
-
-        // Break when the last valid values have been read
-        if (inputstream.eof())
+    // Both endpoints of a data edge only depend on the block of the node, so we look these up once per node instead of once per triple
+    std::vector<block_or_singleton_index> subject_blocks(node_to_block_map.size());
+    std::vector<block_or_singleton_index> object_blocks(node_to_block_map.size());
+    parallel_for_ranges(node_to_block_map.size(), thread_count, [&](unsigned int, uint64_t begin, uint64_t end)
+    {
+        for (node_index node = begin; node < end; node++)
         {
-            break;
+            subject_blocks[node] = block_map.map_block(current_level, node_to_block_map[node]);
+            object_blocks[node] = split_to_merged_map.map_block(subject_blocks[node]);  // Data edges from last level to second-to-last level
         }
+    });
 
-        block_or_singleton_index subject_block = block_map.map_block(current_level,node_to_block_map[subject_index]);
-
-        gs.try_add_block_node(subject_block);
-        if (block_to_interval_map.find(subject_block) == block_to_interval_map.cend())  // If the block has not been given an initial interval, then do it now
+    // The triples are read in chunks, and each chunk is projected onto the summary in parallel
+    // Whenever the projected edges have doubled since the last deduplication, they get deduplicated again, so the memory stays proportional to the number of summary edges
+    std::vector<char> chunk(TRIPLES_PER_CHUNK * BYTES_PER_TRIPLE);
+    std::vector<SummaryEdge> edges;
+    uint64_t deduplicated_edge_count = 0;
+    u_int64_t line_counter = 0;
+    while (inputstream)
+    {
+        inputstream.read(chunk.data(), chunk.size());
+        uint64_t chunk_triple_count = inputstream.gcount() / BYTES_PER_TRIPLE;
+        uint64_t chunk_start = edges.size();
+        edges.resize(chunk_start + chunk_triple_count);
+        parallel_for_ranges(chunk_triple_count, thread_count, [&](unsigned int, uint64_t begin, uint64_t end)
         {
-            k_type first_level = 1;
-            if (include_zero)
+            for (uint64_t triple = begin; triple < end; triple++)
             {
-                first_level = 0;
+                const unsigned char *data = reinterpret_cast<const unsigned char *>(chunk.data()) + triple * BYTES_PER_TRIPLE;
+                node_index subject_index = 0;
+                edge_type edge_label = 0;
+                node_index object_index = 0;
+                for (unsigned int i = 0; i < BYTES_PER_ENTITY; i++)
+                {
+                    subject_index |= node_index(data[i]) << (i * 8);
+                    object_index |= node_index(data[BYTES_PER_ENTITY + BYTES_PER_PREDICATE + i]) << (i * 8);
+                }
+                for (unsigned int i = 0; i < BYTES_PER_PREDICATE; i++)
+                {
+                    edge_label |= edge_type(data[BYTES_PER_ENTITY + i]) << (i * 8);
+                }
+                edges[chunk_start + triple] = {subject_blocks[subject_index], edge_label, object_blocks[object_index]};
             }
-            block_to_interval_map[subject_block] = {first_level, current_level};
+        });
+        if (edges.size() >= 2 * deduplicated_edge_count + TRIPLES_PER_CHUNK)
+        {
+            parallel_sort_unique(edges, thread_count);
+            deduplicated_edge_count = edges.size();
         }
 
-        block_or_singleton_index object_block_previous_level = split_to_merged_map.map_block(block_map.map_block(current_level,node_to_block_map[object_index]));  // Data edges from last level to second-to-last level
-        // std::cout << "DEBUG adding edge: " << subject_block << "," << edge_label << "," << object_block_previous_level << std::endl;
-        gs.add_edge_to_node(subject_block, edge_label, object_block_previous_level);
-
-        if (line_counter % 1000000 == 0)
+        if (line_counter / 1000000 != (line_counter + chunk_triple_count) / 1000000)
         {
             auto now{boost::chrono::system_clock::to_time_t(boost::chrono::system_clock::now())};
             std::tm *ptm{std::localtime(&now)};
-            std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S") << " done with " << line_counter << " triples" << std::endl;
+            std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S") << " done with " << line_counter + chunk_triple_count << " triples" << std::endl;
+        }
+        line_counter += chunk_triple_count;
+    }
+    parallel_sort_unique(edges, thread_count);
+
+    // The edges are sorted by subject, so every summary node is added once
+    k_type first_level = 1;
+    if (include_zero)
+    {
+        first_level = 0;
+    }
+    for (uint64_t i = 0; i < edges.size(); i++)
+    {
+        const SummaryEdge &edge = edges[i];
+        if (i == 0 || edge.subject != edges[i - 1].subject)
+        {
+            gs.try_add_block_node(edge.subject);
+            if (block_to_interval_map.find(edge.subject) == block_to_interval_map.cend())  // If the block has not been given an initial interval, then do it now
+            {
+                block_to_interval_map[edge.subject] = {first_level, current_level};
+            }
         }
-        line_counter++;
     }
+    uint64_t summary_edge_count = edges.size();
+    gs.add_sorted_edges(std::move(edges));
     w.stop_step();
 
     auto t_reading_done{boost::chrono::system_clock::now()};
@@ -1123,27 +1417,15 @@ void read_graph_into_summary_from_stream_timed(std::istream &inputstream, node_t
 
     std::cout << std::put_time(ptm_reading_done, "%Y/%m/%d %H:%M:%S")
               << " Time taken = " << boost::chrono::ceil<boost::chrono::milliseconds>(t_reading_done - t_start).count()
-              << " ms, memory = " << w.get_times()[0].memory_in_kb << " kB" << std::endl;
-// #ifdef CREATE_REVERSE_INDEX
-//     w.start_step("Creating reverse index");
-//     g.compute_reverse_index();
-//     w.stop_step();
-
-//     auto t_reverse_index_done{boost::chrono::system_clock::now()};
-//     auto time_t_reverse_index_done{boost::chrono::system_clock::to_time_t(t_reverse_index_done)};
-//     std::tm *ptm_reverse_index_done{std::localtime(&time_t_reverse_index_done)};
-
-//     std::cout << std::put_time(ptm_reverse_index_done, "%Y/%m/%d %H:%M:%S")
-//               << " Time taken for creating reverse index = " << boost::chrono::ceil<boost::chrono::milliseconds>(t_reverse_index_done - t_reading_done).count()
-//               << " ms, memory = " << w.get_times()[1].memory_in_kb << " kB" << std::endl;
-// #endif
+              << " ms, memory = " << w.get_times()[0].memory_in_kb << " kB"
+              << ", triples = " << line_counter << ", summary edges = " << summary_edge_count << std::endl;
 }
 
-void read_graph_into_summary_timed(const std::string &filename, node_to_block_map_type &node_to_block_map, LocalBlockToGlobalBlockMap &block_map, SplitToMergedMap &split_to_merged_map, boost::unordered_flat_map<block_or_singleton_index, time_interval> &block_to_interval_map, k_type current_level, bool include_zero, bool fixed_point_reached, SummaryGraph &gs)
+void read_graph_into_summary_timed(const std::string &filename, const node_to_block_map_type &node_to_block_map, LocalBlockToGlobalBlockMap &block_map, SplitToMergedMap &split_to_merged_map, boost::unordered_flat_map<block_or_singleton_index, time_interval> &block_to_interval_map, k_type current_level, bool include_zero, bool fixed_point_reached, SummaryGraph &gs, unsigned int thread_count)
 {
 
-    std::ifstream infile(filename, std::ifstream::in);
-    read_graph_into_summary_from_stream_timed(infile, node_to_block_map, block_map, split_to_merged_map, block_to_interval_map, current_level, include_zero, fixed_point_reached, gs);
+    std::ifstream infile(filename, std::ifstream::in | std::ifstream::binary);
+    read_graph_into_summary_from_stream_timed(infile, node_to_block_map, block_map, split_to_merged_map, block_to_interval_map, current_level, include_zero, fixed_point_reached, gs, thread_count);
 }
 
 struct LocalBlock {
@@ -1151,6 +1433,56 @@ struct LocalBlock {
     k_type terminal_level;
 };
 
+// The condensed summary graph is up to date if the manifest lists it, and none of the listed files (which include the outcomes and mappings it was built from) changed since
+bool condensed_summary_is_valid(const ExperimentManifest &manifest, const std::string &experiment_directory)
+{
+    if (!ExperimentManifest::exists(experiment_directory))
+    {
+        return false;
+    }
+    for (std::string summary_file: {"condensed_multi_summary_graph.bin", "condensed_multi_summary_intervals.bin", "condensed_multi_summary_local_global_map.bin"})
+    {
+        if (manifest.find(experiment_directory + "bisimulation/" + summary_file) == nullptr)
+        {
+            return false;
+        }
+    }
+    for (const ManifestEntry &entry: manifest.get_entries())
+    {
+        if (!manifest.is_valid(entry))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Writes the intervals as {block,start_time,end_time} records, sorted by block such that the file does not depend on the order of the hash map
+// (the bisimulator writes its intervals in the same order when it builds the condensed summary)
+void write_intervals_to_file_binary(std::ostream &outputstream, const interval_map &block_to_interval_map)
+{
+    std::vector<std::pair<block_or_singleton_index,time_interval>> block_intervals(block_to_interval_map.cbegin(), block_to_interval_map.cend());
+    std::sort(block_intervals.begin(), block_intervals.end());
+    for (const auto &[block, interval]: block_intervals)
+    {
+        write_int_BLOCK_OR_SINGLETON_little_endian(outputstream, block);
+        write_uint_K_TYPE_little_endian(outputstream, interval.first);
+        write_uint_K_TYPE_little_endian(outputstream, interval.second);
+    }
+}
+
+// Adds the files of the condensed summary graph to the manifest and writes it
+void write_manifest(ExperimentManifest &manifest, const std::string &experiment_directory, const SingletonMapper &blocks_to_singletons, uint64_t edge_count, uint64_t interval_count)
+{
+    std::string output_directory = experiment_directory + "bisimulation/";
+    manifest.add(output_directory + "condensed_multi_summary_graph.bin", MANIFEST_PRODUCER, MANIFEST_NO_LEVEL, edge_count);
+    manifest.add(output_directory + "condensed_multi_summary_intervals.bin", MANIFEST_PRODUCER, MANIFEST_NO_LEVEL, interval_count);
+    manifest.add(output_directory + "condensed_multi_summary_local_global_map.bin", MANIFEST_PRODUCER);
+    blocks_to_singletons.add_to_manifest(manifest);
+    manifest.add(experiment_directory + "ad_hoc_results/summary_graph_stats.json", MANIFEST_PRODUCER);
+    manifest.write();
+}
+
 int main(int ac, char *av[])
 {
     StopWatch<boost::chrono::process_cpu_clock> w_total = StopWatch<boost::chrono::process_cpu_clock>::create_not_started();
@@ -1161,6 +1493,10 @@ int main(int ac, char *av[])
 
     po::options_description global("Global options");
     global.add_options()("experiment_directory", po::value<std::string>(), "The directory for the experiment of interest");
+    global.add_options()("threads", po::value<unsigned int>()->default_value(std::max(std::thread::hardware_concurrency(), 1u)), "The number of threads used for computing the data edges");
+    global.add_options()("skip_if_valid", "Do nothing if the manifest shows that the condensed summary graph was built from the current outcomes");
+    global.add_options()("cache_dir", po::value<std::string>()->default_value(""), "Stage cache directory, the outputs are linked from there if the summary graph was built from the same outcomes before (empty disables the cache)");
+    global.add_options()("cache_size", po::value<uint64_t>()->default_value(10240), "Size limit of the stage cache in MB, the least recently used entries are removed beyond it");
 
     po::positional_options_description pos;
     pos.add("experiment_directory", 1);
@@ -1178,23 +1514,48 @@ int main(int ac, char *av[])
     std::cout << std::put_time(ptm_read, "%Y/%m/%d %H:%M:%S") << " Setting up " << std::endl;
 
     std::string experiment_directory = vm["experiment_directory"].as<std::string>();
+    unsigned int thread_count = std::max(vm["threads"].as<unsigned int>(), 1u);
     std::string graph_file = experiment_directory + "binary_encoding.bin";
 
-    std::string graph_stats_file = experiment_directory + "ad_hoc_results/graph_stats.json";
-    std::ifstream graph_stats_file_stream(graph_stats_file);
+    // The manifest lists the outcome and mapping files with their sizes, experiments without one are described by graph_stats.json
+    ExperimentManifest manifest(experiment_directory);
+    manifest.read_or_start();
+    size_t k = manifest.get_graph_facts().final_depth;
+    node_index graph_size = manifest.get_graph_facts().vertex_count;
+    bool fixed_point_reached = manifest.get_graph_facts().fixed_point;  // The bisimulator writes false when it stopped early, e.g. because its time or memory budget was exhausted
 
-    std::string graph_stats_line;
-    std::string final_depth_string = "\"Final depth\"";
-    std::string vertex_count_string = "\"Vertex count\"";
-    std::string fixed_point_string = "\"Fixed point\"";
-
-    size_t k;
-    node_index graph_size;
-    bool fixed_point_reached;
+    if (vm.count("skip_if_valid") && condensed_summary_is_valid(manifest, experiment_directory))
+    {
+        std::cout << std::put_time(ptm_read, "%Y/%m/%d %H:%M:%S") << " The manifest shows that the condensed summary graph is up to date, skipping" << std::endl;
+        return 0;
+    }
 
-    bool k_found = false;
-    bool size_found = false;
-    bool fixed_point_found = false;
+    // The number of threads does not change the outputs, so only the files that are read make up the key
+    StageCache cache(vm["cache_dir"].as<std::string>(), vm["cache_size"].as<uint64_t>(), MANIFEST_PRODUCER, experiment_directory,
+                     {MANIFEST_FILE_NAME, "bisimulation/condensed_multi_summary_", "bisimulation/singleton_mapping-", "ad_hoc_results/data_edges_statistics_condensed-", "ad_hoc_results/summary_graph_stats.json"});
+    cache.add_derived_file("bisimulation/quotient_index.bin");
+    if (cache.is_enabled())
+    {
+        cache.add_input_file("binary_encoding.bin", graph_file);
+        cache.add_input_file("graph_stats.json", experiment_directory + "ad_hoc_results/graph_stats.json");
+        for (size_t level = 0; level <= k; level++)
+        {
+            std::ostringstream level_stringstream;
+            level_stringstream << std::setw(4) << std::setfill('0') << level;
+            std::ostringstream next_level_stringstream;
+            next_level_stringstream << std::setw(4) << std::setfill('0') << level + 1;
+            std::string outcome_file = "bisimulation/outcome_condensed-" + level_stringstream.str() + ".bin";
+            std::string mapping_file = "bisimulation/mapping-" + level_stringstream.str() + "to" + next_level_stringstream.str() + ".bin";
+            cache.add_input_file(outcome_file, experiment_directory + outcome_file);
+            cache.add_input_file(mapping_file, experiment_directory + mapping_file);
+        }
+    }
+    // Also when the cache is disabled, the outputs of an earlier run may still be linked to an entry
+    if (cache.lookup())
+    {
+        std::cout << std::put_time(ptm_read, "%Y/%m/%d %H:%M:%S") << " Linked the condensed summary graph from the stage cache (key " << cache.get_key() << ")" << std::endl;
+        return 0;
+    }
 
     bool include_zero_outcome = false;
     std::filesystem::path path_to_zero_outcome = experiment_directory + "bisimulation/outcome_condensed-0000.bin";
@@ -1206,46 +1567,6 @@ int main(int ac, char *av[])
         first_level = 0;  // We need to check an extra outcome if we have the 0 outcome
     }
 
-    while (std::getline(graph_stats_file_stream, graph_stats_line))
-    {
-        boost::trim(graph_stats_line);
-        boost::erase_all(graph_stats_line, ",");
-        std::vector<std::string> result;
-        boost::split(result, graph_stats_line, boost::is_any_of(":"));
-        if (result[0] == final_depth_string)
-        {
-            std::stringstream sstream(result[1]);
-            sstream >> k;
-            k_found = true;
-        }
-        else if (result[0] == vertex_count_string)
-        {
-            std::stringstream sstream(result[1]);
-            sstream >> graph_size;
-            size_found = true;
-        }
-        else if (result[0] == fixed_point_string)
-        {
-            std::stringstream sstream(result[1]);
-            std::string fixed_point_string = sstream.str();
-            boost::trim(fixed_point_string);
-            if (fixed_point_string == "true")
-            {
-                fixed_point_reached = true;
-            }
-            else if (fixed_point_string != "false")
-            {
-                throw MyException("The \"Fixed point\" value in the graph_stats.json file has not been set to one of \"true\"/\"false\"");
-            }
-            fixed_point_found = true;
-        }
-        if (k_found && size_found && fixed_point_found)
-        {
-            break;
-        }
-    }
-    graph_stats_file_stream.close();
-
     // >>> LOAD THE FINAL SUMMARY GRAPH >>>
     auto t_start{boost::chrono::system_clock::now()};
     auto time_t_start{boost::chrono::system_clock::to_time_t(t_start)};
@@ -1257,9 +1578,9 @@ int main(int ac, char *av[])
     StopWatch<boost::chrono::process_cpu_clock> w = StopWatch<boost::chrono::process_cpu_clock>::create_not_started();
     w.start_step("Reading outcomes", true);  // Set newline to true
 
-    std::ifstream blocksfile(blocks_file, std::ifstream::in);
-    node_to_block_map_type node_to_block_map;
-    boost::unordered_flat_map<block_index, boost::unordered_flat_set<node_index>> blocks;
+    PartitionFileStream blocksfile(blocks_file, PARTITION_FILE_OUTCOME);
+    node_to_block_map_type node_to_block_map(graph_size);
+    BlockMembership blocks;
 
     // Initialize all nodes as being singletons
     for (node_index node = 0; node < graph_size; node++)
@@ -1274,25 +1595,13 @@ int main(int ac, char *av[])
     std::cout << std::put_time(ptm_reverse_index_done, "%Y/%m/%d %H:%M:%S") << " Processing k=" + std::to_string(first_level) << std::endl;
     
     // Read the first outcome file
-    while (true)
+    if (const ManifestEntry *entry = manifest.find(blocks_file))
     {
-        block_index block = read_uint_BLOCK_little_endian(blocksfile);
-        if (blocksfile.eof())
-        {
-            break;
-        }
-        assert(block <= MAX_SIGNED_BLOCK_SIZE);  // Later, we are storing a block_index as a block_or_singleton_index, so we need to check if the cast is possible
-        u_int64_t block_size = read_uint_ENTITY_little_endian(blocksfile);
-
-        for (uint64_t i = 0; i < block_size; i++)
-        {
-            node_index node = read_uint_ENTITY_little_endian(blocksfile);
-            node_to_block_map[node] = (block_or_singleton_index) block;
-            blocks[block].emplace(node);
-        }
+        blocks.reserve_members(entry->value_count);
     }
+    blocks.read_outcome(blocksfile, node_to_block_map);
 
-    SingletonMapper blocks_to_singletons = SingletonMapper();
+    SingletonMapper blocks_to_singletons(experiment_directory + "bisimulation/");
 
     for (uint32_t i = first_level+1; i <= k; i++)  // We can ignore the last outcome (k), if its only purpose was to find the fixed point (i.e. its empty), otherwise include the last outcome
     {
@@ -1312,8 +1621,8 @@ int main(int ac, char *av[])
 
         std::string current_mapping = experiment_directory + "bisimulation/mapping-" + previous_i_string + "to" + i_string + ".bin";
         std::string current_outcome = experiment_directory + "bisimulation/outcome_condensed-" + i_string + ".bin";
-        std::ifstream current_mapping_file(current_mapping, std::ifstream::in);
-        std::ifstream current_outcome_file(current_outcome, std::ifstream::in);
+        PartitionFileStream current_mapping_file(current_mapping, PARTITION_FILE_MAPPING);
+        PartitionFileStream current_outcome_file(current_outcome, PARTITION_FILE_OUTCOME);
 
         boost::unordered_flat_set<block_index> split_block_incides;
         boost::unordered_flat_set<block_index> new_block_indices;
@@ -1321,6 +1630,11 @@ int main(int ac, char *av[])
 
         bool new_singletons_created = false;
 
+        if (const ManifestEntry *entry = manifest.find(current_mapping))
+        {
+            split_block_incides.reserve(entry->record_count);
+        }
+
         // Read a mapping file
         while (true)
         {
@@ -1351,9 +1665,9 @@ int main(int ac, char *av[])
             }
         }
 
-        boost::unordered_flat_set<node_index> new_singleton_nodes;
-        boost::unordered_flat_set<node_index> old_nodes_in_split;
-        boost::unordered_flat_set<node_index> new_nodes_in_split;
+        std::vector<node_index> new_singleton_nodes;
+        std::vector<node_index> old_nodes_in_split;
+        std::vector<node_index> new_nodes_in_split;
 
         if (new_singletons_created)
         {
@@ -1361,58 +1675,47 @@ int main(int ac, char *av[])
             for (block_or_singleton_index split_block: split_block_incides)
             {
                 assert(split_block <= MAX_SIGNED_BLOCK_SIZE);  // We need to check if the cast to block_or_singleton_index is possible
-                old_nodes_in_split.insert(blocks[split_block].begin(), blocks[(block_or_singleton_index) split_block].end());
+                blocks.append_members(split_block, old_nodes_in_split);
             }
             // Clear all blocks that got turned into only singletons
-            // All other split blocks will be cleared later
+            // All other split blocks will be overwritten by the outcome
             for (block_or_singleton_index disappeared_block: disappeared_block_indices)
             {
-                blocks[disappeared_block].clear();
+                blocks.clear_block(disappeared_block);
             }
         }
 
         // Read an outcome file
-        while (true)
+        if (const ManifestEntry *entry = manifest.find(current_outcome))
         {
-            block_index block = read_uint_BLOCK_little_endian(current_outcome_file);
-            // if (i == 1 and block == 1)
-            // {
-            //     std::cout << "DEBUG: found (1,1)" << std::endl;
-            // }
-            if (current_outcome_file.eof())
-            {
-                break;
-            }
-            assert(block <= MAX_SIGNED_BLOCK_SIZE);  // Later, we are storing a block_index as a block_or_singleton_index, so we need to check if the cast is possible
-            u_int64_t block_size = read_uint_ENTITY_little_endian(current_outcome_file);
-            blocks[(block_or_singleton_index) block].clear();  // Remove the old map
-            for (uint64_t i = 0; i < block_size; i++) {
-                node_index node = read_uint_ENTITY_little_endian(current_outcome_file);
-                node_to_block_map[node] = (block_or_singleton_index) block;
-                blocks[(block_or_singleton_index) block].emplace(node);
-            }
+            blocks.reserve_members(entry->value_count);
         }
+        blocks.read_outcome(current_outcome_file, node_to_block_map);
 
         if (new_singletons_created)
         {
             for (block_or_singleton_index new_block: new_block_indices)
             {
-                new_nodes_in_split.insert(blocks[new_block].begin(), blocks[new_block].end());
+                blocks.append_members(new_block, new_nodes_in_split);
             }
-            for (auto node: new_nodes_in_split)
-            {
-                old_nodes_in_split.erase(node);
-            }
-            new_singleton_nodes = std::move(old_nodes_in_split);
-            
-            blocks_to_singletons.add_level(i);
+            // The new blocks partition a subset of the nodes in the split blocks, the remaining nodes became singletons
+            std::sort(old_nodes_in_split.begin(), old_nodes_in_split.end());
+            std::sort(new_nodes_in_split.begin(), new_nodes_in_split.end());
+            std::set_difference(old_nodes_in_split.begin(), old_nodes_in_split.end(),
+                                new_nodes_in_split.begin(), new_nodes_in_split.end(),
+                                std::back_inserter(new_singleton_nodes));
+
+            std::vector<std::pair<block_index,node_index>> merged_singleton_pairs;
+            merged_singleton_pairs.reserve(new_singleton_nodes.size());
             for (node_index node: new_singleton_nodes)
             {
-                blocks_to_singletons.get_map(i).add_node(node_to_block_map[node], node);  // Add the block to singlton mapping to keep track (for later) of which merged blocks singletons refine
+                merged_singleton_pairs.emplace_back(node_to_block_map[node], node);  // Keep track (for later) of which merged blocks singletons refine
                 block_or_singleton_index singleton_block = -((block_or_singleton_index)node)-1;
                 node_to_block_map[node] = singleton_block;
             }
+            blocks_to_singletons.write_level(i, merged_singleton_pairs);
         }
+        blocks.compact_if_needed();
     }
     
     w.stop_step();
@@ -1456,9 +1759,8 @@ int main(int ac, char *av[])
     }
 
     // Add all terminal non-empty non-singleton blocks as living nodes
-    for (auto iter = blocks.cbegin(); iter != blocks.cend(); iter++)
+    for (block_index block_id = 0; block_id < blocks.get_block_count(); block_id++)
     {
-        block_index block_id = iter->first;
         // if (current_level == 1)
         // {
         //     std::cout << "DEBUG: map found level 1 #1" << std::endl;
@@ -1467,7 +1769,7 @@ int main(int ac, char *av[])
         // {
         //     std::cout << "DEBUG: map found (1,1) #1";
         // }
-        size_t block_size = iter->second.size();
+        size_t block_size = blocks.get_size(block_id);
         if (block_size == 0)  // Empty blocks do not yield summary nodes
         {
             continue;
@@ -1479,11 +1781,11 @@ int main(int ac, char *av[])
     }
 
     // All existing singleton blocks are alive at the last layer (since they can't disappear by splitting further)
-    for (auto node_block_pair: node_to_block_map)
+    for (block_or_singleton_index node_block: node_to_block_map)
     {
-        if (node_block_pair.second < 0)  // Blocks have a negative index iff they are singletons
+        if (node_block < 0)  // Blocks have a negative index iff they are singletons
         {
-            old_living_blocks[node_block_pair.second] = {node_block_pair.second, (k_type) current_level};
+            old_living_blocks[node_block] = {node_block, (k_type) current_level};
         }
     }
 
@@ -1509,7 +1811,7 @@ int main(int ac, char *av[])
     // block_to_interval_map[literal_block] = {first_level, current_level};
 
     // Declare our condensed multi summary graph
-    SummaryGraph gs;
+    SummaryGraph gs(thread_count);
 
     SplitToMergedMap old_split_to_merged_map;
 
@@ -1542,9 +1844,9 @@ int main(int ac, char *av[])
             // std::cout << "DEBUG 2 block out: <" << global_universal_block << ">\n" << std::endl;   
             gs.add_block_node(global_universal_block);
             block_to_interval_map[global_universal_block] = {zero_level, zero_level};
-            for (auto node_block_pair: node_to_block_map)
+            for (block_or_singleton_index node_block: node_to_block_map)
             {
-                old_split_to_merged_map.add_pair(node_block_pair.second, global_universal_block);  // The universal block is the only parent to all nodes in k=1
+                old_split_to_merged_map.add_pair(node_block, global_universal_block);  // The universal block is the only parent to all nodes in k=1
             }
         }
 
@@ -1569,13 +1871,13 @@ int main(int ac, char *av[])
         std::tm *ptm_first_edges{std::localtime(&time_t_first_edges)};
         std::cout << std::put_time(ptm_first_edges, "%Y/%m/%d %H:%M:%S") << " Loading initial/terminal condensed data edges (0001-->0000) " << std::flush;  // We don't end the line so we can add statistics later
 
-        read_graph_into_summary_timed(graph_file, node_to_block_map, block_map, initial_map, block_to_interval_map, current_level, include_zero_outcome, fixed_point_reached, gs);
+        read_graph_into_summary_timed(graph_file, node_to_block_map, block_map, initial_map, block_to_interval_map, current_level, include_zero_outcome, fixed_point_reached, gs, thread_count);
 
         // This corresponds to the one block that has no outgoing edges.
         // Since it never apears as a subject, it will normally not be added by our algorithm, therefore we will manually add it here if it exists
         for (auto living_block_key_val: old_living_blocks)
         {
-            if (gs.get_nodes().find(living_block_key_val.first) == gs.get_nodes().cend())
+            if (!gs.contains_node(living_block_key_val.first))
             {
                 block_to_interval_map[living_block_key_val.first] = {first_level, current_level};
             }
@@ -1583,18 +1885,12 @@ int main(int ac, char *av[])
 
         if (fixed_point_reached)  // In this case we loaded in the fixed point edges, but we still need to add the edges between k=1 and k=0
         {
-            for (auto s_po_pair: gs.get_nodes())
+            gs.flush();
+            gs.for_each_edge([&gs, &old_split_to_merged_map](const SummaryEdge &edge)
             {
-                block_or_singleton_index subject = s_po_pair.first;
-                for (auto predicate_object_pair: s_po_pair.second.get_pairs())
-                {
-                    block_or_singleton_index predicate = predicate_object_pair.first;
-                    block_or_singleton_index object = predicate_object_pair.second;
-
-                    block_or_singleton_index object_image = old_split_to_merged_map.map_block(object);
-                    gs.add_edge_to_node(subject, predicate, object_image);
-                }
-            }
+                block_or_singleton_index object_image = old_split_to_merged_map.map_block(edge.object);
+                gs.add_edge_to_node(edge.subject, edge.predicate, object_image);
+            });
         }
         w.stop_step();
 
@@ -1613,17 +1909,12 @@ int main(int ac, char *av[])
         std::cout << std::put_time(ptm_write_graph_instant, "%Y/%m/%d %H:%M:%S") << " Writing condensed summary graph to disk" << std::endl;
 
         uint64_t edge_count = 0;
-        boost::unordered_flat_set<block_or_singleton_index> summary_nodes;
-        for (auto s_po_pair: gs.get_nodes())
+        boost::unordered_flat_set<block_or_singleton_index> summary_nodes = gs.get_nodes();
+        for (const SummaryEdge &edge: gs.get_sorted_edges())
         {
-            block_or_singleton_index subject = s_po_pair.first;
-            summary_nodes.emplace(subject);
-            for (auto predicate_object_pair: s_po_pair.second.get_pairs())
-            {
-                edge_count++;
-                block_or_singleton_index object = predicate_object_pair.second;
-                summary_nodes.emplace(object);
-            }
+            edge_count++;
+            summary_nodes.emplace(edge.subject);
+            summary_nodes.emplace(edge.object);
         }
 
         // Write the condensed summary graph to a file
@@ -1637,19 +1928,10 @@ int main(int ac, char *av[])
         std::tm *ptm_write_intervals_instant{std::localtime(&time_t_write_intervals_instant)};
         std::cout << std::put_time(ptm_write_intervals_instant, "%Y/%m/%d %H:%M:%S") << " Writing node intervals to disk" << std::endl;
 
-        // Write the merged block to singleton node map to a file
-        blocks_to_singletons.write_map_to_file_binary(output_directory);
-
         // Write node intvervals to a file
         std::string output_interval_file_path = output_directory + "condensed_multi_summary_intervals.bin";
         std::ofstream output_interval_file_binary(output_interval_file_path, std::ios::trunc | std::ofstream::out);
-        for (auto block_interval_pair: block_to_interval_map)  // We effectively write the following to disk: {block,start_time,end_time}
-        {
-            write_int_BLOCK_OR_SINGLETON_little_endian(output_interval_file_binary, block_interval_pair.first);
-            write_uint_K_TYPE_little_endian(output_interval_file_binary, block_interval_pair.second.first);
-            write_uint_K_TYPE_little_endian(output_interval_file_binary, block_interval_pair.second.second);
-            // std::cout << "DEBUG wrote block-interval: " << block_interval_pair.first << ":[" << block_interval_pair.second.first << "," << block_interval_pair.second.second << "]" << std::endl;
-        }
+        write_intervals_to_file_binary(output_interval_file_binary, block_to_interval_map);
         output_interval_file_binary.flush();
 
         auto t_write_map_instant{boost::chrono::system_clock::now()};
@@ -1681,7 +1963,12 @@ int main(int ac, char *av[])
                                    << ",\n    \"Edge count\": " << edge_count
                                    << ",\n    \"Total time taken (ms)\": " << experiment_duration
                                    << ",\n    \"Maximum memory footprint (kB)\": " << maximum_memory_footprint << "\n}";
-        summary_graph_stats_output.flush();
+        summary_graph_stats_output.close();
+        output_graph_file_binary.close();
+        output_interval_file_binary.close();
+        output_map_file_binary.close();
+        write_manifest(manifest, experiment_directory, blocks_to_singletons, edge_count, block_to_interval_map.size());
+        cache.store();
 
         exit(0);  // Close the program
     }
@@ -1695,7 +1982,7 @@ int main(int ac, char *av[])
     std::string previous_level_string(previous_level_stringstream.str());
 
     std::string current_mapping = experiment_directory + "bisimulation/mapping-" + previous_level_string + "to" + current_level_string + ".bin";
-    std::ifstream current_mapping_file(current_mapping, std::ifstream::in);
+    PartitionFileStream current_mapping_file(current_mapping, PARTITION_FILE_MAPPING);
 
     w.start_step("Read edges into summary graph", true);
     if (fixed_point_reached)
@@ -1707,7 +1994,7 @@ int main(int ac, char *av[])
             fixed_point_map.add_pair(index_block_pair.first, index_block_pair.first);  // At the fixed point, all blocks map to themselves
         }
         // Create the final set of data edges (between k and k-1)
-        read_graph_into_summary_timed(graph_file, node_to_block_map, block_map, fixed_point_map, block_to_interval_map, current_level, include_zero_outcome, fixed_point_reached, gs);
+        read_graph_into_summary_timed(graph_file, node_to_block_map, block_map, fixed_point_map, block_to_interval_map, current_level, include_zero_outcome, fixed_point_reached, gs, thread_count);
         old_split_to_merged_map = fixed_point_map;
         w.stop_step();
 
@@ -1756,8 +2043,7 @@ int main(int ac, char *av[])
                 block_index split_block = read_uint_BLOCK_little_endian(current_mapping_file);
                 if (split_block == 0)
                 {
-                    BlockMap& block_to_singletons = blocks_to_singletons.get_map(current_level);
-                    for (node_index singleton: block_to_singletons.get_node_set(merged_block).get_nodes())
+                    blocks_to_singletons.for_each_singleton(current_level, merged_block, [&](node_index singleton)
                     {
                         assert(singleton <= MAX_SIGNED_BLOCK_SIZE); // Check if the following cast is possible
 
@@ -1768,7 +2054,7 @@ int main(int ac, char *av[])
                         old_split_to_merged_map.add_pair(singlton_block, global_block);
                         dying_blocks.emplace(singlton_block);
                         block_to_interval_map[singlton_block] = {current_level,current_level};  // The block immediately dies, therefore it only lived at the last level (current_level)
-                    }
+                    });
                 }
                 else
                 {
@@ -1799,7 +2085,7 @@ int main(int ac, char *av[])
         }
 
         // Create the final set of data edges (between k and k-1)
-        read_graph_into_summary_timed(graph_file, node_to_block_map, block_map, old_split_to_merged_map, block_to_interval_map, current_level, include_zero_outcome, fixed_point_reached, gs);
+        read_graph_into_summary_timed(graph_file, node_to_block_map, block_map, old_split_to_merged_map, block_to_interval_map, current_level, include_zero_outcome, fixed_point_reached, gs, thread_count);
         w.stop_step();
 
         std::ofstream ad_hoc_output(experiment_directory + "ad_hoc_results/data_edges_statistics_condensed-" + current_level_string + "to" + previous_level_string + ".json", std::ios::trunc);
@@ -1812,9 +2098,10 @@ int main(int ac, char *av[])
 
     // This corresponds to the one block that has no outgoing edges.
     // Since it never apears as a subject, it will normally not be added by our algorithm, therefore we will manually add it here if it exists
+    // If the fixed point was not reached, the blocks that split at the last level already got their (one level) interval above, so we skip those
     for (auto living_block_key_val: old_living_blocks)
     {
-        if (gs.get_nodes().find(living_block_key_val.first) == gs.get_nodes().cend())
+        if (!gs.contains_node(living_block_key_val.first) && !old_dying_blocks.contains(living_block_key_val.first))
         {
             block_to_interval_map[living_block_key_val.first] = {first_level, current_level};
         }
@@ -1841,6 +2128,7 @@ int main(int ac, char *av[])
     for (current_level=initial_level; current_level>smallest_level; current_level--)
     {
         SplitToMergedMap current_split_to_merged_map;
+        gs.flush();  // Makes the edges added for the previous level visible to the lookups below
 
         std::ostringstream current_level_stringstream;
         current_level_stringstream << std::setw(4) << std::setfill('0') << current_level;
@@ -1851,14 +2139,8 @@ int main(int ac, char *av[])
         std::string previous_level_string(previous_level_stringstream.str());
 
         std::string current_mapping = experiment_directory + "bisimulation/mapping-" + previous_level_string + "to" + current_level_string + ".bin";
-        std::ifstream current_mapping_file(current_mapping, std::ifstream::in);
-        
-        const int BufferSize = 8 * 16184;
+        PartitionFileStream current_mapping_file(current_mapping, PARTITION_FILE_MAPPING);
 
-        char _buffer[BufferSize];
-    
-        current_mapping_file.rdbuf()->pubsetbuf(_buffer, BufferSize);
-        
         auto t_edges{boost::chrono::system_clock::now()};
         auto time_t_edges{boost::chrono::system_clock::to_time_t(t_edges)};
         std::tm *ptm_edges{std::localtime(&time_t_edges)};
@@ -1896,8 +2178,7 @@ int main(int ac, char *av[])
                 block_index split_block = read_uint_BLOCK_little_endian(current_mapping_file);
                 if (split_block == 0)
                 {
-                    BlockMap& block_to_singletons = blocks_to_singletons.get_map(current_level);
-                    for (node_index singleton: block_to_singletons.get_node_set(merged_block).get_nodes())
+                    blocks_to_singletons.for_each_singleton(current_level, merged_block, [&](node_index singleton)
                     {
                         assert(singleton <= MAX_SIGNED_BLOCK_SIZE); // Check if the following cast is possible
 
@@ -1908,7 +2189,7 @@ int main(int ac, char *av[])
                         current_split_to_merged_map.add_pair(singlton_block, global_block);
                         dying_blocks.emplace(singlton_block);
                         block_to_interval_map[singlton_block].first = current_level;
-                    }
+                    });
                 }
                 else
                 {
@@ -1950,116 +2231,70 @@ int main(int ac, char *av[])
         // }
         // std::cout << std::endl;
         // std::cout << "DEBUG current level: " << current_level << std::endl;
+        // The edges of a level only depend on the summary graph up to the previous level and on the maps above, which are not changed while
+        // the edges are computed, so every thread handles a share of the dying blocks and collects its edges in its own buffer
+        // The buffers are added to the summary graph afterwards, which sorts and deduplicates them at the next flush, so the order of the threads does not matter
+        gs.create_incoming_edge_index();
+        std::vector<block_or_singleton_index> dying_block_list(dying_blocks.cbegin(), dying_blocks.cend());
+        std::vector<block_or_singleton_index> old_dying_block_list(old_dying_blocks.cbegin(), old_dying_blocks.cend());
+        std::vector<std::vector<SummaryEdge>> thread_edges(thread_count);
+
         // Add the incomming edges for the blocks that died in the current level
-        // auto t_debug_2{boost::chrono::system_clock::now()};
-        // auto time_t_debug_2{boost::chrono::system_clock::to_time_t(t_debug_2)};
-        // std::tm *ptm_debug_2{std::localtime(&time_t_debug_2)};
-        // std::cout << "\n" << std::put_time(ptm_debug_2, "%Y/%m/%d %H:%M:%S") << " DEBUG: Before add current incomming" << std::endl;
-        // u_int64_t outer_loop_count = 0;
-        // u_int64_t inner_loop_a_count = 0;
-        // u_int64_t inner_loop_b_count = 0;
-        // u_int64_t inner_loop_c_count = 0;
-        for (block_or_singleton_index dying_block: dying_blocks)
+        parallel_for_ranges(dying_block_list.size(), thread_count, [&](unsigned int thread, uint64_t begin, uint64_t end)
         {
-            // outer_loop_count++;
-            block_or_singleton_index object_image = current_split_to_merged_map.map_block(dying_block);
-            for (auto predicate_subject_pair: gs.get_reverse_nodes()[dying_block].get_pairs())
+            for (uint64_t i = begin; i < end; i++)
             {
-                // inner_loop_a_count++;
-                block_or_singleton_index subject = predicate_subject_pair.second;
-
-                if (old_living_blocks.find(subject) == old_living_blocks.cend())
-                {
-                    continue;
-                }
-                // inner_loop_b_count++;
-                block_or_singleton_index subject_image = old_split_to_merged_map.map_block(subject);
-
-                // if (subject_image == 195){
-                //     std::cout << "DEBUG 195 mapped from sub: " << subject << std::endl;
-                // }
-
-                // if (object_image == 195){
-                //     std::cout << "DEBUG 195 mapped from obj: " << dying_block << std::endl;
-                // }
-
-                // if (subject == -2059) {
-                //     edge_type predicate = predicate_object_pair.first;
-                //     std::cout << "DEBUG -2059 edge (before): " << subject << "," << predicate << "," << dying_block << std::endl;
-                //     std::cout << "DEBUG -2059 edge (after): " << subject_image << "," << predicate << "," << object_image << std::endl;
-                // }
-                
-                // if (dying_block == 111)
-                // {
-                //     edge_type predicate = predicate_object_pair.first;
-                //     if (predicate == 78)
-                //     {
-                //         std::cout << "DEBUG 111 edge: " << subject_image << ", " << predicate << ", " << object_image << std::endl;
-                //     }
-                // }
-                // std::cout << "DEBUG dying block: " << dying_block << std::endl;
-
-                if (subject_image == subject && object_image == dying_block)
+                block_or_singleton_index dying_block = dying_block_list[i];
+                block_or_singleton_index object_image = current_split_to_merged_map.map_block(dying_block);
+                gs.for_each_incoming_edge(dying_block, [&](const SummaryEdge &edge)
                 {
-                    // edge_type predicate = predicate_object_pair.first;
-                    // std::cout << "DEBUG skipped edge: " << subject_image << ", " << predicate << ", " << object_image << std::endl;
-                    continue;
-                }
-                // inner_loop_c_count++;
-                
-                edge_type predicate = predicate_subject_pair.first;
-
-                // std::cout << "DEBUG new dying SPO: " << subject_image << "," << predicate << "," << object_image << std::endl;
-                gs.add_edge_to_node(subject_image, predicate, object_image);
+                    block_or_singleton_index subject = edge.subject;
+                    if (old_living_blocks.find(subject) == old_living_blocks.cend())
+                    {
+                        return;
+                    }
+                    block_or_singleton_index subject_image = old_split_to_merged_map.map_block(subject);
+                    if (subject_image == subject && object_image == dying_block)
+                    {
+                        return;
+                    }
+                    thread_edges[thread].push_back({subject_image, edge.predicate, object_image});
+                });
             }
-        }
-        // auto t_debug_loop1{boost::chrono::system_clock::now()};
-        // auto time_t_debug_loop1{boost::chrono::system_clock::to_time_t(t_debug_loop1)};
-        // std::tm *ptm_debug_loop1{std::localtime(&time_t_debug_loop1)};
-        // std::cout << std::put_time(ptm_debug_loop1, "%Y/%m/%d %H:%M:%S") << " DEBUG: out:" << outer_loop_count << " in1:" << inner_loop_a_count << " in2:" << inner_loop_b_count << " in3:" << inner_loop_c_count << std::endl;
+        });
 
         // Add the outgoing edges for the blocks that died in the previous level
-        // auto t_debug_1{boost::chrono::system_clock::now()};
-        // auto time_t_debug_1{boost::chrono::system_clock::to_time_t(t_debug_1)};
-        // std::tm *ptm_debug_1{std::localtime(&time_t_debug_1)};
-        // std::cout << std::put_time(ptm_debug_1, "%Y/%m/%d %H:%M:%S") << " DEBUG: Before add previous outgoing" << std::endl;
-        // outer_loop_count = 0;
-        // inner_loop_a_count = 0;
-        // inner_loop_b_count = 0;
-        // inner_loop_c_count = 0;
-        for (block_or_singleton_index old_dying_block: old_dying_blocks)
-        {
-            // outer_loop_count++;
-            block_or_singleton_index subject_image = old_split_to_merged_map.map_block(old_dying_block);
-            for (auto predicate_object_pair: gs.get_nodes()[old_dying_block].get_pairs())
+        parallel_for_ranges(old_dying_block_list.size(), thread_count, [&](unsigned int thread, uint64_t begin, uint64_t end)
+        {
+            for (uint64_t i = begin; i < end; i++)
             {
-                // inner_loop_a_count++;
-                block_or_singleton_index object = predicate_object_pair.second;
-
-                if (new_living_blocks.find(object) == new_living_blocks.cend())
-                {
-                    continue;
-                }
-                // inner_loop_b_count++;
-
-                block_or_singleton_index object_image = current_split_to_merged_map.map_block(object);
-
-                if (subject_image == old_dying_block && object_image == object)
+                block_or_singleton_index old_dying_block = old_dying_block_list[i];
+                block_or_singleton_index subject_image = old_split_to_merged_map.map_block(old_dying_block);
+                gs.for_each_outgoing_edge(old_dying_block, [&](const SummaryEdge &edge)
                 {
-                    // edge_type predicate = predicate_object_pair.first;
-                    // std::cout << "DEBUG skipped edge: " << subject_image << ", " << predicate << ", " << object_image << std::endl;
-                    continue;
-                }
-                // inner_loop_c_count++;
+                    block_or_singleton_index object = edge.object;
+                    if (new_living_blocks.find(object) == new_living_blocks.cend())
+                    {
+                        return;
+                    }
+                    block_or_singleton_index object_image = current_split_to_merged_map.map_block(object);
+                    if (subject_image == old_dying_block && object_image == object)
+                    {
+                        return;
+                    }
+                    thread_edges[thread].push_back({subject_image, edge.predicate, object_image});
+                });
+            }
+        });
 
-                edge_type predicate = predicate_object_pair.first;
-                gs.add_edge_to_node(subject_image, predicate, object_image);
+        for (std::vector<SummaryEdge> &edges: thread_edges)
+        {
+            for (const SummaryEdge &edge: edges)
+            {
+                gs.add_edge_to_node(edge.subject, edge.predicate, edge.object);
             }
+            edges = std::vector<SummaryEdge>();
         }
-        // auto t_debug_loop2{boost::chrono::system_clock::now()};
-        // auto time_t_debug_loop2{boost::chrono::system_clock::to_time_t(t_debug_loop2)};
-        // std::tm *ptm_debug_loop2{std::localtime(&time_t_debug_loop2)};
-        // std::cout << std::put_time(ptm_debug_loop2, "%Y/%m/%d %H:%M:%S") << " DEBUG: out:" << outer_loop_count << " in1:" << inner_loop_a_count << " in2:" << inner_loop_b_count << " in3:" << inner_loop_c_count << std::endl;
 
 
         // std::cout << std::endl;
@@ -2173,15 +2408,15 @@ int main(int ac, char *av[])
         gs.add_block_node(global_universal_block);
         k_type universal_block_time = 0;
         block_to_interval_map[global_universal_block] = {universal_block_time, universal_block_time};
+        gs.flush();
         for (auto living_block_key_val: old_living_blocks)
         {
             block_or_singleton_index subject = living_block_key_val.first;
-            for (auto predicate_object_pair: gs.get_nodes()[subject].get_pairs())
+            block_or_singleton_index subject_image = old_split_to_merged_map.map_block(subject);
+            gs.for_each_outgoing_edge(subject, [&gs, subject_image, global_universal_block](const SummaryEdge &edge)
             {
-                edge_type predicate = predicate_object_pair.first;
-                block_or_singleton_index subject_image = old_split_to_merged_map.map_block(subject);
-                gs.add_edge_to_node(subject_image, predicate, global_universal_block);
-            }
+                gs.add_edge_to_node(subject_image, edge.predicate, global_universal_block);
+            });
         }
         w.stop_step();
 
@@ -2202,17 +2437,12 @@ int main(int ac, char *av[])
     std::cout << std::put_time(ptm_write_graph, "%Y/%m/%d %H:%M:%S") << " Writing condensed summary graph to disk" << std::endl;
 
     uint64_t edge_count = 0;
-    boost::unordered_flat_set<block_or_singleton_index> summary_nodes;
-    for (auto s_po_pair: gs.get_nodes())
+    boost::unordered_flat_set<block_or_singleton_index> summary_nodes = gs.get_nodes();
+    for (const SummaryEdge &edge: gs.get_sorted_edges())
     {
-        block_or_singleton_index subject = s_po_pair.first;
-        summary_nodes.emplace(subject);
-        for (auto predicate_object_pair: s_po_pair.second.get_pairs())
-        {
-            edge_count++;
-            block_or_singleton_index object = predicate_object_pair.second;
-            summary_nodes.emplace(object);
-        }
+        edge_count++;
+        summary_nodes.emplace(edge.subject);
+        summary_nodes.emplace(edge.object);
     }
 
     // Write the condensed summary graph (along with the time intervals) to a file
@@ -2221,9 +2451,6 @@ int main(int ac, char *av[])
     std::ofstream output_graph_file_binary(output_graph_file_path, std::ios::trunc | std::ofstream::out);
     gs.write_graph_to_file_binary(output_graph_file_binary);
 
-    // Write the merged block to singleton node map to a file
-    blocks_to_singletons.write_map_to_file_binary(output_directory);
-
     auto t_write_intervals{boost::chrono::system_clock::now()};
     auto time_t_write_intervals{boost::chrono::system_clock::to_time_t(t_write_intervals)};
     std::tm *ptm_write_intervals{std::localtime(&time_t_write_intervals)};
@@ -2232,13 +2459,7 @@ int main(int ac, char *av[])
     // Write node intvervals to a file
     std::string output_interval_file_path = output_directory + "condensed_multi_summary_intervals.bin";
     std::ofstream output_interval_file_binary(output_interval_file_path, std::ios::trunc | std::ofstream::out);
-    for (auto block_interval_pair: block_to_interval_map)  // We effectively write the following to disk: {block,start_time,end_time}
-    {
-        write_int_BLOCK_OR_SINGLETON_little_endian(output_interval_file_binary, block_interval_pair.first);
-        write_uint_K_TYPE_little_endian(output_interval_file_binary, block_interval_pair.second.first);
-        write_uint_K_TYPE_little_endian(output_interval_file_binary, block_interval_pair.second.second);
-        // std::cout << "DEBUG wrote block-interval: " << block_interval_pair.first << ":[" << block_interval_pair.second.first << "," << block_interval_pair.second.second << "]" << std::endl;
-    }
+    write_intervals_to_file_binary(output_interval_file_binary, block_to_interval_map);
     output_interval_file_binary.flush();
 
     auto t_write_map{boost::chrono::system_clock::now()};
@@ -2270,5 +2491,10 @@ int main(int ac, char *av[])
                                << ",\n    \"Edge count\": " << edge_count
                                << ",\n    \"Total time taken (ms)\": " << experiment_duration
                                << ",\n    \"Maximum memory footprint (kB)\": " << maximum_memory_footprint << "\n}";
-    summary_graph_stats_output.flush();
+    summary_graph_stats_output.close();
+    output_graph_file_binary.close();
+    output_interval_file_binary.close();
+    output_map_file_binary.close();
+    write_manifest(manifest, experiment_directory, blocks_to_singletons, edge_count, block_to_interval_map.size());
+    cache.store();
 }
\ No newline at end of file
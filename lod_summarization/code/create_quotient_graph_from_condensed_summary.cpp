@@ -1,13 +1,23 @@
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <tuple>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <filesystem>
+#include <memory>
+#include <thread>
+#include <charconv>
+#include <string_view>
 #include <boost/algorithm/string.hpp>
 #include <boost/unordered/unordered_flat_set.hpp>
 #include <boost/unordered/unordered_flat_map.hpp>
 #include <boost/program_options.hpp>
+#include "quotient_index.hpp"
+#include "entity_dictionary.hpp"
+#include "partition_file.hpp"
+#include "experiment_manifest.hpp"
 
 using edge_type = uint32_t;
 using node_index = uint64_t;
@@ -22,11 +32,18 @@ using triple_set = boost::unordered_flat_set<std::tuple<block_or_singleton_index
 using block_map = boost::unordered_flat_map<block_or_singleton_index,std::pair<k_type,block_or_singleton_index>>;
 using block_set = boost::unordered_flat_set<block_or_singleton_index>;
 using id_entity_map = boost::unordered_flat_map<node_index,std::string>;
+using local_global_pairs_type = std::vector<std::pair<block_or_singleton_index,block_or_singleton_index>>;
+using level_offset_map_type = boost::unordered_flat_map<k_type,uint64_t>;
+
+const std::string LOCAL_GLOBAL_MAP_MAGIC = "LGMP";
+const uint8_t LOCAL_GLOBAL_MAP_VERSION = 2;
 const int BYTES_PER_ENTITY = 5;
 const int BYTES_PER_PREDICATE = 4;
 const int BYTES_PER_BLOCK = 4;
 const int BYTES_PER_BLOCK_OR_SINGLETON = 5;
 const int BYTES_PER_K_TYPE = 2;
+const int BYTES_PER_OFFSET = 8;
+const uint64_t WRITE_BUFFER_SIZE = 1 << 24;  // The output is collected in buffers of this size, before it is written to the files
 const int SUMMARY_NODE_INTERVAL_PAIR_SIZE = BYTES_PER_BLOCK_OR_SINGLETON + BYTES_PER_K_TYPE + BYTES_PER_K_TYPE;
 
 class MyException : public std::exception
@@ -140,6 +157,32 @@ k_type read_uint_K_TYPE_little_endian(std::istream &inputstream)
     return result;
 }
 
+u_int64_t read_uint_OFFSET_little_endian(std::istream &inputstream)
+{
+    char data[BYTES_PER_OFFSET];
+    inputstream.read(data, BYTES_PER_OFFSET);
+    if (inputstream.eof())
+    {
+        return UINT64_MAX;
+    }
+    if (inputstream.fail())
+    {
+        std::cout << "Read offset failed with code: " << inputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << inputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << inputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (inputstream.fail() && !inputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << inputstream.bad() << std::endl;
+        exit(inputstream.rdstate());
+    }
+    u_int64_t result = u_int64_t(0);
+
+    for (unsigned int i = 0; i < BYTES_PER_OFFSET; i++)
+    {
+        result |= (u_int64_t(data[i]) & 0x00000000000000FFull) << (i * 8);
+    }
+    return result;
+}
+
 u_int64_t read_uint_BLOCK_little_endian(std::istream &inputstream)
 {
     char data[8];
@@ -330,32 +373,66 @@ void read_singleton_mapping_timed(const std::string &filename, local_refines_typ
     read_singleton_mapping_from_stream_timed(infile, refines_map);
 }
 
+// Checks the header of a local to global map file, and reads the index at its end (mapping every level to the offset of its group)
+level_offset_map_type read_local_global_map_index(std::istream &inputstream)
+{
+    std::string magic(LOCAL_GLOBAL_MAP_MAGIC.size(), ' ');
+    inputstream.read(magic.data(), magic.size());
+    int version = inputstream.get();
+    if (!inputstream || magic != LOCAL_GLOBAL_MAP_MAGIC || version != LOCAL_GLOBAL_MAP_VERSION)
+    {
+        throw MyException("The local to global map file does not have the expected format (version " + std::to_string(LOCAL_GLOBAL_MAP_VERSION) + "). Please recreate the condensed summary graph.");
+    }
+    inputstream.seekg(-BYTES_PER_OFFSET, std::ios_base::end);
+    uint64_t index_offset = read_uint_OFFSET_little_endian(inputstream);
+    inputstream.seekg(index_offset);
+    uint64_t level_count = read_uint_OFFSET_little_endian(inputstream);
+    level_offset_map_type level_offsets;
+    for (uint64_t i = 0; i < level_count; i++)
+    {
+        k_type level = read_uint_K_TYPE_little_endian(inputstream);
+        level_offsets[level] = read_uint_OFFSET_little_endian(inputstream);
+    }
+    return level_offsets;
+}
+
+// Reads the {local, global} pairs of a single level (sorted by local block), which are empty if no block starts at that level
+local_global_pairs_type read_local_global_map_level(std::istream &inputstream, const level_offset_map_type &level_offsets, k_type level)
+{
+    local_global_pairs_type local_global_pairs;
+    auto level_offset_it = level_offsets.find(level);
+    if (level_offset_it == level_offsets.cend())
+    {
+        return local_global_pairs;
+    }
+    inputstream.seekg(level_offset_it->second + BYTES_PER_K_TYPE);  // Skip the level, which we already know
+    uint64_t count = read_uint_OFFSET_little_endian(inputstream);
+    local_global_pairs.reserve(count);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        block_or_singleton_index local_block = read_int_BLOCK_OR_SINGLETON_little_endian(inputstream);
+        block_or_singleton_index global_block = read_int_BLOCK_OR_SINGLETON_little_endian(inputstream);
+        local_global_pairs.emplace_back(local_block, global_block);
+    }
+    return local_global_pairs;
+}
+
 void read_local_global_map_from_stream_timed(std::istream &inputstream, local_to_global_map_type &local_to_global_map, k_type level)
 {
-    k_type lower_level = level;
-    k_type upper_level = level + 1;
-    // Read a mapping file
-    while (true)
+    level_offset_map_type level_offsets = read_local_global_map_index(inputstream);
+    // Only the levels we need are read
+    for (k_type local_level: {level, k_type(level + 1)})
     {
-        k_type local_level = read_uint_K_TYPE_little_endian(inputstream);
-        if (inputstream.eof())
-        {
-            break;
-        }
-        if (local_level < lower_level || local_level > upper_level)
+        for (auto [local_block, global_block]: read_local_global_map_level(inputstream, level_offsets, local_level))
         {
-            inputstream.seekg(2*BYTES_PER_BLOCK_OR_SINGLETON, std::ios_base::cur);  // No need to read the ids in this case
-            continue;
+            local_to_global_map[std::make_pair(local_level,local_block)] = global_block;
         }
-        block_or_singleton_index local_block = read_int_BLOCK_OR_SINGLETON_little_endian(inputstream);
-        block_or_singleton_index global_block = read_int_BLOCK_OR_SINGLETON_little_endian(inputstream);
-        local_to_global_map[std::make_pair(local_level,local_block)] = global_block;
     }
 }
 
 void read_local_global_map_timed(const std::string &filename, local_to_global_map_type &local_to_global_map, k_type level)
 {
-    std::ifstream infile(filename, std::ifstream::in);
+    std::ifstream infile(filename, std::ifstream::in | std::ifstream::binary);
     read_local_global_map_from_stream_timed(infile, local_to_global_map, level);
 }
 
@@ -463,106 +540,44 @@ void read_data_edges_timed_early(const std::string &infilename, triple_set &quot
     read_data_edges_from_stream_timed_early(infile, quotient_graph_triples, interval_map, level);
 }
 
-int main(int ac, char *av[])
+void write_uint_little_endian(std::string &output, uint64_t value, unsigned int byte_count)
 {
-    // This structure was inspired by https://gist.github.com/randomphrase/10801888
-    namespace po = boost::program_options;
-
-    po::options_description global("Global options");
-    global.add_options()("experiment_directory", po::value<std::string>(), "The directory for the experiment of interest");
-    global.add_options()("level", po::value<int32_t>(), "Which level the generate the quotient graph for. Use -1 as an alias for the fixed point.");
-
-    po::positional_options_description pos;
-    pos.add("experiment_directory", 1).add("level", 2);
-
-    po::variables_map vm;
-
-    po::parsed_options parsed = po::command_line_parser(ac, av).options(global).positional(pos).allow_unregistered().run();
-
-    po::store(parsed, vm);
-    po::notify(vm);
-
-    std::string experiment_directory = vm["experiment_directory"].as<std::string>();
-    int32_t input_level = vm["level"].as<int32_t>();
-
-    std::string graph_stats_file = experiment_directory + "ad_hoc_results/graph_stats.json";
-    std::ifstream graph_stats_file_stream(graph_stats_file);
-
-    std::string graph_stats_line;
-    std::string final_depth_string = "\"Final depth\"";
-    std::string fixed_point_string = "\"Fixed point\"";
-    
-    k_type final_depth;
-    bool fixed_point_reached;
-    
-    bool k_found = false;
-    bool fixed_point_found = false;
-
-    while (std::getline(graph_stats_file_stream, graph_stats_line))
+    for (unsigned int i = 0; i < byte_count; i++)
     {
-        boost::trim(graph_stats_line);
-        boost::erase_all(graph_stats_line, ",");
-        std::vector<std::string> result;
-        boost::split(result, graph_stats_line, boost::is_any_of(":"));
-        if (result[0] == final_depth_string)
-        {
-            std::stringstream sstream(result[1]);
-            sstream >> final_depth;
-            k_found = true;
-        }
-        else if (result[0] == fixed_point_string)
-        {
-            std::stringstream sstream(result[1]);
-            std::string fixed_point_string = sstream.str();
-            boost::trim(fixed_point_string);
-            if (fixed_point_string == "true")
-            {
-                fixed_point_reached = true;
-            }
-            else if (fixed_point_string != "false")
-            {
-                throw MyException("The \"Fixed point\" value in the graph_stats.json file has not been set to one of \"true\"/\"false\"");
-            }
-            fixed_point_found = true;
-        }
-        if (k_found && fixed_point_found)
-        {
-            break;
-        }
+        output.push_back(char((value >> (i * 8)) & 255));
     }
-    graph_stats_file_stream.close();
+}
 
-    k_type level;
-    if (input_level == -1)
+// Builds the quotient index by replaying all mapping files once, which determines the lifetime of every block (in the same way as finding the living blocks for a single level)
+void build_quotient_index(const std::string &experiment_directory, k_type final_depth, const std::string &index_file)
+{
+    std::vector<QuotientIndexNode> nodes;
+    boost::unordered_flat_map<block_or_singleton_index,uint64_t> living_blocks;  // local_id --> node
+    std::vector<std::pair<k_type,block_or_singleton_index>> node_local_blocks;  // node --> (start level, local_id)
+
+    std::string local_to_global_file = experiment_directory + "bisimulation/condensed_multi_summary_local_global_map.bin";
+    std::ifstream local_to_global_file_stream(local_to_global_file, std::ifstream::in | std::ifstream::binary);
+    level_offset_map_type level_offsets = read_local_global_map_index(local_to_global_file_stream);
+    auto read_level_global_blocks = [&](k_type level)
     {
-        if (not fixed_point_reached)
+        boost::unordered_flat_map<block_or_singleton_index,block_or_singleton_index> global_blocks;
+        for (auto [local_block, global_block]: read_local_global_map_level(local_to_global_file_stream, level_offsets, level))
         {
-            throw MyException("The level was specified as -1, but the bisimulation has not reached a fixed point. Use an absolute (non-negative) level instead.");
+            global_blocks[local_block] = global_block;
         }
-        level = final_depth;  // TODO add some logic to for this case, since it is slighlt different
-    }
-    else
+        return global_blocks;
+    };
+    auto add_node = [&](k_type start, block_or_singleton_index local_block, block_or_singleton_index global_block, block_or_singleton_index parent)
     {
-        if (input_level > final_depth)
-        {
-            throw MyException("The specified level goes beyond the final depth reached by the bisimulation.");
-        }
-        if (level == final_depth and not fixed_point_reached)
-        {
-            throw MyException("The specified level is the last computed level, but it is NOT the fixed point. To get the quotient graph for this level, please compute the bismulation for one more level.");
-        }
-        level = input_level;
-    }
-
-    std::string outcome_zero_file = experiment_directory + "bisimulation/outcome_condensed-0000.bin";
-    std::ifstream outcome_zero_file_stream(outcome_zero_file, std::ifstream::in);
-
-    block_map living_blocks;  // local_id --> (level, global_id)
-
-    const block_or_singleton_index GLOBAL_ID_PLACEHOLDER = 0;
+        nodes.push_back({global_block, parent, start, final_depth, 0, 0});
+        node_local_blocks.emplace_back(start, local_block);
+        return nodes.size() - 1;
+    };
 
     // Read the initial blocks
     std::cout << "Reading the initial blocks" << std::endl;
+    auto global_blocks = read_level_global_blocks(0);
+    PartitionFileStream outcome_zero_file_stream(experiment_directory + "bisimulation/outcome_condensed-0000.bin", PARTITION_FILE_OUTCOME);
     while (true)
     {
         block_or_singleton_index block = static_cast<block_or_singleton_index>(read_uint_BLOCK_little_endian(outcome_zero_file_stream));
@@ -570,55 +585,16 @@ int main(int ac, char *av[])
         {
             break;
         }
-
-        living_blocks[block] = std::make_pair(0, GLOBAL_ID_PLACEHOLDER);
+        living_blocks[block] = add_node(0, block, global_blocks[block], 0);
         node_index block_size = read_uint_ENTITY_little_endian(outcome_zero_file_stream);
-        // std::cout << "DEBUG initial block count: " << block_size << std::endl;
         outcome_zero_file_stream.seekg(block_size*BYTES_PER_ENTITY, std::ios_base::cur);
     }
     outcome_zero_file_stream.close();
-    
-    // Read the entity to id map
-    std::cout << "Reading the entity to id map" << std::endl;
-    std::string entity_id_file = experiment_directory + "entity2ID.txt";
-    std::ifstream entity_id_file_stream(entity_id_file, std::ifstream::in);
-
-    id_entity_map entity_names;
-    std::string line;
-    std::string delimiter = " ";
-    while (std::getline(entity_id_file_stream, line))
-    {
-        size_t delimiter_pos = line.find(delimiter);
-        std::string entity_string = line.substr(0, delimiter_pos);
-        std::string id_string = line.substr(delimiter_pos + delimiter.size());
-        entity_names[std::stoull(id_string)] = entity_string;
-    }
-    entity_id_file_stream.close();
-
-    // Find the living blocks at the specified level
-    std::cout << "Finding the living blocks" << std::endl;
 
-    std::ostringstream level_stringstream;
-    level_stringstream << std::setw(4) << std::setfill('0') << level;
-    std::string level_string(level_stringstream.str());
-
-    std::string quotient_graphs_directory = experiment_directory + "quotient_graphs/";
-    if (!std::filesystem::exists(quotient_graphs_directory))
+    // Replay the mappings, a block ends at the level before it is split (or before its local id is reused)
+    std::cout << "Finding the lifetimes of the blocks" << std::endl;
+    for (k_type i = 0; i < final_depth; i++)
     {
-        std::filesystem::create_directory(quotient_graphs_directory);
-    }
-
-    std::string outcome_contains_file = quotient_graphs_directory + "quotient_graph_contains-" + level_string +".txt";
-    std::ofstream outcome_contains_file_stream(outcome_contains_file, std::ios::trunc);
-
-    bool singletons_found;
-    // node_index singleton_counts = 0;
-    block_set replaced_blocks;
-
-    for (k_type i = 0; i < level; i++)
-    {
-        singletons_found = false;
-
         std::ostringstream current_level_stringstream;
         current_level_stringstream << std::setw(4) << std::setfill('0') << i;
         std::string current_level_string(current_level_stringstream.str());
@@ -627,11 +603,11 @@ int main(int ac, char *av[])
         next_level_stringstream << std::setw(4) << std::setfill('0') << i+1;
         std::string next_level_string(next_level_stringstream.str());
 
+        // The merged blocks refer to the blocks before this mapping, so the whole mapping is read before it is applied
+        std::vector<std::pair<block_or_singleton_index,std::vector<block_or_singleton_index>>> mapping;
+        bool singletons_found = false;
         std::string mapping_file = experiment_directory + "bisimulation/mapping-" + current_level_string + "to" + next_level_string + ".bin";
-        std::ifstream mapping_file_stream(mapping_file, std::ifstream::in);
-
-        replaced_blocks.clear();
-
+        PartitionFileStream mapping_file_stream(mapping_file, PARTITION_FILE_MAPPING);
         while (true)
         {
             block_or_singleton_index merged_block = static_cast<block_or_singleton_index>(read_uint_BLOCK_little_endian(mapping_file_stream));
@@ -639,10 +615,7 @@ int main(int ac, char *av[])
             {
                 break;
             }
-            if (replaced_blocks.find(merged_block) == replaced_blocks.cend())
-            {
-                living_blocks.erase(merged_block);
-            }
+            mapping.emplace_back(merged_block, std::vector<block_or_singleton_index>());
             block_index split_block_count = read_uint_BLOCK_little_endian(mapping_file_stream);
             for (block_index j = 0; j < split_block_count; j++)
             {
@@ -652,451 +625,633 @@ int main(int ac, char *av[])
                     singletons_found = true;
                     continue;
                 }
-                replaced_blocks.emplace(split_block);
-                living_blocks[split_block] = std::make_pair(i+1, GLOBAL_ID_PLACEHOLDER);
+                mapping.back().second.push_back(split_block);
             }
-
         }
         mapping_file_stream.close();
 
+        auto get_global_merged_block = [&](block_or_singleton_index merged_block)
+        {
+            auto merged_it = living_blocks.find(merged_block);
+            return merged_it == living_blocks.cend() ? block_or_singleton_index(0) : nodes[merged_it->second].global_block;
+        };
+        std::vector<block_or_singleton_index> global_merged_blocks;
+        for (const auto &[merged_block, split_blocks]: mapping)
+        {
+            global_merged_blocks.push_back(get_global_merged_block(merged_block));
+        }
+        std::vector<std::tuple<block_or_singleton_index,block_or_singleton_index>> singletons;  // (singleton, global merged block)
         if (singletons_found)
         {
             std::string singleton_mapping_file = experiment_directory + "bisimulation/singleton_mapping-" + current_level_string + "to" + next_level_string + ".bin";
-            std::ifstream singleton_mapping_file_stream(singleton_mapping_file, std::ifstream::in);
-
+            std::ifstream singleton_mapping_file_stream(singleton_mapping_file, std::ifstream::in | std::ifstream::binary);
             while (true)
             {
-                read_uint_BLOCK_little_endian(singleton_mapping_file_stream);
+                block_or_singleton_index merged_block = static_cast<block_or_singleton_index>(read_uint_BLOCK_little_endian(singleton_mapping_file_stream));
                 if (singleton_mapping_file_stream.eof())
                 {
                     break;
                 }
+                block_or_singleton_index global_merged_block = get_global_merged_block(merged_block);
                 block_or_singleton_index singleton_count = read_int_BLOCK_OR_SINGLETON_little_endian(singleton_mapping_file_stream);
                 for (block_or_singleton_index j = 0; j < singleton_count; j++)
                 {
-                    block_or_singleton_index singleton = read_int_BLOCK_OR_SINGLETON_little_endian(singleton_mapping_file_stream);
-                    // TODO We might not have to store the stingleton values???
-                    living_blocks[singleton] = std::make_pair(i+1, singleton);  // Singletons have a unique local block ID be design, so it is reused for the global id
-                    node_index singleton_entity = static_cast<node_index>(-(singleton+1));
-                    outcome_contains_file_stream << singleton << " " << entity_names[singleton_entity] << "\n";
-                    // singleton_counts += 1;
+                    singletons.emplace_back(read_int_BLOCK_OR_SINGLETON_little_endian(singleton_mapping_file_stream), global_merged_block);
                 }
             }
             singleton_mapping_file_stream.close();
         }
-    }
-    outcome_contains_file_stream.flush();  // Flush the intermediate results to the file
 
-    // std::cout << "DEBUG singleton count: " << singleton_counts << std::endl;
-    // std::cout << "DEBUG living block count: " << living_blocks.size() << std::endl; 
-
-    // Read and store the global ids for the summary nodes
-    std::cout << "Reading the global ids" << std::endl;
-    std::string local_to_global_file = experiment_directory + "bisimulation/condensed_multi_summary_local_global_map.bin";
-    std::ifstream local_to_global_file_stream(local_to_global_file, std::ifstream::in);
-
-    block_map next_blocks;  // local_id --> (level, global_id)
+        global_blocks = read_level_global_blocks(i + 1);
+        block_set replaced_blocks;
+        for (uint64_t m = 0; m < mapping.size(); m++)
+        {
+            const auto &[merged_block, split_blocks] = mapping[m];
+            if (replaced_blocks.find(merged_block) == replaced_blocks.cend())
+            {
+                auto merged_it = living_blocks.find(merged_block);
+                if (merged_it != living_blocks.cend())
+                {
+                    nodes[merged_it->second].end = i;
+                    living_blocks.erase(merged_it);
+                }
+            }
+            for (block_or_singleton_index split_block: split_blocks)
+            {
+                replaced_blocks.emplace(split_block);
+                auto replaced_it = living_blocks.find(split_block);
+                if (replaced_it != living_blocks.cend())
+                {
+                    nodes[replaced_it->second].end = i;
+                }
+                living_blocks[split_block] = add_node(i + 1, split_block, global_blocks[split_block], global_merged_blocks[m]);
+            }
+        }
+        for (auto [singleton, global_merged_block]: singletons)
+        {
+            // Singletons have a unique local block ID be design, so it is reused for the global id
+            uint64_t node = add_node(i + 1, singleton, singleton, global_merged_block);
+            nodes[node].member_count = 1;
+            living_blocks[singleton] = node;
+        }
+    }
 
-    auto living_blocks_end_it = living_blocks.cend();
+    // Read the members of every block from the outcome of the level at which it starts
+    std::cout << "Reading the contained entities" << std::endl;
+    boost::unordered_flat_map<std::pair<k_type,block_or_singleton_index>,uint64_t> local_block_nodes;
+    for (uint64_t node = 0; node < nodes.size(); node++)
+    {
+        local_block_nodes[node_local_blocks[node]] = node;
+    }
+    std::vector<node_index> members;
+    std::vector<uint64_t> node_member_offsets(nodes.size());
+    for (uint64_t node = 0; node < nodes.size(); node++)
+    {
+        if (nodes[node].global_block < 0)
+        {
+            node_member_offsets[node] = members.size();
+            members.push_back(static_cast<node_index>(-(nodes[node].global_block + 1)));
+        }
+    }
+    for (k_type i = 0; i <= final_depth; i++)
+    {
+        std::ostringstream current_level_stringstream;
+        current_level_stringstream << std::setw(4) << std::setfill('0') << i;
+        std::string outcome_file = experiment_directory + "bisimulation/outcome_condensed-" + current_level_stringstream.str() + ".bin";
+        PartitionFileStream outcome_file_stream(outcome_file, PARTITION_FILE_OUTCOME);
+        while (true)
+        {
+            block_or_singleton_index block = static_cast<block_or_singleton_index>(read_uint_BLOCK_little_endian(outcome_file_stream));
+            if (outcome_file_stream.eof())
+            {
+                break;
+            }
+            node_index block_size = read_uint_ENTITY_little_endian(outcome_file_stream);
+            auto node_it = local_block_nodes.find({i, block});
+            if (node_it == local_block_nodes.cend())
+            {
+                outcome_file_stream.seekg(block_size*BYTES_PER_ENTITY, std::ios_base::cur);
+                continue;
+            }
+            node_member_offsets[node_it->second] = members.size();
+            nodes[node_it->second].member_count = block_size;
+            for (node_index j = 0; j < block_size; j++)
+            {
+                members.push_back(read_uint_ENTITY_little_endian(outcome_file_stream));
+            }
+        }
+    }
+    for (uint64_t node = 0; node < nodes.size(); node++)
+    {
+        nodes[node].member_offset = node_member_offsets[node];
+    }
 
+    // Every data edge is part of the quotient graphs of the levels at which both its subject and object exist
+    // (or at which the object exists and the subject is created at the next level)
+    std::cout << "Reading data edges" << std::endl;
+    boost::unordered_flat_map<block_or_singleton_index,uint64_t> global_block_nodes;
+    for (uint64_t node = 0; node < nodes.size(); node++)
+    {
+        global_block_nodes[nodes[node].global_block] = node;
+    }
+    std::vector<QuotientIndexEdge> edges;
+    std::string data_edges_file = experiment_directory + "bisimulation/condensed_multi_summary_graph.bin";
+    std::ifstream data_edges_file_stream(data_edges_file, std::ifstream::in | std::ifstream::binary);
     while (true)
     {
-        k_type local_level = read_uint_K_TYPE_little_endian(local_to_global_file_stream);
-        if (local_to_global_file_stream.eof())
+        block_or_singleton_index subject = read_int_BLOCK_OR_SINGLETON_little_endian(data_edges_file_stream);
+        if (data_edges_file_stream.eof())
         {
             break;
         }
-        block_or_singleton_index local_block = read_int_BLOCK_OR_SINGLETON_little_endian(local_to_global_file_stream);
-
-        if (local_level == level + 1)  // We will need these ids later when mapping data edge subjects over refines edges
+        edge_type predicate = read_uint_PREDICATE_little_endian(data_edges_file_stream);
+        block_or_singleton_index object = read_int_BLOCK_OR_SINGLETON_little_endian(data_edges_file_stream);
+        auto subject_it = global_block_nodes.find(subject);
+        auto object_it = global_block_nodes.find(object);
+        if (subject_it == global_block_nodes.cend() || object_it == global_block_nodes.cend())
         {
-            block_or_singleton_index global_block = read_int_BLOCK_OR_SINGLETON_little_endian(local_to_global_file_stream);
-            next_blocks[local_block] = std::make_pair(local_level, global_block);
             continue;
         }
-
-        auto local_block_it = living_blocks.find(local_block);
-        if (local_block_it == living_blocks_end_it)  // No block by the local id found
+        const QuotientIndexNode &subject_node = nodes[subject_it->second];
+        const QuotientIndexNode &object_node = nodes[object_it->second];
+        k_type subject_from = subject_node.start > 0 ? subject_node.start - 1 : 0;
+        k_type from = std::max(subject_from, object_node.start);
+        k_type to = std::min(subject_node.end, object_node.end);
+        if (from > to)
         {
-            local_to_global_file_stream.seekg(BYTES_PER_BLOCK_OR_SINGLETON, std::ios_base::cur);
             continue;
         }
-        k_type stored_local_level = (local_block_it->second).first;
-        if (local_level != stored_local_level)  // The block found by the local id starts at another level
+        edges.push_back({subject, subject_node.parent, subject_node.start, from, to, predicate, object});
+    }
+
+    // Group the nodes and edges by their last level, ordered by their first level
+    std::sort(nodes.begin(), nodes.end(), [](const QuotientIndexNode &a, const QuotientIndexNode &b){return std::tie(a.end, a.start) < std::tie(b.end, b.start);});
+    std::sort(edges.begin(), edges.end(), [](const QuotientIndexEdge &a, const QuotientIndexEdge &b){return std::tie(a.to, a.from) < std::tie(b.to, b.from);});
+
+    std::cout << "Writing the quotient index" << std::endl;
+    auto [graph_checksum, local_global_checksum] = get_quotient_index_source_checksums(experiment_directory);
+    std::string output;
+    output += QUOTIENT_INDEX_MAGIC;
+    write_uint_little_endian(output, QUOTIENT_INDEX_VERSION, 1);
+    write_uint_little_endian(output, final_depth, QUOTIENT_INDEX_BYTES_PER_LEVEL);
+    write_uint_little_endian(output, graph_checksum, QUOTIENT_INDEX_BYTES_PER_OFFSET);
+    write_uint_little_endian(output, local_global_checksum, QUOTIENT_INDEX_BYTES_PER_OFFSET);
+    write_uint_little_endian(output, nodes.size(), QUOTIENT_INDEX_BYTES_PER_OFFSET);
+    write_uint_little_endian(output, edges.size(), QUOTIENT_INDEX_BYTES_PER_OFFSET);
+    write_uint_little_endian(output, members.size(), QUOTIENT_INDEX_BYTES_PER_OFFSET);
+    // For every level, the position of the first node (and edge) whose last level is at least that level
+    uint64_t position = 0;
+    for (uint64_t level = 0; level <= uint64_t(final_depth) + 1; level++)
+    {
+        while (position < nodes.size() && nodes[position].end < level)
         {
-            local_to_global_file_stream.seekg(BYTES_PER_BLOCK_OR_SINGLETON, std::ios_base::cur);
-            continue;
+            position++;
         }
-        block_or_singleton_index global_block = read_int_BLOCK_OR_SINGLETON_little_endian(local_to_global_file_stream);
-        (local_block_it->second).second = global_block;
+        write_uint_little_endian(output, position, QUOTIENT_INDEX_BYTES_PER_OFFSET);
     }
-    local_to_global_file_stream.close();
-
-    std::ostringstream next_level_stringstream;
-    next_level_stringstream << std::setw(4) << std::setfill('0') << level+1;
-    std::string next_level_string(next_level_stringstream.str());
-
-
-
-    // >>> DEBUG >>>
-    for(auto thingy: living_blocks)
+    position = 0;
+    for (uint64_t level = 0; level <= uint64_t(final_depth) + 1; level++)
     {
-        if (thingy.second.second == 0)
+        while (position < edges.size() && edges[position].to < level)
         {
-            std::cout << "DEBUG non-updated block: (" << thingy.first << "," << thingy.second.first << ") --> 0" << std::endl;
+            position++;
         }
+        write_uint_little_endian(output, position, QUOTIENT_INDEX_BYTES_PER_OFFSET);
+    }
+    for (const QuotientIndexNode &node: nodes)
+    {
+        write_uint_little_endian(output, node.global_block, QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON);
+        write_uint_little_endian(output, node.parent, QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON);
+        write_uint_little_endian(output, node.start, QUOTIENT_INDEX_BYTES_PER_LEVEL);
+        write_uint_little_endian(output, node.end, QUOTIENT_INDEX_BYTES_PER_LEVEL);
+        write_uint_little_endian(output, node.member_offset, QUOTIENT_INDEX_BYTES_PER_OFFSET);
+        write_uint_little_endian(output, node.member_count, QUOTIENT_INDEX_BYTES_PER_ENTITY);
+    }
+    for (const QuotientIndexEdge &edge: edges)
+    {
+        write_uint_little_endian(output, edge.subject, QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON);
+        write_uint_little_endian(output, edge.subject_parent, QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON);
+        write_uint_little_endian(output, edge.subject_start, QUOTIENT_INDEX_BYTES_PER_LEVEL);
+        write_uint_little_endian(output, edge.from, QUOTIENT_INDEX_BYTES_PER_LEVEL);
+        write_uint_little_endian(output, edge.to, QUOTIENT_INDEX_BYTES_PER_LEVEL);
+        write_uint_little_endian(output, edge.predicate, QUOTIENT_INDEX_BYTES_PER_PREDICATE);
+        write_uint_little_endian(output, edge.object, QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON);
+    }
+    for (node_index member: members)
+    {
+        write_uint_little_endian(output, member, QUOTIENT_INDEX_BYTES_PER_ENTITY);
     }
 
-    std::string next_level_mapping_file = experiment_directory + "bisimulation/mapping-" + level_string + "to" + next_level_string + ".bin";
-    std::ifstream next_level_mapping_file_stream(next_level_mapping_file, std::ifstream::in);
-    block_set alt_next;
+    // Write to a temporary file first, such that an interrupted build never leaves a partial index behind
+    std::string temporary_index_file = index_file + ".tmp";
+    std::ofstream index_file_stream(temporary_index_file, std::ios::trunc | std::ios::binary);
+    index_file_stream.write(output.data(), output.size());
+    index_file_stream.close();
+    if (!index_file_stream)
+    {
+        throw MyException("Could not write the quotient index to " + temporary_index_file);
+    }
+    std::filesystem::rename(temporary_index_file, index_file);
+}
 
-    while (true)
+class BufferedWriter
+{
+private:
+    std::string filename;
+    std::ofstream outputstream;
+    std::string buffer;
+
+public:
+    BufferedWriter(const std::string &filename) : filename(filename), outputstream(filename, std::ios::trunc | std::ios::binary)
     {
-        read_uint_BLOCK_little_endian(next_level_mapping_file_stream);
-        if (next_level_mapping_file_stream.eof())
+        if (!this->outputstream)
         {
-            break;
-        }
-        block_index split_block_count = read_uint_BLOCK_little_endian(next_level_mapping_file_stream);
-        for (block_index i = 0; i < split_block_count; i++)
-        {
-            block_or_singleton_index split_block = static_cast<block_or_singleton_index>(read_uint_BLOCK_little_endian(next_level_mapping_file_stream));
-            if (split_block == 0)
-            {
-                continue;
-            }
-            alt_next.emplace(split_block);
+            throw MyException("Could not open " + filename + " for writing");
         }
+        this->buffer.reserve(WRITE_BUFFER_SIZE);
     }
-    next_level_mapping_file_stream.close();
-
-    for (block_or_singleton_index alt: alt_next)
+    std::string& get_buffer()
+    {
+        return this->buffer;
+    }
+    void flush_if_full()
     {
-        if (next_blocks.find(alt) == next_blocks.cend())
+        if (this->buffer.size() >= WRITE_BUFFER_SIZE)
         {
-            std::cout << "DEBUG alt next missing in next: " << alt << std::endl;
+            this->flush();
         }
     }
-    for (auto block: next_blocks)
+    void flush()
     {
-        if (alt_next.find(block.first) == alt_next.cend())
+        this->outputstream.write(this->buffer.data(), this->buffer.size());
+        this->outputstream.flush();
+        this->buffer.clear();
+        if (!this->outputstream)
         {
-            std::cout << "DEBUG next missing in alt next: " << block.first << std::endl;
+            throw MyException("Could not write to " + this->filename);
         }
     }
-    // <<< DEBUG <<<
-
+    void close()
+    {
+        this->flush();
+        this->outputstream.close();
+    }
+};
 
+// Appends the decimal representation of an integer, without going through a stream
+void append_integer(std::string &output, int64_t value)
+{
+    char data[24];
+    auto result = std::to_chars(data, data + sizeof(data), value);
+    output.append(data, result.ptr - data);
+}
 
-    std::string next_level_singleton_mapping_file = experiment_directory + "bisimulation/singleton_mapping-" + level_string + "to" + next_level_string + ".bin";
+struct SummaryEdge
+{
+    block_or_singleton_index subject;
+    edge_type predicate;
+    block_or_singleton_index object;
 
-    if (std::filesystem::exists(next_level_singleton_mapping_file))
+    bool operator<(const SummaryEdge &other) const
     {
-        std::ifstream next_level_singleton_mapping_file_stream(next_level_singleton_mapping_file, std::ifstream::in);
+        return std::tie(subject, predicate, object) < std::tie(other.subject, other.predicate, other.object);
+    }
+    bool operator==(const SummaryEdge &other) const
+    {
+        return subject == other.subject && predicate == other.predicate && object == other.object;
+    }
+};
 
-        while (true)
-        {
-            read_uint_BLOCK_little_endian(next_level_singleton_mapping_file_stream);
-            if (next_level_singleton_mapping_file_stream.eof())
-            {
-                break;
-            }
-            block_or_singleton_index singleton_count = read_int_BLOCK_OR_SINGLETON_little_endian(next_level_singleton_mapping_file_stream);
-            for (block_or_singleton_index j = 0; j < singleton_count; j++)
-            {
-                block_or_singleton_index singleton = read_int_BLOCK_OR_SINGLETON_little_endian(next_level_singleton_mapping_file_stream);
-                next_blocks[singleton] = std::make_pair(level+1, singleton);
-            }
-        }
-        next_level_singleton_mapping_file_stream.close();
+// Runs function(thread, begin, end) on thread_count threads, each getting an (almost) equal share of [0, size)
+template <typename Function>
+void parallel_for_ranges(uint64_t size, unsigned int thread_count, Function function)
+{
+    if (thread_count <= 1 || size < thread_count)
+    {
+        function(0, 0, size);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back(function, t, (size * t) / thread_count, (size * (t + 1)) / thread_count);
+    }
+    for (std::thread &thread: threads)
+    {
+        thread.join();
     }
+}
 
-    // for (auto lb_pair: living_blocks)
-    // {
-    //     std::cout << "DEBUG living block: " << lb_pair.first << " (" << lb_pair.second.first << ", " <<  lb_pair.second.second << ")" << std::endl;
-    // }
+// Sorts the edges and removes the duplicates, by sorting one range per thread and then merging the ranges pairwise in parallel
+void parallel_sort_unique(std::vector<SummaryEdge> &edges, unsigned int thread_count)
+{
+    std::vector<std::pair<uint64_t, uint64_t>> runs(std::max(thread_count, 1u));
+    parallel_for_ranges(edges.size(), runs.size(), [&edges, &runs](unsigned int t, uint64_t begin, uint64_t end)
+    {
+        std::sort(edges.begin() + begin, edges.begin() + end);
+        runs[t] = {begin, std::unique(edges.begin() + begin, edges.begin() + end) - edges.begin()};
+    });
+    if (edges.size() < runs.size())  // All edges were sorted as one range
+    {
+        runs.resize(1);
+    }
 
-    // Read and store the entities contained in the living blocks
-    // TODO ALSO READ SINGLETONS
-    std::cout << "Reading and storing the contained entities" << std::endl;
-    // node_index DEBUG_block_sizes = 0;
-    for (k_type i = 0; i <= level; i++)
+    // Every merged run is written at the start of its left run, which leaves enough room since the union is never larger than both runs together
+    std::vector<SummaryEdge> buffer(edges.size());
+    while (runs.size() > 1)
     {
-        // std::cout << "DEBUG level: " << i << std::endl;
-        std::ostringstream current_level_stringstream;
-        current_level_stringstream << std::setw(4) << std::setfill('0') << i;
-        std::string current_level_string(current_level_stringstream.str());
-        
-        std::string outcome_file = experiment_directory + "bisimulation/outcome_condensed-" + current_level_string +".bin";
-        std::ifstream outcome_file_stream(outcome_file, std::ifstream::in);
-        
-        while (true)
+        std::vector<std::pair<uint64_t, uint64_t>> merged_runs((runs.size() + 1) / 2);
+        parallel_for_ranges(merged_runs.size(), merged_runs.size(), [&edges, &buffer, &runs, &merged_runs](unsigned int, uint64_t begin, uint64_t end)
         {
-            block_or_singleton_index block = static_cast<block_or_singleton_index>(read_uint_BLOCK_little_endian(outcome_file_stream));
-            if (outcome_file_stream.eof())
+            for (uint64_t pair = begin; pair < end; pair++)
             {
-                break;
+                auto left = runs[2 * pair];
+                if (2 * pair + 1 == runs.size())
+                {
+                    std::copy(edges.begin() + left.first, edges.begin() + left.second, buffer.begin() + left.first);
+                    merged_runs[pair] = left;
+                    continue;
+                }
+                auto right = runs[2 * pair + 1];
+                auto merged_end = std::set_union(edges.begin() + left.first, edges.begin() + left.second,
+                                                 edges.begin() + right.first, edges.begin() + right.second,
+                                                 buffer.begin() + left.first);
+                merged_runs[pair] = {left.first, merged_end - buffer.begin()};
             }
+        });
+        edges.swap(buffer);
+        runs = std::move(merged_runs);
+    }
+    edges.erase(edges.begin() + runs[0].second, edges.end());
+    edges.erase(edges.begin(), edges.begin() + runs[0].first);
+}
 
-            node_index block_size = read_uint_ENTITY_little_endian(outcome_file_stream);
-            // std::cout << "DEBUG block-size: " << block << " --- " << block_size << std::endl;
-
-            auto block_it = living_blocks.find(block);
-            if (block_it == living_blocks_end_it)
-            {
-                outcome_file_stream.seekg(block_size*BYTES_PER_ENTITY, std::ios_base::cur);
-                continue;
-            }
-            k_type stored_local_level = (block_it->second).first;
-            if (i != stored_local_level)
+// Collects the data edges of the quotient graph at the given level, sorted and without duplicates
+// The edge ranges of the index are split evenly over the threads, which each decode their share straight into the shared vector
+std::vector<SummaryEdge> collect_quotient_edges(const QuotientIndex &quotient_index, k_type level, unsigned int thread_count)
+{
+    std::vector<std::pair<uint64_t,uint64_t>> ranges = quotient_index.get_edge_ranges(level);
+    std::vector<uint64_t> range_offsets = {0};  // The position of the first edge of every range in the collected edges
+    for (auto [begin, end]: ranges)
+    {
+        range_offsets.push_back(range_offsets.back() + (end - begin));
+    }
+    std::vector<SummaryEdge> edges(range_offsets.back());
+    parallel_for_ranges(edges.size(), thread_count, [&](unsigned int, uint64_t begin, uint64_t end)
+    {
+        uint64_t range = std::upper_bound(range_offsets.begin(), range_offsets.end(), begin) - range_offsets.begin() - 1;
+        for (uint64_t position = begin; position < end; position++)
+        {
+            while (position >= range_offsets[range + 1])
             {
-                outcome_file_stream.seekg(block_size*BYTES_PER_ENTITY, std::ios_base::cur);
-                continue;
+                range++;
             }
-            // DEBUG_block_sizes += 1;
-            block_or_singleton_index global_block = (block_it->second).second;
-            
-            for (node_index j = 0; j < block_size; j++)
-            {
-                node_index entity_id = read_uint_ENTITY_little_endian(outcome_file_stream);
-                std::string entity = entity_names[entity_id];
+            QuotientIndexEdge edge = quotient_index.get_edge(ranges[range].first + (position - range_offsets[range]));
+            edges[position] = {QuotientIndex::get_subject_at_level(edge, level), edge.predicate, edge.object};
+        }
+    });
+    parallel_sort_unique(edges, thread_count);
+    return edges;
+}
 
-                outcome_contains_file_stream << global_block << " " << entity << "\n";
-            }
+k_type get_level(int32_t input_level, k_type final_depth, bool fixed_point_reached)
+{
+    if (input_level == -1)
+    {
+        if (not fixed_point_reached)
+        {
+            throw MyException("The level was specified as -1, but the bisimulation has not reached a fixed point. Use an absolute (non-negative) level instead.");
         }
+        return final_depth;
     }
-    outcome_contains_file_stream.close();  // This should flush
-    // std::cout << "DEBUG block sizes: " << DEBUG_block_sizes << std::endl;
-
-    if (level == final_depth)  // This is the fixed point, so we don't have explicit refines edges
+    if (input_level < -1)
     {
-        // TODO do stuff
-        exit(0);  // Close the program
+        throw MyException("The specified level should be non-negative (or -1 for the fixed point).");
     }
+    if (input_level > final_depth)
+    {
+        throw MyException("The specified level goes beyond the final depth reached by the bisimulation.");
+    }
+    if (input_level == final_depth and not fixed_point_reached)
+    {
+        throw MyException("The specified level is the last computed level, but it is NOT the fixed point. To get the quotient graph for this level, please compute the bismulation for one more level.");
+    }
+    return input_level;
+}
 
-    std::cout << "Reading " << level_string << "-->" << next_level_string << " mapping" << std::endl;
-    std::string mapping_file = experiment_directory + "bisimulation/mapping-" + level_string + "to" + next_level_string + ".bin";
-    std::ifstream mapping_file_stream(mapping_file, std::ifstream::in);
-
-    global_refines_type refines_edges;
+// Writes the contained entities, and (unless the level is the fixed point) the edges and types of the quotient graph at the given level
+// With binary output, the edges are written as {subject, predicate, object} records in the same format as condensed_multi_summary_graph.bin instead
+// Without an entity dictionary, the contained entities are written as their ids
+void write_quotient_graph(const QuotientIndex &quotient_index, const EntityDictionary *entity_dictionary, const std::string &quotient_graphs_directory, k_type level, k_type final_depth, unsigned int thread_count, bool binary_output)
+{
+    std::ostringstream level_stringstream;
+    level_stringstream << std::setw(4) << std::setfill('0') << level;
+    std::string level_string(level_stringstream.str());
 
-    bool new_singletons_found = false;
-    while (true)
+    // Write the entities contained in the living blocks
+    std::cout << "Writing the contained entities" << std::endl;
+    BufferedWriter contains_writer(quotient_graphs_directory + "quotient_graph_contains-" + level_string +".txt");
+    std::string &contains_buffer = contains_writer.get_buffer();
+    quotient_index.for_each_member(level, [&](block_or_singleton_index global_block, node_index entity_id)
     {
-        block_or_singleton_index merged_block = static_cast<block_or_singleton_index>(read_uint_BLOCK_little_endian(mapping_file_stream));
-        if (mapping_file_stream.eof())
+        append_integer(contains_buffer, global_block);
+        contains_buffer += ' ';
+        if (entity_dictionary == nullptr)
         {
-            break;
+            append_integer(contains_buffer, entity_id);
         }
-        block_or_singleton_index global_merged_block = living_blocks[merged_block].second;
-        // if (global_merged_block == 1021)
-        // {
-        //     std::cout << "DEBUG merged block: 1021" << std::endl;
-        // }
-        block_index split_block_count = read_uint_BLOCK_little_endian(mapping_file_stream);
-        for (block_index i = 0; i < split_block_count; i++)
+        else
         {
-            block_or_singleton_index split_block = static_cast<block_or_singleton_index>(read_uint_BLOCK_little_endian(mapping_file_stream));
-            if (split_block == 0)
-            {
-                new_singletons_found = true;
-                continue;
-            }
-            block_or_singleton_index global_split_block = next_blocks[split_block].second;
-            refines_edges[global_split_block] = global_merged_block;
+            contains_buffer += entity_dictionary->get_name(entity_id);
         }
+        contains_buffer += '\n';
+        contains_writer.flush_if_full();
+    });
+    contains_writer.close();
 
+    if (level == final_depth)  // This is the fixed point, so we don't have explicit refines edges
+    {
+        return;
     }
-    mapping_file_stream.close();
 
-    if (new_singletons_found)
-    {
-        std::cout << "Reading " << level_string << "-->" << next_level_string << " singleton mapping" << std::endl;
-        std::string singleton_mapping_file = experiment_directory + "bisimulation/singleton_mapping-" + level_string + "to" + next_level_string + ".bin";
-        std::ifstream singleton_mapping_file_stream(singleton_mapping_file, std::ifstream::in);
+    // Collect the data edges, subjects that only start at level+1 are mapped over their refines edge (to get an edge from level to level)
+    std::cout << "Collecting data edges" << std::endl;
+    std::vector<SummaryEdge> data_edges = collect_quotient_edges(quotient_index, level, thread_count);
 
-        while (true)
+    if (binary_output)
+    {
+        std::cout << "Writing the quotient graph edges" << std::endl;
+        BufferedWriter edges_writer(quotient_graphs_directory + "quotient_graph_edges-" + level_string + ".bin");
+        std::string &edges_buffer = edges_writer.get_buffer();
+        for (const SummaryEdge &edge: data_edges)
         {
-            block_or_singleton_index merged_block = static_cast<block_or_singleton_index>(read_uint_BLOCK_little_endian(singleton_mapping_file_stream));
-            if (singleton_mapping_file_stream.eof())
-            {
-                break;
-            }
-            block_or_singleton_index global_merged_block = living_blocks[merged_block].second;
-            block_or_singleton_index singleton_count = read_int_BLOCK_OR_SINGLETON_little_endian(singleton_mapping_file_stream);
-            for (block_or_singleton_index i = 0; i < singleton_count; i++)
-            {
-                block_or_singleton_index singleton = read_int_BLOCK_OR_SINGLETON_little_endian(singleton_mapping_file_stream);
-                // std::cout << "DEBUG singleton refines edge: " << singleton << std::endl;
-                refines_edges[singleton] = global_merged_block;
-            }
+            write_uint_little_endian(edges_buffer, edge.subject, BYTES_PER_BLOCK_OR_SINGLETON);
+            write_uint_little_endian(edges_buffer, edge.predicate, BYTES_PER_PREDICATE);
+            write_uint_little_endian(edges_buffer, edge.object, BYTES_PER_BLOCK_OR_SINGLETON);
+            edges_writer.flush_if_full();
         }
-        singleton_mapping_file_stream.close();
+        edges_writer.close();
+        return;
     }
-    else
-    {
-        std::cout << "No singletons found" << std::endl;
-    }
-
-    // for (auto s_o: refines_edges)
-    // {
-    //     std::cout << "DEBUG s-o: " << s_o.first << "," << s_o.second << std::endl;
-    // }
 
-    // Create the global_living_blocks and global_next_blocks sets
-    std::cout << "Creating global living blocks and global next blocks sets" << std::endl;
-    block_set global_living_blocks;
-    block_set global_next_blocks;
-
-    for (auto local_data_pair: living_blocks)
-    {
-        block_or_singleton_index global_block = local_data_pair.second.second;
-        global_living_blocks.emplace(global_block);
-    }
-    for (auto local_data_pair: next_blocks)
+    // Write the quotient graph edges and types
+    std::cout << "Writing the quotient graph edges and types" << std::endl;
+    BufferedWriter edges_writer(quotient_graphs_directory + "quotient_graph_edges-" + level_string + ".txt");
+    BufferedWriter types_writer(quotient_graphs_directory + "quotient_graph_types-" + level_string + ".txt");
+    std::string &edges_buffer = edges_writer.get_buffer();
+    std::string &types_buffer = types_writer.get_buffer();
+    for (const SummaryEdge &edge: data_edges)
     {
-        block_or_singleton_index global_block = local_data_pair.second.second;
-        global_next_blocks.emplace(global_block);
+        append_integer(edges_buffer, edge.subject);
+        edges_buffer += ' ';
+        append_integer(edges_buffer, edge.object);
+        edges_buffer += '\n';
+        append_integer(types_buffer, edge.predicate);
+        types_buffer += '\n';
+        edges_writer.flush_if_full();
+        types_writer.flush_if_full();
     }
+    edges_writer.close();
+    types_writer.close();
+}
 
-    // for (auto s_o: refines_edges)
-    // {
-    //     // if (global_living_blocks.find(s_o.first) == global_living_blocks.cend())
-    //     // {
-    //     //     std::cout << "DEBUG: wrong refines subject: " << s_o.first << std::endl;
-    //     // }
-    //     if (global_living_blocks.find(s_o.second) == global_living_blocks.cend())
-    //     {
-    //         std::cout << "DEBUG: wrong refines object: " << s_o.second << std::endl;
-    //     }
-    // }
+int main(int ac, char *av[])
+{
+    // This structure was inspired by https://gist.github.com/randomphrase/10801888
+    namespace po = boost::program_options;
 
-    // Read the data edges    
-    std::cout << "Reading data edges" << std::endl;
-    std::string data_edges_file = experiment_directory + "bisimulation/condensed_multi_summary_graph.bin";
-    std::ifstream data_edges_file_stream(data_edges_file, std::ifstream::in);
+    po::options_description global("Global options");
+    global.add_options()("experiment_directory", po::value<std::string>(), "The directory for the experiment of interest");
+    global.add_options()("level", po::value<int32_t>(), "Which level the generate the quotient graph for. Use -1 as an alias for the fixed point.");
+    global.add_options()("levels", po::value<std::string>(), "Generate the quotient graphs for a range of levels `a-b` (inclusive), or for `all` levels, in one run instead of a single level.");
+    global.add_options()("threads", po::value<unsigned int>()->default_value(std::max(std::thread::hardware_concurrency(), 1u)), "The number of threads used for collecting, sorting and deduplicating the data edges");
+    global.add_options()("format", po::value<std::string>()->default_value("text"), "The output format of the data edges, one of: \"text\" or \"binary\"");
+    global.add_options()("entity_names", po::value<std::string>()->default_value("lazy"), "How the contained entities are written, one of: \"lazy\" (their names, looked up when needed) or \"numeric\" (their ids)");
 
-    auto global_next_blocks_end_it = global_next_blocks.cend();
-    auto global_living_blocks_end_it = global_living_blocks.cend();
-    triple_set data_edges;
-    // bool DEBUG_subject_found;
+    po::positional_options_description pos;
+    pos.add("experiment_directory", 1).add("level", 2);
+
+    po::variables_map vm;
 
+    po::parsed_options parsed = po::command_line_parser(ac, av).options(global).positional(pos).allow_unregistered().run();
 
+    po::store(parsed, vm);
+    po::notify(vm);
 
-    // >>> DEBUG >>>
-    std::string intervals_file = experiment_directory + "bisimulation/condensed_multi_summary_intervals.bin";
-    std::ifstream intervals_file_stream(intervals_file, std::ifstream::in);
+    std::string experiment_directory = vm["experiment_directory"].as<std::string>();
+    unsigned int thread_count = std::max(vm["threads"].as<unsigned int>(), 1u);
+    std::string format = vm["format"].as<std::string>();
+    if (format != "text" && format != "binary")
+    {
+        throw MyException("`format` is set to \"" + format + "\". It should be one of: \"text\" or \"binary\".");
+    }
+    bool binary_output = format == "binary";
+    std::string entity_names_mode = vm["entity_names"].as<std::string>();
+    if (entity_names_mode != "lazy" && entity_names_mode != "numeric")
+    {
+        throw MyException("`entity_names` is set to \"" + entity_names_mode + "\". It should be one of: \"lazy\" or \"numeric\".");
+    }
 
-    block_set interval_blocks;
+    ExperimentManifest manifest(experiment_directory);
+    manifest.read_or_start();
+    k_type final_depth = manifest.get_graph_facts().final_depth;
+    bool fixed_point_reached = manifest.get_graph_facts().fixed_point;  // The bisimulator writes false when it stopped early, e.g. because its time or memory budget was exhausted
 
-    while (true)
+    // A summary file that does not have the size listed in the manifest (e.g. because the disk ran full) is reported here, instead of being read past its end
+    for (const ManifestEntry &entry: manifest.get_entries())
     {
-        block_or_singleton_index block = read_int_BLOCK_OR_SINGLETON_little_endian(intervals_file_stream);
-        if (intervals_file_stream.eof())
+        if (entry.path.starts_with("bisimulation/condensed_multi_summary_") && !manifest.has_listed_size(entry))
         {
-            break;
-        }
-        block_or_singleton_index start_time = read_uint_K_TYPE_little_endian(intervals_file_stream);
-        block_or_singleton_index end_time = read_uint_K_TYPE_little_endian(intervals_file_stream);
-        if (start_time <= level and end_time >= start_time)
-        {
-            interval_blocks.emplace(block);
+            throw MyException(experiment_directory + entry.path + " does not have the size listed in the manifest, build the condensed summary graph again");
         }
     }
 
-    for (block_or_singleton_index glob: global_living_blocks)
+    std::vector<k_type> levels;
+    if (vm.count("levels"))
     {
-        if (global_living_blocks.find(glob) == global_living_blocks.cend())
+        std::string levels_string = vm["levels"].as<std::string>();
+        int32_t first_level = 0;
+        int32_t last_level = fixed_point_reached ? final_depth : int32_t(final_depth) - 1;
+        if (levels_string != "all")
         {
-            std::cout << "DEBUG alt missing glob in inter: " << glob << std::endl;
+            std::vector<std::string> result;
+            boost::split(result, levels_string, boost::is_any_of("-"));
+            if (result.size() != 2 || result[0].empty() || result[1].empty())
+            {
+                throw MyException("The levels should be specified as `all` or as a range `a-b`");
+            }
+            first_level = std::stoi(result[0]);
+            last_level = std::stoi(result[1]);
+            get_level(last_level, final_depth, fixed_point_reached);  // Check that the last level is valid
+        }
+        for (int32_t input_level = first_level; input_level <= last_level; input_level++)
+        {
+            levels.push_back(get_level(input_level, final_depth, fixed_point_reached));
+        }
+        if (levels.empty())
+        {
+            throw MyException("The specified range of levels is empty");
         }
     }
-    for (block_or_singleton_index inter: interval_blocks)
+    else
     {
-        if (interval_blocks.find(inter) == interval_blocks.cend())
+        if (!vm.count("level"))
         {
-            std::cout << "DEBUG next missing inter in glob: " << inter << std::endl;
+            throw MyException("Either a level or the --levels flag should be provided");
         }
+        levels.push_back(get_level(vm["level"].as<int32_t>(), final_depth, fixed_point_reached));
     }
-    // <<< DEBUG <<<
-
-
 
-
-    while (true)
+    // The quotient index is built once from the mapping files, after which the quotient graph of any level can be extracted directly
+    std::string quotient_index_file = get_quotient_index_file(experiment_directory);
+    bool quotient_index_current = false;
+    if (std::filesystem::exists(quotient_index_file))
     {
-        block_or_singleton_index subject = read_int_BLOCK_OR_SINGLETON_little_endian(data_edges_file_stream);
-        if (data_edges_file_stream.eof())
+        try
         {
-            break;
+            QuotientIndex existing_quotient_index(quotient_index_file);
+            quotient_index_current = existing_quotient_index.is_current(experiment_directory, final_depth);
         }
-        // DEBUG_subject_found = false;
-        // if(subject == 1021)
-        // {
-        //     DEBUG_subject_found = true;
-        // }
-        auto subject_global_next_block_it = global_next_blocks.find(subject);
-        // We next blocks only contains the newly created blocks, but these are not the only relevant ones
-        if (subject_global_next_block_it == global_next_blocks_end_it)
+        catch (const std::exception &exception)
         {
-            auto subject_global_living_it = global_living_blocks.find(subject);
-            if (subject_global_living_it == global_living_blocks_end_it)
-            {
-                // if (DEBUG_subject_found)
-                // {
-                //     std::cout << "DEBUG: not next, not living" << std::endl;
-                // }
-                data_edges_file_stream.seekg(BYTES_PER_PREDICATE+BYTES_PER_BLOCK_OR_SINGLETON, std::ios_base::cur);  // No need to read the predicate and object in this case
-                continue;
-            }
-            edge_type predicate = read_uint_PREDICATE_little_endian(data_edges_file_stream);
-            block_or_singleton_index object = read_int_BLOCK_OR_SINGLETON_little_endian(data_edges_file_stream);
-            auto object_global_living_it = global_living_blocks.find(object);
-            // If the object is alive at level then the subject is alive at level+1 (and we already established this same subject is alive at level)
-            if (object_global_living_it != global_living_blocks_end_it)
-            {
-                std::tuple triple = std::make_tuple(subject,predicate,object);  // We don't have to map the subject, as it did not refine between level and level+1 (i.e. the id stays the same)
-                data_edges.emplace(triple);
-            }
-            continue;
+            std::cout << exception.what() << std::endl;
         }
-        // In this case we have a data edge from level+1 to level and we should map the subject over the refines edge (to get an edge from level to level)
-        block_or_singleton_index mapped_subject = refines_edges[subject];  // Map the subject over the refines edge
-        // if (mapped_subject == 1021)
-        // {
-        //     std::cout << "DEBUG sub-->mapped_sub: " << subject << "," << mapped_subject << std::endl;
-        // }
-        edge_type predicate = read_uint_PREDICATE_little_endian(data_edges_file_stream);
-        block_or_singleton_index object = read_int_BLOCK_OR_SINGLETON_little_endian(data_edges_file_stream);
-        auto object_global_living_it = global_living_blocks.find(object);
-        if (object_global_living_it == global_living_blocks_end_it)
+    }
+    if (quotient_index_current)
+    {
+        std::cout << "Reusing the quotient index" << std::endl;
+    }
+    else
+    {
+        std::cout << "Building the quotient index" << std::endl;
+        build_quotient_index(experiment_directory, final_depth, quotient_index_file);
+    }
+    QuotientIndex quotient_index(quotient_index_file);
+
+    // The entity names are looked up in entity2ID.txt when they are written, through an index with the position of every entity
+    std::unique_ptr<EntityDictionary> entity_dictionary;
+    if (entity_names_mode == "lazy")
+    {
+        std::string entity_id_file = experiment_directory + "entity2ID.txt";
+        std::string entity_offsets_file = experiment_directory + "entity2ID_offsets.bin";
+        if (EntityDictionary::build_offsets_if_outdated(entity_id_file, entity_offsets_file))
         {
-            continue;
+            std::cout << "Indexed the entity to id map" << std::endl;
         }
-        std::tuple triple = std::make_tuple(mapped_subject,predicate,object);
-        data_edges.emplace(triple);
+        entity_dictionary = std::make_unique<EntityDictionary>(entity_id_file, entity_offsets_file);
     }
 
-    // Write the quotient graph edges and types
-    std::cout << "Writing the quotient graph edges and types" << std::endl;
-    std::string outcome_edges_file = quotient_graphs_directory + "quotient_graph_edges-" + level_string + ".txt";
-    std::ofstream outcome_edges_file_stream(outcome_edges_file, std::ios::trunc);
-
-    std::string outcome_types_file = quotient_graphs_directory + "quotient_graph_types-" + level_string + ".txt";
-    std::ofstream outcome_types_file_stream(outcome_types_file, std::ios::trunc);
-
-    for (auto triple: data_edges)
+    std::string quotient_graphs_directory = experiment_directory + "quotient_graphs/";
+    if (!std::filesystem::exists(quotient_graphs_directory))
     {
-        block_or_singleton_index subject = std::get<0>(triple);
-        block_or_singleton_index predicate = std::get<1>(triple);
-        block_or_singleton_index object = std::get<2>(triple);
+        std::filesystem::create_directory(quotient_graphs_directory);
+    }
 
-        outcome_edges_file_stream << subject << " " << object << "\n";
-        outcome_types_file_stream << predicate << "\n";
+    for (k_type level: levels)
+    {
+        std::cout << "Extracting the quotient graph of level " << level << std::endl;
+        write_quotient_graph(quotient_index, entity_dictionary.get(), quotient_graphs_directory, level, final_depth, thread_count, binary_output);
     }
-    outcome_edges_file_stream.close();
-    outcome_types_file_stream.close();
 
     // block_set data_edge_subjects;
     // block_set data_edge_objects;
@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -13,6 +14,8 @@
 #include <regex>
 #include <filesystem>
 #include <boost/algorithm/algorithm.hpp>
+#include "partition_file.hpp"
+#include "experiment_manifest.hpp"
 #include <boost/algorithm/string.hpp>
 
 using edge_type = uint32_t;
@@ -141,27 +144,20 @@ public:
 #endif
 };
 
-void write_int_BLOCK_OR_SINGLETON_little_endian(std::ostream &outputstream, block_or_singleton_index value)
+const size_t WRITE_BUFFER_SIZE = 1 << 24;
+
+void append_int_BLOCK_OR_SINGLETON_little_endian(std::string &output, block_or_singleton_index value)
 {
     char data[BYTES_PER_BLOCK_OR_SINGLETON];
     for (unsigned int i = 0; i < BYTES_PER_BLOCK_OR_SINGLETON; i++)
     {
-        data[i] = char(value);  // TODO check if removing & 0x00000000000000FFull fixed it
+        data[i] = char(value);
         value = value >> 8;
     }
-    outputstream.write(data, BYTES_PER_BLOCK_OR_SINGLETON);
-    if (outputstream.fail())
-    {
-        std::cout << "Write block failed with code: " << outputstream.rdstate() << std::endl;
-        std::cout << "Goodbit: " << outputstream.good() << std::endl;
-        std::cout << "Eofbit:  " << outputstream.eof() << std::endl;
-        std::cout << "Failbit: " << (outputstream.fail() && !outputstream.bad()) << std::endl;
-        std::cout << "Badbit:  " << outputstream.bad() << std::endl;
-        exit(outputstream.rdstate());
-    }
+    output.append(data, BYTES_PER_BLOCK_OR_SINGLETON);
 }
 
-void write_uint_PREDICATE_little_endian(std::ostream &outputstream, edge_type value)
+void append_uint_PREDICATE_little_endian(std::string &output, edge_type value)
 {
     char data[BYTES_PER_PREDICATE];
     for (unsigned int i = 0; i < BYTES_PER_PREDICATE; i++)
@@ -169,18 +165,53 @@ void write_uint_PREDICATE_little_endian(std::ostream &outputstream, edge_type va
         data[i] = char(value & 0x00000000000000FFull);
         value = value >> 8;
     }
-    outputstream.write(data, BYTES_PER_PREDICATE);
-    if (outputstream.fail())
-    {
-        std::cout << "Write block failed with code: " << outputstream.rdstate() << std::endl;
-        std::cout << "Goodbit: " << outputstream.good() << std::endl;
-        std::cout << "Eofbit:  " << outputstream.eof() << std::endl;
-        std::cout << "Failbit: " << (outputstream.fail() && !outputstream.bad()) << std::endl;
-        std::cout << "Badbit:  " << outputstream.bad() << std::endl;
-        exit(outputstream.rdstate());
-    }
+    output.append(data, BYTES_PER_PREDICATE);
 }
 
+// Collects the output in a large buffer, such that the file gets written in a few big chunks
+class BufferedWriter
+{
+private:
+    std::string filename;
+    std::ofstream outputstream;
+    std::string buffer;
+
+public:
+    BufferedWriter(const std::string &filename) : filename(filename), outputstream(filename, std::ios::trunc | std::ios::binary)
+    {
+        if (!this->outputstream)
+        {
+            throw MyException("Could not open " + filename + " for writing");
+        }
+        this->buffer.reserve(WRITE_BUFFER_SIZE);
+    }
+    std::string& get_buffer()
+    {
+        return this->buffer;
+    }
+    void flush_if_full()
+    {
+        if (this->buffer.size() >= WRITE_BUFFER_SIZE)
+        {
+            this->flush();
+        }
+    }
+    void flush()
+    {
+        this->outputstream.write(this->buffer.data(), this->buffer.size());
+        this->outputstream.flush();
+        this->buffer.clear();
+        if (!this->outputstream)
+        {
+            throw MyException("Could not write to " + this->filename);
+        }
+    }
+    void close()
+    {
+        this->flush();
+        this->outputstream.close();
+    }
+};
 u_int64_t read_uint_ENTITY_little_endian(std::istream &inputstream)
 {
     char data[8];
@@ -559,210 +590,187 @@ void read_graph_timed(const std::string &filename, Graph &g)
     read_graph_from_stream_timed(infile, g);
 }
 
-class SummaryObjectSet
+class Triple
 {
-    private:
-    boost::unordered_flat_set<block_or_singleton_index> objects;
+public:
+    block_or_singleton_index subject;
+    edge_type predicate;
+    block_or_singleton_index object;
 
-    public:
-    SummaryObjectSet()
+    bool operator<(const Triple &other) const
     {
+        return std::tie(subject, predicate, object) < std::tie(other.subject, other.predicate, other.object);
     }
-    void add_object(block_or_singleton_index object)
+    bool operator==(const Triple &other) const
     {
-        objects.emplace(object);  // Should the be emplace or insert?
-    }
-    boost::unordered_flat_set<block_or_singleton_index>& get_objects()
-    {
-        return objects;
-    }
-    void remove_object(block_or_singleton_index object)
-    {
-        objects.erase(object);
+        return subject == other.subject && predicate == other.predicate && object == other.object;
     }
 };
 
-
-class SummaryNode
+// An edge of the summary graph. The subject is implied by the edge range the edge is stored in
+struct SummaryEdge
 {
-    private:
-    boost::unordered_flat_map<edge_type, SummaryObjectSet> node;
+    edge_type predicate;
+    block_or_singleton_index object;
 
-    public:
-    SummaryNode()
-    {
-    }
-    boost::unordered_flat_map<edge_type, SummaryObjectSet>& get_edges()
+    bool operator<(const SummaryEdge &other) const
     {
-        return node;
+        return std::tie(predicate, object) < std::tie(other.predicate, other.object);
     }
-    size_t count_edge_key(edge_type edge)
+    bool operator==(const SummaryEdge &other) const
     {
-        return this->get_edges().count(edge);
-    }
-    void add_edge(edge_type edge, block_or_singleton_index object)
-    {
-        if (node.count(edge) == 0)
-        {
-            SummaryObjectSet empty_object_set = SummaryObjectSet();
-            this->get_edges()[edge] = empty_object_set;
-        }
-        this->get_edges()[edge].add_object(object);
-    }
-    void remove_edge_recursive(edge_type edge, block_or_singleton_index object)
-    {
-        if (this->get_edges()[edge].get_objects().size() > 1)
-        {
-            this->get_edges()[edge].remove_object(object);  // Remove just the object if we have more triples with the same edge type
-        }
-        else
-        {
-            this->get_edges().erase(edge);  // If there was just one triple with the given edge type, remove the whole edge type from the map
-        }
+        return predicate == other.predicate && object == other.object;
     }
 };
 
-class Triple
+struct EdgeRange
 {
-public:
-    block_or_singleton_index subject;
-    edge_type predicate;
-    block_or_singleton_index object;
-    Triple(block_or_singleton_index s, edge_type p, block_or_singleton_index o)
-    {
-        subject = s;
-        predicate = p;
-        object = o;
-    }
+    size_t offset;
+    size_t count;
 };
 
 class SummaryGraph
 {
 private:
-    boost::unordered_flat_map<block_or_singleton_index, SummaryNode> block_nodes;
-    boost::unordered_flat_map<block_or_singleton_index, SummaryNode> reverse_block_nodes;
+    // All edges live in one vector, in which every subject block owns a contiguous range sorted on (predicate, object).
+    // A rewritten range is appended at the end and its old copy becomes stale, until the next compaction drops it.
+    std::vector<SummaryEdge> edges;
+    boost::unordered_flat_map<block_or_singleton_index, EdgeRange> edge_ranges;
+    size_t stale_edge_count = 0;
 
     SummaryGraph(SummaryGraph &)
     {
     }
 
-public:
-    SummaryGraph()
+    std::vector<block_or_singleton_index> get_sorted_subjects()
     {
+        std::vector<block_or_singleton_index> subjects;
+        subjects.reserve(this->edge_ranges.size());
+        for (const auto &subject_range: this->edge_ranges)
+        {
+            subjects.push_back(subject_range.first);
+        }
+        std::sort(subjects.begin(), subjects.end());
+        return subjects;
     }
-    boost::unordered_flat_map<block_or_singleton_index, SummaryNode>& get_nodes()
+
+    void set_edge_range(block_or_singleton_index subject, const std::vector<SummaryEdge> &range_edges)
     {
-        return block_nodes;
+        this->edge_ranges[subject] = EdgeRange{this->edges.size(), range_edges.size()};
+        this->edges.insert(this->edges.end(), range_edges.begin(), range_edges.end());
     }
-    boost::unordered_flat_map<block_or_singleton_index, SummaryNode>& get_reverse_index()
+
+    void compact()
     {
-        return reverse_block_nodes;
+        std::vector<SummaryEdge> compacted_edges;
+        compacted_edges.reserve(this->get_edge_count());
+        for (block_or_singleton_index subject: this->get_sorted_subjects())
+        {
+            EdgeRange &range = this->edge_ranges[subject];
+            size_t offset = compacted_edges.size();
+            compacted_edges.insert(compacted_edges.end(), this->edges.begin() + range.offset, this->edges.begin() + range.offset + range.count);
+            range.offset = offset;
+        }
+        this->edges = std::move(compacted_edges);
+        this->stale_edge_count = 0;
     }
-    void add_block_node(block_or_singleton_index block_node)
+
+public:
+    SummaryGraph()
     {
-        assert(this->get_nodes().count(block_node) == 0);  // The node should not already exist
-        SummaryNode empty_node = SummaryNode();
-        this->get_nodes()[block_node] = empty_node;
     }
-    void add_reverse_block_node(block_or_singleton_index block_node)
+    size_t get_edge_count()
     {
-        assert(reverse_block_nodes.count(block_node) == 0);  // The node should not already exist
-        SummaryNode empty_node = SummaryNode();
-        reverse_block_nodes[block_node] = empty_node;
+        return this->edges.size() - this->stale_edge_count;
     }
-    void add_edge_to_node(block_or_singleton_index subject, edge_type predicate, block_or_singleton_index object, bool add_reverse=true)
+    // Drops the edge ranges of the split blocks and rewrites the ranges of the subjects of new_edges.
+    // new_edges must hold the outgoing and incoming edges of every node that moved to a new block, expressed in the new blocks.
+    // Every edge of an untouched subject into a split block then has its replacement in new_edges, so only the affected ranges change.
+    // Returns the number of rewritten edge ranges
+    size_t apply_split(const boost::unordered_flat_set<block_index> &split_blocks, std::vector<Triple> &new_edges)
     {
-        assert(this->get_nodes().count(subject) > 0);  // The node should exist
-        this->get_nodes()[subject].add_edge(predicate, object);
-        if (add_reverse)
+        for (block_index split_block: split_blocks)
         {
-            if (reverse_block_nodes.count(object) == 0)
+            auto range_iterator = this->edge_ranges.find((block_or_singleton_index) split_block);
+            if (range_iterator != this->edge_ranges.end())
             {
-                add_reverse_block_node(object);
+                this->stale_edge_count += range_iterator->second.count;
+                this->edge_ranges.erase(range_iterator);
             }
-            this->get_reverse_index()[object].add_edge(predicate, subject);
         }
-    }
-    std::vector<Triple> remove_split_blocks_edges(boost::unordered_flat_set<block_index> split_blocks)
-    {
-        std::vector<Triple> removed_edges;
-        // Remove the forward edges from the index and reverse index
-        for (block_or_singleton_index subject: split_blocks)
+
+        // Both directions of an edge between two moved nodes are in new_edges
+        std::sort(new_edges.begin(), new_edges.end());
+        new_edges.erase(std::unique(new_edges.begin(), new_edges.end()), new_edges.end());
+
+        size_t rewritten_ranges = 0;
+        std::vector<SummaryEdge> range_edges;
+        auto group_begin = new_edges.begin();
+        while (group_begin != new_edges.end())
         {
-            for (auto& block_node_key_val: this->get_nodes()[subject].get_edges())
+            block_or_singleton_index subject = group_begin->subject;
+            auto group_end = std::find_if(group_begin, new_edges.end(), [subject](const Triple &triple) { return triple.subject != subject; });
+
+            // Merge the surviving old edges of the subject with its new edges, both sorted on (predicate, object)
+            range_edges.clear();
+            auto new_edge = group_begin;
+            auto range_iterator = this->edge_ranges.find(subject);
+            if (range_iterator != this->edge_ranges.end())
             {
-                edge_type predicate = block_node_key_val.first;
-                for (block_or_singleton_index object: block_node_key_val.second.get_objects())
+                const EdgeRange &old_range = range_iterator->second;
+                for (size_t i = old_range.offset; i < old_range.offset + old_range.count; i++)
                 {
-                    reverse_block_nodes[object].remove_edge_recursive(predicate, subject);
-                    removed_edges.emplace_back(Triple(subject, predicate, object));  // Keep track of the edges we have removed
+                    const SummaryEdge &old_edge = this->edges[i];
+                    if (old_edge.object >= 0 && split_blocks.contains((block_index) old_edge.object))
+                    {
+                        continue;  // The object block no longer exists
+                    }
+                    while (new_edge != group_end && SummaryEdge{new_edge->predicate, new_edge->object} < old_edge)
+                    {
+                        range_edges.push_back(SummaryEdge{new_edge->predicate, new_edge->object});
+                        new_edge++;
+                    }
+                    if (new_edge != group_end && SummaryEdge{new_edge->predicate, new_edge->object} == old_edge)
+                    {
+                        new_edge++;
+                    }
+                    range_edges.push_back(old_edge);
                 }
+                this->stale_edge_count += old_range.count;
+            }
+            for (; new_edge != group_end; new_edge++)
+            {
+                range_edges.push_back(SummaryEdge{new_edge->predicate, new_edge->object});
             }
-            this->get_nodes()[subject] = SummaryNode();  // After having removed the forward edges from the reverse index, clear the edges for the index
+            this->set_edge_range(subject, range_edges);
+            rewritten_ranges++;
+            group_begin = group_end;
         }
 
-        // Remove the backward edges from the index and reverse index
-        for (block_or_singleton_index subject: split_blocks)
+        if (this->stale_edge_count > this->get_edge_count())
         {
-            for (auto& reverse_block_node_key_val: reverse_block_nodes[subject].get_edges())
-            {
-                edge_type predicate = reverse_block_node_key_val.first;
-                for (block_or_singleton_index object: reverse_block_node_key_val.second.get_objects())
-                {
-                    this->get_nodes()[object].remove_edge_recursive(predicate, subject);
-                    removed_edges.emplace_back(Triple(subject, predicate, object));  // Keep track of the edges we have removed
-                }
-            }
-            reverse_block_nodes[subject] = SummaryNode();  // After having removed the backward edges from the index, clear the edges for the reverse index
+            this->compact();
         }
-        return removed_edges;
+        return rewritten_ranges;
     }
-    void write_graph_to_file_binary(std::ostream &outputstream)
+    void write_graph_to_file_binary(const std::string &filename)
     {
-        for (auto node_key_val: this->get_nodes())
+        BufferedWriter writer(filename);
+        std::string &buffer = writer.get_buffer();
+        for (block_or_singleton_index subject: this->get_sorted_subjects())
         {
-            block_or_singleton_index subject = node_key_val.first;
-            for (auto edge_key_val: node_key_val.second.get_edges())
+            const EdgeRange &range = this->edge_ranges[subject];
+            for (size_t i = range.offset; i < range.offset + range.count; i++)
             {
-                edge_type predicate = edge_key_val.first;
-                for (block_or_singleton_index object: edge_key_val.second.get_objects())
-                {
-                    // std::cout << "DEBUG spo: " << subject << " " << predicate << " " << object << std::endl;
-                    write_int_BLOCK_OR_SINGLETON_little_endian(outputstream, subject);
-                    write_uint_PREDICATE_little_endian(outputstream, predicate);
-                    write_int_BLOCK_OR_SINGLETON_little_endian(outputstream, object);
-                }
+                append_int_BLOCK_OR_SINGLETON_little_endian(buffer, subject);
+                append_uint_PREDICATE_little_endian(buffer, this->edges[i].predicate);
+                append_int_BLOCK_OR_SINGLETON_little_endian(buffer, this->edges[i].object);
             }
+            writer.flush_if_full();
         }
+        writer.close();
     }
-    // void write_graph_to_file_json(std::ostream &outputstream)
-    // {
-    //     outputstream << "[";
-    //     bool first_line = true;
-    //     for (auto node_key_val: this->get_nodes())
-    //     {
-    //         block_or_singleton_index subject = node_key_val.first;
-    //         for (auto edge_key_val: node_key_val.second.get_edges())
-    //         {
-    //             edge_type predicate = edge_key_val.first;
-    //             for (block_or_singleton_index object: edge_key_val.second.get_objects())
-    //             {
-    //                 if (first_line)
-    //                 {
-    //                     first_line = false;
-    //                 }
-    //                 else
-    //                 {
-    //                     outputstream << ",";
-    //                 }
-    //                 outputstream << "\n    [" << subject << ", " << object << ", " << predicate << "]";
-    //             }
-    //         }
-    //     }
-    //     outputstream << "\n]";
-    // }
 };
-
 int main(int ac, char *av[])
 {
     // This structure was inspired by https://gist.github.com/randomphrase/10801888
@@ -790,26 +798,7 @@ int main(int ac, char *av[])
     // std::string mapping_file = vm["mapping_file"].as<std::string>();
     std::string graph_file = experiment_directory + "binary_encoding.bin";
 
-    std::string graph_stats_file = experiment_directory + "ad_hoc_results/graph_stats.json";
-    std::ifstream graph_stats_file_stream(graph_stats_file);
-
-    std::string graph_stats_line;
-    std::string final_depth_string = "\"Final depth\"";
-    size_t k;
-    while (std::getline(graph_stats_file_stream, graph_stats_line))
-    {
-        boost::trim(graph_stats_line);
-        boost::erase_all(graph_stats_line, ",");
-        std::vector<std::string> result;
-        boost::split(result, graph_stats_line, boost::is_any_of(":"));
-        if (result[0] == final_depth_string)
-        {
-            std::stringstream sstream(result[1]);
-            sstream >> k;
-            break;
-        }
-    }
-    graph_stats_file_stream.close();
+    size_t k = read_graph_facts(experiment_directory).final_depth;
     // std::cout << "DEBUG " << k << std::endl;
 
     // std::vector<std::string> outcome_files;
@@ -836,8 +825,6 @@ int main(int ac, char *av[])
     // std::string summary_graph_file_path_json = summary_graph_file_path_base + "0001.json";
     // std::string condensed_summary_graph_file_path = experiment_directory + "bisimulation/summary_graph_condensed.bin";
 
-    std::ofstream summary_graph_file_binary(summary_graph_file_path_binary, std::ios::trunc | std::ofstream::out);
-    // std::ofstream summary_graph_file_json(summary_graph_file_path_json, std::ios::trunc | std::ofstream::out);
 
     StopWatch<boost::chrono::process_cpu_clock> w = StopWatch<boost::chrono::process_cpu_clock>::create_not_started();
     Graph g;
@@ -847,7 +834,7 @@ int main(int ac, char *av[])
 
     SummaryGraph gs;
 
-    std::ifstream blocksfile(blocks_file, std::ifstream::in);
+    PartitionFileStream blocksfile(blocks_file, PARTITION_FILE_OUTCOME);
     boost::unordered_flat_map<node_index, block_or_singleton_index> node_to_block_map;
     boost::unordered_flat_map<block_index, boost::unordered_flat_set<node_index>> blocks;
 
@@ -877,7 +864,6 @@ int main(int ac, char *av[])
         }
         // std::cout << "DEBUG block: " << block <<std::endl;
         assert(block <= MAX_SIGNED_BLOCK_SIZE);  // Later, we are storing a block_index as a block_or_singleton_index, so we need to check if the cast is possible
-        gs.add_block_node(block);
         u_int64_t block_size = read_uint_ENTITY_little_endian(blocksfile);
         // std::cout << "DEBUG block size: " << block_size <<std::endl;
         for (uint64_t i = 0; i < block_size; i++) {
@@ -889,6 +875,7 @@ int main(int ac, char *av[])
     }
 
     // Add the respective edges to the summary graph
+    std::vector<Triple> new_edges;
     for (node_index node = 0; node < g.get_nodes().size(); node++)
     {
         auto subject_node_iterator = node_to_block_map.find(node);
@@ -906,9 +893,6 @@ int main(int ac, char *av[])
         //     std::cout << "DEBUG subject added: " << subject_block << std::endl;
         //     gs.add_block_node(subject_block);  // Singleton blocks still need to be added to the graph
         // }
-        if (subject_block < 0) {
-            gs.add_block_node(subject_block);  // We still need to add the singleton blocks to the graph
-        }
         for (Edge edge: g.get_nodes()[node].get_outgoing_edges())
         {
             edge_type predicate = edge.label;
@@ -927,13 +911,11 @@ int main(int ac, char *av[])
                 object_block = (block_or_singleton_index) -((block_or_singleton_index) edge.target)-1;  // We assign singleton blocks a uniqe negative number
             }
             // std::cout << "DEBUG subject block to add: " << subject_block << std::endl;
-            gs.add_edge_to_node(subject_block, predicate, object_block, true);
+            new_edges.push_back(Triple{subject_block, predicate, object_block});
         }
     }
-    gs.write_graph_to_file_binary(summary_graph_file_binary);
-    // gs.write_graph_to_file_json(summary_graph_file_json);
-    summary_graph_file_binary.close();
-    // summary_graph_file_json.close();
+    gs.apply_split(boost::unordered_flat_set<block_index>(), new_edges);
+    gs.write_graph_to_file_binary(summary_graph_file_path_binary);
     // std::ifstream summary_graph_file_input(summary_graph_file_path, std::ifstream::in);
     // const int BufferSize = 8 * 16184;
     // char _buffer[BufferSize];
@@ -974,16 +956,14 @@ int main(int ac, char *av[])
 
         std::string current_mapping = experiment_directory + "bisimulation/mapping-" + previous_i_string + "to" + i_string + ".bin";
         std::string current_outcome = experiment_directory + "bisimulation/outcome_condensed-" + i_string + ".bin";
-        std::ifstream current_mapping_file(current_mapping, std::ifstream::in);
-        std::ifstream current_outcome_file(current_outcome, std::ifstream::in);
+        PartitionFileStream current_mapping_file(current_mapping, PARTITION_FILE_MAPPING);
+        PartitionFileStream current_outcome_file(current_outcome, PARTITION_FILE_OUTCOME);
 
         // std::ostringstream k_next_stringstream;
         // k_next_stringstream << std::setw(4) << std::setfill('0') << i+2;
         // std::string k_next_string(k_next_stringstream.str());
 
         std::string summary_graph_file_path = summary_graph_file_path_base + i_string + ".bin";
-        std::ofstream summary_graph_file_binary(summary_graph_file_path, std::ios::trunc | std::ofstream::out);
-        // std::ofstream summary_graph_file_json(summary_graph_file_path_base + i_string + ".json", std::ios::trunc | std::ofstream::out);
 
         boost::unordered_flat_set<block_index> split_block_incides;
         boost::unordered_flat_set<block_index> new_block_indices;
@@ -1026,8 +1006,6 @@ int main(int ac, char *av[])
         boost::unordered_flat_set<node_index> old_nodes_in_split;
         boost::unordered_flat_set<node_index> new_nodes_in_split;
 
-        gs.remove_split_blocks_edges(split_block_incides);
-        // std::vector<Triple> removed_edges = gs.remove_split_blocks_edges(split_block_incides);
         if (new_singletons_created)
         {
             for (block_or_singleton_index split_block: split_block_incides)
@@ -1049,10 +1027,6 @@ int main(int ac, char *av[])
             }
             // std::cout << "DEBUG block: " << block <<std::endl;
             assert(block <= MAX_SIGNED_BLOCK_SIZE);  // Later, we are storing a block_index as a block_or_singleton_index, so we need to check if the cast is possible
-            if (gs.get_nodes().count(block) == 0)
-            {
-                gs.add_block_node(block);
-            }
             u_int64_t block_size = read_uint_ENTITY_little_endian(current_outcome_file);
             // std::cout << "DEBUG block size: " << block_size <<std::endl;
             blocks[(block_or_singleton_index) block].clear();  // Remove the old map
@@ -1104,11 +1078,11 @@ int main(int ac, char *av[])
             for (node_index node: new_singleton_nodes)
             {
                 block_or_singleton_index singleton_block = -((block_or_singleton_index)node)-1;
-                gs.add_block_node(singleton_block);
                 node_to_block_map[node] = singleton_block;
             }
         }
-        // For all non-singleton blocks add the new edges to the summary graph
+        // For all non-singleton blocks collect the new edges of the summary graph
+        std::vector<Triple> new_edges;
         for (block_index block: new_block_indices)
         {
             if (block == 0)
@@ -1122,13 +1096,13 @@ int main(int ac, char *av[])
                 {
                     block_or_singleton_index subject = node_to_block_map[node];
                     block_or_singleton_index object = node_to_block_map[edge.target];
-                    gs.add_edge_to_node(subject, edge.label, object, true);
+                    new_edges.push_back(Triple{subject, edge.label, object});
                 }
                 for (auto edge: g.get_reverse_nodes()[node].get_outgoing_edges())
                 {
                     block_or_singleton_index object = node_to_block_map[node];
                     block_or_singleton_index subject = node_to_block_map[edge.target];
-                    gs.add_edge_to_node(subject, edge.label, object, true);
+                    new_edges.push_back(Triple{subject, edge.label, object});
                 }
             }
         }
@@ -1138,16 +1112,24 @@ int main(int ac, char *av[])
             {
                 block_or_singleton_index subject = node_to_block_map[node];
                 block_or_singleton_index object = node_to_block_map[edge.target];
-                gs.add_edge_to_node(subject, edge.label, object, true);
+                new_edges.push_back(Triple{subject, edge.label, object});
             }
             for (auto edge: g.get_reverse_nodes()[node].get_outgoing_edges())
             {
                 block_or_singleton_index object = node_to_block_map[node];
                 block_or_singleton_index subject = node_to_block_map[edge.target];
-                gs.add_edge_to_node(subject, edge.label, object, true);
+                new_edges.push_back(Triple{subject, edge.label, object});
             }
         }
-        gs.write_graph_to_file_binary(summary_graph_file_binary);
-        // gs.write_graph_to_file_json(summary_graph_file_json);
+        size_t rewritten_ranges = gs.apply_split(split_block_incides, new_edges);
+
+        auto t_split_done{boost::chrono::system_clock::now()};
+        auto time_t_split_done{boost::chrono::system_clock::to_time_t(t_split_done)};
+        std::tm *ptm_split_done{std::localtime(&time_t_split_done)};
+
+        std::cout << std::put_time(ptm_split_done, "%Y/%m/%d %H:%M:%S") << " Rewrote " << rewritten_ranges << " edge ranges, the summary graph has "
+                  << gs.get_edge_count() << " edges" << std::endl;
+
+        gs.write_graph_to_file_binary(summary_graph_file_path);
     }
 }
\ No newline at end of file
@@ -0,0 +1,198 @@
+// Resolves entity names through entity2ID.txt without loading it, such that the memory used scales with the output instead of with the number of entities
+// The offsets file (`entity2ID_offsets.bin`) stores the position of the line of every entity in entity2ID.txt: magic, version, the size and checksum (see experiment_manifest.hpp)
+// of entity2ID.txt, then one offset per entity id (8 bytes each, little endian). Both files are mapped into memory.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "experiment_manifest.hpp"
+
+const std::string ENTITY_OFFSETS_MAGIC = "EOFS";
+const uint8_t ENTITY_OFFSETS_VERSION = 2;
+const int ENTITY_OFFSETS_BYTES_PER_OFFSET = 8;
+const int ENTITY_OFFSETS_HEADER_SIZE = 4 + 1 + 2 * ENTITY_OFFSETS_BYTES_PER_OFFSET;
+
+class EntityDictionary
+{
+private:
+    const unsigned char *dictionary_data = nullptr;
+    uint64_t dictionary_size = 0;
+    const unsigned char *offsets_data = nullptr;
+    uint64_t offsets_size = 0;
+
+    EntityDictionary(EntityDictionary &)
+    {
+    }
+
+    static const unsigned char *map_file(const std::string &file_path, uint64_t &mapped_size)
+    {
+        int file_descriptor = open(file_path.c_str(), O_RDONLY);
+        if (file_descriptor == -1)
+        {
+            throw std::runtime_error("Could not open " + file_path);
+        }
+        struct stat file_status;
+        fstat(file_descriptor, &file_status);
+        mapped_size = file_status.st_size;
+        if (mapped_size == 0)  // An empty file can not be mapped
+        {
+            close(file_descriptor);
+            return nullptr;
+        }
+        void *data = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        close(file_descriptor);
+        if (data == MAP_FAILED)
+        {
+            throw std::runtime_error("Could not map " + file_path + " into memory");
+        }
+        return (const unsigned char *) data;
+    }
+    uint64_t read_offset(uint64_t position) const
+    {
+        uint64_t value = 0;
+        for (unsigned int i = 0; i < ENTITY_OFFSETS_BYTES_PER_OFFSET; i++)
+        {
+            value |= uint64_t(this->offsets_data[position + i]) << (i * 8);
+        }
+        return value;
+    }
+
+public:
+    EntityDictionary(const std::string &dictionary_file, const std::string &offsets_file)
+    {
+        this->dictionary_data = map_file(dictionary_file, this->dictionary_size);
+        this->offsets_data = map_file(offsets_file, this->offsets_size);
+    }
+    ~EntityDictionary()
+    {
+        if (this->dictionary_data != nullptr)
+        {
+            munmap((void *) this->dictionary_data, this->dictionary_size);
+        }
+        if (this->offsets_data != nullptr)
+        {
+            munmap((void *) this->offsets_data, this->offsets_size);
+        }
+    }
+    // Whether the offsets file is valid for the current entity2ID.txt
+    // The size alone is not enough, the dictionary of a shuffled input has the same size but other lines
+    bool is_current() const
+    {
+        if (this->offsets_size < uint64_t(ENTITY_OFFSETS_HEADER_SIZE)
+            || std::string((const char *) this->offsets_data, ENTITY_OFFSETS_MAGIC.size()) != ENTITY_OFFSETS_MAGIC
+            || this->offsets_data[ENTITY_OFFSETS_MAGIC.size()] != ENTITY_OFFSETS_VERSION
+            || this->read_offset(ENTITY_OFFSETS_MAGIC.size() + 1) != this->dictionary_size)
+        {
+            return false;
+        }
+        ChecksumBuilder checksum;
+        checksum.update((const char *) this->dictionary_data, this->dictionary_size);
+        return this->read_offset(ENTITY_OFFSETS_MAGIC.size() + 1 + ENTITY_OFFSETS_BYTES_PER_OFFSET) == checksum.finish();
+    }
+    // The number of entity ids, i.e. the largest id plus one
+    uint64_t get_entity_count() const
+    {
+        return this->offsets_size < uint64_t(ENTITY_OFFSETS_HEADER_SIZE) ? 0 : (this->offsets_size - ENTITY_OFFSETS_HEADER_SIZE) / ENTITY_OFFSETS_BYTES_PER_OFFSET;
+    }
+    std::string_view get_name(uint64_t entity) const
+    {
+        uint64_t position = ENTITY_OFFSETS_HEADER_SIZE + entity * ENTITY_OFFSETS_BYTES_PER_OFFSET;
+        if (position + ENTITY_OFFSETS_BYTES_PER_OFFSET > this->offsets_size)
+        {
+            throw std::runtime_error("Entity " + std::to_string(entity) + " is not in the entity dictionary");
+        }
+        uint64_t begin = this->read_offset(position);
+        uint64_t end = begin;
+        while (end < this->dictionary_size && this->dictionary_data[end] != ' ')
+        {
+            end++;
+        }
+        return std::string_view((const char *) this->dictionary_data + begin, end - begin);
+    }
+    // Writes the offsets file in two passes over entity2ID.txt (the first one finds the largest id), the entities themselves are never kept in memory
+    static void build_offsets(const std::string &dictionary_file, const std::string &offsets_file)
+    {
+        std::ifstream dictionary_file_stream(dictionary_file, std::ifstream::in | std::ifstream::binary);
+        if (!dictionary_file_stream)
+        {
+            throw std::runtime_error("Could not open " + dictionary_file);
+        }
+        std::string line;
+        uint64_t entity_count = 0;
+        while (std::getline(dictionary_file_stream, line))
+        {
+            size_t delimiter_pos = line.find(' ');
+            if (delimiter_pos != std::string::npos)
+            {
+                entity_count = std::max(entity_count, uint64_t(std::stoull(line.substr(delimiter_pos + 1))) + 1);
+            }
+        }
+
+        // The offsets are written in place, through a writable mapping of the (preallocated) output file
+        std::string temporary_offsets_file = offsets_file + ".tmp";
+        uint64_t output_size = ENTITY_OFFSETS_HEADER_SIZE + entity_count * ENTITY_OFFSETS_BYTES_PER_OFFSET;
+        int file_descriptor = open(temporary_offsets_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (file_descriptor == -1 || ftruncate(file_descriptor, output_size) == -1)
+        {
+            throw std::runtime_error("Could not create " + temporary_offsets_file);
+        }
+        void *data = mmap(nullptr, output_size, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+        close(file_descriptor);
+        if (data == MAP_FAILED)
+        {
+            throw std::runtime_error("Could not map " + temporary_offsets_file + " into memory");
+        }
+        unsigned char *output = (unsigned char *) data;
+        auto write_at = [output](uint64_t position, uint64_t value, unsigned int byte_count)
+        {
+            for (unsigned int i = 0; i < byte_count; i++)
+            {
+                output[position + i] = (value >> (i * 8)) & 255;
+            }
+        };
+        std::copy(ENTITY_OFFSETS_MAGIC.begin(), ENTITY_OFFSETS_MAGIC.end(), output);
+        output[ENTITY_OFFSETS_MAGIC.size()] = ENTITY_OFFSETS_VERSION;
+        write_at(ENTITY_OFFSETS_MAGIC.size() + 1, std::filesystem::file_size(dictionary_file), ENTITY_OFFSETS_BYTES_PER_OFFSET);
+        write_at(ENTITY_OFFSETS_MAGIC.size() + 1 + ENTITY_OFFSETS_BYTES_PER_OFFSET, compute_file_checksum(dictionary_file), ENTITY_OFFSETS_BYTES_PER_OFFSET);
+
+        dictionary_file_stream.clear();
+        dictionary_file_stream.seekg(0);
+        uint64_t line_offset = 0;
+        while (std::getline(dictionary_file_stream, line))
+        {
+            size_t delimiter_pos = line.find(' ');
+            if (delimiter_pos != std::string::npos)
+            {
+                uint64_t entity = std::stoull(line.substr(delimiter_pos + 1));
+                write_at(ENTITY_OFFSETS_HEADER_SIZE + entity * ENTITY_OFFSETS_BYTES_PER_OFFSET, line_offset, ENTITY_OFFSETS_BYTES_PER_OFFSET);
+            }
+            line_offset += line.size() + 1;
+        }
+        if (msync(data, output_size, MS_SYNC) == -1)
+        {
+            munmap(data, output_size);
+            throw std::runtime_error("Could not write to " + temporary_offsets_file);
+        }
+        munmap(data, output_size);
+        std::filesystem::rename(temporary_offsets_file, offsets_file);
+    }
+    // Builds the offsets file if it is missing or belongs to an earlier entity2ID.txt, returns whether it was (re)built
+    static bool build_offsets_if_outdated(const std::string &dictionary_file, const std::string &offsets_file)
+    {
+        if (std::filesystem::exists(offsets_file) && EntityDictionary(dictionary_file, offsets_file).is_current())
+        {
+            return false;
+        }
+        build_offsets(dictionary_file, offsets_file);
+        return true;
+    }
+};
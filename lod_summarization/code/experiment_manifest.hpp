@@ -0,0 +1,460 @@
+// Every experiment directory gets a manifest (`manifest.bin`), which describes the artefacts written by the bisimulator and by the programs that build
+// the condensed multi summary graph, such that later programs do not need to parse `ad_hoc_results/graph_stats.json` or scan files to learn about them.
+// All numbers are little endian
+//
+// Layout:
+//   magic "LODM" (4 bytes), version (1 byte)
+//   vertex count (8 bytes), final depth (2 bytes), fixed point (1 byte), entry count (8 bytes)
+//   Entries: path length (2 bytes), path (relative to the experiment directory), producer length (1 byte), producer (the program that wrote the entry),
+//            level (2 bytes, MANIFEST_NO_LEVEL for files that do not belong to a single level), record count, value count, file size, file checksum (8 bytes each)
+//   checksum of all the bytes before it (8 bytes)
+// The record and value counts are the same as in the header of a version 2 outcome or mapping file (see partition_file.hpp), and the number of
+// edges or blocks for the condensed summary files. They are 0 when the file has no such counts.
+//
+// The manifest is written to a temporary file that is then renamed, so a manifest is either complete or not there.
+// The bisimulator removes the manifest when it starts, so a manifest never describes the files of an earlier run.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+
+const std::string MANIFEST_MAGIC = "LODM";
+const uint8_t MANIFEST_VERSION = 1;
+const std::string MANIFEST_FILE_NAME = "manifest.bin";
+const uint16_t MANIFEST_NO_LEVEL = 0xFFFF;
+const size_t MANIFEST_HEADER_SIZE = 4 + 1 + 8 + 2 + 1 + 8;
+const size_t MANIFEST_READ_BUFFER_SIZE = 1 << 20;
+
+// A 64 bit checksum in the style of xxHash, which is only meant to notice files that changed or got truncated (it is not cryptographic)
+class ChecksumBuilder
+{
+private:
+    static const uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+    static const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+    static const uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+    uint64_t state = PRIME_3;
+    uint64_t length = 0;
+    unsigned char pending[8];
+    size_t pending_size = 0;
+
+    static uint64_t rotate(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static uint64_t load_word(const unsigned char *data)
+    {
+        uint64_t word = 0;
+        for (int i = 7; i >= 0; i--)
+        {
+            word = (word << 8) | data[i];
+        }
+        return word;
+    }
+
+    void mix_word(uint64_t word)
+    {
+        this->state = rotate(this->state ^ (word * PRIME_2), 31) * PRIME_1;
+    }
+
+public:
+    void update(const char *data, size_t size)
+    {
+        const unsigned char *bytes = (const unsigned char *) data;
+        this->length += size;
+        while (this->pending_size > 0 && size > 0)
+        {
+            this->pending[this->pending_size++] = *bytes++;
+            size--;
+            if (this->pending_size == 8)
+            {
+                this->mix_word(load_word(this->pending));
+                this->pending_size = 0;
+            }
+        }
+        while (size >= 8)
+        {
+            this->mix_word(load_word(bytes));
+            bytes += 8;
+            size -= 8;
+        }
+        while (size > 0)
+        {
+            this->pending[this->pending_size++] = *bytes++;
+            size--;
+        }
+    }
+
+    uint64_t finish() const
+    {
+        uint64_t result = this->state;
+        for (size_t i = 0; i < this->pending_size; i++)
+        {
+            result = rotate(result ^ (this->pending[i] * PRIME_3), 11) * PRIME_1;
+        }
+        result ^= this->length;
+        result ^= result >> 33;
+        result *= PRIME_2;
+        result ^= result >> 29;
+        result *= PRIME_3;
+        result ^= result >> 32;
+        return result;
+    }
+};
+
+inline uint64_t compute_file_checksum(const std::string &filename)
+{
+    std::ifstream inputstream(filename, std::ios::binary);
+    if (!inputstream)
+    {
+        throw std::runtime_error("Could not open " + filename);
+    }
+    ChecksumBuilder checksum;
+    std::vector<char> buffer(MANIFEST_READ_BUFFER_SIZE);
+    while (inputstream.read(buffer.data(), buffer.size()) || inputstream.gcount() > 0)
+    {
+        checksum.update(buffer.data(), inputstream.gcount());
+    }
+    return checksum.finish();
+}
+
+// The values that every stage needs from the bisimulation
+struct GraphFacts
+{
+    uint64_t vertex_count = 0;
+    uint16_t final_depth = 0;
+    bool fixed_point = false;
+};
+
+// Reads the graph facts from graph_stats.json, which is how experiments without a manifest are read
+inline GraphFacts read_graph_stats_file(const std::string &experiment_directory)
+{
+    std::string graph_stats_file = experiment_directory + "ad_hoc_results/graph_stats.json";
+    std::ifstream graph_stats_file_stream(graph_stats_file);
+    if (!graph_stats_file_stream)
+    {
+        throw std::runtime_error("Could not open " + graph_stats_file);
+    }
+    GraphFacts facts;
+    bool vertex_count_found = false;
+    bool final_depth_found = false;
+    std::string graph_stats_line;
+    while (std::getline(graph_stats_file_stream, graph_stats_line))
+    {
+        size_t colon = graph_stats_line.find(':');
+        if (colon == std::string::npos)
+        {
+            continue;
+        }
+        std::string key = graph_stats_line.substr(0, colon);
+        key.erase(0, key.find_first_not_of(" \t"));
+        std::string value = graph_stats_line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t\r,") + 1);
+        if (key == "\"Vertex count\"")
+        {
+            facts.vertex_count = std::stoull(value);
+            vertex_count_found = true;
+        }
+        else if (key == "\"Final depth\"")
+        {
+            facts.final_depth = uint16_t(std::stoul(value));
+            final_depth_found = true;
+        }
+        else if (key == "\"Fixed point\"")  // The bisimulator writes false when it stopped early, e.g. because its time or memory budget was exhausted
+        {
+            if (value != "true" && value != "false")
+            {
+                throw std::runtime_error("The \"Fixed point\" value in the graph_stats.json file has not been set to one of \"true\"/\"false\"");
+            }
+            facts.fixed_point = value == "true";
+        }
+    }
+    if (!vertex_count_found || !final_depth_found)
+    {
+        throw std::runtime_error("Could not find the \"Vertex count\" and \"Final depth\" in " + graph_stats_file);
+    }
+    return facts;
+}
+
+struct ManifestEntry
+{
+    std::string path;
+    std::string producer;
+    uint16_t level;
+    uint64_t record_count;
+    uint64_t value_count;
+    uint64_t size;
+    uint64_t checksum;
+    bool measured;  // Whether the size and checksum have been computed, this is not stored
+};
+
+class ExperimentManifest
+{
+private:
+    std::string experiment_directory;
+    GraphFacts facts;
+    std::vector<ManifestEntry> entries;
+
+    static void append_fixed(std::string &buffer, uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+        {
+            buffer += char(value & 0xFF);
+            value >>= 8;
+        }
+    }
+
+    uint64_t read_fixed(const std::string &buffer, size_t &offset, int bytes) const
+    {
+        if (offset + bytes > buffer.size())
+        {
+            throw std::runtime_error("The manifest of " + this->experiment_directory + " is truncated");
+        }
+        uint64_t value = 0;
+        for (int i = bytes - 1; i >= 0; i--)
+        {
+            value = (value << 8) | uint8_t(buffer[offset + i]);
+        }
+        offset += bytes;
+        return value;
+    }
+
+    std::string read_string(const std::string &buffer, size_t &offset, int length_bytes) const
+    {
+        uint64_t length = this->read_fixed(buffer, offset, length_bytes);
+        if (offset + length > buffer.size())
+        {
+            throw std::runtime_error("The manifest of " + this->experiment_directory + " is truncated");
+        }
+        std::string value = buffer.substr(offset, length);
+        offset += length;
+        return value;
+    }
+
+    std::string get_relative_path(const std::string &file_path) const
+    {
+        if (file_path.compare(0, this->experiment_directory.size(), this->experiment_directory) != 0)
+        {
+            throw std::runtime_error(file_path + " is not in the experiment directory " + this->experiment_directory);
+        }
+        return file_path.substr(this->experiment_directory.size());
+    }
+
+public:
+    // An empty manifest for the given experiment directory (which ends with a slash, like everywhere else)
+    ExperimentManifest(const std::string &experiment_directory) : experiment_directory(experiment_directory)
+    {
+    }
+
+    static std::string get_manifest_file(const std::string &experiment_directory)
+    {
+        return experiment_directory + MANIFEST_FILE_NAME;
+    }
+
+    static bool exists(const std::string &experiment_directory)
+    {
+        return std::filesystem::exists(get_manifest_file(experiment_directory));
+    }
+
+    static void remove(const std::string &experiment_directory)
+    {
+        std::filesystem::remove(get_manifest_file(experiment_directory));
+    }
+
+    void read()
+    {
+        std::string manifest_file = get_manifest_file(this->experiment_directory);
+        std::ifstream inputstream(manifest_file, std::ios::binary);
+        if (!inputstream)
+        {
+            throw std::runtime_error("Could not open " + manifest_file);
+        }
+        std::string buffer((std::istreambuf_iterator<char>(inputstream)), std::istreambuf_iterator<char>());
+        if (buffer.size() < MANIFEST_HEADER_SIZE + 8 || buffer.compare(0, MANIFEST_MAGIC.size(), MANIFEST_MAGIC) != 0 || uint8_t(buffer[MANIFEST_MAGIC.size()]) != MANIFEST_VERSION)
+        {
+            throw std::runtime_error(manifest_file + " does not have the expected format (version " + std::to_string(MANIFEST_VERSION) + ")");
+        }
+        size_t checksum_offset = buffer.size() - 8;
+        ChecksumBuilder checksum;
+        checksum.update(buffer.data(), checksum_offset);
+        if (this->read_fixed(buffer, checksum_offset, 8) != checksum.finish())
+        {
+            throw std::runtime_error(manifest_file + " is corrupted (its checksum does not match)");
+        }
+        buffer.resize(buffer.size() - 8);
+
+        size_t offset = MANIFEST_MAGIC.size() + 1;
+        this->facts.vertex_count = this->read_fixed(buffer, offset, 8);
+        this->facts.final_depth = uint16_t(this->read_fixed(buffer, offset, 2));
+        this->facts.fixed_point = this->read_fixed(buffer, offset, 1) != 0;
+        uint64_t entry_count = this->read_fixed(buffer, offset, 8);
+        this->entries.clear();
+        for (uint64_t i = 0; i < entry_count; i++)
+        {
+            ManifestEntry entry;
+            entry.path = this->read_string(buffer, offset, 2);
+            entry.producer = this->read_string(buffer, offset, 1);
+            entry.level = uint16_t(this->read_fixed(buffer, offset, 2));
+            entry.record_count = this->read_fixed(buffer, offset, 8);
+            entry.value_count = this->read_fixed(buffer, offset, 8);
+            entry.size = this->read_fixed(buffer, offset, 8);
+            entry.checksum = this->read_fixed(buffer, offset, 8);
+            entry.measured = true;
+            this->entries.push_back(entry);
+        }
+        if (offset != buffer.size())
+        {
+            throw std::runtime_error(manifest_file + " has trailing bytes");
+        }
+    }
+
+    // Reads the manifest, or starts one from graph_stats.json for experiments that were run without a manifest
+    void read_or_start()
+    {
+        if (exists(this->experiment_directory))
+        {
+            this->read();
+        }
+        else
+        {
+            this->facts = read_graph_stats_file(this->experiment_directory);
+            this->entries.clear();
+        }
+    }
+
+    void write()
+    {
+        for (ManifestEntry &entry : this->entries)
+        {
+            if (!entry.measured)
+            {
+                std::string file_path = this->experiment_directory + entry.path;
+                entry.size = std::filesystem::file_size(file_path);
+                entry.checksum = compute_file_checksum(file_path);
+                entry.measured = true;
+            }
+        }
+        std::string buffer = MANIFEST_MAGIC;
+        buffer += char(MANIFEST_VERSION);
+        append_fixed(buffer, this->facts.vertex_count, 8);
+        append_fixed(buffer, this->facts.final_depth, 2);
+        append_fixed(buffer, this->facts.fixed_point ? 1 : 0, 1);
+        append_fixed(buffer, this->entries.size(), 8);
+        for (const ManifestEntry &entry : this->entries)
+        {
+            append_fixed(buffer, entry.path.size(), 2);
+            buffer += entry.path;
+            append_fixed(buffer, entry.producer.size(), 1);
+            buffer += entry.producer;
+            append_fixed(buffer, entry.level, 2);
+            append_fixed(buffer, entry.record_count, 8);
+            append_fixed(buffer, entry.value_count, 8);
+            append_fixed(buffer, entry.size, 8);
+            append_fixed(buffer, entry.checksum, 8);
+        }
+        ChecksumBuilder checksum;
+        checksum.update(buffer.data(), buffer.size());
+        append_fixed(buffer, checksum.finish(), 8);
+
+        std::string manifest_file = get_manifest_file(this->experiment_directory);
+        std::string temporary_file = manifest_file + ".tmp";
+        {
+            std::ofstream outputstream(temporary_file, std::ios::trunc | std::ios::binary);
+            outputstream.write(buffer.data(), buffer.size());
+            if (!outputstream.flush())
+            {
+                throw std::runtime_error("Could not write to " + temporary_file);
+            }
+        }
+        std::filesystem::rename(temporary_file, manifest_file);
+    }
+
+    const GraphFacts &get_graph_facts() const
+    {
+        return this->facts;
+    }
+
+    void set_graph_facts(uint64_t vertex_count, uint16_t final_depth, bool fixed_point)
+    {
+        this->facts = {vertex_count, final_depth, fixed_point};
+    }
+
+    // Adds a file that has been written (given by its full path), replacing an earlier entry for the same file.
+    // Its size and checksum are only computed when the manifest is written, such that the programs can add files while they are being timed
+    void add(const std::string &file_path, const std::string &producer, uint16_t level = MANIFEST_NO_LEVEL, uint64_t record_count = 0, uint64_t value_count = 0)
+    {
+        ManifestEntry entry{this->get_relative_path(file_path), producer, level, record_count, value_count, 0, 0, false};
+        for (ManifestEntry &existing_entry : this->entries)
+        {
+            if (existing_entry.path == entry.path)
+            {
+                existing_entry = entry;
+                return;
+            }
+        }
+        this->entries.push_back(entry);
+    }
+
+    // Returns the entry of a file (given by its full path), or nullptr if the manifest does not list it
+    const ManifestEntry *find(const std::string &file_path) const
+    {
+        std::string relative_path = this->get_relative_path(file_path);
+        for (const ManifestEntry &entry : this->entries)
+        {
+            if (entry.path == relative_path)
+            {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    const std::vector<ManifestEntry> &get_entries() const
+    {
+        return this->entries;
+    }
+
+    // Whether the file of the entry still has the listed size, which is enough to map it into memory without reading past its end
+    bool has_listed_size(const ManifestEntry &entry) const
+    {
+        std::string file_path = this->experiment_directory + entry.path;
+        return std::filesystem::exists(file_path) && std::filesystem::file_size(file_path) == entry.size;
+    }
+
+    // Whether the file of the entry is unchanged, this reads the whole file
+    bool is_valid(const ManifestEntry &entry) const
+    {
+        return this->has_listed_size(entry) && compute_file_checksum(this->experiment_directory + entry.path) == entry.checksum;
+    }
+
+    // Whether every file that the producer wrote is unchanged (and there is at least one)
+    bool are_valid(const std::string &producer) const
+    {
+        bool found = false;
+        for (const ManifestEntry &entry : this->entries)
+        {
+            if (entry.producer == producer)
+            {
+                if (!this->is_valid(entry))
+                {
+                    return false;
+                }
+                found = true;
+            }
+        }
+        return found;
+    }
+};
+
+// The graph facts of an experiment, from its manifest if it has one, and from graph_stats.json otherwise
+inline GraphFacts read_graph_facts(const std::string &experiment_directory)
+{
+    ExperimentManifest manifest(experiment_directory);
+    manifest.read_or_start();
+    return manifest.get_graph_facts();
+}
@@ -1,3 +1,4 @@
+import io
 import networkx as nx
 from networkx import Graph
 import os
@@ -11,6 +12,67 @@ BYTES_PER_PREDICATE = 4
 BYTES_PER_BLOCK = 4
 BYTES_PER_BLOCK_OR_SINGLETON = 5
 BYTES_PER_K_TYPE = 2
+BYTES_PER_OFFSET = 8
+
+LOCAL_GLOBAL_MAP_MAGIC = b"LGMP"
+LOCAL_GLOBAL_MAP_VERSION = 2
+
+PARTITION_FILE_MAGIC = b"LODP"
+PARTITION_FILE_VERSION = 2
+PARTITION_FILE_HEADER_SIZE = 24
+
+def read_varint(data:bytes, position:int) -> tuple[int,int]:
+    value = 0
+    shift = 0
+    while True:
+        byte = data[position]
+        position += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, position
+        shift += 7
+
+def read_signed_varint(data:bytes, position:int) -> tuple[int,int]:
+    value, position = read_varint(data, position)
+    return (value >> 1) ^ -(value & 1), position
+
+def open_partition_file(partition_file:str):
+    # Opens an outcome or mapping file for binary reading, version 2 files are decoded to the fixed width version 1 layout
+    f = open(partition_file, "rb")
+    header = f.read(PARTITION_FILE_HEADER_SIZE)
+    if len(header) < PARTITION_FILE_HEADER_SIZE or header[:len(PARTITION_FILE_MAGIC)] != PARTITION_FILE_MAGIC:
+        f.seek(0)  # Version 1 has no header
+        return f
+    data = f.read()
+    f.close()
+    assert header[4] == PARTITION_FILE_VERSION, f"Unsupported partition file version {header[4]}"
+    assert header[6] == 0, "Compressed partition files are not supported"
+    is_outcome = header[5] == ord("O")
+    record_count = int.from_bytes(header[8:16], "little", signed=False)
+
+    output = bytearray()
+    position = 0
+    block = 0
+    for _ in range(record_count):
+        delta, position = read_signed_varint(data, position)
+        block += delta
+        value_count, position = read_varint(data, position)
+        output += block.to_bytes(BYTES_PER_BLOCK, "little", signed=False)
+        if is_outcome:
+            output += value_count.to_bytes(BYTES_PER_ENTITY, "little", signed=False)
+            member = 0
+            for _ in range(value_count):
+                delta, position = read_varint(data, position)
+                member += delta
+                output += member.to_bytes(BYTES_PER_ENTITY, "little", signed=False)
+        else:
+            output += value_count.to_bytes(BYTES_PER_BLOCK, "little", signed=False)
+            new_block = 0
+            for _ in range(value_count):
+                delta, position = read_signed_varint(data, position)
+                new_block += delta
+                output += new_block.to_bytes(BYTES_PER_BLOCK, "little", signed=False)
+    return io.BytesIO(bytes(output))
 
 def get_summary_graph(experiment_directory:str) -> tuple[list[list[int]], list[int]]:
     assert os.path.exists(experiment_directory), "The experiment directory string should refer to a valid (existing) directory"
@@ -58,16 +120,23 @@ def get_local_global_maps(experiment_directory:str) -> dict[(int,int),int]:
     global_to_local_map =  dict()
 
     with open(local_to_global_map_binary_file, "rb") as f:
-        while (level_bytes := f.read(BYTES_PER_K_TYPE)):
-            local_level = int.from_bytes(level_bytes, "little", signed=False)
-            local_block_id = int.from_bytes(f.read(BYTES_PER_BLOCK_OR_SINGLETON), "little", signed=True)
-            global_block_id = int.from_bytes(f.read(BYTES_PER_BLOCK_OR_SINGLETON), "little", signed=True)
+        header = f.read(len(LOCAL_GLOBAL_MAP_MAGIC) + 1)
+        assert header[:len(LOCAL_GLOBAL_MAP_MAGIC)] == LOCAL_GLOBAL_MAP_MAGIC and header[-1] == LOCAL_GLOBAL_MAP_VERSION, f"The local to global map file should have format version {LOCAL_GLOBAL_MAP_VERSION}"
+        f.seek(-BYTES_PER_OFFSET, os.SEEK_END)
+        index_offset = int.from_bytes(f.read(BYTES_PER_OFFSET), "little", signed=False)
+        f.seek(len(header))
+        while f.tell() < index_offset:  # The groups are followed by the index of level offsets, which we do not need here
+            local_level = int.from_bytes(f.read(BYTES_PER_K_TYPE), "little", signed=False)
+            map_size = int.from_bytes(f.read(BYTES_PER_OFFSET), "little", signed=False)
+            for i in range(map_size):
+                local_block_id = int.from_bytes(f.read(BYTES_PER_BLOCK_OR_SINGLETON), "little", signed=True)
+                global_block_id = int.from_bytes(f.read(BYTES_PER_BLOCK_OR_SINGLETON), "little", signed=True)
 
-            local_to_global_map[(local_block_id,local_level)] = global_block_id
-            if global_block_id in global_to_local_map:
-                global_to_local_map[global_block_id].add((local_block_id,local_level))
-            else:
-                global_to_local_map[global_block_id] = {(local_block_id,local_level)}
+                local_to_global_map[(local_block_id,local_level)] = global_block_id
+                if global_block_id in global_to_local_map:
+                    global_to_local_map[global_block_id].add((local_block_id,local_level))
+                else:
+                    global_to_local_map[global_block_id] = {(local_block_id,local_level)}
 
     return local_to_global_map, global_to_local_map
 
@@ -101,7 +170,7 @@ def get_outcome(experiment_directory:str, level:int) -> dict[int,set[int]]:
     assert os.path.isfile(outcome_binary_file), "The outcome (binary) file should exist"
 
     outcome = dict()
-    with open(outcome_binary_file, "rb") as f:
+    with open_partition_file(outcome_binary_file) as f:
         while (block_bytes := f.read(BYTES_PER_BLOCK)):
             block_id = int.from_bytes(block_bytes, "little", signed=False)
             block_size = int.from_bytes(f.read(BYTES_PER_ENTITY), "little", signed=False)
@@ -0,0 +1,280 @@
+// lod_pipeline runs the preprocessor, the bisimulator and the condensed summary builder in one process.
+// The stages are the same code as the separate programs (preprocessing.hpp and bisimulation.hpp). The dictionaries, the binary encoded graph
+// and the partitions are passed on in memory, and only the requested artefacts are written to the experiment directory, next to a report
+// with the timings of every stage.
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <filesystem>
+#include <boost/program_options.hpp>
+#include "preprocessing.hpp"
+#include "bisimulation.hpp"
+
+const std::vector<std::string> PIPELINE_ARTEFACTS = {"dictionary", "graph", "partitions", "summary"};
+const std::string PIPELINE_REPORT_FILE_NAME = "pipeline_report.json";
+
+/**
+ * A read-only stream buffer over the binary encoded graph in memory, such that the bisimulator can read it like the file the preprocessor would have written.
+ * A std::stringbuf can not be used for this, as the graph reader sets its own buffer, which discards the contents of a std::stringbuf.
+ */
+class InMemoryGraphBuffer : public std::streambuf
+{
+public:
+    InMemoryGraphBuffer(std::string &graph)
+    {
+        this->setg(graph.data(), graph.data(), graph.data() + graph.size());
+    }
+};
+
+/**
+ * The timed steps of one stage, for the report.
+ */
+struct PipelineStage
+{
+    std::string name;
+    StopWatch<boost::chrono::process_cpu_clock> watch;
+    int64_t wall_time_in_ms;
+};
+
+/**
+ * Encodes the triples of the input file in memory and returns the binary encoding. The dictionaries are only written when requested, they are not needed by the later stages.
+ * The predicate IDs are also passed back in the rel2ID.txt format, for the predicate filter of the bisimulation.
+ */
+std::string preprocess_timed(const std::string &input_file, const std::string &output_path, const preprocessing::PreprocessingOptions &options, bool write_dictionary, bool write_graph,
+                             StopWatch<boost::chrono::process_cpu_clock> &w, u_int64_t &vertex_count, std::stringstream &predicate_IDs)
+{
+    std::ifstream infile(input_file);
+    if (!infile.is_open())
+    {
+        throw MyException("Could not open the input file: " + input_file);
+    }
+
+    preprocessing::IDMapper<preprocessing::node_index> node_ID_Mapper;
+    preprocessing::IDMapper<preprocessing::edge_type> edge_ID_Mapper;
+    std::ostringstream graph_output;
+    w.start_step("Convert graph");
+    preprocessing::convert_graph(infile, graph_output, node_ID_Mapper, edge_ID_Mapper, options);
+    std::string graph = std::move(graph_output).str();
+    w.stop_step();
+    vertex_count = node_ID_Mapper.size();
+    edge_ID_Mapper.dump(predicate_IDs);
+
+    if (write_dictionary)
+    {
+        w.start_step("Write dictionaries");
+        node_ID_Mapper.dump_to_file(output_path + "entity2ID.txt");
+        edge_ID_Mapper.dump_to_file(output_path + "rel2ID.txt");
+        w.stop_step();
+    }
+    if (write_graph)
+    {
+        w.start_step("Write graph");
+        std::ofstream graph_file(output_path + "binary_encoding.bin", std::ios::binary | std::ios::trunc);
+        graph_file.write(graph.data(), graph.size());
+        if (!graph_file.flush())
+        {
+            throw MyException("Could not write the binary encoded graph to " + output_path + "binary_encoding.bin");
+        }
+        w.stop_step();
+    }
+    return graph;
+}
+
+void write_pipeline_report(const std::vector<PipelineStage> &stages, const std::string &filename)
+{
+    std::ofstream report(filename, std::ios::trunc);
+    int64_t total_time = 0;
+    int max_memory = 0;
+    report << "{\n    \"Stages\": [";
+    for (std::size_t stage_index = 0; stage_index < stages.size(); stage_index++)
+    {
+        PipelineStage stage = stages[stage_index];
+        int64_t stage_time = 0;
+        int stage_memory = 0;
+        for (auto step : stage.watch.get_times())
+        {
+            stage_time += boost::chrono::ceil<boost::chrono::milliseconds>(step.duration).count();
+            stage_memory = std::max(stage_memory, step.memory_in_kb);
+        }
+        total_time += stage_time;
+        max_memory = std::max(max_memory, stage_memory);
+
+        report << (stage_index == 0 ? "" : ",") << "\n        {"
+               << "\n            \"Stage\": \"" << stage.name << "\""
+               << ",\n            \"Time taken (ms)\": " << stage_time
+               << ",\n            \"Wall time taken (ms)\": " << stage.wall_time_in_ms
+               << ",\n            \"Maximum memory footprint (kB)\": " << stage_memory
+               << ",\n            \"Steps\": [";
+        std::vector<std::string> step_lines;
+        for (auto step : stage.watch.get_times())
+        {
+            std::ostringstream step_line;
+            step_line << "\n                {\"Step\": \"" << step.name << "\", \"Time taken (ms)\": " << boost::chrono::ceil<boost::chrono::milliseconds>(step.duration).count()
+                      << ", \"Memory footprint (kB)\": " << step.memory_in_kb << "}";
+            step_lines.push_back(step_line.str());
+        }
+        report << boost::algorithm::join(step_lines, ",") << "\n            ]\n        }";
+    }
+    report << "\n    ],\n    \"Total time taken (ms)\": " << total_time
+           << ",\n    \"Maximum memory footprint (kB)\": " << max_memory << "\n}\n";
+    if (!report.flush())
+    {
+        throw MyException("Could not write the pipeline report to " + filename);
+    }
+}
+
+int main(int ac, char *av[])
+{
+    // This structure was inspired by https://gist.github.com/randomphrase/10801888
+    namespace po = boost::program_options;
+
+    po::options_description global("Global options");
+    global.add_options()("input_file", po::value<std::string>(), "Input file, must contain n-triples");
+    global.add_options()("output_path", po::value<std::string>(), "Output path, the experiment directory");
+    global.add_options()("write", po::value<std::string>()->default_value("dictionary,graph,partitions,summary"),
+                         "Comma separated artefacts to write: dictionary (entity2ID.txt and rel2ID.txt), graph (binary_encoding.bin), partitions (the outcome and mapping files) and summary (the condensed multi summary, only built if requested)");
+    global.add_options()("skipRDFlists", "Makes the code ignore RDF lists");
+    global.add_options()("skip_literals", "Triples with literal objects will be ignored.");
+    global.add_options()("laundromat", "Set this flag to run on the LOD laundromat dataset");
+    global.add_options()("types_to_predicates", "Transforms triples of the form <subject> <rdf:type> <object> to <subject> <object> _:rdfTypeNode");
+    global.add_options()("support", po::value<uint>()->default_value(1), "Specify the required size for a block to be considered splittable");
+    global.add_options()("typed_start", "flag indicating that the nodes are initially (at k=0) partitioned acording to their RDF type set");
+    global.add_options()("time_budget", po::value<int64_t>()->default_value(0), "wall clock budget in seconds for the bisimulation, after the first level that ends beyond it the bisimulation stops without reaching the fixed point (0 means no budget)");
+    global.add_options()("memory_budget", po::value<int64_t>()->default_value(0), "resident memory budget in kB, after a level during which it was exceeded the bisimulation stops without reaching the fixed point (0 means no budget)");
+    global.add_options()("wide_indices", "flag forcing 64-bit node indices, also for graphs with fewer than 2^31 vertices");
+    global.add_options()("renumbering", po::value<std::string>()->default_value("none"), "order in which the nodes are renumbered before the refinement, one of none, bfs, rcm or type_set");
+    global.add_options()("partition_format", po::value<std::string>()->default_value("v1"), "encoding of the outcome and mapping files, v1 (fixed width) or v2 (header and delta encoded varints)");
+    global.add_options()("predicates", po::value<std::string>()->default_value(""), "file with the predicates (one IRI per line) that are used for the bisimulation, all other triples are ignored. The summary can then not be written");
+    global.add_options()("ignore_predicates", po::value<std::string>()->default_value(""), "file with the predicates (one IRI per line) that are ignored for the bisimulation. The summary can then not be written");
+    po::positional_options_description pos;
+    pos.add("input_file", 1).add("output_path", 2);
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::command_line_parser(ac, av).options(global).positional(pos).run(), vm);
+        po::notify(vm);
+    }
+    catch (const po::error &error)
+    {
+        throw MyException("Invalid arguments: " + std::string(error.what()));
+    }
+    if (!vm.count("input_file") || !vm.count("output_path"))
+    {
+        throw MyException("Two arguments should be provided: 1) the n-triples input file, 2) the path to the experiment directory");
+    }
+
+    std::string input_file = vm["input_file"].as<std::string>();
+    std::string output_path = vm["output_path"].as<std::string>();
+    if (output_path.back() != '/')
+    {
+        output_path += "/";
+    }
+
+    std::vector<std::string> artefacts;
+    std::string write_option = vm["write"].as<std::string>();
+    if (write_option == "")
+    {
+        throw MyException("--write needs at least one artefact, use dictionary, graph, partitions and/or summary");
+    }
+    boost::split(artefacts, write_option, boost::is_any_of(","));
+    for (const std::string &artefact : artefacts)
+    {
+        if (std::find(PIPELINE_ARTEFACTS.cbegin(), PIPELINE_ARTEFACTS.cend(), artefact) == PIPELINE_ARTEFACTS.cend())
+        {
+            throw MyException("Unknown artefact to write: " + artefact + ". Use dictionary, graph, partitions and/or summary");
+        }
+    }
+    auto writes = [&artefacts](const std::string &artefact)
+    {
+        return std::find(artefacts.cbegin(), artefacts.cend(), artefact) != artefacts.cend();
+    };
+
+    preprocessing::PreprocessingOptions options;
+    options.skipRDFlists = vm.count("skipRDFlists");
+    options.skip_literals = vm.count("skip_literals");
+    options.trigfile = vm.count("laundromat");
+    options.types_to_predicates = vm.count("types_to_predicates");
+
+    uint support = vm["support"].as<uint>();
+    bool typed_start = vm.count("typed_start");
+    std::string renumbering = vm["renumbering"].as<std::string>();
+    bool wide_indices = vm.count("wide_indices");
+    uint8_t partition_file_version = parse_partition_file_version(vm["partition_format"].as<std::string>());
+    int64_t time_budget = vm["time_budget"].as<int64_t>();
+    int64_t memory_budget = vm["memory_budget"].as<int64_t>();
+    std::string predicates_file = vm["predicates"].as<std::string>();
+    std::string ignore_predicates_file = vm["ignore_predicates"].as<std::string>();
+    if (std::find(RENUMBERING_STRATEGIES.cbegin(), RENUMBERING_STRATEGIES.cend(), renumbering) == RENUMBERING_STRATEGIES.cend())
+    {
+        throw MyException("Unknown renumbering strategy: " + renumbering + ". Use one of none, bfs, rcm or type_set");
+    }
+    if (predicates_file != "" && ignore_predicates_file != "")
+    {
+        throw MyException("Specify at most one of --predicates and --ignore_predicates");
+    }
+    // Checked before the preprocessing, the bisimulation would only refuse it after the graph was encoded
+    if ((predicates_file != "" || ignore_predicates_file != "") && writes("summary"))
+    {
+        throw MyException("The summary can not be built when predicates are filtered, leave it out of --write and run create_condensed_summary_graph_from_partitions on the written graph and partitions");
+    }
+
+    std::filesystem::create_directories(output_path + "bisimulation/");
+    std::filesystem::create_directories(output_path + "ad_hoc_results/");
+    // The outputs of earlier runs of the separate stages may still be linked to entries of their stage caches
+    StageCache::detach_outputs(output_path, {"binary_encoding.bin", "entity2ID.txt", "rel2ID.txt", "bisimulation/", "ad_hoc_results/"});
+    StageCache::remove_derived_files(output_path, {"entity2ID_offsets.bin", "bisimulation/quotient_index.bin"});
+    std::vector<PipelineStage> stages;
+
+    auto t_preprocessing_start{boost::chrono::system_clock::now()};
+    auto time_t_preprocessing_start{boost::chrono::system_clock::to_time_t(t_preprocessing_start)};
+    std::tm *ptm_preprocessing_start{std::localtime(&time_t_preprocessing_start)};
+    std::cout << std::put_time(ptm_preprocessing_start, "%Y/%m/%d %H:%M:%S") << " Preprocessing started" << std::endl;
+    StopWatch<boost::chrono::process_cpu_clock> preprocessing_watch = StopWatch<boost::chrono::process_cpu_clock>::create_not_started();
+    u_int64_t vertex_count = 0;
+    std::stringstream predicate_IDs;
+    std::string graph = preprocess_timed(input_file, output_path, options, writes("dictionary"), writes("graph"), preprocessing_watch, vertex_count, predicate_IDs);
+    auto t_preprocessing_done{boost::chrono::system_clock::now()};
+    stages.push_back({"preprocessor", preprocessing_watch, boost::chrono::ceil<boost::chrono::milliseconds>(t_preprocessing_done - t_preprocessing_start).count()});
+
+    // The bisimulator lists the graph in the manifest only if it was written
+    std::string graph_file = writes("graph") ? output_path + "binary_encoding.bin" : "";
+    InMemoryGraphBuffer graph_buffer(graph);
+    std::istream graph_stream(&graph_buffer);
+    bool use_32_bit_node_index = !wide_indices && fits_32_bit_node_index(vertex_count);
+    log_node_index_width(vertex_count, use_32_bit_node_index);
+    PredicateFilter filter;
+    if (predicates_file != "")
+    {
+        filter = PredicateFilter(predicate_IDs, predicates_file, true);
+        if (typed_start && !filter.keeps(0))
+        {
+            std::cout << "Warning: rdf:type is not in the allowed predicates, so the typed start puts all vertices in one block" << std::endl;
+        }
+    }
+    else if (ignore_predicates_file != "")
+    {
+        filter = PredicateFilter(predicate_IDs, ignore_predicates_file, false);
+    }
+    if (use_32_bit_node_index)
+    {
+        stages.push_back({"bisimulator", run_k_bisimulation_store_partition_condensed_timed<uint32_t>(graph_stream, graph_file, support, output_path, typed_start, renumbering, filter, time_budget, memory_budget,
+                                                                                                      writes("summary"), partition_file_version, writes("partitions")), 0});
+    }
+    else
+    {
+        stages.push_back({"bisimulator", run_k_bisimulation_store_partition_condensed_timed<uint64_t>(graph_stream, graph_file, support, output_path, typed_start, renumbering, filter, time_budget, memory_budget,
+                                                                                                      writes("summary"), partition_file_version, writes("partitions")), 0});
+    }
+    auto t_bisimulation_done{boost::chrono::system_clock::now()};
+    stages.back().wall_time_in_ms = boost::chrono::ceil<boost::chrono::milliseconds>(t_bisimulation_done - t_preprocessing_done).count();
+
+    write_pipeline_report(stages, output_path + PIPELINE_REPORT_FILE_NAME);
+    auto time_t_done{boost::chrono::system_clock::to_time_t(t_bisimulation_done)};
+    std::tm *ptm_done{std::localtime(&time_t_done)};
+    std::cout << std::put_time(ptm_done, "%Y/%m/%d %H:%M:%S") << " Pipeline done, the timings are in " << output_path + PIPELINE_REPORT_FILE_NAME << std::endl;
+}
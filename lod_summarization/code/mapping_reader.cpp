@@ -5,6 +5,7 @@
 #include <boost/unordered/unordered_flat_map.hpp>
 #include <iostream>
 #include <boost/program_options.hpp>
+#include "partition_file.hpp"
 // #include <vector>
 
 const int BYTES_PER_BLOCK = 4;
@@ -41,7 +42,7 @@ int main(int ac, char *av[])
 
     std::string input_file = vm["input_file"].as<std::string>();
 
-    std::ifstream infile(input_file, std::ifstream::in);
+    PartitionFileStream infile(input_file, PARTITION_FILE_MAPPING);
     u_int64_t split_count = 0;
     while (true)
     {
@@ -0,0 +1,20 @@
+// The exception thrown by the preprocessing and bisimulation code (preprocessing.hpp and bisimulation.hpp), and by the programs that include them.
+// The other programs define the same class themselves.
+#pragma once
+
+#include <exception>
+#include <string>
+
+class MyException : public std::exception
+{
+private:
+    const std::string message;
+
+public:
+    MyException(const std::string &err) : message(err) {}
+
+    const char *what() const noexcept override
+    {
+        return message.c_str();
+    }
+};
@@ -0,0 +1,440 @@
+// The bisimulator stores the partition of every level as an outcome file (`outcome_condensed-XXXX.bin`, the blocks created at that level with their members)
+// and a mapping file (`mapping-XXXXtoYYYY.bin`, the blocks that split along with the blocks they split into). Both exist in two versions, all numbers are little endian
+//
+// Version 1 (no header):
+//   Outcome: per block: block (4 bytes), member count (5 bytes), members (5 bytes each)
+//   Mapping: per split block: block (4 bytes), new block count (4 bytes), new blocks (4 bytes each)
+// Version 2:
+//   magic "LODP" (4 bytes), version (1 byte), kind (1 byte, 'O' for an outcome or 'M' for a mapping), compression (1 byte), reserved (1 byte)
+//   record count, value count (8 bytes each): the number of blocks and members, or the number of split blocks and new blocks
+//   Records, with every number stored as a varint (7 bits per byte, least significant first) and every signed delta zigzag encoded:
+//   Outcome: per block: block (delta to the previous block), member count, members (sorted, the first one as is, then the deltas to the previous member)
+//   Mapping: per split block: block (delta to the previous split block), new block count, new blocks (delta to the previous new block in the list)
+// Only compression 0 (none) is defined, the field is there such that compressed framing can be added without a new version.
+// A file without records is empty in both versions, so an empty file never has a header.
+//
+// PartitionFileStream reads either version as if it was version 1, such that readers only need to decode the version 1 layout.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <istream>
+#include <streambuf>
+#include <stdexcept>
+
+const std::string PARTITION_FILE_MAGIC = "LODP";
+const uint8_t PARTITION_FILE_VERSION = 2;
+const char PARTITION_FILE_OUTCOME = 'O';
+const char PARTITION_FILE_MAPPING = 'M';
+const uint8_t PARTITION_FILE_NO_COMPRESSION = 0;
+const size_t PARTITION_FILE_HEADER_SIZE = 24;
+const int PARTITION_FILE_BYTES_PER_BLOCK = 4;
+const int PARTITION_FILE_BYTES_PER_ENTITY = 5;
+const size_t PARTITION_FILE_BUFFER_SIZE = 1 << 16;
+
+// Parses the partition_format setting, which is either v1 or v2
+inline uint8_t parse_partition_file_version(const std::string &format)
+{
+    if (format == "v1")
+    {
+        return 1;
+    }
+    if (format == "v2")
+    {
+        return 2;
+    }
+    throw std::runtime_error("Unknown partition file format: " + format + ". Use v1 or v2");
+}
+
+class PartitionFileWriter
+{
+private:
+    std::string filename;
+    std::ofstream outputstream;
+    uint8_t version;
+    char kind;
+    std::string buffer;
+    uint64_t record_count = 0;
+    uint64_t value_count = 0;
+    int64_t previous_record = 0;
+
+    void append_fixed(uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+        {
+            this->buffer += char(value & 0xFF);
+            value >>= 8;
+        }
+    }
+
+    void append_varint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            this->buffer += char((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        this->buffer += char(value);
+    }
+
+    void append_signed_varint(int64_t value)
+    {
+        this->append_varint((uint64_t(value) << 1) ^ uint64_t(value >> 63));
+    }
+
+    void flush()
+    {
+        this->outputstream.write(this->buffer.data(), this->buffer.size());
+        this->buffer.clear();
+        if (!this->outputstream)
+        {
+            throw std::runtime_error("Could not write to " + this->filename);
+        }
+    }
+
+    void start_record(uint64_t block, uint64_t values)
+    {
+        if (this->buffer.size() >= PARTITION_FILE_BUFFER_SIZE)
+        {
+            this->flush();
+        }
+        this->record_count++;
+        this->value_count += values;
+        if (this->version == 1)
+        {
+            this->append_fixed(block, PARTITION_FILE_BYTES_PER_BLOCK);
+            this->append_fixed(values, this->kind == PARTITION_FILE_OUTCOME ? PARTITION_FILE_BYTES_PER_ENTITY : PARTITION_FILE_BYTES_PER_BLOCK);
+        }
+        else
+        {
+            this->append_signed_varint(int64_t(block) - this->previous_record);
+            this->append_varint(values);
+        }
+        this->previous_record = int64_t(block);
+    }
+
+public:
+    PartitionFileWriter(const std::string &filename, char kind, uint8_t version)
+        : filename(filename), outputstream(filename, std::ios::trunc | std::ios::binary), version(version), kind(kind)
+    {
+        if (!this->outputstream)
+        {
+            throw std::runtime_error("Could not open " + filename + " for writing");
+        }
+        if (version != 1 && version != 2)
+        {
+            throw std::runtime_error("Unknown partition file version " + std::to_string(version));
+        }
+        if (version == 2)
+        {
+            // The counts are only known at the end, so the header is written again when closing
+            this->buffer.assign(PARTITION_FILE_HEADER_SIZE, '\0');
+        }
+    }
+
+    // Writes a block of an outcome file. For version 2 the members get sorted
+    void write_block(uint64_t block, std::vector<uint64_t> &members)
+    {
+        this->start_record(block, members.size());
+        if (this->version == 1)
+        {
+            for (uint64_t member : members)
+            {
+                this->append_fixed(member, PARTITION_FILE_BYTES_PER_ENTITY);
+            }
+            return;
+        }
+        std::sort(members.begin(), members.end());
+        uint64_t previous_member = 0;
+        for (uint64_t member : members)
+        {
+            this->append_varint(member - previous_member);
+            previous_member = member;
+        }
+    }
+
+    // Writes a split block of a mapping file, 0 among the new blocks stands for the singletons
+    void write_split(uint64_t block, const std::vector<uint64_t> &new_blocks)
+    {
+        this->start_record(block, new_blocks.size());
+        int64_t previous_new_block = 0;
+        for (uint64_t new_block : new_blocks)
+        {
+            if (this->version == 1)
+            {
+                this->append_fixed(new_block, PARTITION_FILE_BYTES_PER_BLOCK);
+            }
+            else
+            {
+                this->append_signed_varint(int64_t(new_block) - previous_new_block);
+                previous_new_block = int64_t(new_block);
+            }
+        }
+    }
+
+    uint64_t get_record_count() const
+    {
+        return this->record_count;
+    }
+
+    uint64_t get_value_count() const
+    {
+        return this->value_count;
+    }
+
+    void close()
+    {
+        if (this->version == 2 && this->record_count == 0)
+        {
+            this->buffer.clear();  // Only the header placeholder has been buffered, and an empty file has no header
+        }
+        this->flush();
+        if (this->version == 2 && this->record_count > 0)
+        {
+            this->buffer = PARTITION_FILE_MAGIC;
+            this->buffer += char(PARTITION_FILE_VERSION);
+            this->buffer += this->kind;
+            this->buffer += char(PARTITION_FILE_NO_COMPRESSION);
+            this->buffer += '\0';
+            this->append_fixed(this->record_count, 8);
+            this->append_fixed(this->value_count, 8);
+            this->outputstream.seekp(0);
+            this->flush();
+        }
+        this->outputstream.close();
+    }
+};
+
+// Decodes a partition file of either version into the version 1 layout
+class PartitionFileBuffer : public std::streambuf
+{
+private:
+    std::string filename;
+    std::ifstream inputstream;
+    char kind;
+    bool encoded = false;
+    uint64_t record_count = 0;
+    uint64_t value_count = 0;
+    uint64_t records_read = 0;
+    uint64_t values_read = 0;
+    int64_t previous_record = 0;
+    std::vector<char> input;
+    size_t input_position = 0;
+    size_t input_end = 0;
+    std::string output;
+    uint64_t output_position = 0;  // The position of the start of output in the (decoded) file
+
+    bool refill_input()
+    {
+        this->inputstream.read(this->input.data(), this->input.size());
+        this->input_position = 0;
+        this->input_end = this->inputstream.gcount();
+        return this->input_end > 0;
+    }
+
+    uint64_t read_varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (this->input_position == this->input_end && !this->refill_input())
+            {
+                throw std::runtime_error(this->filename + " ends in the middle of a record");
+            }
+            uint8_t byte = uint8_t(this->input[this->input_position++]);
+            value |= uint64_t(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+        throw std::runtime_error(this->filename + " contains a varint longer than 64 bits");
+    }
+
+    int64_t read_signed_varint()
+    {
+        uint64_t value = this->read_varint();
+        return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+
+    void append_fixed(uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+        {
+            this->output += char(value & 0xFF);
+            value >>= 8;
+        }
+    }
+
+    void decode_record()
+    {
+        int64_t block = this->previous_record + this->read_signed_varint();
+        this->previous_record = block;
+        uint64_t values = this->read_varint();
+        this->records_read++;
+        this->values_read += values;
+        this->append_fixed(uint64_t(block), PARTITION_FILE_BYTES_PER_BLOCK);
+        if (this->kind == PARTITION_FILE_OUTCOME)
+        {
+            this->append_fixed(values, PARTITION_FILE_BYTES_PER_ENTITY);
+            uint64_t member = 0;
+            for (uint64_t i = 0; i < values; i++)
+            {
+                member += this->read_varint();
+                this->append_fixed(member, PARTITION_FILE_BYTES_PER_ENTITY);
+            }
+        }
+        else
+        {
+            this->append_fixed(values, PARTITION_FILE_BYTES_PER_BLOCK);
+            int64_t new_block = 0;
+            for (uint64_t i = 0; i < values; i++)
+            {
+                new_block += this->read_signed_varint();
+                this->append_fixed(uint64_t(new_block), PARTITION_FILE_BYTES_PER_BLOCK);
+            }
+        }
+    }
+
+protected:
+    int_type underflow() override
+    {
+        if (this->gptr() < this->egptr())
+        {
+            return traits_type::to_int_type(*this->gptr());
+        }
+        this->output_position += this->output.size();
+        this->output.clear();
+        if (!this->encoded)
+        {
+            this->output.resize(PARTITION_FILE_BUFFER_SIZE);
+            this->inputstream.read(this->output.data(), this->output.size());
+            this->output.resize(this->inputstream.gcount());
+        }
+        else
+        {
+            while (this->output.size() < PARTITION_FILE_BUFFER_SIZE && this->records_read < this->record_count)
+            {
+                this->decode_record();
+            }
+            if (this->records_read == this->record_count && this->output.empty() && this->values_read != this->value_count)
+            {
+                throw std::runtime_error(this->filename + " has a different number of values than its header states");
+            }
+        }
+        if (this->output.empty())
+        {
+            return traits_type::eof();
+        }
+        this->setg(this->output.data(), this->output.data(), this->output.data() + this->output.size());
+        return traits_type::to_int_type(*this->gptr());
+    }
+
+    // Only skipping forward is supported, which is how the readers pass over the members they do not need.
+    // Like for a file, skipping beyond the end succeeds and the next read hits the end
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override
+    {
+        if (direction != std::ios_base::cur || offset < 0 || !(which & std::ios_base::in))
+        {
+            return pos_type(off_type(-1));
+        }
+        while (offset > 0)
+        {
+            off_type available = this->egptr() - this->gptr();
+            if (available == 0 && !this->encoded)
+            {
+                // Version 1 is stored as is, so we skip in the file itself
+                this->inputstream.seekg(offset, std::ios_base::cur);
+                this->output_position += this->output.size() + offset;
+                this->output.clear();
+                this->setg(nullptr, nullptr, nullptr);
+                break;
+            }
+            if (available == 0 && traits_type::eq_int_type(this->underflow(), traits_type::eof()))
+            {
+                return pos_type(off_type(this->output_position + offset));
+            }
+            off_type skipped = std::min(offset, off_type(this->egptr() - this->gptr()));
+            this->gbump(int(skipped));
+            offset -= skipped;
+        }
+        return pos_type(off_type(this->output_position + (this->gptr() - this->eback())));
+    }
+
+public:
+    PartitionFileBuffer(const std::string &filename, char kind) : filename(filename), inputstream(filename, std::ios::binary), kind(kind)
+    {
+        if (!this->inputstream)
+        {
+            return;  // Like a missing std::ifstream, a missing file reads as empty
+        }
+        char header[PARTITION_FILE_HEADER_SIZE];
+        this->inputstream.read(header, PARTITION_FILE_HEADER_SIZE);
+        if (size_t(this->inputstream.gcount()) == PARTITION_FILE_HEADER_SIZE && std::string(header, PARTITION_FILE_MAGIC.size()) == PARTITION_FILE_MAGIC)
+        {
+            if (uint8_t(header[4]) != PARTITION_FILE_VERSION)
+            {
+                throw std::runtime_error(filename + " has unsupported version " + std::to_string(uint8_t(header[4])));
+            }
+            if (header[5] != kind)
+            {
+                throw std::runtime_error(filename + (kind == PARTITION_FILE_OUTCOME ? " is not an outcome file" : " is not a mapping file"));
+            }
+            if (uint8_t(header[6]) != PARTITION_FILE_NO_COMPRESSION)
+            {
+                throw std::runtime_error(filename + " uses compression " + std::to_string(uint8_t(header[6])) + ", which is not supported");
+            }
+            for (int i = 7; i >= 0; i--)
+            {
+                this->record_count = (this->record_count << 8) | uint8_t(header[8 + i]);
+                this->value_count = (this->value_count << 8) | uint8_t(header[16 + i]);
+            }
+            this->encoded = true;
+            this->input.resize(PARTITION_FILE_BUFFER_SIZE);
+        }
+        else
+        {
+            // Version 1 has no header, so we read it from the start
+            this->inputstream.clear();
+            this->inputstream.seekg(0);
+        }
+    }
+
+    bool is_encoded() const
+    {
+        return this->encoded;
+    }
+
+    void close()
+    {
+        this->inputstream.close();
+    }
+};
+
+// An input stream over an outcome or mapping file of either version, which reads as version 1.
+// Errors in the file are thrown as std::runtime_error from the read that hits them, instead of only setting the stream state
+class PartitionFileStream : public std::istream
+{
+private:
+    PartitionFileBuffer buffer;
+
+public:
+    PartitionFileStream(const std::string &filename, char kind) : std::istream(nullptr), buffer(filename, kind)
+    {
+        this->rdbuf(&this->buffer);
+        this->exceptions(std::ios::badbit);
+    }
+
+    bool is_encoded() const
+    {
+        return this->buffer.is_encoded();
+    }
+
+    void close()
+    {
+        this->buffer.close();
+    }
+};
@@ -12,6 +12,8 @@
 #include <boost/program_options.hpp>
 #include <boost/algorithm/string.hpp>
 #include <filesystem>
+#include "partition_file.hpp"
+#include "experiment_manifest.hpp"
 
 const int BYTES_PER_ENTITY = 5;
 const int BYTES_PER_BLOCK = 4;
@@ -88,27 +90,8 @@ int main(int ac, char *av[])
     std::string input_path = vm["input_path"].as<std::string>();
     std::filesystem::create_directory(input_path + "post_hoc_results/");
 
-    std::string graph_stats_file = input_path + "ad_hoc_results/graph_stats.json";
-    std::ifstream graph_stats_file_stream(graph_stats_file);
-
     // Automatically select the largest possible k
-    std::string graph_stats_line;
-    std::string final_depth_string = "\"Final depth\"";
-    size_t k;
-    while (std::getline(graph_stats_file_stream, graph_stats_line))
-    {
-        boost::trim(graph_stats_line);
-        boost::erase_all(graph_stats_line, ",");
-        std::vector<std::string> result;
-        boost::split(result, graph_stats_line, boost::is_any_of(":"));
-        if (result[0] == final_depth_string)
-        {
-            std::stringstream sstream(result[1]);
-            sstream >> k;
-            break;
-        }
-    }
-    graph_stats_file_stream.close();
+    size_t k = read_graph_facts(input_path).final_depth;
 
     // uint32_t k = 1;
     // bool last_file = false;
@@ -133,11 +116,11 @@ int main(int ac, char *av[])
         std::string input_file = input_path + "bisimulation/outcome_condensed-" + i_string + ".bin";
         std::string output_file = input_path + "post_hoc_results/statistics_condensed-" + i_string + ".json";
 
-        std::ifstream infile(input_file, std::ifstream::in);
+        PartitionFileStream infile(input_file, PARTITION_FILE_OUTCOME);
         std::ofstream outfile(output_file, std::ios::trunc | std::ofstream::out);
 
         std::string mapping_file = input_path + "bisimulation/mapping-" + i_string + "to" + i_next_string + ".bin";
-        std::ifstream mappingfile(mapping_file, std::ifstream::in);
+        PartitionFileStream mappingfile(mapping_file, PARTITION_FILE_MAPPING);
 
         uint64_t disappeared_count = 0;
         uint64_t split_count = 0;
@@ -1,3 +1,4 @@
+import io
 import os
 import json
 from collections import Counter
@@ -7,6 +8,78 @@ BYTES_PER_PREDICATE = 4
 BYTES_PER_BLOCK = 4
 BYTES_PER_BLOCK_OR_SINGLETON = 5
 BYTES_PER_K_TYPE = 2
+BYTES_PER_OFFSET = 8
+
+LOCAL_GLOBAL_MAP_MAGIC = b"LGMP"
+LOCAL_GLOBAL_MAP_VERSION = 2
+
+PARTITION_FILE_MAGIC = b"LODP"
+PARTITION_FILE_VERSION = 2
+PARTITION_FILE_HEADER_SIZE = 24
+
+
+def read_varint(data: bytes, position: int) -> tuple[int, int]:
+    value = 0
+    shift = 0
+    while True:
+        byte = data[position]
+        position += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, position
+        shift += 7
+
+
+def read_signed_varint(data: bytes, position: int) -> tuple[int, int]:
+    value, position = read_varint(data, position)
+    return (value >> 1) ^ -(value & 1), position
+
+
+def open_partition_file(partition_file: str):
+    """
+    Opens an outcome or mapping file for binary reading. Version 2 files (delta encoded varints) are decoded to the
+    fixed width version 1 layout, such that callers can always read version 1 records (and skip them with seek)
+    """
+    f = open(partition_file, "rb")
+    header = f.read(PARTITION_FILE_HEADER_SIZE)
+    if (
+        len(header) < PARTITION_FILE_HEADER_SIZE
+        or header[: len(PARTITION_FILE_MAGIC)] != PARTITION_FILE_MAGIC
+    ):
+        f.seek(0)  # Version 1 has no header
+        return f
+    data = f.read()
+    f.close()
+    assert (
+        header[4] == PARTITION_FILE_VERSION
+    ), f"Unsupported partition file version {header[4]}"
+    assert header[6] == 0, "Compressed partition files are not supported"
+    is_outcome = header[5] == ord("O")
+    record_count = int.from_bytes(header[8:16], "little", signed=False)
+
+    output = bytearray()
+    position = 0
+    block = 0
+    for _ in range(record_count):
+        delta, position = read_signed_varint(data, position)
+        block += delta
+        value_count, position = read_varint(data, position)
+        output += block.to_bytes(BYTES_PER_BLOCK, "little", signed=False)
+        if is_outcome:
+            output += value_count.to_bytes(BYTES_PER_ENTITY, "little", signed=False)
+            member = 0
+            for _ in range(value_count):
+                delta, position = read_varint(data, position)
+                member += delta
+                output += member.to_bytes(BYTES_PER_ENTITY, "little", signed=False)
+        else:
+            output += value_count.to_bytes(BYTES_PER_BLOCK, "little", signed=False)
+            new_block = 0
+            for _ in range(value_count):
+                delta, position = read_signed_varint(data, position)
+                new_block += delta
+                output += new_block.to_bytes(BYTES_PER_BLOCK, "little", signed=False)
+    return io.BytesIO(bytes(output))
 
 
 def get_summary_graph(experiment_directory: str) -> tuple[list[list[int]], list[int]]:
@@ -64,10 +137,32 @@ def get_node_intervals(experiment_directory: str) -> dict[int, tuple[int,int]]:
     return node_intervals
 
 
+def read_local_global_map_index(f) -> dict[int, int]:
+    """Checks the header of a local to global map file and returns its index (level --> offset of the level's group)"""
+    header = f.read(len(LOCAL_GLOBAL_MAP_MAGIC) + 1)
+    assert (
+        header[: len(LOCAL_GLOBAL_MAP_MAGIC)] == LOCAL_GLOBAL_MAP_MAGIC
+        and header[-1] == LOCAL_GLOBAL_MAP_VERSION
+    ), f"The local to global map file should have format version {LOCAL_GLOBAL_MAP_VERSION}"
+    f.seek(-BYTES_PER_OFFSET, os.SEEK_END)
+    index_offset = int.from_bytes(f.read(BYTES_PER_OFFSET), "little", signed=False)
+    f.seek(index_offset)
+    level_count = int.from_bytes(f.read(BYTES_PER_OFFSET), "little", signed=False)
+    level_offsets = dict()
+    for _ in range(level_count):
+        level = int.from_bytes(f.read(BYTES_PER_K_TYPE), "little", signed=False)
+        level_offsets[level] = int.from_bytes(
+            f.read(BYTES_PER_OFFSET), "little", signed=False
+        )
+    return level_offsets
+
+
 def get_local_global_maps(
     experiment_directory: str,
     include_inverted_index=False,
+    levels: set[int] | None = None,
 ) -> tuple[dict[tuple[int, int], int], dict[int, tuple[int, int]]]:
+    """If levels is given, then only the blocks starting at those levels are loaded"""
     assert os.path.exists(
         experiment_directory
     ), "The experiment directory string should refer to a valid (existing) directory"
@@ -83,21 +178,26 @@ def get_local_global_maps(
     global_to_local_map = dict()
 
     with open(local_to_global_map_binary_file, "rb") as f:
-        while level_bytes := f.read(BYTES_PER_K_TYPE):
-            local_level = int.from_bytes(level_bytes, "little", signed=False)
-            local_block_id = int.from_bytes(
-                f.read(BYTES_PER_BLOCK_OR_SINGLETON), "little", signed=True
-            )
-            global_block_id = int.from_bytes(
-                f.read(BYTES_PER_BLOCK_OR_SINGLETON), "little", signed=True
-            )
+        level_offsets = read_local_global_map_index(f)
+        for local_level, offset in sorted(level_offsets.items()):
+            if levels is not None and local_level not in levels:
+                continue
+            f.seek(offset + BYTES_PER_K_TYPE)
+            map_size = int.from_bytes(f.read(BYTES_PER_OFFSET), "little", signed=False)
+            for _ in range(map_size):
+                local_block_id = int.from_bytes(
+                    f.read(BYTES_PER_BLOCK_OR_SINGLETON), "little", signed=True
+                )
+                global_block_id = int.from_bytes(
+                    f.read(BYTES_PER_BLOCK_OR_SINGLETON), "little", signed=True
+                )
 
-            local_to_global_map[(local_block_id, local_level)] = global_block_id
-            if include_inverted_index:
-                if global_block_id in global_to_local_map:
-                    global_to_local_map[global_block_id].add((local_block_id, local_level))
-                else:
-                    global_to_local_map[global_block_id] = {(local_block_id, local_level)}
+                local_to_global_map[(local_block_id, local_level)] = global_block_id
+                if include_inverted_index:
+                    if global_block_id in global_to_local_map:
+                        global_to_local_map[global_block_id].add((local_block_id, local_level))
+                    else:
+                        global_to_local_map[global_block_id] = {(local_block_id, local_level)}
 
     return local_to_global_map, global_to_local_map
 
@@ -154,7 +254,7 @@ def get_outcome(experiment_directory: str, level: int) -> dict[int, set[int]]:
     assert os.path.isfile(outcome_binary_file), "The outcome (binary) file should exist"
 
     outcome = dict()
-    with open(outcome_binary_file, "rb") as f:
+    with open_partition_file(outcome_binary_file) as f:
         while block_bytes := f.read(BYTES_PER_BLOCK):
             block_id = int.from_bytes(block_bytes, "little", signed=False)
             block_size = int.from_bytes(
@@ -233,7 +333,7 @@ def get_sizes_and_split_blocks(
 
             split_blocks.append({})
 
-            with open(mapping_binary_file, "rb") as f:
+            with open_partition_file(mapping_binary_file) as f:
                 while merged_bytes := f.read(BYTES_PER_BLOCK):
                     merged_id = int.from_bytes(merged_bytes, "little", signed=False)
                     split_count = int.from_bytes(
@@ -245,7 +345,7 @@ def get_sizes_and_split_blocks(
                     sizes.pop(merged_id)  # Remove the old unused blocks
                     f.seek(split_count * BYTES_PER_BLOCK, 1)
 
-        with open(outcome_binary_file, "rb") as f:
+        with open_partition_file(outcome_binary_file) as f:
             while block_bytes := f.read(BYTES_PER_BLOCK):
                 block_id = int.from_bytes(block_bytes, "little", signed=False)
                 block_size = int.from_bytes(
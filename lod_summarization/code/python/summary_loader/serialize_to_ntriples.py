@@ -14,6 +14,7 @@ from loader_functions import (
     BYTES_PER_BLOCK,
     BYTES_PER_BLOCK_OR_SINGLETON,
     BYTES_PER_K_TYPE,
+    open_partition_file,
 )
 
 TRUNCATE = False
@@ -207,7 +208,7 @@ def process_outcomes(
                                     f"<{global_id_to_iri_map[singleton_id]}> <{CONTAINS_IRI}> {entity_string} .\n"
                                 )
 
-            with open(outcome_binary_file, "rb") as f:
+            with open_partition_file(outcome_binary_file) as f:
                 while block_bytes := f.read(BYTES_PER_BLOCK):
                     block_id = int.from_bytes(block_bytes, "little", signed=False)
                     block_size = int.from_bytes(
@@ -264,7 +265,7 @@ def load_and_store_refines_edges(
     outcome_binary_file = (
         experiment_directory + f"bisimulation/outcome_condensed-{start:04d}.bin"
     )
-    with open(outcome_binary_file, "rb") as infile:
+    with open_partition_file(outcome_binary_file) as infile:
         while block_bytes := infile.read(BYTES_PER_BLOCK):
             block_id = int.from_bytes(block_bytes, "little", signed=False)
             block_size = int.from_bytes(
@@ -310,7 +311,7 @@ def load_and_store_refines_edges(
                             )
 
             # For all non-singleton blocks, read the mapping file
-            with open(mapping_binary_file, "rb") as infile:
+            with open_partition_file(mapping_binary_file) as infile:
                 while merged_bytes := infile.read(BYTES_PER_BLOCK):
                     merged_id = int.from_bytes(merged_bytes, "little", signed=False)
                     global_merged_id = local_to_global_block_map[
@@ -1,3 +1,4 @@
+import io
 import sys
 import os
 import json
@@ -9,6 +10,63 @@ BYTES_PER_PREDICATE = 4
 BYTES_PER_BLOCK = 4
 BYTES_PER_BLOCK_OR_SINGLETON = 5
 
+PARTITION_FILE_MAGIC = b"LODP"
+PARTITION_FILE_VERSION = 2
+PARTITION_FILE_HEADER_SIZE = 24
+
+def read_varint(data:bytes, position:int) -> tuple[int,int]:
+    value = 0
+    shift = 0
+    while True:
+        byte = data[position]
+        position += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, position
+        shift += 7
+
+def read_signed_varint(data:bytes, position:int) -> tuple[int,int]:
+    value, position = read_varint(data, position)
+    return (value >> 1) ^ -(value & 1), position
+
+def open_partition_file(partition_file:str):
+    # Opens an outcome or mapping file for binary reading, version 2 files are decoded to the fixed width version 1 layout
+    f = open(partition_file, "rb")
+    header = f.read(PARTITION_FILE_HEADER_SIZE)
+    if len(header) < PARTITION_FILE_HEADER_SIZE or header[:len(PARTITION_FILE_MAGIC)] != PARTITION_FILE_MAGIC:
+        f.seek(0)  # Version 1 has no header
+        return f
+    data = f.read()
+    f.close()
+    assert header[4] == PARTITION_FILE_VERSION, f"Unsupported partition file version {header[4]}"
+    assert header[6] == 0, "Compressed partition files are not supported"
+    is_outcome = header[5] == ord("O")
+    record_count = int.from_bytes(header[8:16], "little", signed=False)
+
+    output = bytearray()
+    position = 0
+    block = 0
+    for _ in range(record_count):
+        delta, position = read_signed_varint(data, position)
+        block += delta
+        value_count, position = read_varint(data, position)
+        output += block.to_bytes(BYTES_PER_BLOCK, "little", signed=False)
+        if is_outcome:
+            output += value_count.to_bytes(BYTES_PER_ENTITY, "little", signed=False)
+            member = 0
+            for _ in range(value_count):
+                delta, position = read_varint(data, position)
+                member += delta
+                output += member.to_bytes(BYTES_PER_ENTITY, "little", signed=False)
+        else:
+            output += value_count.to_bytes(BYTES_PER_BLOCK, "little", signed=False)
+            new_block = 0
+            for _ in range(value_count):
+                delta, position = read_signed_varint(data, position)
+                new_block += delta
+                output += new_block.to_bytes(BYTES_PER_BLOCK, "little", signed=False)
+    return io.BytesIO(bytes(output))
+
 def summary_vectors_to_original_vectors(node_to_block: list[int], summary_vectors: torch.Tensor, dim: int = 0) -> torch.Tensor:
     return torch.index_select(summary_vectors, dim, torch.as_tensor(node_to_block))
 
@@ -69,7 +127,7 @@ def get_outcome(experiment_directory: str, k: int) -> tuple[list[int], list[set[
     # Read the first outcome file
     outcome_file = experiment_directory + "bisimulation/outcome_condensed-0001.bin"
 
-    with open(outcome_file, "rb") as f:
+    with open_partition_file(outcome_file) as f:
         while (block_bytes := f.read(BYTES_PER_BLOCK)):
             block_id = int.from_bytes(block_bytes, "little", signed=False)
 
@@ -95,7 +153,7 @@ def get_outcome(experiment_directory: str, k: int) -> tuple[list[int], list[set[
 
         # Load the refines edges
         refines_edges = {}
-        with open(mapping_file, "rb") as f:
+        with open_partition_file(mapping_file) as f:
             while (split_block_bytes := f.read(BYTES_PER_BLOCK)):
                 split_block_id = int.from_bytes(split_block_bytes, "little", signed=False)
                 refines_edges[split_block_id] = set()
@@ -114,7 +172,7 @@ def get_outcome(experiment_directory: str, k: int) -> tuple[list[int], list[set[
             blocks[split_block] = set()
 
         # Update the blocks
-        with open(outcome_file, "rb") as f:
+        with open_partition_file(outcome_file) as f:
             while (block_bytes := f.read(BYTES_PER_BLOCK)):
                 block_id = int.from_bytes(block_bytes, "little", signed=False)
                 assert block_id != 0, "The outcome should not explicitly encode block 0"  # We do not explicitly store the 0 block (which is reserved for singletons)
@@ -0,0 +1,302 @@
+// The quotient index stores the lifetime of every summary node and data edge of the condensed multi summary graph
+// It is built by `create_quotient_graph_from_condensed_summary` (as `bisimulation/quotient_index.bin`) and can be read with `QuotientIndex`, all numbers are little endian
+//
+// Layout:
+//   magic "QIDX" (4 bytes), version (1 byte), final depth (2 bytes)
+//   summary graph file checksum, local to global map file checksum (see experiment_manifest.hpp), node count, edge count, member count (8 bytes each)
+//   Node groups: final depth + 2 offsets (8 bytes each), the nodes of group e are the nodes from offset e up to offset e+1
+//   Edge groups: final depth + 2 offsets (8 bytes each), in the same way for the edges
+//   Nodes:   global block (5 bytes), parent (5 bytes), start level (2 bytes), end level (2 bytes), member offset (8 bytes), member count (5 bytes)
+//   Edges:   subject (5 bytes), parent of the subject (5 bytes), start level of the subject (2 bytes), from level (2 bytes), to level (2 bytes), predicate (4 bytes), object (5 bytes)
+//   Members: entity id (5 bytes each)
+// The nodes and edges are grouped by their last level, and sorted by their first level within a group.
+// The nodes (or edges) of a level are thus a prefix of every group at that level or later, such that finding them takes time proportional to their number.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "experiment_manifest.hpp"
+
+// A summary node in the quotient index: a block (or singleton) along with the levels at which it exists
+// The parent is the block it refines (i.e. the block it split from at the level before its start), or 0 for the blocks at level 0
+struct QuotientIndexNode
+{
+    int64_t global_block;
+    int64_t parent;
+    uint16_t start;
+    uint16_t end;
+    uint64_t member_offset;
+    uint64_t member_count;
+};
+
+// A data edge in the quotient index, it is part of the quotient graph of every level from `from` up to `to` (inclusive)
+// At level subject_start - 1 the subject does not exist yet, so at that level the edge starts at the parent of the subject instead
+struct QuotientIndexEdge
+{
+    int64_t subject;
+    int64_t subject_parent;
+    uint16_t subject_start;
+    uint16_t from;
+    uint16_t to;
+    uint32_t predicate;
+    int64_t object;
+};
+
+const std::string QUOTIENT_INDEX_MAGIC = "QIDX";
+const uint8_t QUOTIENT_INDEX_VERSION = 2;
+const int QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON = 5;
+const int QUOTIENT_INDEX_BYTES_PER_ENTITY = 5;
+const int QUOTIENT_INDEX_BYTES_PER_PREDICATE = 4;
+const int QUOTIENT_INDEX_BYTES_PER_LEVEL = 2;
+const int QUOTIENT_INDEX_BYTES_PER_OFFSET = 8;
+const int QUOTIENT_INDEX_HEADER_SIZE = 4 + 1 + QUOTIENT_INDEX_BYTES_PER_LEVEL + 5 * QUOTIENT_INDEX_BYTES_PER_OFFSET;
+const int QUOTIENT_INDEX_NODE_SIZE = 2 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON + 2 * QUOTIENT_INDEX_BYTES_PER_LEVEL + QUOTIENT_INDEX_BYTES_PER_OFFSET + QUOTIENT_INDEX_BYTES_PER_ENTITY;
+const int QUOTIENT_INDEX_EDGE_SIZE = 3 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON + 3 * QUOTIENT_INDEX_BYTES_PER_LEVEL + QUOTIENT_INDEX_BYTES_PER_PREDICATE;
+
+inline std::string get_quotient_index_file(const std::string &experiment_directory)
+{
+    return experiment_directory + "bisimulation/quotient_index.bin";
+}
+
+inline uint64_t get_file_checksum_if_exists(const std::string &filename)
+{
+    return std::filesystem::exists(filename) ? compute_file_checksum(filename) : 0;
+}
+
+// The index is rebuilt whenever the contents of one of the files it is derived from changed, or when the final depth changed
+// A size is not enough, e.g. a summary of a shuffled input with the same blocks numbers them differently
+inline std::pair<uint64_t,uint64_t> get_quotient_index_source_checksums(const std::string &experiment_directory)
+{
+    return {get_file_checksum_if_exists(experiment_directory + "bisimulation/condensed_multi_summary_graph.bin"),
+            get_file_checksum_if_exists(experiment_directory + "bisimulation/condensed_multi_summary_local_global_map.bin")};
+}
+
+// The quotient index, mapped into memory such that extracting a level only touches the nodes and edges of that level
+// It is never written to after opening, so it can be read from several threads at once
+class QuotientIndex
+{
+private:
+    const unsigned char *mapped_data = nullptr;
+    uint64_t mapped_size = 0;
+    uint16_t final_depth = 0;
+    uint64_t graph_checksum = 0;
+    uint64_t local_global_checksum = 0;
+    uint64_t node_count = 0;
+    uint64_t edge_count = 0;
+    uint64_t member_count = 0;
+    uint64_t node_level_offsets_position = 0;
+    uint64_t edge_level_offsets_position = 0;
+    uint64_t nodes_position = 0;
+    uint64_t edges_position = 0;
+    uint64_t members_position = 0;
+
+    QuotientIndex(QuotientIndex &)
+    {
+    }
+
+    uint64_t read_uint(uint64_t offset, unsigned int byte_count) const
+    {
+        uint64_t value = 0;
+        for (unsigned int i = 0; i < byte_count; i++)
+        {
+            value |= uint64_t(this->mapped_data[offset + i]) << (i * 8);
+        }
+        return value;
+    }
+    int64_t read_int_BLOCK_OR_SINGLETON(uint64_t offset) const
+    {
+        int64_t value = this->read_uint(offset, QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON);
+        // If this is true, then we are reading a negative number, meaning the high bit needs to be set to 1
+        if (int8_t(this->mapped_data[offset + QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON - 1]) < 0)
+        {
+            value |= 0xFFFFFF0000000000l;  // We need this conversion due to two's complement
+        }
+        return value;
+    }
+    // Returns the range of nodes (or edges) whose last level is last_level, given the position of the offsets
+    std::pair<uint64_t,uint64_t> get_group(uint64_t level_offsets_position, uint16_t last_level) const
+    {
+        return {this->read_uint(level_offsets_position + uint64_t(last_level) * QUOTIENT_INDEX_BYTES_PER_OFFSET, QUOTIENT_INDEX_BYTES_PER_OFFSET),
+                this->read_uint(level_offsets_position + (uint64_t(last_level) + 1) * QUOTIENT_INDEX_BYTES_PER_OFFSET, QUOTIENT_INDEX_BYTES_PER_OFFSET)};
+    }
+    void fail(const std::string &message)
+    {
+        munmap((void *) this->mapped_data, this->mapped_size);
+        throw std::runtime_error(message);
+    }
+
+public:
+    QuotientIndex(const std::string &index_file)
+    {
+        int file_descriptor = open(index_file.c_str(), O_RDONLY);
+        if (file_descriptor == -1)
+        {
+            throw std::runtime_error("Could not open " + index_file);
+        }
+        struct stat file_status;
+        fstat(file_descriptor, &file_status);
+        this->mapped_size = file_status.st_size;
+        if (this->mapped_size < QUOTIENT_INDEX_HEADER_SIZE)
+        {
+            close(file_descriptor);
+            throw std::runtime_error("The quotient index " + index_file + " is too small");
+        }
+        void *data = mmap(nullptr, this->mapped_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        close(file_descriptor);
+        if (data == MAP_FAILED)
+        {
+            throw std::runtime_error("Could not map " + index_file + " into memory");
+        }
+        this->mapped_data = (const unsigned char *) data;
+
+        if (std::string((const char *) this->mapped_data, QUOTIENT_INDEX_MAGIC.size()) != QUOTIENT_INDEX_MAGIC || this->mapped_data[QUOTIENT_INDEX_MAGIC.size()] != QUOTIENT_INDEX_VERSION)
+        {
+            this->fail("The quotient index " + index_file + " does not have the expected format (version " + std::to_string(QUOTIENT_INDEX_VERSION) + ")");
+        }
+        uint64_t offset = QUOTIENT_INDEX_MAGIC.size() + 1;
+        this->final_depth = this->read_uint(offset, QUOTIENT_INDEX_BYTES_PER_LEVEL);
+        offset += QUOTIENT_INDEX_BYTES_PER_LEVEL;
+        this->graph_checksum = this->read_uint(offset, QUOTIENT_INDEX_BYTES_PER_OFFSET);
+        this->local_global_checksum = this->read_uint(offset + QUOTIENT_INDEX_BYTES_PER_OFFSET, QUOTIENT_INDEX_BYTES_PER_OFFSET);
+        this->node_count = this->read_uint(offset + 2 * QUOTIENT_INDEX_BYTES_PER_OFFSET, QUOTIENT_INDEX_BYTES_PER_OFFSET);
+        this->edge_count = this->read_uint(offset + 3 * QUOTIENT_INDEX_BYTES_PER_OFFSET, QUOTIENT_INDEX_BYTES_PER_OFFSET);
+        this->member_count = this->read_uint(offset + 4 * QUOTIENT_INDEX_BYTES_PER_OFFSET, QUOTIENT_INDEX_BYTES_PER_OFFSET);
+        this->node_level_offsets_position = QUOTIENT_INDEX_HEADER_SIZE;
+        this->edge_level_offsets_position = this->node_level_offsets_position + (uint64_t(this->final_depth) + 2) * QUOTIENT_INDEX_BYTES_PER_OFFSET;
+        this->nodes_position = this->edge_level_offsets_position + (uint64_t(this->final_depth) + 2) * QUOTIENT_INDEX_BYTES_PER_OFFSET;
+        this->edges_position = this->nodes_position + this->node_count * QUOTIENT_INDEX_NODE_SIZE;
+        this->members_position = this->edges_position + this->edge_count * QUOTIENT_INDEX_EDGE_SIZE;
+        if (this->members_position + this->member_count * QUOTIENT_INDEX_BYTES_PER_ENTITY != this->mapped_size)
+        {
+            this->fail("The quotient index " + index_file + " has an unexpected size");
+        }
+    }
+    ~QuotientIndex()
+    {
+        munmap((void *) this->mapped_data, this->mapped_size);
+    }
+    // Whether the index was built from the current summary graph
+    bool is_current(const std::string &experiment_directory, uint16_t expected_final_depth) const
+    {
+        return this->final_depth == expected_final_depth && get_quotient_index_source_checksums(experiment_directory) == std::make_pair(this->graph_checksum, this->local_global_checksum);
+    }
+    uint16_t get_final_depth() const
+    {
+        return this->final_depth;
+    }
+    uint64_t get_node_count() const
+    {
+        return this->node_count;
+    }
+    QuotientIndexNode get_node(uint64_t node) const
+    {
+        uint64_t offset = this->nodes_position + node * QUOTIENT_INDEX_NODE_SIZE;
+        return {this->read_int_BLOCK_OR_SINGLETON(offset),
+                this->read_int_BLOCK_OR_SINGLETON(offset + QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON),
+                uint16_t(this->read_uint(offset + 2 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON, QUOTIENT_INDEX_BYTES_PER_LEVEL)),
+                uint16_t(this->read_uint(offset + 2 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON + QUOTIENT_INDEX_BYTES_PER_LEVEL, QUOTIENT_INDEX_BYTES_PER_LEVEL)),
+                this->read_uint(offset + 2 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON + 2 * QUOTIENT_INDEX_BYTES_PER_LEVEL, QUOTIENT_INDEX_BYTES_PER_OFFSET),
+                this->read_uint(offset + 2 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON + 2 * QUOTIENT_INDEX_BYTES_PER_LEVEL + QUOTIENT_INDEX_BYTES_PER_OFFSET, QUOTIENT_INDEX_BYTES_PER_ENTITY)};
+    }
+    QuotientIndexEdge get_edge(uint64_t edge) const
+    {
+        uint64_t offset = this->edges_position + edge * QUOTIENT_INDEX_EDGE_SIZE;
+        return {this->read_int_BLOCK_OR_SINGLETON(offset),
+                this->read_int_BLOCK_OR_SINGLETON(offset + QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON),
+                uint16_t(this->read_uint(offset + 2 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON, QUOTIENT_INDEX_BYTES_PER_LEVEL)),
+                uint16_t(this->read_uint(offset + 2 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON + QUOTIENT_INDEX_BYTES_PER_LEVEL, QUOTIENT_INDEX_BYTES_PER_LEVEL)),
+                uint16_t(this->read_uint(offset + 2 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON + 2 * QUOTIENT_INDEX_BYTES_PER_LEVEL, QUOTIENT_INDEX_BYTES_PER_LEVEL)),
+                uint32_t(this->read_uint(offset + 2 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON + 3 * QUOTIENT_INDEX_BYTES_PER_LEVEL, QUOTIENT_INDEX_BYTES_PER_PREDICATE)),
+                this->read_int_BLOCK_OR_SINGLETON(offset + 2 * QUOTIENT_INDEX_BYTES_PER_BLOCK_OR_SINGLETON + 3 * QUOTIENT_INDEX_BYTES_PER_LEVEL + QUOTIENT_INDEX_BYTES_PER_PREDICATE)};
+    }
+    // Returns member j of the given node
+    uint64_t get_member(const QuotientIndexNode &node, uint64_t j) const
+    {
+        return this->read_uint(this->members_position + (node.member_offset + j) * QUOTIENT_INDEX_BYTES_PER_ENTITY, QUOTIENT_INDEX_BYTES_PER_ENTITY);
+    }
+    // Calls function(node) for every node that exists at the given level
+    template <typename Function>
+    void for_each_node(uint16_t level, Function function) const
+    {
+        for (uint16_t last_level = level; last_level <= this->final_depth; last_level++)
+        {
+            auto [begin, end] = this->get_group(this->node_level_offsets_position, last_level);
+            for (uint64_t i = begin; i < end; i++)
+            {
+                QuotientIndexNode node = this->get_node(i);
+                if (node.start > level)  // The rest of the group starts even later
+                {
+                    break;
+                }
+                function(node);
+            }
+        }
+    }
+    // Calls function(global_block, member) for every member of every block that exists at the given level
+    template <typename Function>
+    void for_each_member(uint16_t level, Function function) const
+    {
+        this->for_each_node(level, [&](const QuotientIndexNode &node)
+        {
+            for (uint64_t j = 0; j < node.member_count; j++)
+            {
+                function(node.global_block, this->get_member(node, j));
+            }
+        });
+    }
+    // Returns the ranges of edges that are part of the quotient graph at the given level, one range per group
+    // Within a group the edges are sorted by their first level, so the end of every range is found with a binary search
+    std::vector<std::pair<uint64_t,uint64_t>> get_edge_ranges(uint16_t level) const
+    {
+        std::vector<std::pair<uint64_t,uint64_t>> ranges;
+        for (uint16_t last_level = level; last_level <= this->final_depth; last_level++)
+        {
+            auto [begin, end] = this->get_group(this->edge_level_offsets_position, last_level);
+            uint64_t low = begin;
+            uint64_t high = end;
+            while (low < high)
+            {
+                uint64_t middle = low + (high - low) / 2;
+                if (this->get_edge(middle).from <= level)
+                {
+                    low = middle + 1;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+            if (begin < low)
+            {
+                ranges.emplace_back(begin, low);
+            }
+        }
+        return ranges;
+    }
+    // The subject of the edge in the quotient graph at the given level, a subject that only starts at the next level is mapped over its refines edge
+    static int64_t get_subject_at_level(const QuotientIndexEdge &edge, uint16_t level)
+    {
+        return edge.subject_start == level + 1 ? edge.subject_parent : edge.subject;
+    }
+    // Calls function(subject, predicate, object) for every data edge of the quotient graph at the given level (possibly more than once)
+    template <typename Function>
+    void for_each_edge(uint16_t level, Function function) const
+    {
+        for (auto [begin, end]: this->get_edge_ranges(level))
+        {
+            for (uint64_t i = begin; i < end; i++)
+            {
+                QuotientIndexEdge edge = this->get_edge(i);
+                function(get_subject_at_level(edge, level), edge.predicate, edge.object);
+            }
+        }
+    }
+};
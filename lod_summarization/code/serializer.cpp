@@ -0,0 +1,1153 @@
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <filesystem>
+#include <thread>
+#include <optional>
+#include <boost/algorithm/string.hpp>
+#include <boost/unordered/unordered_flat_map.hpp>
+#include <boost/program_options.hpp>
+#define BOOST_CHRONO_HEADER_ONLY
+#include <boost/chrono.hpp>
+#include "summary_bundle.hpp"
+#include "partition_file.hpp"
+#include "experiment_manifest.hpp"
+
+using edge_type = uint32_t;
+using node_index = uint64_t;
+using block_index = node_index;
+using block_or_singleton_index = int64_t;
+using k_type = uint16_t;
+using local_to_global_map_type = boost::unordered_flat_map<std::pair<block_or_singleton_index,k_type>,block_or_singleton_index>;
+using global_id_to_iri_map_type = boost::unordered_flat_map<block_or_singleton_index,std::string>;
+
+const std::string LOCAL_GLOBAL_MAP_MAGIC = "LGMP";
+const uint8_t LOCAL_GLOBAL_MAP_VERSION = 2;
+const int BYTES_PER_ENTITY = 5;
+const int BYTES_PER_PREDICATE = 4;
+const int BYTES_PER_BLOCK = 4;
+const int BYTES_PER_BLOCK_OR_SINGLETON = 5;
+const int BYTES_PER_K_TYPE = 2;
+const int BYTES_PER_OFFSET = 8;
+const uint64_t WRITE_BUFFER_SIZE = 1 << 24;  // The output is collected in buffers of this size, before it is written to the files
+
+const std::string NAMESPACE = "http://cs.vu.nl/clustering#";
+const std::string CONTAINS_IRI = NAMESPACE + "contains";
+const std::string SIZE_IRI = NAMESPACE + "size";
+const std::string REFINES_IRI = NAMESPACE + "refines";
+const std::string START_IRI = NAMESPACE + "startLevel";
+const std::string END_IRI = NAMESPACE + "endLevel";
+
+class MyException : public std::exception
+{
+private:
+    const std::string message;
+
+public:
+    MyException(const std::string &err) : message(err) {}
+
+    const char *what() const noexcept override
+    {
+        return message.c_str();
+    }
+};
+
+u_int64_t read_uint_ENTITY_little_endian(std::istream &inputstream)
+{
+    char data[8];
+    inputstream.read(data, BYTES_PER_ENTITY);
+    if (inputstream.eof())
+    {
+        return UINT64_MAX;
+    }
+    if (inputstream.fail())
+    {
+        std::cout << "Read entity failed with code: " << inputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << inputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << inputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (inputstream.fail() && !inputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << inputstream.bad() << std::endl;
+        exit(inputstream.rdstate());
+    }
+    u_int64_t result = uint64_t(0);
+
+    for (unsigned int i = 0; i < BYTES_PER_ENTITY; i++)
+    {
+        result |= (uint64_t(data[i]) & 0x00000000000000FFull) << (i * 8); // `& 0x00000000000000FFull` makes sure that we only write one byte of data
+    }
+    return result;
+}
+
+block_or_singleton_index read_int_BLOCK_OR_SINGLETON_little_endian(std::istream &inputstream)
+{
+    char data[BYTES_PER_BLOCK_OR_SINGLETON];
+    inputstream.read(data, BYTES_PER_BLOCK_OR_SINGLETON);
+    if (inputstream.eof())
+    {
+        return INT64_MAX;
+    }
+    if (inputstream.fail())
+    {
+        std::cout << "Read block failed with code: " << inputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << inputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << inputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (inputstream.fail() && !inputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << inputstream.bad() << std::endl;
+        exit(inputstream.rdstate());
+    }
+    int64_t result = 0;
+
+    for (unsigned int i = 0; i < BYTES_PER_BLOCK_OR_SINGLETON; i++)
+    {
+        result |= (int64_t(data[i]) & 0x00000000000000FFl) << (i * 8);
+    }
+    // If this is true, then we are reading a negative number, meaning the high bit needs to be set to 1
+    if (int8_t(data[BYTES_PER_BLOCK_OR_SINGLETON-1]) < 0)
+    {
+        result |= 0xFFFFFF0000000000l;  // We need this conversion due to two's complement
+    }
+    return result;
+}
+
+k_type read_uint_K_TYPE_little_endian(std::istream &inputstream)
+{
+    char data[8];
+    inputstream.read(data, BYTES_PER_K_TYPE);
+    if (inputstream.eof())
+    {
+        return INT16_MAX;
+    }
+    if (inputstream.fail())
+    {
+        std::cout << "Read block failed with code: " << inputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << inputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << inputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (inputstream.fail() && !inputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << inputstream.bad() << std::endl;
+        exit(inputstream.rdstate());
+    }
+    u_int64_t result = u_int64_t(0);
+
+    for (unsigned int i = 0; i < BYTES_PER_K_TYPE; i++)
+    {
+        result |= (u_int64_t(data[i]) & 0x00000000000000FFull) << (i * 8); // `& 0x00000000000000FFull` makes sure that we only write one byte of data << (i * 8);
+    }
+    return result;
+}
+
+u_int64_t read_uint_OFFSET_little_endian(std::istream &inputstream)
+{
+    char data[BYTES_PER_OFFSET];
+    inputstream.read(data, BYTES_PER_OFFSET);
+    if (inputstream.eof())
+    {
+        return UINT64_MAX;
+    }
+    if (inputstream.fail())
+    {
+        std::cout << "Read offset failed with code: " << inputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << inputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << inputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (inputstream.fail() && !inputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << inputstream.bad() << std::endl;
+        exit(inputstream.rdstate());
+    }
+    u_int64_t result = u_int64_t(0);
+
+    for (unsigned int i = 0; i < BYTES_PER_OFFSET; i++)
+    {
+        result |= (u_int64_t(data[i]) & 0x00000000000000FFull) << (i * 8);
+    }
+    return result;
+}
+
+u_int64_t read_uint_BLOCK_little_endian(std::istream &inputstream)
+{
+    char data[8];
+    inputstream.read(data, BYTES_PER_BLOCK);
+    if (inputstream.eof())
+    {
+        return UINT64_MAX;
+    }
+    if (inputstream.fail())
+    {
+        std::cout << "Read block failed with code: " << inputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << inputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << inputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (inputstream.fail() && !inputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << inputstream.bad() << std::endl;
+        exit(inputstream.rdstate());
+    }
+    u_int64_t result = u_int64_t(0);
+
+    for (unsigned int i = 0; i < BYTES_PER_BLOCK; i++)
+    {
+        result |= (u_int64_t(data[i]) & 0x00000000000000FFull) << (i * 8); // `& 0x00000000000000FFull` makes sure that we only write one byte of data << (i * 8);
+    }
+    return result;
+}
+
+u_int32_t read_uint_PREDICATE_little_endian(std::istream &inputstream)
+{
+    char data[4];
+    inputstream.read(data, BYTES_PER_PREDICATE);
+    if (inputstream.eof())
+    {
+        return UINT32_MAX;
+    }
+    if (inputstream.fail())
+    {
+        std::cout << "Read predicate failed with code: " << inputstream.rdstate() << std::endl;
+        std::cout << "Goodbit: " << inputstream.good() << std::endl;
+        std::cout << "Eofbit:  " << inputstream.eof() << std::endl;
+        std::cout << "Failbit: " << (inputstream.fail() && !inputstream.bad()) << std::endl;
+        std::cout << "Badbit:  " << inputstream.bad() << std::endl;
+        exit(inputstream.rdstate());
+    }
+    u_int32_t result = uint32_t(0);
+
+    for (unsigned int i = 0; i < BYTES_PER_PREDICATE; i++)
+    {
+        result |= (uint32_t(data[i]) & 255) << (i * 8); // `& 255` makes sure that we only write one byte of data
+    }
+    return result;
+}
+
+
+// A SHA-256 implementation (FIPS 180-4), used for the hash based block IRIs
+class Sha256
+{
+private:
+    static constexpr std::array<uint32_t, 64> ROUND_CONSTANTS = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+    std::array<uint32_t, 8> state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    std::array<unsigned char, 64> chunk;
+    uint64_t chunk_size = 0;
+    uint64_t message_size = 0;
+
+    static uint32_t rotate_right(uint32_t value, unsigned int bits)
+    {
+        return (value >> bits) | (value << (32 - bits));
+    }
+    void process_chunk()
+    {
+        std::array<uint32_t, 64> words;
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            words[i] = (uint32_t(this->chunk[4 * i]) << 24) | (uint32_t(this->chunk[4 * i + 1]) << 16) | (uint32_t(this->chunk[4 * i + 2]) << 8) | uint32_t(this->chunk[4 * i + 3]);
+        }
+        for (unsigned int i = 16; i < 64; i++)
+        {
+            uint32_t s0 = rotate_right(words[i - 15], 7) ^ rotate_right(words[i - 15], 18) ^ (words[i - 15] >> 3);
+            uint32_t s1 = rotate_right(words[i - 2], 17) ^ rotate_right(words[i - 2], 19) ^ (words[i - 2] >> 10);
+            words[i] = words[i - 16] + s0 + words[i - 7] + s1;
+        }
+        std::array<uint32_t, 8> h = this->state;
+        for (unsigned int i = 0; i < 64; i++)
+        {
+            uint32_t s1 = rotate_right(h[4], 6) ^ rotate_right(h[4], 11) ^ rotate_right(h[4], 25);
+            uint32_t choice = (h[4] & h[5]) ^ (~h[4] & h[6]);
+            uint32_t temp1 = h[7] + s1 + choice + ROUND_CONSTANTS[i] + words[i];
+            uint32_t s0 = rotate_right(h[0], 2) ^ rotate_right(h[0], 13) ^ rotate_right(h[0], 22);
+            uint32_t majority = (h[0] & h[1]) ^ (h[0] & h[2]) ^ (h[1] & h[2]);
+            uint32_t temp2 = s0 + majority;
+            h = {temp1 + temp2, h[0], h[1], h[2], h[3] + temp1, h[4], h[5], h[6]};
+        }
+        for (unsigned int i = 0; i < 8; i++)
+        {
+            this->state[i] += h[i];
+        }
+        this->chunk_size = 0;
+    }
+
+public:
+    void update(const char *data, uint64_t size)
+    {
+        for (uint64_t i = 0; i < size; i++)
+        {
+            this->chunk[this->chunk_size++] = (unsigned char) data[i];
+            if (this->chunk_size == 64)
+            {
+                this->process_chunk();
+            }
+        }
+        this->message_size += size;
+    }
+    void update(const std::string &data)
+    {
+        this->update(data.data(), data.size());
+    }
+    std::array<unsigned char, 32> digest()
+    {
+        uint64_t message_bits = this->message_size * 8;
+        this->chunk[this->chunk_size++] = 0x80;
+        if (this->chunk_size > 56)
+        {
+            std::fill(this->chunk.begin() + this->chunk_size, this->chunk.end(), 0);
+            this->process_chunk();
+        }
+        std::fill(this->chunk.begin() + this->chunk_size, this->chunk.begin() + 56, 0);
+        for (unsigned int i = 0; i < 8; i++)
+        {
+            this->chunk[63 - i] = (unsigned char) (message_bits >> (8 * i));
+        }
+        this->process_chunk();
+        std::array<unsigned char, 32> result;
+        for (unsigned int i = 0; i < 32; i++)
+        {
+            result[i] = (unsigned char) (this->state[i / 4] >> (24 - 8 * (i % 4)));
+        }
+        return result;
+    }
+};
+
+// Standard base64 (with padding)
+std::string base64_encode(const unsigned char *data, uint64_t size)
+{
+    const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string result;
+    result.reserve(4 * ((size + 2) / 3));
+    for (uint64_t i = 0; i < size; i += 3)
+    {
+        uint32_t group = uint32_t(data[i]) << 16;
+        if (i + 1 < size)
+        {
+            group |= uint32_t(data[i + 1]) << 8;
+        }
+        if (i + 2 < size)
+        {
+            group |= uint32_t(data[i + 2]);
+        }
+        result.push_back(alphabet[(group >> 18) & 0x3F]);
+        result.push_back(alphabet[(group >> 12) & 0x3F]);
+        result.push_back(i + 1 < size ? alphabet[(group >> 6) & 0x3F] : '=');
+        result.push_back(i + 2 < size ? alphabet[group & 0x3F] : '=');
+    }
+    return result;
+}
+
+// Percent-encodes a string in the same way as urllib.parse.quote(string, safe=":/?#[]@!$&'()*+,;=") in Python
+void append_iri_safe(std::string &output, const std::string &unsafe_string)
+{
+    const char *hex_digits = "0123456789ABCDEF";
+    const std::string safe_characters = "_.-~:/?#[]@!$&'()*+,;=";
+    for (char character: unsafe_string)
+    {
+        unsigned char byte = (unsigned char) character;
+        if ((byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') || (byte >= '0' && byte <= '9') || (byte != 0 && safe_characters.find(character) != std::string::npos))
+        {
+            output.push_back(character);
+        }
+        else
+        {
+            output.push_back('%');
+            output.push_back(hex_digits[byte >> 4]);
+            output.push_back(hex_digits[byte & 0x0F]);
+        }
+    }
+}
+
+// Maps the members of a block to the IRI of the block, using one of the schemes of serialize_to_ntriples.py
+class BlockIRIMapper
+{
+private:
+    std::string iri_type;
+    const std::vector<std::string> &entity_names;
+
+    std::string join_sorted_entity_names(std::vector<node_index> &members) const
+    {
+        std::vector<const std::string *> names;
+        names.reserve(members.size());
+        for (node_index member: members)
+        {
+            names.push_back(&this->entity_names[member]);
+        }
+        std::sort(names.begin(), names.end(), [](const std::string *a, const std::string *b){return *a < *b;});
+        std::string joined_names;
+        for (uint64_t i = 0; i < names.size(); i++)
+        {
+            if (i > 0)
+            {
+                joined_names.push_back(',');
+            }
+            joined_names += *names[i];
+        }
+        return joined_names;
+    }
+
+public:
+    BlockIRIMapper(const std::string &iri_type, const std::vector<std::string> &entity_names) : iri_type(iri_type), entity_names(entity_names)
+    {
+        if (iri_type != "id_set" && iri_type != "iri_set" && iri_type != "hash")
+        {
+            throw MyException("`iri_type` is set to \"" + iri_type + "\". It should be one of: \"id_set\", \"iri_set\", or \"hash\".");
+        }
+    }
+    // The members are sorted in place
+    std::string get_iri(std::vector<node_index> &members) const
+    {
+        std::string iri = NAMESPACE;
+        if (this->iri_type == "id_set")
+        {
+            std::sort(members.begin(), members.end());
+            std::string sorted_id_string = "id_block-{";
+            for (uint64_t i = 0; i < members.size(); i++)
+            {
+                if (i > 0)
+                {
+                    sorted_id_string.push_back(',');
+                }
+                sorted_id_string += std::to_string(members[i]);
+            }
+            sorted_id_string.push_back('}');
+            append_iri_safe(iri, sorted_id_string);
+        }
+        else if (this->iri_type == "iri_set")
+        {
+            append_iri_safe(iri, "iri_block-{" + this->join_sorted_entity_names(members) + "}");
+        }
+        else
+        {
+            Sha256 hash;
+            hash.update(this->join_sorted_entity_names(members));
+            std::array<unsigned char, 32> hash_bytes = hash.digest();
+            append_iri_safe(iri, "hash_block-" + base64_encode(hash_bytes.data(), hash_bytes.size()));
+        }
+        return iri;
+    }
+};
+
+// Collects the output in a large buffer, which is only written to the file once it is full
+// close() writes the remainder, so it should be called once all output has been added
+class BufferedWriter
+{
+private:
+    std::string filename;
+    std::ofstream outputstream;
+    std::string buffer;
+
+public:
+    BufferedWriter(const std::string &filename) : filename(filename), outputstream(filename, std::ios::trunc | std::ios::binary)
+    {
+        if (!this->outputstream)
+        {
+            throw MyException("Could not open " + filename + " for writing");
+        }
+        this->buffer.reserve(WRITE_BUFFER_SIZE);
+    }
+    void write(const std::string &data)
+    {
+        this->buffer += data;
+        if (this->buffer.size() >= WRITE_BUFFER_SIZE)
+        {
+            this->flush();
+        }
+    }
+    std::string& get_buffer()
+    {
+        return this->buffer;
+    }
+    void flush_if_full()
+    {
+        if (this->buffer.size() >= WRITE_BUFFER_SIZE)
+        {
+            this->flush();
+        }
+    }
+    void flush()
+    {
+        this->outputstream.write(this->buffer.data(), this->buffer.size());
+        this->outputstream.flush();
+        this->buffer.clear();
+        if (!this->outputstream)
+        {
+            throw MyException("Could not write to " + this->filename);
+        }
+    }
+    void close()
+    {
+        this->flush();
+        this->outputstream.close();
+    }
+};
+
+// Runs function(thread, begin, end) on thread_count threads, each getting an (almost) equal share of [0, size)
+template <typename Function>
+void parallel_for_ranges(uint64_t size, unsigned int thread_count, Function function)
+{
+    if (thread_count <= 1 || size < thread_count)
+    {
+        function(0, 0, size);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back(function, t, (size * t) / thread_count, (size * (t + 1)) / thread_count);
+    }
+    for (std::thread &thread: threads)
+    {
+        thread.join();
+    }
+}
+
+void log_progress(const std::string &message)
+{
+    auto now{boost::chrono::system_clock::to_time_t(boost::chrono::system_clock::now())};
+    std::tm *ptm{std::localtime(&now)};
+    std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S") << " " << message << std::endl;
+}
+
+// Reads a file with lines of the form "<name> <id>", like entity2ID.txt and rel2ID.txt
+std::vector<std::string> read_id_name_map(const std::string &filename)
+{
+    std::ifstream inputstream(filename, std::ifstream::in);
+    if (!inputstream)
+    {
+        throw MyException("Could not open " + filename);
+    }
+    std::vector<std::string> names;
+    std::string line;
+    uint64_t line_number = 0;
+    while (std::getline(inputstream, line))
+    {
+        line_number++;
+        size_t delimiter_pos = line.find(' ');
+        if (delimiter_pos == std::string::npos || line.find(' ', delimiter_pos + 1) != std::string::npos)
+        {
+            throw MyException("Error in splitting line " + std::to_string(line_number) + " of " + filename + ": The IRI likely containts spaces");
+        }
+        uint64_t id = std::stoull(line.substr(delimiter_pos + 1));
+        if (id >= names.size())
+        {
+            names.resize(id + 1);
+        }
+        names[id] = line.substr(0, delimiter_pos);
+    }
+    return names;
+}
+
+local_to_global_map_type read_local_global_map(const std::string &filename)
+{
+    std::ifstream inputstream(filename, std::ifstream::in | std::ifstream::binary);
+    std::string magic(LOCAL_GLOBAL_MAP_MAGIC.size(), ' ');
+    inputstream.read(magic.data(), magic.size());
+    int version = inputstream.get();
+    if (!inputstream || magic != LOCAL_GLOBAL_MAP_MAGIC || version != LOCAL_GLOBAL_MAP_VERSION)
+    {
+        throw MyException("The local to global map file does not have the expected format (version " + std::to_string(LOCAL_GLOBAL_MAP_VERSION) + "). Please recreate the condensed summary graph.");
+    }
+    inputstream.seekg(-BYTES_PER_OFFSET, std::ios_base::end);
+    uint64_t index_offset = read_uint_OFFSET_little_endian(inputstream);
+    inputstream.seekg(index_offset);
+    uint64_t level_count = read_uint_OFFSET_little_endian(inputstream);
+    std::vector<std::pair<k_type,uint64_t>> level_offsets;
+    for (uint64_t i = 0; i < level_count; i++)
+    {
+        k_type level = read_uint_K_TYPE_little_endian(inputstream);
+        level_offsets.emplace_back(level, read_uint_OFFSET_little_endian(inputstream));
+    }
+
+    local_to_global_map_type local_to_global_map;
+    for (auto [level, offset]: level_offsets)
+    {
+        inputstream.seekg(offset + BYTES_PER_K_TYPE);  // Skip the level, which we already know
+        uint64_t count = read_uint_OFFSET_little_endian(inputstream);
+        for (uint64_t i = 0; i < count; i++)
+        {
+            block_or_singleton_index local_block = read_int_BLOCK_OR_SINGLETON_little_endian(inputstream);
+            block_or_singleton_index global_block = read_int_BLOCK_OR_SINGLETON_little_endian(inputstream);
+            local_to_global_map[{local_block, level}] = global_block;
+        }
+    }
+    return local_to_global_map;
+}
+
+// Reads the intervals in the order of the file, if a block occurs more than once, then it keeps its first position and its last interval
+std::vector<std::pair<block_or_singleton_index,std::pair<k_type,k_type>>> read_intervals(const std::string &filename)
+{
+    std::ifstream inputstream(filename, std::ifstream::in | std::ifstream::binary);
+    std::vector<std::pair<block_or_singleton_index,std::pair<k_type,k_type>>> intervals;
+    boost::unordered_flat_map<block_or_singleton_index,uint64_t> positions;
+    while (true)
+    {
+        block_or_singleton_index block = read_int_BLOCK_OR_SINGLETON_little_endian(inputstream);
+        if (inputstream.eof())
+        {
+            break;
+        }
+        k_type start = read_uint_K_TYPE_little_endian(inputstream);
+        k_type end = read_uint_K_TYPE_little_endian(inputstream);
+        auto [position_iterator, inserted] = positions.try_emplace(block, intervals.size());
+        if (inserted)
+        {
+            intervals.push_back({block, {start, end}});
+        }
+        else
+        {
+            intervals[position_iterator->second].second = {start, end};
+        }
+    }
+    return intervals;
+}
+
+std::string level_to_string(k_type level)
+{
+    std::ostringstream level_stringstream;
+    level_stringstream << std::setw(4) << std::setfill('0') << level;
+    return level_stringstream.str();
+}
+
+const std::string& get_block_iri(const global_id_to_iri_map_type &global_id_to_iri_map, block_or_singleton_index global_block)
+{
+    auto iri_iterator = global_id_to_iri_map.find(global_block);
+    if (iri_iterator == global_id_to_iri_map.cend())
+    {
+        throw MyException("The summary node " + std::to_string(global_block) + " does not belong to any of the outcomes");
+    }
+    return iri_iterator->second;
+}
+
+block_or_singleton_index get_global_block(const local_to_global_map_type &local_to_global_map, block_or_singleton_index local_block, k_type level)
+{
+    auto global_iterator = local_to_global_map.find({local_block, level});
+    if (global_iterator == local_to_global_map.cend())
+    {
+        throw MyException("The block " + std::to_string(local_block) + " starting at level " + std::to_string(level) + " is missing from the local to global map");
+    }
+    return global_iterator->second;
+}
+
+void append_entity(std::string &output, const std::string &entity_name)
+{
+    if (entity_name.starts_with("_:"))
+    {
+        output += entity_name;
+    }
+    else
+    {
+        output += "<" + entity_name + ">";
+    }
+}
+
+// Collects the summary bundle (see summary_bundle.hpp) next to, or instead of, the N-Triples files
+// The refines edges and the data edges are added by different threads, so each of these only touches its own columns
+class SummaryBundleBuilder
+{
+private:
+    SummaryBundle bundle;
+    boost::unordered_flat_map<block_or_singleton_index,uint64_t> global_block_to_node;
+    std::vector<uint64_t> entity_strings;  // The string of every entity, or UINT64_MAX if it has not been added yet
+    std::vector<edge_type> data_predicate_ids;  // These are only turned into strings by write(), such that the data edges do not touch the string table
+
+    uint64_t get_node(block_or_singleton_index global_block) const
+    {
+        auto node_iterator = this->global_block_to_node.find(global_block);
+        if (node_iterator == this->global_block_to_node.cend())
+        {
+            throw MyException("The summary node " + std::to_string(global_block) + " does not belong to any of the outcomes");
+        }
+        return node_iterator->second;
+    }
+
+public:
+    SummaryBundleBuilder(k_type depth, bool include_contains, uint64_t entity_count)
+    {
+        this->bundle.depth = depth;
+        this->bundle.has_contains = include_contains;
+        if (include_contains)
+        {
+            this->entity_strings.resize(entity_count, UINT64_MAX);
+        }
+    }
+    void add_node(block_or_singleton_index global_block, const std::string &iri, const std::vector<node_index> &members, const std::vector<std::string> &entity_names)
+    {
+        if (!this->global_block_to_node.try_emplace(global_block, this->bundle.get_node_count()).second)
+        {
+            throw MyException("The summary node " + std::to_string(global_block) + " occurs in more than one outcome");
+        }
+        this->bundle.node_iris.push_back(this->bundle.add_string(iri));
+        this->bundle.node_sizes.push_back(members.size());
+        this->bundle.node_start_levels.push_back(SUMMARY_BUNDLE_NO_LEVEL);
+        this->bundle.node_end_levels.push_back(SUMMARY_BUNDLE_NO_LEVEL);
+        if (this->bundle.has_contains)
+        {
+            for (node_index member: members)
+            {
+                if (this->entity_strings[member] == UINT64_MAX)
+                {
+                    this->entity_strings[member] = this->bundle.add_string(entity_names[member]);
+                }
+                this->bundle.contains_members.push_back(this->entity_strings[member]);
+            }
+            this->bundle.contains_offsets.push_back(this->bundle.contains_members.size());
+        }
+    }
+    void set_intervals(const std::vector<std::pair<block_or_singleton_index,std::pair<k_type,k_type>>> &intervals)
+    {
+        for (const auto &[global_block, interval]: intervals)
+        {
+            uint64_t node = this->get_node(global_block);
+            this->bundle.node_start_levels[node] = interval.first;
+            this->bundle.node_end_levels[node] = interval.second;
+        }
+    }
+    void add_refines_edge(block_or_singleton_index refining_block, block_or_singleton_index refined_block)
+    {
+        this->bundle.refines_children.push_back(this->get_node(refining_block));
+        this->bundle.refines_parents.push_back(this->get_node(refined_block));
+    }
+    void add_data_edge(block_or_singleton_index subject, edge_type predicate, block_or_singleton_index object)
+    {
+        this->bundle.data_subjects.push_back(this->get_node(subject));
+        this->data_predicate_ids.push_back(predicate);
+        this->bundle.data_objects.push_back(this->get_node(object));
+    }
+    void write(const std::string &filename, const std::vector<std::string> &predicate_names)
+    {
+        std::vector<uint64_t> predicate_strings(predicate_names.size(), UINT64_MAX);
+        this->bundle.data_predicates.clear();
+        for (edge_type predicate: this->data_predicate_ids)
+        {
+            if (predicate_strings[predicate] == UINT64_MAX)
+            {
+                predicate_strings[predicate] = this->bundle.add_string(predicate_names[predicate]);
+            }
+            this->bundle.data_predicates.push_back(predicate_strings[predicate]);
+        }
+        write_summary_bundle(filename, this->bundle);
+    }
+};
+
+// A block of an outcome (or a singleton) along with its members, whose IRI is still to be computed
+struct BlockToSerialize
+{
+    block_or_singleton_index global_block;
+    std::vector<node_index> members;
+};
+
+// Computes the IRIs for the blocks (and singletons) created at every level, and writes their sizes and members
+// The IRIs are computed and the lines are formatted in parallel, after which the lines are written in the same order as the blocks were read
+// If a bundle builder is given, then the blocks are also added to it as nodes (in the same order)
+global_id_to_iri_map_type process_outcomes(const std::string &experiment_directory, k_type depth, const local_to_global_map_type &local_to_global_map,
+                                           const BlockIRIMapper &block_iri_mapper, const std::vector<std::string> &entity_names, unsigned int thread_count,
+                                           bool write_ntriples, SummaryBundleBuilder *bundle_builder)
+{
+    global_id_to_iri_map_type global_id_to_iri_map;
+    std::optional<BufferedWriter> sizes_writer, contains_writer;
+    if (write_ntriples)
+    {
+        sizes_writer.emplace(experiment_directory + "rdf_summary_graph/sizes.nt");
+        contains_writer.emplace(experiment_directory + "rdf_summary_graph/contains.nt");
+    }
+
+    for (k_type level = 0; level <= depth; level++)
+    {
+        std::vector<BlockToSerialize> blocks;
+
+        // If singletons were created, then the singleton_mapping file contains this information
+        std::string singleton_mapping_file = experiment_directory + "bisimulation/singleton_mapping-" + level_to_string(level - 1) + "to" + level_to_string(level) + ".bin";
+        if (level >= 1 && std::filesystem::exists(singleton_mapping_file))
+        {
+            std::ifstream singleton_mapping_file_stream(singleton_mapping_file, std::ifstream::in | std::ifstream::binary);
+            while (true)
+            {
+                read_uint_BLOCK_little_endian(singleton_mapping_file_stream);  // The merged block
+                if (singleton_mapping_file_stream.eof())
+                {
+                    break;
+                }
+                block_or_singleton_index singleton_count = read_int_BLOCK_OR_SINGLETON_little_endian(singleton_mapping_file_stream);
+                for (block_or_singleton_index i = 0; i < singleton_count; i++)
+                {
+                    block_or_singleton_index singleton = read_int_BLOCK_OR_SINGLETON_little_endian(singleton_mapping_file_stream);
+                    blocks.push_back({singleton, {node_index(-singleton - 1)}});
+                }
+            }
+        }
+
+        std::string outcome_file = experiment_directory + "bisimulation/outcome_condensed-" + level_to_string(level) + ".bin";
+        if (!std::filesystem::exists(outcome_file))
+        {
+            throw MyException("The outcome (binary) file " + outcome_file + " should exist");
+        }
+        PartitionFileStream outcome_file_stream(outcome_file, PARTITION_FILE_OUTCOME);
+        while (true)
+        {
+            block_index block = read_uint_BLOCK_little_endian(outcome_file_stream);
+            if (outcome_file_stream.eof())
+            {
+                break;
+            }
+            node_index block_size = read_uint_ENTITY_little_endian(outcome_file_stream);
+            BlockToSerialize block_to_serialize{get_global_block(local_to_global_map, block, level), {}};
+            block_to_serialize.members.reserve(block_size);
+            for (node_index i = 0; i < block_size; i++)
+            {
+                block_to_serialize.members.push_back(read_uint_ENTITY_little_endian(outcome_file_stream));
+            }
+            blocks.push_back(std::move(block_to_serialize));
+        }
+
+        std::vector<std::string> iris(blocks.size());
+        std::vector<std::string> thread_sizes(thread_count);
+        std::vector<std::string> thread_contains(thread_count);
+        parallel_for_ranges(blocks.size(), thread_count, [&](unsigned int thread, uint64_t begin, uint64_t end)
+        {
+            for (uint64_t i = begin; i < end; i++)
+            {
+                // The contains edges list the members in the order of the outcome, the mapper may sort its own copy
+                std::vector<node_index> sorted_members = blocks[i].members;
+                iris[i] = block_iri_mapper.get_iri(sorted_members);
+                if (!write_ntriples)
+                {
+                    continue;
+                }
+                thread_sizes[thread] += "<" + iris[i] + "> <" + SIZE_IRI + "> \"" + std::to_string(blocks[i].members.size()) + "\" .\n";
+                for (node_index member: blocks[i].members)
+                {
+                    std::string &output = thread_contains[thread];
+                    output += "<" + iris[i] + "> <" + CONTAINS_IRI + "> ";
+                    append_entity(output, entity_names[member]);
+                    output += " .\n";
+                }
+            }
+        });
+        // parallel_for_ranges gives the ranges to the threads in order, so appending the buffers by thread keeps the order of the blocks
+        for (unsigned int thread = 0; write_ntriples && thread < thread_count; thread++)
+        {
+            sizes_writer->write(thread_sizes[thread]);
+            contains_writer->write(thread_contains[thread]);
+        }
+        for (uint64_t i = 0; i < blocks.size(); i++)
+        {
+            if (bundle_builder != nullptr)
+            {
+                bundle_builder->add_node(blocks[i].global_block, iris[i], blocks[i].members, entity_names);
+            }
+            global_id_to_iri_map[blocks[i].global_block] = std::move(iris[i]);
+        }
+    }
+    if (write_ntriples)
+    {
+        sizes_writer->close();
+        contains_writer->close();
+    }
+    return global_id_to_iri_map;
+}
+
+// Writes the start level of every summary node
+// Like serialize_to_ntriples.py, this also writes the start level as the end level, so the output of both stays the same
+void store_node_intervals(const std::string &experiment_directory, const std::vector<std::pair<block_or_singleton_index,std::pair<k_type,k_type>>> &intervals,
+                          const global_id_to_iri_map_type &global_id_to_iri_map)
+{
+    BufferedWriter intervals_writer(experiment_directory + "rdf_summary_graph/intervals.nt");
+    for (const auto &[global_block, interval]: intervals)
+    {
+        const std::string &iri = get_block_iri(global_id_to_iri_map, global_block);
+        std::string &output = intervals_writer.get_buffer();
+        output += "<" + iri + "> <" + START_IRI + "> \"" + std::to_string(interval.first) + "\" .\n";
+        output += "<" + iri + "> <" + END_IRI + "> \"" + std::to_string(interval.first) + "\" .\n";
+        intervals_writer.flush_if_full();
+    }
+    intervals_writer.close();
+}
+
+// Writes the refines edges to the N-Triples file and/or adds them to the bundle builder
+void load_and_store_refines_edges(const std::string &experiment_directory, k_type depth, const local_to_global_map_type &local_to_global_map,
+                                  const global_id_to_iri_map_type &global_id_to_iri_map, bool typed_start, bool write_ntriples, SummaryBundleBuilder *bundle_builder)
+{
+    std::optional<BufferedWriter> refines_writer;
+    if (write_ntriples)
+    {
+        refines_writer.emplace(experiment_directory + "rdf_summary_graph/refines.nt");
+    }
+    k_type start = typed_start ? 0 : 1;  // The untyped start has a trivial universal block at level 0, so it will not be stored explicitly
+    boost::unordered_flat_map<block_index,k_type> block_to_start_map;
+
+    PartitionFileStream start_outcome_file_stream(experiment_directory + "bisimulation/outcome_condensed-" + level_to_string(start) + ".bin", PARTITION_FILE_OUTCOME);
+    while (true)
+    {
+        block_index block = read_uint_BLOCK_little_endian(start_outcome_file_stream);
+        if (start_outcome_file_stream.eof())
+        {
+            break;
+        }
+        node_index block_size = read_uint_ENTITY_little_endian(start_outcome_file_stream);
+        block_to_start_map[block] = start;
+        start_outcome_file_stream.seekg(block_size * BYTES_PER_ENTITY, std::ios_base::cur);
+    }
+
+    auto get_global_merged_block = [&](block_index merged_block)
+    {
+        auto start_iterator = block_to_start_map.find(merged_block);
+        if (start_iterator == block_to_start_map.cend())
+        {
+            throw MyException("The merged block " + std::to_string(merged_block) + " does not exist");
+        }
+        return get_global_block(local_to_global_map, merged_block, start_iterator->second);
+    };
+    auto store_refines_edge = [&](block_or_singleton_index global_split_block, block_or_singleton_index global_merged_block)
+    {
+        if (write_ntriples)
+        {
+            refines_writer->get_buffer() += "<" + get_block_iri(global_id_to_iri_map, global_split_block) + "> <" + REFINES_IRI + "> <" + get_block_iri(global_id_to_iri_map, global_merged_block) + "> .\n";
+        }
+        if (bundle_builder != nullptr)
+        {
+            bundle_builder->add_refines_edge(global_split_block, global_merged_block);
+        }
+    };
+
+    for (k_type i = start + 1; i <= depth; i++)
+    {
+        std::string mapping_file = experiment_directory + "bisimulation/mapping-" + level_to_string(i - 1) + "to" + level_to_string(i) + ".bin";
+        if (!std::filesystem::exists(mapping_file))
+        {
+            throw MyException("The mapping (binary) file " + mapping_file + " should exist");
+        }
+
+        // If singletons were created, then the singleton_mapping file contains this information
+        std::string singleton_mapping_file = experiment_directory + "bisimulation/singleton_mapping-" + level_to_string(i - 1) + "to" + level_to_string(i) + ".bin";
+        if (std::filesystem::exists(singleton_mapping_file))
+        {
+            std::ifstream singleton_mapping_file_stream(singleton_mapping_file, std::ifstream::in | std::ifstream::binary);
+            while (true)
+            {
+                block_index merged_block = read_uint_BLOCK_little_endian(singleton_mapping_file_stream);
+                if (singleton_mapping_file_stream.eof())
+                {
+                    break;
+                }
+                block_or_singleton_index global_merged_block = get_global_merged_block(merged_block);
+                block_or_singleton_index singleton_count = read_int_BLOCK_OR_SINGLETON_little_endian(singleton_mapping_file_stream);
+                for (block_or_singleton_index j = 0; j < singleton_count; j++)
+                {
+                    block_or_singleton_index singleton = read_int_BLOCK_OR_SINGLETON_little_endian(singleton_mapping_file_stream);
+                    store_refines_edge(singleton, global_merged_block);
+                }
+                if (write_ntriples)
+                {
+                    refines_writer->flush_if_full();
+                }
+            }
+        }
+
+        // For all non-singleton blocks, read the mapping file
+        PartitionFileStream mapping_file_stream(mapping_file, PARTITION_FILE_MAPPING);
+        while (true)
+        {
+            block_index merged_block = read_uint_BLOCK_little_endian(mapping_file_stream);
+            if (mapping_file_stream.eof())
+            {
+                break;
+            }
+            block_or_singleton_index global_merged_block = get_global_merged_block(merged_block);
+            block_index split_count = read_uint_BLOCK_little_endian(mapping_file_stream);
+            for (block_index j = 0; j < split_count; j++)
+            {
+                block_index split_block = read_uint_BLOCK_little_endian(mapping_file_stream);
+                // We handled blocks splitting into singletons (i.e. split_block == 0) already
+                if (split_block == 0)
+                {
+                    continue;
+                }
+                block_or_singleton_index global_split_block = get_global_block(local_to_global_map, split_block, i);
+                block_to_start_map[split_block] = i;
+                store_refines_edge(global_split_block, global_merged_block);
+            }
+            if (write_ntriples)
+            {
+                refines_writer->flush_if_full();
+            }
+        }
+    }
+    if (write_ntriples)
+    {
+        refines_writer->close();
+    }
+}
+
+// Writes the data edges to the N-Triples file and/or adds them to the bundle builder
+void load_and_store_data_edges(const std::string &experiment_directory, const global_id_to_iri_map_type &global_id_to_iri_map, const std::vector<std::string> &predicate_names,
+                               bool write_ntriples, SummaryBundleBuilder *bundle_builder)
+{
+    std::string graph_file = experiment_directory + "bisimulation/condensed_multi_summary_graph.bin";
+    if (!std::filesystem::exists(graph_file))
+    {
+        throw MyException("The graph (binary) file " + graph_file + " should exist");
+    }
+    std::ifstream graph_file_stream(graph_file, std::ifstream::in | std::ifstream::binary);
+    std::optional<BufferedWriter> data_writer;
+    if (write_ntriples)
+    {
+        data_writer.emplace(experiment_directory + "rdf_summary_graph/data.nt");
+    }
+    while (true)
+    {
+        block_or_singleton_index subject = read_int_BLOCK_OR_SINGLETON_little_endian(graph_file_stream);
+        if (graph_file_stream.eof())
+        {
+            break;
+        }
+        edge_type predicate = read_uint_PREDICATE_little_endian(graph_file_stream);
+        block_or_singleton_index object = read_int_BLOCK_OR_SINGLETON_little_endian(graph_file_stream);
+        if (predicate >= predicate_names.size())
+        {
+            throw MyException("The predicate " + std::to_string(predicate) + " is missing from rel2ID.txt");
+        }
+        if (write_ntriples)
+        {
+            data_writer->get_buffer() += "<" + get_block_iri(global_id_to_iri_map, subject) + "> <" + predicate_names[predicate] + "> <" + get_block_iri(global_id_to_iri_map, object) + "> .\n";
+            data_writer->flush_if_full();
+        }
+        if (bundle_builder != nullptr)
+        {
+            bundle_builder->add_data_edge(subject, predicate, object);
+        }
+    }
+    if (write_ntriples)
+    {
+        data_writer->close();
+    }
+}
+
+int main(int ac, char *av[])
+{
+    // This structure was inspired by https://gist.github.com/randomphrase/10801888
+    namespace po = boost::program_options;
+
+    po::options_description global("Global options");
+    global.add_options()("experiment_directory", po::value<std::string>(), "The directory for the experiment of interest");
+    global.add_options()("iri_type", po::value<std::string>(), "The way in which block IRIs are created, one of: \"id_set\", \"iri_set\", or \"hash\"");
+    global.add_options()("threads", po::value<unsigned int>()->default_value(std::max(std::thread::hardware_concurrency(), 1u)), "The number of threads used for computing the block IRIs");
+    global.add_options()("format", po::value<std::string>()->default_value("ntriples"), "The output format, one of: \"ntriples\", \"bundle\", or \"both\"");
+    global.add_options()("bundle_contains", "Also store the members of every summary node in the bundle");
+
+    po::positional_options_description pos;
+    pos.add("experiment_directory", 1).add("iri_type", 1);
+
+    po::variables_map vm;
+
+    po::parsed_options parsed = po::command_line_parser(ac, av).options(global).positional(pos).run();
+
+    po::store(parsed, vm);
+    po::notify(vm);
+
+    if (!vm.count("experiment_directory") || !vm.count("iri_type"))
+    {
+        throw MyException("Two arguments should be provided: 1) the path to an experiment directory, 2) the iri output type (one of: \"id_set\", \"iri_set\", or \"hash\")");
+    }
+    std::string experiment_directory = vm["experiment_directory"].as<std::string>();
+    std::string iri_type = vm["iri_type"].as<std::string>();
+    unsigned int thread_count = std::max(vm["threads"].as<unsigned int>(), 1u);
+    std::string format = vm["format"].as<std::string>();
+    if (format != "ntriples" && format != "bundle" && format != "both")
+    {
+        throw MyException("`format` is set to \"" + format + "\". It should be one of: \"ntriples\", \"bundle\", or \"both\".");
+    }
+    bool write_ntriples = format != "bundle";
+    bool write_bundle = format != "ntriples";
+    if (vm.count("bundle_contains") && !write_bundle)
+    {
+        throw MyException("`--bundle_contains` can only be used when a bundle is written (i.e. with `--format=bundle` or `--format=both`)");
+    }
+
+    auto t_start{boost::chrono::system_clock::now()};
+
+    // Make a directory to store the RDF summary graph in
+    std::string rdf_summary_graph_directory = experiment_directory + "rdf_summary_graph/";
+    if (std::filesystem::exists(rdf_summary_graph_directory))
+    {
+        throw MyException("The directory " + rdf_summary_graph_directory + " already exists");
+    }
+    std::filesystem::create_directory(rdf_summary_graph_directory);
+
+    // Load some files
+    log_progress("Reading the entity, predicate and block maps");
+    std::vector<std::string> entity_names = read_id_name_map(experiment_directory + "entity2ID.txt");
+    std::vector<std::string> predicate_names = read_id_name_map(experiment_directory + "rel2ID.txt");
+    local_to_global_map_type local_to_global_map = read_local_global_map(experiment_directory + "bisimulation/condensed_multi_summary_local_global_map.bin");
+    auto intervals = read_intervals(experiment_directory + "bisimulation/condensed_multi_summary_intervals.bin");
+    k_type depth = read_graph_facts(experiment_directory).final_depth;
+    BlockIRIMapper block_iri_mapper(iri_type, entity_names);
+    std::optional<SummaryBundleBuilder> bundle_builder;
+    if (write_bundle)
+    {
+        bundle_builder.emplace(depth, vm.count("bundle_contains") > 0, entity_names.size());
+    }
+    SummaryBundleBuilder *bundle_builder_pointer = bundle_builder ? &*bundle_builder : nullptr;
+
+    // Create a map from global block ids to IRIs
+    // While loading the outcomes, we immediately serialize the size and contains edges
+    log_progress("Making the block IRIs, while serializing size and contains edges");
+    global_id_to_iri_map_type global_id_to_iri_map = process_outcomes(experiment_directory, depth, local_to_global_map, block_iri_mapper, entity_names, thread_count,
+                                                                       write_ntriples, bundle_builder_pointer);
+    if (write_bundle)
+    {
+        bundle_builder->set_intervals(intervals);
+    }
+
+    // The remaining files only need the block IRIs, so they are written concurrently
+    log_progress("Serializing summary node lifetime intervals, refines edges and data edges");
+    // serialize_to_ntriples.py passes the intervals as its typed_start argument, so only an empty summary counts as an untyped start there
+    bool typed_start = !intervals.empty();
+    std::exception_ptr intervals_exception, refines_exception;
+    std::thread intervals_thread([&]()
+    {
+        try
+        {
+            if (write_ntriples)
+            {
+                store_node_intervals(experiment_directory, intervals, global_id_to_iri_map);
+            }
+        }
+        catch (...)
+        {
+            intervals_exception = std::current_exception();
+        }
+    });
+    std::thread refines_thread([&]()
+    {
+        try
+        {
+            load_and_store_refines_edges(experiment_directory, depth, local_to_global_map, global_id_to_iri_map, typed_start, write_ntriples, bundle_builder_pointer);
+        }
+        catch (...)
+        {
+            refines_exception = std::current_exception();
+        }
+    });
+    load_and_store_data_edges(experiment_directory, global_id_to_iri_map, predicate_names, write_ntriples, bundle_builder_pointer);
+    intervals_thread.join();
+    refines_thread.join();
+    for (std::exception_ptr exception: {intervals_exception, refines_exception})
+    {
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    if (write_bundle)
+    {
+        log_progress("Writing the summary bundle");
+        bundle_builder->write(rdf_summary_graph_directory + "summary_bundle.bin", predicate_names);
+    }
+
+    auto t_end{boost::chrono::system_clock::now()};
+    log_progress("Serializing done (Time taken = " + std::to_string(boost::chrono::ceil<boost::chrono::milliseconds>(t_end - t_start).count()) + " ms)");
+}
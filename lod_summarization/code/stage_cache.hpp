@@ -0,0 +1,352 @@
+// The stage cache keeps the outputs of the preprocessor, the bisimulator and the condensed summary builder, such that running a stage again on the
+// same inputs with the same settings links the earlier outputs into the experiment directory instead of computing them again.
+//
+// Every stage computes a key from the checksum of its own binary, the options that change its outputs and the contents of its input files.
+// The cache directory holds one entry per key (`<stage>-<key>/`), with the output files at their paths relative to the experiment directory
+// and an index (`entry.txt`, one line per file: size, checksum, then the relative path). An entry is only used if all its files still have
+// the recorded size and checksum. The modification time of the index is the last time the entry was used, the least recently used entries
+// are removed when the cache grows beyond its size limit.
+//
+// Entries are written to a temporary directory that is then renamed, so an entry is either complete or not there.
+// Files are hard linked between the cache and the experiment directories (and copied if that is not possible, e.g. across file systems).
+// A file with more than one link is therefore replaced by a private copy before a stage writes its outputs, such that writing them never changes
+// the files of a cache entry or of another experiment. This also applies when the cache is disabled (lookup() and detach_outputs() do it), since
+// the outputs of an earlier run in the same experiment directory may still be linked to an entry.
+// When an entry is linked in, the files under the output prefixes that are not part of it (e.g. the files of levels beyond the final depth of the
+// entry) are removed, as are the derived files of the stage (indexes that other programs build from its outputs), so no file of an earlier run remains.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <stdexcept>
+#include <unistd.h>
+#include "experiment_manifest.hpp"
+
+const std::string STAGE_CACHE_INDEX_FILE_NAME = "entry.txt";
+const std::string STAGE_CACHE_TEMPORARY_MARKER = ".tmp-";
+
+class StageCache
+{
+private:
+    struct FileState
+    {
+        uint64_t size;
+        std::filesystem::file_time_type modified;
+    };
+
+    std::string cache_directory;  // Empty when the cache is disabled
+    uint64_t size_limit;
+    std::string stage;
+    std::string experiment_directory;
+    std::vector<std::string> output_prefixes;  // Relative to the experiment directory, e.g. "bisimulation/mapping-", the stage only writes files starting with these
+    std::vector<std::string> derived_files;  // Relative to the experiment directory, files that other programs build from the outputs
+    ChecksumBuilder key_builder;
+    std::map<std::string, FileState> outputs_before;
+
+    void add_to_key(const std::string &value)
+    {
+        uint64_t size = value.size();
+        this->key_builder.update((const char *) &size, sizeof(size));
+        this->key_builder.update(value.data(), value.size());
+    }
+
+    std::string get_entry_directory() const
+    {
+        return (std::filesystem::path(this->cache_directory) / (this->stage + "-" + this->get_key())).string();
+    }
+
+    // Lists the files whose path relative to the experiment directory starts with one of the output prefixes
+    static std::vector<std::string> list_output_files(const std::string &experiment_directory, const std::vector<std::string> &output_prefixes)
+    {
+        std::vector<std::string> files;
+        std::filesystem::path experiment_path(experiment_directory);
+        for (const std::string &output_prefix : output_prefixes)
+        {
+            std::filesystem::path directory = (experiment_path / output_prefix).parent_path();
+            if (!std::filesystem::is_directory(directory))
+            {
+                continue;
+            }
+            for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory))
+            {
+                std::string file = std::filesystem::relative(entry.path(), experiment_path).generic_string();
+                if (entry.is_regular_file() && file.compare(0, output_prefix.size(), output_prefix) == 0)
+                {
+                    files.push_back(file);
+                }
+            }
+        }
+        return files;
+    }
+
+    static void link_or_copy(const std::filesystem::path &source, const std::filesystem::path &target)
+    {
+        std::filesystem::create_directories(target.parent_path());
+        std::filesystem::remove(target);
+        std::error_code link_error;
+        std::filesystem::create_hard_link(source, target, link_error);
+        if (link_error)
+        {
+            std::filesystem::copy_file(source, target);
+        }
+    }
+
+    // Replaces a file that shares its contents with a cache entry by a copy, writing it in place would otherwise change the entry as well
+    static void detach(const std::filesystem::path &file)
+    {
+        if (std::filesystem::hard_link_count(file) <= 1)
+        {
+            return;
+        }
+        std::filesystem::path temporary_file = file.string() + STAGE_CACHE_TEMPORARY_MARKER + std::to_string(getpid());
+        std::filesystem::copy_file(file, temporary_file, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::rename(temporary_file, file);
+    }
+
+    // Reads the index of an entry as {relative path, size, checksum} tuples, an entry without a readable index is treated as absent
+    static bool read_index(const std::filesystem::path &entry_directory, std::vector<std::tuple<std::string,uint64_t,uint64_t>> &files)
+    {
+        std::ifstream index_stream(entry_directory / STAGE_CACHE_INDEX_FILE_NAME);
+        if (!index_stream)
+        {
+            return false;
+        }
+        files.clear();
+        uint64_t size;
+        uint64_t checksum;
+        std::string file;
+        while (index_stream >> size >> checksum && std::getline(index_stream >> std::ws, file))
+        {
+            files.emplace_back(file, size, checksum);
+        }
+        return index_stream.eof();
+    }
+
+    // Whether every file of an entry still has the size and checksum it had when it was stored, e.g. a file that was written through a link is not
+    static bool is_intact(const std::filesystem::path &entry_directory, const std::vector<std::tuple<std::string,uint64_t,uint64_t>> &files)
+    {
+        for (const auto &[file, size, checksum] : files)
+        {
+            std::error_code size_error;
+            if (std::filesystem::file_size(entry_directory / file, size_error) != size || size_error || compute_file_checksum((entry_directory / file).string()) != checksum)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    StageCache(const std::string &cache_directory, uint64_t size_limit_megabytes, const std::string &stage, const std::string &experiment_directory, const std::vector<std::string> &output_prefixes)
+        : cache_directory(cache_directory), size_limit(size_limit_megabytes << 20), stage(stage), experiment_directory(experiment_directory), output_prefixes(output_prefixes)
+    {
+        if (this->is_enabled())
+        {
+            std::filesystem::create_directories(this->cache_directory);
+            // A rebuilt stage may produce different outputs, so the key starts with the stage binary itself
+            this->add_to_key(stage);
+            this->add_to_key(std::to_string(compute_file_checksum("/proc/self/exe")));
+        }
+    }
+
+    bool is_enabled() const
+    {
+        return this->cache_directory != "";
+    }
+
+    // Used for runs whose outputs do not only depend on the inputs, e.g. with a time budget
+    void disable()
+    {
+        this->cache_directory = "";
+    }
+
+    void add_option(const std::string &name, const std::string &value)
+    {
+        this->add_to_key(name);
+        this->add_to_key(value);
+    }
+
+    // The name identifies the input independently of where the experiment directory is
+    void add_input_file(const std::string &name, const std::string &file_path)
+    {
+        this->add_to_key(name);
+        if (std::filesystem::exists(file_path))
+        {
+            this->add_to_key(std::to_string(std::filesystem::file_size(file_path)));
+            this->add_to_key(std::to_string(compute_file_checksum(file_path)));
+        }
+        else
+        {
+            this->add_to_key("absent");
+        }
+    }
+
+    std::string get_key() const
+    {
+        std::ostringstream key_stream;
+        key_stream << std::hex << std::setw(16) << std::setfill('0') << this->key_builder.finish();
+        return key_stream.str();
+    }
+
+    // Replaces the output files that share their contents with a cache entry by private copies.
+    // Programs that write outputs of a cached stage without a StageCache of their own (e.g. the incremental bisimulation) call this before writing
+    static void detach_outputs(const std::string &experiment_directory, const std::vector<std::string> &output_prefixes)
+    {
+        for (const std::string &file : list_output_files(experiment_directory, output_prefixes))
+        {
+            detach(std::filesystem::path(experiment_directory) / file);
+        }
+    }
+
+    // A file that is built from the outputs of the stage, e.g. an index, which describes the earlier outputs once they are replaced
+    void add_derived_file(const std::string &file)
+    {
+        this->derived_files.push_back(file);
+    }
+
+    // Removes the derived files, such that they are built again from the new outputs.
+    // Programs that write outputs of a cached stage without a StageCache of their own call this along with detach_outputs()
+    static void remove_derived_files(const std::string &experiment_directory, const std::vector<std::string> &derived_files)
+    {
+        for (const std::string &file : derived_files)
+        {
+            std::filesystem::remove(std::filesystem::path(experiment_directory) / file);
+        }
+    }
+
+    // Links the outputs of an earlier run into the experiment directory and returns true if there is an intact entry for the key.
+    // Otherwise the output files are detached from the cache and their state is remembered, such that store() can find the files the stage wrote.
+    // The derived files are removed in both cases.
+    // A disabled cache only detaches the output files, so this should be called before a stage writes its outputs whether the cache is enabled or not
+    bool lookup()
+    {
+        remove_derived_files(this->experiment_directory, this->derived_files);
+        if (!this->is_enabled())
+        {
+            detach_outputs(this->experiment_directory, this->output_prefixes);
+            return false;
+        }
+        std::filesystem::path entry_directory = this->get_entry_directory();
+        std::vector<std::tuple<std::string,uint64_t,uint64_t>> files;
+        if (read_index(entry_directory, files) && is_intact(entry_directory, files))
+        {
+            // The entry holds every file that the stage wrote, so the other files under the output prefixes are left over from an earlier run
+            for (const std::string &file : list_output_files(this->experiment_directory, this->output_prefixes))
+            {
+                if (std::none_of(files.cbegin(), files.cend(), [&file](const auto &entry_file){return std::get<0>(entry_file) == file;}))
+                {
+                    std::filesystem::remove(std::filesystem::path(this->experiment_directory) / file);
+                }
+            }
+            for (const auto &[file, size, checksum] : files)
+            {
+                link_or_copy(entry_directory / file, std::filesystem::path(this->experiment_directory) / file);
+            }
+            std::filesystem::last_write_time(entry_directory / STAGE_CACHE_INDEX_FILE_NAME, std::filesystem::file_time_type::clock::now());
+            return true;
+        }
+        if (std::filesystem::exists(entry_directory))
+        {
+            std::error_code remove_error;
+            std::filesystem::remove_all(entry_directory, remove_error);
+        }
+
+        this->outputs_before.clear();
+        for (const std::string &file : list_output_files(this->experiment_directory, this->output_prefixes))
+        {
+            std::filesystem::path file_path = std::filesystem::path(this->experiment_directory) / file;
+            detach(file_path);
+            this->outputs_before[file] = {std::filesystem::file_size(file_path), std::filesystem::last_write_time(file_path)};
+        }
+        return false;
+    }
+
+    // Adds the files that the stage created or changed since lookup() as a new entry, and removes the least recently used entries beyond the size limit
+    void store()
+    {
+        if (!this->is_enabled())
+        {
+            return;
+        }
+        std::filesystem::path entry_directory = this->get_entry_directory();
+        std::filesystem::path temporary_directory = entry_directory.string() + STAGE_CACHE_TEMPORARY_MARKER + std::to_string(getpid());
+        std::filesystem::remove_all(temporary_directory);
+        std::filesystem::create_directories(temporary_directory);
+
+        std::ostringstream index;
+        for (const std::string &file : list_output_files(this->experiment_directory, this->output_prefixes))
+        {
+            std::filesystem::path file_path = std::filesystem::path(this->experiment_directory) / file;
+            uint64_t size = std::filesystem::file_size(file_path);
+            auto before = this->outputs_before.find(file);
+            if (before != this->outputs_before.end() && before->second.size == size && before->second.modified == std::filesystem::last_write_time(file_path))
+            {
+                continue;
+            }
+            link_or_copy(file_path, temporary_directory / file);
+            index << size << " " << compute_file_checksum(file_path.string()) << " " << file << "\n";
+        }
+        {
+            std::ofstream index_stream(temporary_directory / STAGE_CACHE_INDEX_FILE_NAME, std::ios::trunc);
+            index_stream << index.str();
+            if (!index_stream.flush())
+            {
+                throw std::runtime_error("Could not write the index of " + temporary_directory.string());
+            }
+        }
+        // Another run may have stored the same entry in the meantime, which then stays
+        std::error_code rename_error;
+        std::filesystem::rename(temporary_directory, entry_directory, rename_error);
+        if (rename_error)
+        {
+            std::filesystem::remove_all(temporary_directory);
+        }
+        this->evict();
+    }
+
+    void evict()
+    {
+        std::vector<std::tuple<std::filesystem::file_time_type,uint64_t,std::filesystem::path>> entries;  // {last use, size, directory}
+        uint64_t total_size = 0;
+        for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(this->cache_directory))
+        {
+            std::vector<std::tuple<std::string,uint64_t,uint64_t>> files;
+            if (!entry.is_directory() || entry.path().filename().string().find(STAGE_CACHE_TEMPORARY_MARKER) != std::string::npos || !read_index(entry.path(), files))
+            {
+                continue;
+            }
+            uint64_t entry_size = 0;
+            for (const auto &[file, size, checksum] : files)
+            {
+                entry_size += size;
+            }
+            std::error_code time_error;
+            std::filesystem::file_time_type last_use = std::filesystem::last_write_time(entry.path() / STAGE_CACHE_INDEX_FILE_NAME, time_error);
+            if (!time_error)
+            {
+                entries.emplace_back(last_use, entry_size, entry.path());
+                total_size += entry_size;
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+        for (const auto &[last_use, entry_size, entry_directory] : entries)
+        {
+            if (total_size <= this->size_limit)
+            {
+                break;
+            }
+            // Entries can be removed by other runs at the same time
+            std::error_code remove_error;
+            std::filesystem::remove_all(entry_directory, remove_error);
+            total_size -= entry_size;
+        }
+    }
+};
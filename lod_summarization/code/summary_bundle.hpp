@@ -0,0 +1,275 @@
+// The summary bundle is a compact binary alternative to the N-Triples files in `rdf_summary_graph/`
+// It is written by the serializer and can be read with `read_summary_bundle`, all numbers are little endian
+//
+// Layout:
+//   magic "LSGB" (4 bytes), version (1 byte), flags (1 byte, bit 0 is set if the contains section exists), final depth (2 bytes)
+//   Strings:  count, count + 1 offsets into the character data (8 bytes each), character data
+//   Nodes:    count, IRI string (5 bytes each), size (5 bytes each), start level (2 bytes each), end level (2 bytes each)
+//   Refines:  count, refining node (5 bytes each), refined node (5 bytes each)
+//   Data:     count, subject node (5 bytes each), predicate string (5 bytes each), object node (5 bytes each)
+//   Contains: (optional) node count + 1 offsets into the members (8 bytes each), entity string per member (5 bytes each)
+// All counts are 8 bytes. Every section stores its columns one after the other.
+// Nodes without a lifetime interval get SUMMARY_BUNDLE_NO_LEVEL as their start and end level.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+
+const std::string SUMMARY_BUNDLE_MAGIC = "LSGB";
+const uint8_t SUMMARY_BUNDLE_VERSION = 1;
+const uint8_t SUMMARY_BUNDLE_HAS_CONTAINS = 1;
+const uint16_t SUMMARY_BUNDLE_NO_LEVEL = UINT16_MAX;
+const int SUMMARY_BUNDLE_BYTES_PER_INDEX = 5;
+const int SUMMARY_BUNDLE_BYTES_PER_LEVEL = 2;
+const int SUMMARY_BUNDLE_BYTES_PER_OFFSET = 8;
+
+struct SummaryBundle
+{
+    uint16_t depth = 0;
+
+    // The string table, string i consists of the characters from string_offsets[i] up to string_offsets[i+1]
+    std::vector<uint64_t> string_offsets = {0};
+    std::string string_data;
+
+    std::vector<uint64_t> node_iris;
+    std::vector<uint64_t> node_sizes;
+    std::vector<uint16_t> node_start_levels;
+    std::vector<uint16_t> node_end_levels;
+
+    std::vector<uint64_t> refines_children;
+    std::vector<uint64_t> refines_parents;
+
+    std::vector<uint64_t> data_subjects;
+    std::vector<uint64_t> data_predicates;
+    std::vector<uint64_t> data_objects;
+
+    // The members of node i are contains_members[contains_offsets[i]] up to contains_members[contains_offsets[i+1]]
+    bool has_contains = false;
+    std::vector<uint64_t> contains_offsets = {0};
+    std::vector<uint64_t> contains_members;
+
+    uint64_t add_string(std::string_view value)
+    {
+        this->string_data += value;
+        this->string_offsets.push_back(this->string_data.size());
+        return this->string_offsets.size() - 2;
+    }
+    std::string_view get_string(uint64_t string) const
+    {
+        return std::string_view(this->string_data).substr(this->string_offsets[string], this->string_offsets[string + 1] - this->string_offsets[string]);
+    }
+    uint64_t get_string_count() const
+    {
+        return this->string_offsets.size() - 1;
+    }
+    uint64_t get_node_count() const
+    {
+        return this->node_iris.size();
+    }
+};
+
+namespace summary_bundle_detail
+{
+    inline void write_uint(std::string &output, uint64_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; i++)
+        {
+            output.push_back(char((value >> (i * 8)) & 255));
+        }
+    }
+
+    template <typename T>
+    void write_column(std::string &output, const std::vector<T> &column, int bytes)
+    {
+        for (T value: column)
+        {
+            write_uint(output, value, bytes);
+        }
+    }
+
+    // Reads from the contents of a bundle file, while checking that it does not read past the end
+    class BundleCursor
+    {
+    private:
+        const std::string &data;
+        uint64_t position = 0;
+
+    public:
+        BundleCursor(const std::string &data) : data(data)
+        {
+        }
+        void require(uint64_t bytes) const
+        {
+            if (bytes > this->data.size() - this->position)
+            {
+                throw std::runtime_error("The summary bundle ends unexpectedly at byte " + std::to_string(this->position));
+            }
+        }
+        uint64_t read_uint(int bytes)
+        {
+            this->require(bytes);
+            uint64_t result = 0;
+            for (int i = 0; i < bytes; i++)
+            {
+                result |= (uint64_t(this->data[this->position + i]) & 255) << (i * 8);
+            }
+            this->position += bytes;
+            return result;
+        }
+        std::string read_bytes(uint64_t count)
+        {
+            this->require(count);
+            std::string result = this->data.substr(this->position, count);
+            this->position += count;
+            return result;
+        }
+        template <typename T>
+        void read_column(std::vector<T> &column, uint64_t count, int bytes, uint64_t limit, const std::string &name)
+        {
+            if (count > this->data.size())  // Also keeps count * bytes from overflowing
+            {
+                throw std::runtime_error("The summary bundle has an invalid length for its " + name + " column");
+            }
+            this->require(count * bytes);
+            column.resize(count);
+            for (T &value: column)
+            {
+                value = T(this->read_uint(bytes));
+                if (uint64_t(value) >= limit)
+                {
+                    throw std::runtime_error("The summary bundle contains an out of range value in its " + name + " column");
+                }
+            }
+        }
+        bool at_end() const
+        {
+            return this->position == this->data.size();
+        }
+    };
+}
+
+inline void write_summary_bundle(const std::string &filename, const SummaryBundle &bundle)
+{
+    using namespace summary_bundle_detail;
+
+    std::string output;
+    output += SUMMARY_BUNDLE_MAGIC;
+    write_uint(output, SUMMARY_BUNDLE_VERSION, 1);
+    write_uint(output, bundle.has_contains ? SUMMARY_BUNDLE_HAS_CONTAINS : 0, 1);
+    write_uint(output, bundle.depth, SUMMARY_BUNDLE_BYTES_PER_LEVEL);
+
+    write_uint(output, bundle.get_string_count(), SUMMARY_BUNDLE_BYTES_PER_OFFSET);
+    write_column(output, bundle.string_offsets, SUMMARY_BUNDLE_BYTES_PER_OFFSET);
+    output += bundle.string_data;
+
+    write_uint(output, bundle.get_node_count(), SUMMARY_BUNDLE_BYTES_PER_OFFSET);
+    write_column(output, bundle.node_iris, SUMMARY_BUNDLE_BYTES_PER_INDEX);
+    write_column(output, bundle.node_sizes, SUMMARY_BUNDLE_BYTES_PER_INDEX);
+    write_column(output, bundle.node_start_levels, SUMMARY_BUNDLE_BYTES_PER_LEVEL);
+    write_column(output, bundle.node_end_levels, SUMMARY_BUNDLE_BYTES_PER_LEVEL);
+
+    write_uint(output, bundle.refines_children.size(), SUMMARY_BUNDLE_BYTES_PER_OFFSET);
+    write_column(output, bundle.refines_children, SUMMARY_BUNDLE_BYTES_PER_INDEX);
+    write_column(output, bundle.refines_parents, SUMMARY_BUNDLE_BYTES_PER_INDEX);
+
+    write_uint(output, bundle.data_subjects.size(), SUMMARY_BUNDLE_BYTES_PER_OFFSET);
+    write_column(output, bundle.data_subjects, SUMMARY_BUNDLE_BYTES_PER_INDEX);
+    write_column(output, bundle.data_predicates, SUMMARY_BUNDLE_BYTES_PER_INDEX);
+    write_column(output, bundle.data_objects, SUMMARY_BUNDLE_BYTES_PER_INDEX);
+
+    if (bundle.has_contains)
+    {
+        write_column(output, bundle.contains_offsets, SUMMARY_BUNDLE_BYTES_PER_OFFSET);
+        write_column(output, bundle.contains_members, SUMMARY_BUNDLE_BYTES_PER_INDEX);
+    }
+
+    std::ofstream outputstream(filename, std::ios::trunc | std::ios::binary);
+    outputstream.write(output.data(), output.size());
+    outputstream.flush();
+    if (!outputstream)
+    {
+        throw std::runtime_error("Could not write the summary bundle to " + filename);
+    }
+}
+
+inline SummaryBundle read_summary_bundle(const std::string &filename)
+{
+    using namespace summary_bundle_detail;
+
+    std::ifstream inputstream(filename, std::ifstream::in | std::ifstream::binary);
+    if (!inputstream)
+    {
+        throw std::runtime_error("Could not open the summary bundle " + filename);
+    }
+    std::string data((std::istreambuf_iterator<char>(inputstream)), std::istreambuf_iterator<char>());
+    BundleCursor cursor(data);
+
+    SummaryBundle bundle;
+    if (cursor.read_bytes(SUMMARY_BUNDLE_MAGIC.size()) != SUMMARY_BUNDLE_MAGIC)
+    {
+        throw std::runtime_error(filename + " is not a summary bundle");
+    }
+    uint64_t version = cursor.read_uint(1);
+    if (version != SUMMARY_BUNDLE_VERSION)
+    {
+        throw std::runtime_error("The summary bundle has version " + std::to_string(version) + ", but only version " + std::to_string(SUMMARY_BUNDLE_VERSION) + " is supported");
+    }
+    bundle.has_contains = cursor.read_uint(1) & SUMMARY_BUNDLE_HAS_CONTAINS;
+    bundle.depth = cursor.read_uint(SUMMARY_BUNDLE_BYTES_PER_LEVEL);
+
+    uint64_t string_count = cursor.read_uint(SUMMARY_BUNDLE_BYTES_PER_OFFSET);
+    cursor.read_column(bundle.string_offsets, string_count + 1, SUMMARY_BUNDLE_BYTES_PER_OFFSET, UINT64_MAX, "string offset");
+    for (uint64_t i = 0; i < string_count; i++)
+    {
+        if (bundle.string_offsets[i] > bundle.string_offsets[i + 1])
+        {
+            throw std::runtime_error("The string offsets in the summary bundle are not sorted");
+        }
+    }
+    if (bundle.string_offsets[0] != 0)
+    {
+        throw std::runtime_error("The string offsets in the summary bundle should start at 0");
+    }
+    bundle.string_data = cursor.read_bytes(bundle.string_offsets.back());
+
+    uint64_t node_count = cursor.read_uint(SUMMARY_BUNDLE_BYTES_PER_OFFSET);
+    cursor.read_column(bundle.node_iris, node_count, SUMMARY_BUNDLE_BYTES_PER_INDEX, string_count, "node IRI");
+    cursor.read_column(bundle.node_sizes, node_count, SUMMARY_BUNDLE_BYTES_PER_INDEX, UINT64_MAX, "node size");
+    cursor.read_column(bundle.node_start_levels, node_count, SUMMARY_BUNDLE_BYTES_PER_LEVEL, UINT64_MAX, "start level");
+    cursor.read_column(bundle.node_end_levels, node_count, SUMMARY_BUNDLE_BYTES_PER_LEVEL, UINT64_MAX, "end level");
+
+    uint64_t refines_count = cursor.read_uint(SUMMARY_BUNDLE_BYTES_PER_OFFSET);
+    cursor.read_column(bundle.refines_children, refines_count, SUMMARY_BUNDLE_BYTES_PER_INDEX, node_count, "refining node");
+    cursor.read_column(bundle.refines_parents, refines_count, SUMMARY_BUNDLE_BYTES_PER_INDEX, node_count, "refined node");
+
+    uint64_t data_count = cursor.read_uint(SUMMARY_BUNDLE_BYTES_PER_OFFSET);
+    cursor.read_column(bundle.data_subjects, data_count, SUMMARY_BUNDLE_BYTES_PER_INDEX, node_count, "data subject");
+    cursor.read_column(bundle.data_predicates, data_count, SUMMARY_BUNDLE_BYTES_PER_INDEX, string_count, "data predicate");
+    cursor.read_column(bundle.data_objects, data_count, SUMMARY_BUNDLE_BYTES_PER_INDEX, node_count, "data object");
+
+    if (bundle.has_contains)
+    {
+        cursor.read_column(bundle.contains_offsets, node_count + 1, SUMMARY_BUNDLE_BYTES_PER_OFFSET, UINT64_MAX, "contains offset");
+        for (uint64_t i = 0; i < node_count; i++)
+        {
+            if (bundle.contains_offsets[i] > bundle.contains_offsets[i + 1])
+            {
+                throw std::runtime_error("The contains offsets in the summary bundle are not sorted");
+            }
+        }
+        if (bundle.contains_offsets[0] != 0)
+        {
+            throw std::runtime_error("The contains offsets in the summary bundle should start at 0");
+        }
+        cursor.read_column(bundle.contains_members, bundle.contains_offsets.back(), SUMMARY_BUNDLE_BYTES_PER_INDEX, string_count, "contains member");
+    }
+    if (!cursor.at_end())
+    {
+        throw std::runtime_error("The summary bundle has trailing data");
+    }
+    return bundle;
+}
@@ -0,0 +1,191 @@
+// This file reads the summary bundle written by the serializer (see summary_bundle.hpp)
+// Without flags it prints an overview of the bundle, with `--check` it checks that the bundle describes the same graph as the N-Triples files next to it
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <boost/program_options.hpp>
+#include "summary_bundle.hpp"
+
+const std::string NAMESPACE = "http://cs.vu.nl/clustering#";
+const std::string CONTAINS_IRI = NAMESPACE + "contains";
+const std::string SIZE_IRI = NAMESPACE + "size";
+const std::string REFINES_IRI = NAMESPACE + "refines";
+const std::string START_IRI = NAMESPACE + "startLevel";
+const std::string END_IRI = NAMESPACE + "endLevel";
+
+class MyException : public std::exception
+{
+private:
+    const std::string message;
+
+public:
+    MyException(const std::string &err) : message(err) {}
+
+    const char *what() const noexcept override
+    {
+        return message.c_str();
+    }
+};
+
+std::string node_term(const SummaryBundle &bundle, uint64_t node)
+{
+    return "<" + std::string(bundle.get_string(bundle.node_iris[node])) + ">";
+}
+
+std::string entity_term(const SummaryBundle &bundle, uint64_t string)
+{
+    std::string_view entity_name = bundle.get_string(string);
+    if (entity_name.starts_with("_:"))
+    {
+        return std::string(entity_name);
+    }
+    return "<" + std::string(entity_name) + ">";
+}
+
+std::vector<std::string> read_lines(const std::string &filename)
+{
+    std::ifstream inputstream(filename);
+    if (!inputstream)
+    {
+        throw MyException("Could not open " + filename);
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(inputstream, line))
+    {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Compares the lines as multisets, and prints the first few differences
+bool compare_lines(const std::string &name, std::vector<std::string> ntriples_lines, std::vector<std::string> bundle_lines)
+{
+    std::sort(ntriples_lines.begin(), ntriples_lines.end());
+    std::sort(bundle_lines.begin(), bundle_lines.end());
+    std::vector<std::string> only_ntriples, only_bundle;
+    std::set_difference(ntriples_lines.begin(), ntriples_lines.end(), bundle_lines.begin(), bundle_lines.end(), std::back_inserter(only_ntriples));
+    std::set_difference(bundle_lines.begin(), bundle_lines.end(), ntriples_lines.begin(), ntriples_lines.end(), std::back_inserter(only_bundle));
+    if (only_ntriples.empty() && only_bundle.empty())
+    {
+        std::cout << name << ": ok (" << bundle_lines.size() << " triples)" << std::endl;
+        return true;
+    }
+    std::cout << name << ": MISMATCH (" << only_ntriples.size() << " triples only in the N-Triples file, " << only_bundle.size() << " triples only in the bundle)" << std::endl;
+    for (uint64_t i = 0; i < std::min(only_ntriples.size(), uint64_t(3)); i++)
+    {
+        std::cout << "    N-Triples: " << only_ntriples[i] << std::endl;
+    }
+    for (uint64_t i = 0; i < std::min(only_bundle.size(), uint64_t(3)); i++)
+    {
+        std::cout << "    Bundle:    " << only_bundle[i] << std::endl;
+    }
+    return false;
+}
+
+// Checks that the bundle has the same nodes, sizes, intervals, refines edges and data edges (and members, if the bundle has them) as the N-Triples export
+// The N-Triples export writes the start level as the end level of every node, so only the subjects of the endLevel triples are compared
+bool check_against_ntriples(const SummaryBundle &bundle, const std::string &rdf_summary_graph_directory)
+{
+    bool all_equal = true;
+
+    std::vector<std::string> size_lines, contains_lines, interval_lines, refines_lines, data_lines;
+    for (uint64_t node = 0; node < bundle.get_node_count(); node++)
+    {
+        std::string subject = node_term(bundle, node);
+        size_lines.push_back(subject + " <" + SIZE_IRI + "> \"" + std::to_string(bundle.node_sizes[node]) + "\" .");
+        if (bundle.node_start_levels[node] != SUMMARY_BUNDLE_NO_LEVEL)
+        {
+            interval_lines.push_back(subject + " <" + START_IRI + "> \"" + std::to_string(bundle.node_start_levels[node]) + "\" .");
+            interval_lines.push_back(subject + " <" + END_IRI + ">");
+        }
+        if (bundle.has_contains)
+        {
+            for (uint64_t i = bundle.contains_offsets[node]; i < bundle.contains_offsets[node + 1]; i++)
+            {
+                contains_lines.push_back(subject + " <" + CONTAINS_IRI + "> " + entity_term(bundle, bundle.contains_members[i]) + " .");
+            }
+        }
+    }
+    for (uint64_t i = 0; i < bundle.refines_children.size(); i++)
+    {
+        refines_lines.push_back(node_term(bundle, bundle.refines_children[i]) + " <" + REFINES_IRI + "> " + node_term(bundle, bundle.refines_parents[i]) + " .");
+    }
+    for (uint64_t i = 0; i < bundle.data_subjects.size(); i++)
+    {
+        data_lines.push_back(node_term(bundle, bundle.data_subjects[i]) + " <" + std::string(bundle.get_string(bundle.data_predicates[i])) + "> " + node_term(bundle, bundle.data_objects[i]) + " .");
+    }
+
+    std::vector<std::string> ntriples_interval_lines = read_lines(rdf_summary_graph_directory + "intervals.nt");
+    const std::string end_predicate = " <" + END_IRI + ">";
+    for (std::string &line: ntriples_interval_lines)
+    {
+        size_t end_predicate_position = line.find(end_predicate);
+        if (end_predicate_position != std::string::npos)
+        {
+            line.erase(end_predicate_position + end_predicate.size());
+        }
+    }
+
+    all_equal &= compare_lines("sizes.nt", read_lines(rdf_summary_graph_directory + "sizes.nt"), size_lines);
+    all_equal &= compare_lines("intervals.nt", ntriples_interval_lines, interval_lines);
+    all_equal &= compare_lines("refines.nt", read_lines(rdf_summary_graph_directory + "refines.nt"), refines_lines);
+    all_equal &= compare_lines("data.nt", read_lines(rdf_summary_graph_directory + "data.nt"), data_lines);
+    if (bundle.has_contains)
+    {
+        all_equal &= compare_lines("contains.nt", read_lines(rdf_summary_graph_directory + "contains.nt"), contains_lines);
+    }
+    else
+    {
+        std::cout << "contains.nt: skipped (the bundle does not contain the members of the nodes)" << std::endl;
+    }
+    return all_equal;
+}
+
+int main(int ac, char *av[])
+{
+    // This structure was inspired by https://gist.github.com/randomphrase/10801888
+    namespace po = boost::program_options;
+
+    po::options_description global("Global options");
+    global.add_options()("experiment_directory", po::value<std::string>(), "The directory for the experiment of interest");
+    global.add_options()("check", "Check that the bundle describes the same graph as the N-Triples files");
+
+    po::positional_options_description pos;
+    pos.add("experiment_directory", 1);
+
+    po::variables_map vm;
+
+    po::parsed_options parsed = po::command_line_parser(ac, av).options(global).positional(pos).run();
+
+    po::store(parsed, vm);
+    po::notify(vm);
+
+    if (!vm.count("experiment_directory"))
+    {
+        throw MyException("The path to an experiment directory should be provided");
+    }
+    std::string rdf_summary_graph_directory = vm["experiment_directory"].as<std::string>() + "rdf_summary_graph/";
+    SummaryBundle bundle = read_summary_bundle(rdf_summary_graph_directory + "summary_bundle.bin");
+
+    std::cout << "Final depth: " << bundle.depth << std::endl;
+    std::cout << "Strings: " << bundle.get_string_count() << std::endl;
+    std::cout << "Nodes: " << bundle.get_node_count() << std::endl;
+    std::cout << "Refines edges: " << bundle.refines_children.size() << std::endl;
+    std::cout << "Data edges: " << bundle.data_subjects.size() << std::endl;
+    if (bundle.has_contains)
+    {
+        std::cout << "Contains edges: " << bundle.contains_members.size() << std::endl;
+    }
+
+    if (vm.count("check"))
+    {
+        if (!check_against_ntriples(bundle, rdf_summary_graph_directory))
+        {
+            return 1;
+        }
+    }
+}
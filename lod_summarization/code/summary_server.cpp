@@ -0,0 +1,591 @@
+// This file answers queries about the multi summary graph of an experiment over a Unix domain socket
+// The quotient index and the entity names are loaded once, after which every query only touches the part of the index it asks for
+//
+// Protocol: every request is a single line, and every response is a single line with a JSON object
+//   stats                   --> {"final_depth":..., "fixed_point":..., "nodes":..., "entities":...}
+//   quotient <level>        --> {"level":..., "blocks":[[block,size],...], "edges":[[subject,predicate,object],...]}
+//   members <block>         --> {"block":..., "start":..., "end":..., "members":["entity",...]}
+//   block <level> <entity>  --> {"entity":"...", "level":..., "block":...}
+// A level of -1 is an alias for the fixed point, and failed requests get {"error":"..."} as their response
+// Requests longer than MAX_REQUEST_LENGTH get an error, after which the connection is closed
+// The server stops on SIGINT or SIGTERM, after which it removes its socket
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#define BOOST_CHRONO_HEADER_ONLY
+#include <boost/chrono.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/unordered/unordered_flat_set.hpp>
+#include <boost/unordered/unordered_flat_map.hpp>
+#include <boost/program_options.hpp>
+#include "quotient_index.hpp"
+#include "entity_dictionary.hpp"
+#include "experiment_manifest.hpp"
+
+using edge_type = uint32_t;
+using node_index = uint64_t;
+using block_or_singleton_index = int64_t;
+using k_type = uint16_t;
+using triple_set = boost::unordered_flat_set<std::tuple<block_or_singleton_index,edge_type,block_or_singleton_index>>;
+
+const size_t MAX_REQUEST_LENGTH = 65536;
+
+class MyException : public std::exception
+{
+private:
+    const std::string message;
+
+public:
+    MyException(const std::string &err) : message(err) {}
+
+    const char *what() const noexcept override
+    {
+        return message.c_str();
+    }
+};
+
+void log_progress(const std::string &message)
+{
+    auto now{boost::chrono::system_clock::to_time_t(boost::chrono::system_clock::now())};
+    std::tm *ptm{std::localtime(&now)};
+    std::cout << std::put_time(ptm, "%Y/%m/%d %H:%M:%S") << " " << message << std::endl;
+}
+
+void append_json_string(std::string &output, const std::string &value)
+{
+    output += '"';
+    for (char character: value)
+    {
+        switch (character)
+        {
+        case '"':
+            output += "\\\"";
+            break;
+        case '\\':
+            output += "\\\\";
+            break;
+        case '\n':
+            output += "\\n";
+            break;
+        case '\t':
+            output += "\\t";
+            break;
+        default:
+            if ((unsigned char) character < 0x20)
+            {
+                std::ostringstream escaped;
+                escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(character);
+                output += escaped.str();
+            }
+            else
+            {
+                output += character;
+            }
+        }
+    }
+    output += '"';
+}
+
+// Everything the queries need, it is only read after loading so the worker threads can share it without locking
+class SummaryState
+{
+private:
+    k_type final_depth;
+    bool fixed_point_reached;
+    std::unique_ptr<EntityDictionary> entity_dictionary;  // entity id --> name, mapped from entity2ID.txt
+    uint64_t entity_count;
+    // name --> entity id, as {hash of the name, entity id} pairs sorted by hash, such that only the ids are kept in memory (the names are checked through the dictionary)
+    std::vector<std::pair<uint64_t,node_index>> entity_hashes;
+    boost::unordered_flat_map<block_or_singleton_index,uint64_t> block_nodes;  // global block --> node in the index
+    // The nodes containing entity i are entity_nodes[entity_node_offsets[i]] up to entity_nodes[entity_node_offsets[i+1]]
+    std::vector<uint64_t> entity_node_offsets;
+    std::vector<uint64_t> entity_nodes;
+
+    k_type parse_level(const std::string &level_string) const
+    {
+        int32_t input_level = std::stoi(level_string);
+        if (input_level == -1)
+        {
+            if (not this->fixed_point_reached)
+            {
+                throw MyException("The level was specified as -1, but the bisimulation has not reached a fixed point");
+            }
+            return this->final_depth;
+        }
+        if (input_level < 0 || input_level > this->final_depth)
+        {
+            throw MyException("The level should be between 0 and the final depth (" + std::to_string(this->final_depth) + ")");
+        }
+        if (input_level == this->final_depth and not this->fixed_point_reached)
+        {
+            throw MyException("The specified level is the last computed level, but it is NOT the fixed point");
+        }
+        return input_level;
+    }
+
+    node_index find_entity(const std::string &entity_name) const
+    {
+        uint64_t hash = std::hash<std::string_view>{}(entity_name);
+        auto candidate = std::lower_bound(this->entity_hashes.cbegin(), this->entity_hashes.cend(), std::make_pair(hash, node_index(0)));
+        for (; candidate != this->entity_hashes.cend() && candidate->first == hash; candidate++)
+        {
+            if (this->entity_dictionary->get_name(candidate->second) == entity_name)
+            {
+                return candidate->second;
+            }
+        }
+        throw MyException("Entity " + entity_name + " does not exist");
+    }
+
+public:
+    const QuotientIndex &quotient_index;
+
+    SummaryState(const QuotientIndex &index, const std::string &experiment_directory, k_type depth, bool fixed_point) : final_depth(depth), fixed_point_reached(fixed_point), quotient_index(index)
+    {
+        log_progress("Mapping the entity to id map into memory");
+        std::string entity_id_file = experiment_directory + "entity2ID.txt";
+        std::string entity_offsets_file = experiment_directory + "entity2ID_offsets.bin";
+        if (!std::filesystem::exists(entity_id_file))
+        {
+            throw MyException("Could not open " + entity_id_file);
+        }
+        if (EntityDictionary::build_offsets_if_outdated(entity_id_file, entity_offsets_file))
+        {
+            log_progress("Indexed the entity to id map");
+        }
+        this->entity_dictionary = std::make_unique<EntityDictionary>(entity_id_file, entity_offsets_file);
+        this->entity_count = this->entity_dictionary->get_entity_count();
+        this->entity_hashes.reserve(this->entity_count);
+        for (node_index entity = 0; entity < this->entity_count; entity++)
+        {
+            this->entity_hashes.emplace_back(std::hash<std::string_view>{}(this->entity_dictionary->get_name(entity)), entity);
+        }
+        std::sort(this->entity_hashes.begin(), this->entity_hashes.end());
+
+        log_progress("Indexing the blocks of every entity");
+        uint64_t node_count = this->quotient_index.get_node_count();
+        this->entity_node_offsets.assign(this->entity_count + 1, 0);
+        for (uint64_t node = 0; node < node_count; node++)
+        {
+            QuotientIndexNode index_node = this->quotient_index.get_node(node);
+            this->block_nodes[index_node.global_block] = node;
+            for (uint64_t j = 0; j < index_node.member_count; j++)
+            {
+                node_index entity = this->quotient_index.get_member(index_node, j);
+                if (entity < this->entity_count)
+                {
+                    this->entity_node_offsets[entity + 1]++;
+                }
+            }
+        }
+        for (uint64_t i = 0; i < this->entity_count; i++)
+        {
+            this->entity_node_offsets[i + 1] += this->entity_node_offsets[i];
+        }
+        this->entity_nodes.resize(this->entity_node_offsets.back());
+        std::vector<uint64_t> positions(this->entity_node_offsets.begin(), this->entity_node_offsets.end() - 1);
+        for (uint64_t node = 0; node < node_count; node++)
+        {
+            QuotientIndexNode index_node = this->quotient_index.get_node(node);
+            for (uint64_t j = 0; j < index_node.member_count; j++)
+            {
+                node_index entity = this->quotient_index.get_member(index_node, j);
+                if (entity < this->entity_count)
+                {
+                    this->entity_nodes[positions[entity]++] = node;
+                }
+            }
+        }
+    }
+
+    std::string answer_stats() const
+    {
+        return "{\"final_depth\":" + std::to_string(this->final_depth) + ",\"fixed_point\":" + (this->fixed_point_reached ? "true" : "false")
+            + ",\"nodes\":" + std::to_string(this->quotient_index.get_node_count()) + ",\"entities\":" + std::to_string(this->entity_count) + "}";
+    }
+
+    std::string answer_quotient(const std::string &level_string) const
+    {
+        k_type level = this->parse_level(level_string);
+        std::string output = "{\"level\":" + std::to_string(level) + ",\"blocks\":[";
+        bool first = true;
+        this->quotient_index.for_each_node(level, [&](const QuotientIndexNode &node)
+        {
+            output += first ? "[" : ",[";
+            output += std::to_string(node.global_block) + "," + std::to_string(node.member_count) + "]";
+            first = false;
+        });
+        output += "],\"edges\":[";
+        if (level < this->final_depth)  // The fixed point has no explicit refines edges, so its data edges are not part of the index
+        {
+            triple_set data_edges;
+            this->quotient_index.for_each_edge(level, [&](block_or_singleton_index subject, edge_type predicate, block_or_singleton_index object)
+            {
+                data_edges.emplace(subject, predicate, object);
+            });
+            // The set removes the duplicates, the edges are sorted such that the same query always gets the same response
+            std::vector<std::tuple<block_or_singleton_index,edge_type,block_or_singleton_index>> sorted_edges(data_edges.cbegin(), data_edges.cend());
+            std::sort(sorted_edges.begin(), sorted_edges.end());
+            first = true;
+            for (auto [subject, predicate, object]: sorted_edges)
+            {
+                output += first ? "[" : ",[";
+                output += std::to_string(subject) + "," + std::to_string(predicate) + "," + std::to_string(object) + "]";
+                first = false;
+            }
+        }
+        output += "]}";
+        return output;
+    }
+
+    std::string answer_members(const std::string &block_string) const
+    {
+        block_or_singleton_index block = std::stoll(block_string);
+        auto block_it = this->block_nodes.find(block);
+        if (block_it == this->block_nodes.cend())
+        {
+            throw MyException("Block " + block_string + " does not exist");
+        }
+        QuotientIndexNode node = this->quotient_index.get_node(block_it->second);
+        std::string output = "{\"block\":" + std::to_string(block) + ",\"start\":" + std::to_string(node.start) + ",\"end\":" + std::to_string(node.end) + ",\"members\":[";
+        for (uint64_t j = 0; j < node.member_count; j++)
+        {
+            if (j > 0)
+            {
+                output += ",";
+            }
+            node_index entity = this->quotient_index.get_member(node, j);
+            append_json_string(output, entity < this->entity_count ? std::string(this->entity_dictionary->get_name(entity)) : std::to_string(entity));
+        }
+        output += "]}";
+        return output;
+    }
+
+    std::string answer_block(const std::string &level_string, const std::string &entity_name) const
+    {
+        k_type level = this->parse_level(level_string);
+        node_index entity = this->find_entity(entity_name);
+        for (uint64_t i = this->entity_node_offsets[entity]; i < this->entity_node_offsets[entity + 1]; i++)
+        {
+            QuotientIndexNode node = this->quotient_index.get_node(this->entity_nodes[i]);
+            if (node.start <= level && level <= node.end)
+            {
+                std::string output = "{\"entity\":";
+                append_json_string(output, entity_name);
+                output += ",\"level\":" + std::to_string(level) + ",\"block\":" + std::to_string(node.global_block) + "}";
+                return output;
+            }
+        }
+        throw MyException("Entity " + entity_name + " is not contained in a block at level " + std::to_string(level));
+    }
+
+    std::string answer(const std::string &request) const
+    {
+        std::vector<std::string> arguments;
+        std::string trimmed_request = boost::trim_copy(request);
+        boost::split(arguments, trimmed_request, boost::is_any_of(" "), boost::token_compress_on);
+        try
+        {
+            if (arguments[0] == "stats" && arguments.size() == 1)
+            {
+                return this->answer_stats();
+            }
+            if (arguments[0] == "quotient" && arguments.size() == 2)
+            {
+                return this->answer_quotient(arguments[1]);
+            }
+            if (arguments[0] == "members" && arguments.size() == 2)
+            {
+                return this->answer_members(arguments[1]);
+            }
+            if (arguments[0] == "block" && arguments.size() == 3)
+            {
+                return this->answer_block(arguments[1], arguments[2]);
+            }
+            throw MyException("Unknown request, it should be one of: \"stats\", \"quotient <level>\", \"members <block>\", or \"block <level> <entity>\"");
+        }
+        catch (const std::logic_error &)  // Thrown by std::stoi and friends
+        {
+            std::string output = "{\"error\":";
+            append_json_string(output, "Could not parse the numbers in the request");
+            return output + "}";
+        }
+        catch (const MyException &exception)
+        {
+            std::string output = "{\"error\":";
+            append_json_string(output, exception.what());
+            return output + "}";
+        }
+    }
+};
+
+bool send_all(int connection, const std::string &data)
+{
+    uint64_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t result = send(connection, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (result <= 0)
+        {
+            return false;
+        }
+        sent += result;
+    }
+    return true;
+}
+
+std::string request_too_long_response()
+{
+    std::string output = "{\"error\":";
+    append_json_string(output, "The request is longer than " + std::to_string(MAX_REQUEST_LENGTH) + " bytes");
+    return output + "}";
+}
+
+// Answers the requests of a single client until it closes the connection
+void serve_connection(const SummaryState &state, int connection)
+{
+    std::string pending;
+    char buffer[4096];
+    bool discarding = false;  // Whether the remainder of a request longer than MAX_REQUEST_LENGTH is being skipped
+    bool connection_open = true;
+    while (connection_open)
+    {
+        ssize_t received = recv(connection, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            break;
+        }
+        pending.append(buffer, received);
+        size_t newline_position;
+        while (connection_open && (newline_position = pending.find('\n')) != std::string::npos)
+        {
+            if (discarding)
+            {
+                discarding = false;
+                connection_open = send_all(connection, request_too_long_response() + "\n");
+            }
+            else
+            {
+                std::string request = pending.substr(0, newline_position);
+                connection_open = send_all(connection, (request.size() > MAX_REQUEST_LENGTH ? request_too_long_response() : state.answer(request)) + "\n");
+            }
+            pending.erase(0, newline_position + 1);
+        }
+        // A client that never sends a newline would otherwise make the pending request grow without bound, the request is answered once its newline arrives
+        if (pending.size() > MAX_REQUEST_LENGTH)
+        {
+            discarding = true;
+            pending.clear();
+        }
+    }
+    if (connection_open && discarding)  // The client stopped sending in the middle of a request that was too long
+    {
+        send_all(connection, request_too_long_response() + "\n");
+    }
+    close(connection);
+}
+
+// A fixed pool of worker threads, each serving one accepted connection at a time
+class ConnectionPool
+{
+private:
+    std::deque<int> connections;
+    boost::unordered_flat_set<int> active_connections;
+    bool stopping = false;
+    std::mutex connections_mutex;
+    std::condition_variable connections_available;
+    std::vector<std::thread> workers;
+
+    ConnectionPool(ConnectionPool &)
+    {
+    }
+
+public:
+    ConnectionPool(const SummaryState &state, unsigned int thread_count)
+    {
+        for (unsigned int t = 0; t < thread_count; t++)
+        {
+            this->workers.emplace_back([this, &state]()
+            {
+                while (true)
+                {
+                    int connection;
+                    {
+                        std::unique_lock<std::mutex> lock(this->connections_mutex);
+                        this->connections_available.wait(lock, [this]{return this->stopping || !this->connections.empty();});
+                        if (this->stopping)
+                        {
+                            return;
+                        }
+                        connection = this->connections.front();
+                        this->connections.pop_front();
+                        this->active_connections.emplace(connection);
+                    }
+                    serve_connection(state, connection);
+                    std::lock_guard<std::mutex> lock(this->connections_mutex);
+                    this->active_connections.erase(connection);
+                }
+            });
+        }
+    }
+    ~ConnectionPool()
+    {
+        this->stop();
+    }
+    void add_connection(int connection)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->connections_mutex);
+            this->connections.push_back(connection);
+        }
+        this->connections_available.notify_one();
+    }
+    // Closes the waiting connections, ends the ones being served (their workers then see that the client is gone) and waits for the workers
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->connections_mutex);
+            this->stopping = true;
+            for (int connection: this->connections)
+            {
+                close(connection);
+            }
+            this->connections.clear();
+            for (int connection: this->active_connections)
+            {
+                shutdown(connection, SHUT_RDWR);
+            }
+        }
+        this->connections_available.notify_all();
+        for (std::thread &worker: this->workers)
+        {
+            if (worker.joinable())
+            {
+                worker.join();
+            }
+        }
+    }
+};
+
+// Set by the handler of SIGINT and SIGTERM, which interrupts the wait for connections of the main thread
+volatile std::sig_atomic_t stop_requested = 0;
+
+void request_stop(int)
+{
+    stop_requested = 1;
+}
+
+int main(int ac, char *av[])
+{
+    // This structure was inspired by https://gist.github.com/randomphrase/10801888
+    namespace po = boost::program_options;
+
+    po::options_description global("Global options");
+    global.add_options()("experiment_directory", po::value<std::string>(), "The directory for the experiment of interest");
+    global.add_options()("socket", po::value<std::string>(), "The path of the Unix domain socket to listen on (default: summary_server.sock in the experiment directory)");
+    global.add_options()("threads", po::value<unsigned int>()->default_value(std::max(std::thread::hardware_concurrency(), 1u)), "The number of threads answering queries");
+
+    po::positional_options_description pos;
+    pos.add("experiment_directory", 1);
+
+    po::variables_map vm;
+
+    po::parsed_options parsed = po::command_line_parser(ac, av).options(global).positional(pos).run();
+
+    po::store(parsed, vm);
+    po::notify(vm);
+
+    if (!vm.count("experiment_directory"))
+    {
+        throw MyException("The path to an experiment directory should be provided");
+    }
+    std::string experiment_directory = vm["experiment_directory"].as<std::string>();
+    std::string socket_path = vm.count("socket") ? vm["socket"].as<std::string>() : experiment_directory + "summary_server.sock";
+    unsigned int thread_count = std::max(vm["threads"].as<unsigned int>(), 1u);
+
+    GraphFacts graph_facts = read_graph_facts(experiment_directory);
+    k_type final_depth = graph_facts.final_depth;
+    bool fixed_point_reached = graph_facts.fixed_point;
+
+    log_progress("Mapping the quotient index into memory");
+    std::string quotient_index_file = get_quotient_index_file(experiment_directory);
+    if (!std::filesystem::exists(quotient_index_file))
+    {
+        throw MyException("There is no quotient index at " + quotient_index_file + ", run create_quotient_graph_from_condensed_summary once to build it");
+    }
+    QuotientIndex quotient_index(quotient_index_file);
+    if (!quotient_index.is_current(experiment_directory, final_depth))
+    {
+        throw MyException("The quotient index at " + quotient_index_file + " is out of date, run create_quotient_graph_from_condensed_summary once to rebuild it");
+    }
+    SummaryState state(quotient_index, experiment_directory, final_depth, fixed_point_reached);
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path))
+    {
+        throw MyException("The socket path " + socket_path + " is too long");
+    }
+    std::copy(socket_path.begin(), socket_path.end(), address.sun_path);
+    int server_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server_socket == -1)
+    {
+        throw MyException("Could not create a socket");
+    }
+    unlink(socket_path.c_str());  // Remove the socket of an earlier run, if any
+    if (bind(server_socket, (sockaddr *) &address, sizeof(address)) == -1 || listen(server_socket, 64) == -1)
+    {
+        throw MyException("Could not listen on " + socket_path);
+    }
+
+    // The signals stay blocked, except while the main thread waits for a connection (ppoll unblocks them atomically), so a stop request is never missed
+    // The workers inherit the blocked mask, such that the signals are always delivered to the main thread
+    struct sigaction stop_action{};
+    stop_action.sa_handler = request_stop;
+    sigemptyset(&stop_action.sa_mask);
+    sigaction(SIGINT, &stop_action, nullptr);
+    sigaction(SIGTERM, &stop_action, nullptr);
+    sigset_t stop_signals;
+    sigset_t waiting_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &waiting_mask);
+    sigdelset(&waiting_mask, SIGINT);
+    sigdelset(&waiting_mask, SIGTERM);
+    ConnectionPool pool(state, thread_count);
+
+    log_progress("Listening on " + socket_path + " with " + std::to_string(thread_count) + " threads");
+    while (!stop_requested)
+    {
+        pollfd server_poll{server_socket, POLLIN, 0};
+        if (ppoll(&server_poll, 1, nullptr, &waiting_mask) <= 0)
+        {
+            continue;  // Interrupted by a signal, the loop condition decides whether to stop
+        }
+        int connection = accept(server_socket, nullptr, nullptr);
+        if (connection == -1)
+        {
+            continue;
+        }
+        pool.add_connection(connection);
+    }
+
+    log_progress("Stopping");
+    close(server_socket);
+    pool.stop();
+    unlink(socket_path.c_str());
+    log_progress("Removed " + socket_path);
+}
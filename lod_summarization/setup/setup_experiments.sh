@@ -210,8 +210,23 @@ echo $(date) $(hostname) "${logging_process}.Info: compiler_flags=${compiler_fla
 sed -i 's/\r//g' ./compile.sh
 chmod +x ./compile.sh
 
-# Compile the preprocessor
 compiler_flags="${compiler_flags//,/ } -I../external/boost/include"
+
+# Copy the headers for reading and writing outcome and mapping files, the experiment manifest and the stage cache (included by the preprocessor, the bisimulator and the programs reading its output)
+echo Copying partition_file.hpp, experiment_manifest.hpp and stage_cache.hpp
+echo $(date) $(hostname) "${logging_process}.Info: Copying partition_file.hpp, experiment_manifest.hpp and stage_cache.hpp" >> $log_file
+cp ../code/partition_file.hpp ../$git_hash/code/src/partition_file.hpp
+cp ../code/experiment_manifest.hpp ../$git_hash/code/src/experiment_manifest.hpp
+cp ../code/stage_cache.hpp ../$git_hash/code/src/stage_cache.hpp
+
+# Copy the stages themselves, included by the preprocessor and the bisimulator, and by the single process pipeline (along with the exception they throw)
+echo Copying preprocessing.hpp, bisimulation.hpp and my_exception.hpp
+echo $(date) $(hostname) "${logging_process}.Info: Copying preprocessing.hpp, bisimulation.hpp and my_exception.hpp" >> $log_file
+cp ../code/my_exception.hpp ../$git_hash/code/src/my_exception.hpp
+cp ../code/preprocessing.hpp ../$git_hash/code/src/preprocessing.hpp
+cp ../code/bisimulation.hpp ../$git_hash/code/src/bisimulation.hpp
+
+# Compile the preprocessor
 echo Copying preprocessor.cpp
 echo $(date) $(hostname) "${logging_process}.Info: Copying preprocessor.cpp" >> $log_file
 cp ../code/preprocessor.cpp ../$git_hash/code/src/preprocessor.cpp
@@ -235,13 +250,40 @@ echo Compiling create_condensed_summary_graph_from_partitions.cpp
 echo $(date) $(hostname) "${logging_process}.Info: Compiling create_condensed_summary_graph_from_partitions.cpp" >> $log_file
 ./compile.sh ../$git_hash/code/src/create_condensed_summary_graph_from_partitions.cpp ../$git_hash/code/bin/create_condensed_summary_graph_from_partitions
 
-# Compile the quotient graph creator program
-echo Copying create_quotient_graph_from_condensed_summary.cpp
-echo $(date) $(hostname) "${logging_process}.Info: Copying create_quotient_graph_from_condensed_summary.cpp" >> $log_file
+# Compile the single process pipeline, which includes the preprocessing and bisimulation headers copied above
+echo Copying lod_pipeline.cpp
+echo $(date) $(hostname) "${logging_process}.Info: Copying lod_pipeline.cpp" >> $log_file
+cp ../code/lod_pipeline.cpp ../$git_hash/code/src/lod_pipeline.cpp
+echo Compiling lod_pipeline.cpp
+echo $(date) $(hostname) "${logging_process}.Info: Compiling lod_pipeline.cpp" >> $log_file
+./compile.sh ../$git_hash/code/src/lod_pipeline.cpp ../$git_hash/code/bin/lod_pipeline
+
+# Compile the quotient graph creator program, along with the server answering queries from its quotient index (both include quotient_index.hpp and entity_dictionary.hpp)
+echo Copying create_quotient_graph_from_condensed_summary.cpp, summary_server.cpp, quotient_index.hpp and entity_dictionary.hpp
+echo $(date) $(hostname) "${logging_process}.Info: Copying create_quotient_graph_from_condensed_summary.cpp, summary_server.cpp, quotient_index.hpp and entity_dictionary.hpp" >> $log_file
 cp ../code/create_quotient_graph_from_condensed_summary.cpp ../$git_hash/code/src/create_quotient_graph_from_condensed_summary.cpp
+cp ../code/summary_server.cpp ../$git_hash/code/src/summary_server.cpp
+cp ../code/quotient_index.hpp ../$git_hash/code/src/quotient_index.hpp
+cp ../code/entity_dictionary.hpp ../$git_hash/code/src/entity_dictionary.hpp
 echo Compiling create_quotient_graph_from_condensed_summary.cpp
 echo $(date) $(hostname) "${logging_process}.Info: Compiling create_quotient_graph_from_condensed_summary.cpp" >> $log_file
 ./compile.sh ../$git_hash/code/src/create_quotient_graph_from_condensed_summary.cpp ../$git_hash/code/bin/create_quotient_graph_from_condensed_summary
+echo Compiling summary_server.cpp
+echo $(date) $(hostname) "${logging_process}.Info: Compiling summary_server.cpp" >> $log_file
+./compile.sh ../$git_hash/code/src/summary_server.cpp ../$git_hash/code/bin/summary_server
+
+# Compile the serializer, along with the reader for its binary summary bundle (both include summary_bundle.hpp)
+echo Copying serializer.cpp, summary_bundle_reader.cpp and summary_bundle.hpp
+echo $(date) $(hostname) "${logging_process}.Info: Copying serializer.cpp, summary_bundle_reader.cpp and summary_bundle.hpp" >> $log_file
+cp ../code/serializer.cpp ../$git_hash/code/src/serializer.cpp
+cp ../code/summary_bundle_reader.cpp ../$git_hash/code/src/summary_bundle_reader.cpp
+cp ../code/summary_bundle.hpp ../$git_hash/code/src/summary_bundle.hpp
+echo Compiling serializer.cpp
+echo $(date) $(hostname) "${logging_process}.Info: Compiling serializer.cpp" >> $log_file
+./compile.sh ../$git_hash/code/src/serializer.cpp ../$git_hash/code/bin/serializer
+echo Compiling summary_bundle_reader.cpp
+echo $(date) $(hostname) "${logging_process}.Info: Compiling summary_bundle_reader.cpp" >> $log_file
+./compile.sh ../$git_hash/code/src/summary_bundle_reader.cpp ../$git_hash/code/bin/summary_bundle_reader
 
 # Echo that the compilation was successful
 echo C++ cpoying and compiling successful
@@ -291,6 +333,8 @@ laundromat=false
 types_to_predicates=false
 use_lz4=false
 lz4_command=/usr/local/lz4
+cache_dir=../stage_cache/
+cache_size=10240
 EOF
 
 # Make sure the file will have Unix style line endings
@@ -403,6 +447,16 @@ case \$use_lz4 in
   *) echo "use_lz4 has been set to \\"\$use_lz4\\" in preprocessor.config. Please change it to \\"true\\" or \\"false\\" instead"; exit 1 ;;
 esac
 
+# Set the stage cache flags, the cache directory is made absolute since the job runs in the experiment directory
+cache_flags=''
+if [ -n "\$cache_dir" ]; then
+  case \$cache_size in
+    ''|*[!0-9]*) echo "cache_size has been set to \\"\$cache_size\\" in preprocessor.config. Please change it to a number of MB instead"; exit 1 ;;
+  esac
+  mkdir -p \$cache_dir
+  cache_flags=" --cache_dir=\$(realpath \$cache_dir)/ --cache_size=\$cache_size"
+fi
+
 # Print the settings
 echo Using the following settings:
 echo job_name=\$job_name
@@ -418,6 +472,8 @@ echo laundromat=\$laundromat
 echo types_to_predicates=\$types_to_predicates
 echo use_lz4=\$use_lz4
 echo lz4_command=\$lz4_command
+echo cache_dir=\$cache_dir
+echo cache_size=\$cache_size
 
 if ! \$skip_user_read; then
   # Ask the user to run the experiment with the aforementioned settings
@@ -456,7 +512,7 @@ rm ./ttl_buffer
 EOM
   )
 else
-  preprocessor_command="/usr/bin/time -v ../code/bin/preprocessor \$dataset_path ./\$skiplists\$skip_literals_flag\$types_to_predicates_flag"
+  preprocessor_command="/usr/bin/time -v ../code/bin/preprocessor \$dataset_path ./\$skiplists\$skip_literals_flag\$types_to_predicates_flag\$cache_flags"
 fi
 
 # Create a log file for the experiments
@@ -480,6 +536,8 @@ echo \$(date) \$(hostname) "\${logging_process}.Info: laundromat=\$laundromat" >
 echo \$(date) \$(hostname) "\${logging_process}.Info: types_to_predicates=\$types_to_predicates" >> \$log_file
 echo \$(date) \$(hostname) "\${logging_process}.Info: use_lz4=\$use_lz4" >> \$log_file
 echo \$(date) \$(hostname) "\${logging_process}.Info: lz4_command=\$lz4_command" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: cache_dir=\$cache_dir" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: cache_size=\$cache_size" >> \$log_file
 
 # Create the slurm script
 echo Creating slurm script
@@ -579,6 +637,15 @@ output=slurm_bisimulator.out
 nodelist=
 bisimulation_mode=run_k_bisimulation_store_partition_condensed_timed
 typed_start=true
+renumbering=none
+predicates=
+ignore_predicates=
+time_budget=
+memory_budget=
+condensed_summary=false
+partition_format=v1
+cache_dir=../stage_cache/
+cache_size=10240
 EOF
 
 # Make sure the file will have Unix style line endings
@@ -662,6 +729,15 @@ echo output=\$output
 echo nodelist=\$nodelist
 echo bisimulation_mode=\$bisimulation_mode
 echo typed_start=\$typed_start
+echo renumbering=\$renumbering
+echo predicates=\$predicates
+echo ignore_predicates=\$ignore_predicates
+echo time_budget=\$time_budget
+echo memory_budget=\$memory_budget
+echo condensed_summary=\$condensed_summary
+echo partition_format=\$partition_format
+echo cache_dir=\$cache_dir
+echo cache_size=\$cache_size
 
 if ! \$skip_user_read; then
   # Ask the user to run the experiment with the aforementioned settings
@@ -698,6 +774,15 @@ echo \$(date) \$(hostname) "\${logging_process}.Info: output=\$output" >> \$log_
 echo \$(date) \$(hostname) "\${logging_process}.Info: nodelist=\$nodelist" >> \$log_file
 echo \$(date) \$(hostname) "\${logging_process}.Info: bisimulation_mode=\$bisimulation_mode" >> \$log_file
 echo \$(date) \$(hostname) "\${logging_process}.Info: typed_start=\$typed_start" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: renumbering=\$renumbering" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: predicates=\$predicates" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: ignore_predicates=\$ignore_predicates" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: time_budget=\$time_budget" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: memory_budget=\$memory_budget" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: condensed_summary=\$condensed_summary" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: partition_format=\$partition_format" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: cache_dir=\$cache_dir" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: cache_size=\$cache_size" >> \$log_file
 
 # Set a flag based on the value of typed_start
 case \$typed_start in
@@ -706,6 +791,41 @@ case \$typed_start in
   *) echo "typed_start has been set to \\"\$typed_start\\" in preprocessor.config. Please change it to \\"true\\" or \\"false\\" instead"; exit 1 ;;
 esac
 
+# Set the predicate filter flags, the files are made absolute since the job runs in the experiment directory
+predicate_flags=''
+if [ -n "\$predicates" ]; then
+  predicate_flags="\$predicate_flags --predicates=\$(realpath \$predicates)"
+fi
+if [ -n "\$ignore_predicates" ]; then
+  predicate_flags="\$predicate_flags --ignore_predicates=\$(realpath \$ignore_predicates)"
+fi
+
+# Set the budget flags, without a budget the bisimulation always continues until the fixed point
+budget_flags=''
+if [ -n "\$time_budget" ]; then
+  budget_flags="\$budget_flags --time_budget=\$time_budget"
+fi
+if [ -n "\$memory_budget" ]; then
+  budget_flags="\$budget_flags --memory_budget=\$memory_budget"
+fi
+
+# When the bisimulator also builds the multi summary, the summary graphs creator does not have to be run
+case \$condensed_summary in
+  'true') condensed_summary_flag=' --condensed_summary'; completed_status='multi_summary_complete' ;;
+  'false') condensed_summary_flag=''; completed_status='bisimulation_complete' ;;
+  *) echo "condensed_summary has been set to \\"\$condensed_summary\\" in bisimulator.config. Please change it to \\"true\\" or \\"false\\" instead"; exit 1 ;;
+esac
+
+# Set the stage cache flags, the cache directory is made absolute since the job runs in the experiment directory
+cache_flags=''
+if [ -n "\$cache_dir" ]; then
+  case \$cache_size in
+    ''|*[!0-9]*) echo "cache_size has been set to \\"\$cache_size\\" in bisimulator.config. Please change it to a number of MB instead"; exit 1 ;;
+  esac
+  mkdir -p \$cache_dir
+  cache_flags=" --cache_dir=\$(realpath \$cache_dir)/ --cache_size=\$cache_size"
+fi
+
 # Create the slurm script
 echo Creating slurm script
 echo \$(date) \$(hostname) "\${logging_process}.Info: Creating slurm script" >> \$log_file
@@ -722,9 +842,9 @@ cat >\$bisimulator_job << EOF2
 #SBATCH --nodelist=\$nodelist
 status=\\\$(grep 'summary_status' state.toml | cut -d'=' -f2 | tr -d ' "')
 if [[ "\\\$status" == "preprocessed" ]]; then
-  /usr/bin/time -v ../code/bin/bisimulator \$bisimulation_mode ./binary_encoding.bin --output=./\$typed_start_flag
+  /usr/bin/time -v ../code/bin/bisimulator \$bisimulation_mode ./binary_encoding.bin --output=./\$typed_start_flag --renumbering=\$renumbering\$predicate_flags\$budget_flags\$condensed_summary_flag --partition_format=\$partition_format\$cache_flags
   if [ \\\$? -eq 0 ]; then
-    sed -i '/^summary_status =/c\summary_status = "bisimulation_complete"' state.toml
+    sed -i '/^summary_status =/c\summary_status = "\$completed_status"' state.toml
   else
     sed -i '/^summary_status =/c\summary_status = "failed_to_bisimulate"' state.toml
   fi
@@ -793,6 +913,9 @@ ntasks_per_node=1
 partition=defq
 output=slurm_summary_graphs_creator.out
 nodelist=
+skip_if_valid=false
+cache_dir=../stage_cache/
+cache_size=10240
 EOF
 
 # Make sure the file will have Unix style line endings
@@ -874,6 +997,9 @@ echo ntasks_per_node=\$ntasks_per_node
 echo partition=\$partition
 echo output=\$output
 echo nodelist=\$nodelist
+echo skip_if_valid=\$skip_if_valid
+echo cache_dir=\$cache_dir
+echo cache_size=\$cache_size
 
 if ! \$skip_user_read; then
 # Ask the user to run the experiment with the aforementioned settings
@@ -908,6 +1034,26 @@ echo \$(date) \$(hostname) "\${logging_process}.Info: ntasks_per_node=\$ntasks_p
 echo \$(date) \$(hostname) "\${logging_process}.Info: partition=\$partition" >> \$log_file
 echo \$(date) \$(hostname) "\${logging_process}.Info: output=\$output" >> \$log_file
 echo \$(date) \$(hostname) "\${logging_process}.Info: nodelist=\$nodelist" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: skip_if_valid=\$skip_if_valid" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: cache_dir=\$cache_dir" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: cache_size=\$cache_size" >> \$log_file
+
+# The summary graph is only built again if the manifest does not show it to be up to date
+case \$skip_if_valid in
+  'true') skip_if_valid_flag=' --skip_if_valid' ;;
+  'false') skip_if_valid_flag='' ;;
+  *) echo "skip_if_valid has been set to \\"\$skip_if_valid\\" in summary_graphs_creator.config. Please change it to \\"true\\" or \\"false\\" instead"; exit 1 ;;
+esac
+
+# Set the stage cache flags, the cache directory is made absolute since the job runs in the experiment directory
+cache_flags=''
+if [ -n "\$cache_dir" ]; then
+  case \$cache_size in
+    ''|*[!0-9]*) echo "cache_size has been set to \\"\$cache_size\\" in summary_graphs_creator.config. Please change it to a number of MB instead"; exit 1 ;;
+  esac
+  mkdir -p \$cache_dir
+  cache_flags=" --cache_dir=\$(realpath \$cache_dir)/ --cache_size=\$cache_size"
+fi
 
 # Create the slurm script
 echo Creating slurm script
@@ -925,7 +1071,7 @@ cat >\$summary_graphs_creator_job << EOF2
 #SBATCH --nodelist=\$nodelist
 status=\\\$(grep 'summary_status' state.toml | cut -d'=' -f2 | tr -d ' "')
 if [[ "\\\$status" == "bisimulation_complete" ]]; then
-  /usr/bin/time -v ../code/bin/create_condensed_summary_graph_from_partitions ./
+  /usr/bin/time -v ../code/bin/create_condensed_summary_graph_from_partitions ./\$skip_if_valid_flag\$cache_flags
   if [ \\\$? -eq 0 ]; then
     sed -i '/^summary_status =/c\summary_status = "multi_summary_complete"' state.toml
   else
@@ -997,6 +1143,8 @@ partition=defq
 output=quotient_graphs_materializer.out
 nodelist=
 level=1
+output_format=text
+entity_names=lazy
 EOF
 
 # Make sure the file will have Unix style line endings
@@ -1079,6 +1227,8 @@ echo partition=\$partition
 echo output=\$output
 echo nodelist=\$nodelist
 echo level=\$level
+echo output_format=\$output_format
+echo entity_names=\$entity_names
 
 if ! \$skip_user_read; then
 # Ask the user to run the experiment with the aforementioned settings
@@ -1114,6 +1264,8 @@ echo \$(date) \$(hostname) "\${logging_process}.Info: partition=\$partition" >>
 echo \$(date) \$(hostname) "\${logging_process}.Info: output=\$output" >> \$log_file
 echo \$(date) \$(hostname) "\${logging_process}.Info: nodelist=\$nodelist" >> \$log_file
 echo \$(date) \$(hostname) "\${logging_process}.Info: level=\$level" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: output_format=\$output_format" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: entity_names=\$entity_names" >> \$log_file
 
 # Extract the output file name
 base="\${output%.*}"
@@ -1140,7 +1292,7 @@ cat >\$quotient_graphs_materializer_job << EOF2
 #SBATCH --nodelist=\$nodelist
 status=\\\$(grep 'summary_status' state.toml | cut -d'=' -f2 | tr -d ' "')
 if [[ "\\\$status" == "multi_summary_complete" ]]; then
-  /usr/bin/time -v ../code/bin/create_quotient_graph_from_condensed_summary ./ -- \$level
+  /usr/bin/time -v ../code/bin/create_quotient_graph_from_condensed_summary ./ --format=\$output_format --entity_names=\$entity_names -- \$level
 else
   warning_message="Did not create the quotient graph, because the experiment is not in the right state. Expected state: \\\"multi_summary_complete\\\". Actual state: \\\"\\\$status\\\"."
   echo \\\$warning_message
@@ -1423,6 +1575,8 @@ partition=defq
 output=slurm_serializer.out
 nodelist=
 iri_type=hash
+output_format=ntriples
+bundle_contains=false
 EOF
 
 # Make sure the file will have Unix style line endings
@@ -1504,6 +1658,9 @@ echo ntasks_per_node=\$ntasks_per_node
 echo partition=\$partition
 echo output=\$output
 echo nodelist=\$nodelist
+echo iri_type=\$iri_type
+echo output_format=\$output_format
+echo bundle_contains=\$bundle_contains
 
 if ! \$skip_user_read; then
   # Ask the user to run the experiment with the aforementioned settings
@@ -1538,6 +1695,16 @@ echo \$(date) \$(hostname) "\${logging_process}.Info: ntasks_per_node=\$ntasks_p
 echo \$(date) \$(hostname) "\${logging_process}.Info: partition=\$partition" >> \$log_file
 echo \$(date) \$(hostname) "\${logging_process}.Info: output=\$output" >> \$log_file
 echo \$(date) \$(hostname) "\${logging_process}.Info: nodelist=\$nodelist" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: iri_type=\$iri_type" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: output_format=\$output_format" >> \$log_file
+echo \$(date) \$(hostname) "\${logging_process}.Info: bundle_contains=\$bundle_contains" >> \$log_file
+
+# The summary bundle can optionally also store the members of every summary node
+case \$bundle_contains in
+  'true') bundle_contains_flag=' --bundle_contains' ;;
+  'false') bundle_contains_flag='' ;;
+  *) echo "bundle_contains has been set to \\"\$bundle_contains\\" in serializer.config. Please change it to \\"true\\" or \\"false\\" instead"; exit 1 ;;
+esac
 
 # Create the slurm script
 echo Creating slurm script
@@ -1560,7 +1727,7 @@ cd \\\$working_directory  # We have to move back to the working directory, as .b
 
 status=\\\$(grep 'summary_status' state.toml | cut -d'=' -f2 | tr -d ' "')
 if [[ "\\\$status" == "multi_summary_complete" ]]; then
-  /usr/bin/time -v python \\\$working_directory/../code/python/summary_loader/serialize_to_ntriples.py ./ \$iri_type
+  /usr/bin/time -v ../code/bin/serializer ./ \$iri_type --format=\$output_format\$bundle_contains_flag
   if [ \\\$? -eq 0 ]; then
     sed -i '/^serialized =/c\serialized = true' state.toml
   else
@@ -1628,6 +1795,8 @@ touch $run_all_config
 cat >$run_all_config << EOF
 plot_statistics=true
 serialize_to_ntriples=true
+single_process=false
+pipeline_write=dictionary,graph,partitions,summary
 EOF
 
 # Create the shell file for running all experiments
@@ -1728,44 +1897,119 @@ case \$serialize_to_ntriples in
   *) echo "serialize_to_ntriples has been set to \\"\$serialize_to_ntriples\\" in run_all.config. Please change it to \\"true\\" or \\"false\\" instead"; exit 1 ;;
 esac
 
-echo -e "\n##### SETTING UP PREPROCESSOR EXPERIMENT #####"
-./preprocessor.sh \$dataset_path \$y_flag
-# status=\$(grep 'summary_status' \$state_file | cut -d'=' -f2 | tr -d ' "')
-# if [[ "\$status" == "preprocessed" ]]; then
-#   echo Preprocessing successful
-#   echo \$(date) \$(hostname) "\${logging_process}.Info: Preprocessing successful" >> \$log_file
-# else
-#   echo Preprocessing failed
-#   echo \$(date) \$(hostname) "\${logging_process}.Err: Preprocessing failed" >> \$log_file
-#   echo \$(date) \$(hostname) "\${logging_process}.Err: Exiting with code: 1" >> \$log_file
-#   exit 1
-# fi
+# Check if single_process is set to a sane value
+case \$single_process in
+  'true') ;;
+  'false') ;;
+  *) echo "single_process has been set to \\"\$single_process\\" in run_all.config. Please change it to \\"true\\" or \\"false\\" instead"; exit 1 ;;
+esac
 
-echo -e "\n##### SETTING UP BISIMULATOR EXPERIMENT #####"
-./bisimulator.sh \$output_dir \$y_flag
-# status=\$(grep 'summary_status' \$state_file | cut -d'=' -f2 | tr -d ' "')
-# if [[ "\$status" == "bisimulation_complete" ]]; then
-#   echo Bisimulation successful
-#   echo \$(date) \$(hostname) "\${logging_process}.Info: Bisimulation successful" >> \$log_file
-# else
-#   echo Bisimulation failed
-#   echo \$(date) \$(hostname) "\${logging_process}.Err: Bisimulation failed" >> \$log_file
-#   echo \$(date) \$(hostname) "\${logging_process}.Err: Exiting with code: 1" >> \$log_file
-#   exit 1
-# fi
+if \$single_process; then
+  # Run the preprocessor, the bisimulator and the summary graph creation in one process, with the settings of their configs
+  echo -e "\n##### RUNNING THE SINGLE PROCESS PIPELINE #####"
+  . ./bisimulator.config
+  logging_process="Pipeline"
+  pipeline_flags=" --write=\$pipeline_write --renumbering=\$renumbering --partition_format=\$partition_format"
+  # With a predicate filter the summary has to be built afterwards, by summary_graphs_creator.sh
+  if [ -n "\$predicates" ] || [ -n "\$ignore_predicates" ]; then
+    case ,\$pipeline_write, in
+      *,summary,*) echo "The single process pipeline can not build the summary with predicates or ignore_predicates in bisimulator.config, remove summary from pipeline_write in run_all.config"; exit 1 ;;
+    esac
+  fi
+  if [ -n "\$predicates" ]; then
+    pipeline_flags="\$pipeline_flags --predicates=\$(realpath \$predicates)"
+  fi
+  if [ -n "\$ignore_predicates" ]; then
+    pipeline_flags="\$pipeline_flags --ignore_predicates=\$(realpath \$ignore_predicates)"
+  fi
+  for setting in skipRDFlists skip_literals laundromat types_to_predicates typed_start; do
+    case \${!setting} in
+      'true') pipeline_flags="\$pipeline_flags --\$setting" ;;
+      'false') ;;
+      *) echo "\$setting has been set to \\"\${!setting}\\" in its config. Please change it to \\"true\\" or \\"false\\" instead"; exit 1 ;;
+    esac
+  done
+  if [ -n "\$time_budget" ]; then
+    pipeline_flags="\$pipeline_flags --time_budget=\$time_budget"
+  fi
+  if [ -n "\$memory_budget" ]; then
+    pipeline_flags="\$pipeline_flags --memory_budget=\$memory_budget"
+  fi
+  # Without the summary the experiment is left in the state the bisimulator would leave it in
+  case ,\$pipeline_write, in
+    *,summary,*) completed_status='multi_summary_complete' ;;
+    *) completed_status='bisimulation_complete' ;;
+  esac
+
+  mkdir \$output_dir
+  touch \$log_file
+  echo \$(date) \$(hostname) "\${logging_process}.Info: Running the pipeline on the dataset: \${dataset_path_absolute}" >> \$log_file
+  echo \$(date) \$(hostname) "\${logging_process}.Info: Using the flags:\$pipeline_flags" >> \$log_file
+  cat >\$state_file << EOF2
+[state]
+summary_status = "ready_to_start"
+plotted = false
+serialized = false
+EOF2
 
-echo -e "\n##### SETTING UP SUMMARY GRAPH CREATOR EXPERIMENT #####"
-./summary_graphs_creator.sh \$output_dir \$y_flag
-# status=\$(grep 'summary_status' \$state_file | cut -d'=' -f2 | tr -d ' "')
-# if [[ "\$status" == "multi_summary_complete" ]]; then
-#   echo Summary graph creation successful
-#   echo \$(date) \$(hostname) "\${logging_process}.Info: Summary graph creation successful" >> \$log_file
-# else
-#   echo Summary graph creation failed
-#   echo \$(date) \$(hostname) "\${logging_process}.Err: Summary graph creation failed" >> \$log_file
-#   echo \$(date) \$(hostname) "\${logging_process}.Err: Exiting with code: 1" >> \$log_file
-#   exit 1
-# fi
+  # The lz4 compressed datasets are decompressed into a named pipe, like preprocessor.sh does
+  pipeline_input=\$(realpath \$dataset_path)
+  if [ \$use_lz4 == "true" ]; then
+    (cd \$output_dir; mkfifo ttl_buffer)
+    \$lz4_command -d -c \$dataset_path > \${output_dir}ttl_buffer &
+    pipeline_input=./ttl_buffer
+  fi
+  if (cd \$output_dir; /usr/bin/time -v ../code/bin/lod_pipeline \$pipeline_input ./\$pipeline_flags > pipeline.out 2>&1); then
+    sed -i '/^summary_status =/c\\summary_status = "'\$completed_status'"' \$state_file
+    echo Pipeline successful, see \${output_dir}pipeline_report.json for the timings
+    echo \$(date) \$(hostname) "\${logging_process}.Info: Pipeline successful" >> \$log_file
+  else
+    sed -i '/^summary_status =/c\\summary_status = "failed_to_run_pipeline"' \$state_file
+    echo Pipeline failed, see \${output_dir}pipeline.out
+    echo \$(date) \$(hostname) "\${logging_process}.Err: Pipeline failed" >> \$log_file
+    exit 1
+  fi
+  rm -f \${output_dir}ttl_buffer
+else
+  echo -e "\n##### SETTING UP PREPROCESSOR EXPERIMENT #####"
+  ./preprocessor.sh \$dataset_path \$y_flag
+  # status=\$(grep 'summary_status' \$state_file | cut -d'=' -f2 | tr -d ' "')
+  # if [[ "\$status" == "preprocessed" ]]; then
+  #   echo Preprocessing successful
+  #   echo \$(date) \$(hostname) "\${logging_process}.Info: Preprocessing successful" >> \$log_file
+  # else
+  #   echo Preprocessing failed
+  #   echo \$(date) \$(hostname) "\${logging_process}.Err: Preprocessing failed" >> \$log_file
+  #   echo \$(date) \$(hostname) "\${logging_process}.Err: Exiting with code: 1" >> \$log_file
+  #   exit 1
+  # fi
+
+  echo -e "\n##### SETTING UP BISIMULATOR EXPERIMENT #####"
+  ./bisimulator.sh \$output_dir \$y_flag
+  # status=\$(grep 'summary_status' \$state_file | cut -d'=' -f2 | tr -d ' "')
+  # if [[ "\$status" == "bisimulation_complete" ]]; then
+  #   echo Bisimulation successful
+  #   echo \$(date) \$(hostname) "\${logging_process}.Info: Bisimulation successful" >> \$log_file
+  # else
+  #   echo Bisimulation failed
+  #   echo \$(date) \$(hostname) "\${logging_process}.Err: Bisimulation failed" >> \$log_file
+  #   echo \$(date) \$(hostname) "\${logging_process}.Err: Exiting with code: 1" >> \$log_file
+  #   exit 1
+  # fi
+
+  echo -e "\n##### SETTING UP SUMMARY GRAPH CREATOR EXPERIMENT #####"
+  ./summary_graphs_creator.sh \$output_dir \$y_flag
+  # status=\$(grep 'summary_status' \$state_file | cut -d'=' -f2 | tr -d ' "')
+  # if [[ "\$status" == "multi_summary_complete" ]]; then
+  #   echo Summary graph creation successful
+  #   echo \$(date) \$(hostname) "\${logging_process}.Info: Summary graph creation successful" >> \$log_file
+  # else
+  #   echo Summary graph creation failed
+  #   echo \$(date) \$(hostname) "\${logging_process}.Err: Summary graph creation failed" >> \$log_file
+  #   echo \$(date) \$(hostname) "\${logging_process}.Err: Exiting with code: 1" >> \$log_file
+  #   exit 1
+  # fi
+fi
 
 if \$plot_statistics; then
   echo -e "\n##### SETTING UP RESULT PLOTTER EXPERIMENT #####"